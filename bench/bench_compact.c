@@ -0,0 +1,217 @@
+/**
+ * @file bench_compact.c
+ * @brief Memory and lookups of a loaded configuration versus its compact form.
+ *
+ * Writes `tenants` tenants of `keys per tenant` hierarchical keys with 8-byte
+ * values, then loads the file and indexes it, and builds the compact form and
+ * writes it. Reported are the live bytes of each form, counted by an allocator
+ * installed with `confin_set_allocator`, the time to load each file, and the
+ * p50/p99 latency and average cost of random lookups, less the cost of reading
+ * the clock.
+ *
+ * Usage: bench_compact [tenants] [keys per tenant] [lookups]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+#define KEY_SIZE __CONFIN_STRUCT_MAX_KEYLEN
+
+// Size header in front of every block, so that frees can be counted
+typedef union {
+    size_t size;
+    max_align_t align;
+} block_header_t;
+
+static size_t live_bytes = 0;
+
+static void *counting_alloc(void *userdata, size_t size) {
+    (void)userdata;
+    block_header_t *block = (block_header_t*)malloc(sizeof(block_header_t) + size);
+    if (!block) {
+        return NULL;
+    }
+    block->size = size;
+    live_bytes += size;
+    return block + 1;
+}
+
+static void counting_free(void *userdata, void *ptr) {
+    (void)userdata;
+    if (ptr) {
+        block_header_t *block = (block_header_t*)ptr - 1;
+        live_bytes -= block->size;
+        free(block);
+    }
+}
+
+static void *counting_realloc(void *userdata, void *ptr, size_t size) {
+    if (!ptr) {
+        return counting_alloc(userdata, size);
+    }
+    block_header_t *block = (block_header_t*)ptr - 1;
+    size_t old = block->size;
+    block = (block_header_t*)realloc(block, sizeof(block_header_t) + size);
+    if (!block) {
+        return NULL;
+    }
+    live_bytes = live_bytes - old + size;
+    block->size = size;
+    return block + 1;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_nanoseconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t*)a, right = *(const uint64_t*)b;
+    return (left > right) - (left < right);
+}
+
+static void make_key(char *key, uint64_t tenant, unsigned limit) {
+    snprintf(key, KEY_SIZE, "tenant%06llu.services.api.limits.l%03u", (unsigned long long)tenant, limit);
+}
+
+// Times every lookup, prints the percentiles and returns the sum of the values
+static uint64_t lookups(cffile_t *config, cfcompact_t *compact, const char **keys, size_t count, uint64_t *samples,
+                        uint64_t overhead, const char *label) {
+    uint64_t sum = 0;
+    cfentry_t entry;
+    double start = now_seconds();
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t begin = now_nanoseconds();
+        if (config) {
+            const cfentry_t *found = cfget(config, keys[i]);
+            sum += found ? CF_UNREF_ENTRYVAL(CF_ENTRYVAL(found), uint64_t) : 0;
+        } else if (cfcompactget(compact, keys[i], &entry)) {
+            uint64_t value;
+            memcpy(&value, CF_ENTRYVAL(&entry), sizeof(value));
+            sum += value;
+        }
+        uint64_t elapsed = now_nanoseconds() - begin;
+        samples[i] = elapsed > overhead ? elapsed - overhead : 0;
+    }
+    double seconds = now_seconds() - start;
+    qsort(samples, count, sizeof(*samples), compare_u64);
+    printf("%-20s p50 %5llu ns  p99 %5llu ns  %6.0f ns/lookup with timing\n", label,
+           (unsigned long long)samples[count / 2], (unsigned long long)samples[count * 99 / 100],
+           seconds * 1e9 / (double)count);
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    uint64_t tenants = argc > 1 ? strtoull(argv[1], NULL, 10) : 50000;
+    unsigned keys_per_tenant = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 100;
+    size_t count = argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 1000000;
+    const char *filename = "bench_compact.bin";
+    const char *compactname = "bench_compact.cfc";
+    if (tenants == 0 || keys_per_tenant == 0 || keys_per_tenant > 1000 || count == 0) {
+        fprintf(stderr, "Usage: bench_compact [tenants] [keys per tenant (at most 1000)] [lookups]\n");
+        return 2;
+    }
+    uint64_t entrycount = tenants * keys_per_tenant;
+    cfallocator_t allocator = {counting_alloc, counting_realloc, counting_free, NULL};
+    cfsetallocator(&allocator);
+
+    cfwriter_t *writer = cfwriteropen(filename);
+    if (!writer) {
+        return 1;
+    }
+    char key[KEY_SIZE];
+    for (uint64_t t = 0; t < tenants; ++t) {
+        for (unsigned k = 0; k < keys_per_tenant; ++k) {
+            uint64_t value = t * keys_per_tenant + k;
+            make_key(key, t, k);
+            cfwriterappend(writer, key, CONFIN_ANNOTYPE_INT, &value, sizeof(value));
+        }
+    }
+    if (!cfwriterclose(writer)) {
+        return 1;
+    }
+
+    size_t baseline = live_bytes;
+    double start = now_seconds();
+    cffile_t *config = cfreadcfg(filename);
+    if (!config || !cfindexcfg(config)) {
+        return 1;
+    }
+    double config_seconds = now_seconds() - start;
+    size_t config_bytes = live_bytes - baseline;
+
+    cfcompact_t *compact = cfcompact(config);
+    if (!compact || !cfcompactwrite(compact, compactname)) {
+        return 1;
+    }
+    cfcompactfree(compact);
+    baseline = live_bytes;
+    start = now_seconds();
+    compact = cfcompactread(compactname);
+    if (!compact) {
+        return 1;
+    }
+    double compact_seconds = now_seconds() - start;
+    size_t compact_bytes = live_bytes - baseline;
+
+    char (*names)[KEY_SIZE] = (char(*)[KEY_SIZE])malloc(KEY_SIZE * count);
+    const char **keys = (const char**)malloc(sizeof(char*) * count);
+    uint64_t *samples = (uint64_t*)malloc(sizeof(uint64_t) * count);
+    if (!names || !keys || !samples) {
+        perror("malloc");
+        return 1;
+    }
+    uint64_t state = 88172645463325252ull;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t index = next_random(&state) % entrycount;
+        make_key(names[i], index / keys_per_tenant, (unsigned)(index % keys_per_tenant));
+        keys[i] = names[i];
+    }
+    uint64_t overhead = UINT64_MAX;
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t first = now_nanoseconds();
+        uint64_t elapsed = now_nanoseconds() - first;
+        overhead = elapsed < overhead ? elapsed : overhead;
+    }
+
+    printf("%llu entries (%llu tenants of %u keys), %zu random lookups\n", (unsigned long long)entrycount,
+           (unsigned long long)tenants, keys_per_tenant, count);
+    printf("loaded and indexed: %8.1f MB  %6.0f ms to load\n", (double)config_bytes / (1024.0 * 1024.0), config_seconds * 1e3);
+    printf("compact:            %8.1f MB  %6.0f ms to load  (%.1fx smaller, %.1f bytes per entry)\n",
+           (double)compact_bytes / (1024.0 * 1024.0), compact_seconds * 1e3, (double)config_bytes / (double)compact_bytes,
+           (double)compact_bytes / (double)entrycount);
+    uint64_t config_sum = lookups(config, NULL, keys, count, samples, overhead, "confin_get");
+    uint64_t compact_sum = lookups(NULL, compact, keys, count, samples, overhead, "confin_compact_get");
+    if (config_sum != compact_sum) {
+        fprintf(stderr, "Checksums differ\n");
+        return 1;
+    }
+
+    cffreecfgfile(config);
+    cfcompactfree(compact);
+    cfsetallocator(NULL);
+    free(names);
+    free((void*)keys);
+    free(samples);
+    remove(filename);
+    remove(compactname);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file bench_compile.c
+ * @brief Throughput of the INI and JSON compiler.
+ * 
+ * Generates a synthetic JSON document and an equivalent INI file in memory, then
+ * compiles each into a Confin file and reports the input throughput. The INI
+ * source is compiled once per thread count up to the given maximum.
+ * 
+ * Usage: bench_compile [sections] [keys per section] [max threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} buffer_t;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void append(buffer_t *buffer, const char *text, size_t size) {
+    if (buffer->size + size > buffer->capacity) {
+        buffer->capacity = (buffer->capacity + size) * 2;
+        buffer->data = (char*)realloc(buffer->data, buffer->capacity);
+        if (!buffer->data) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    memcpy(buffer->data + buffer->size, text, size);
+    buffer->size += size;
+}
+
+static void value_text(char *out, size_t size, unsigned long s, unsigned long k, int json) {
+    switch (k % 3) {
+        case 0: snprintf(out, size, "%lu", s * 1000 + k); break;
+        case 1: snprintf(out, size, "%lu.%lu", s, k); break;
+        default: snprintf(out, size, json ? "\"value of entry %lu in section %lu\"" : "value of entry %lu in section %lu", k, s); break;
+    }
+}
+
+static void generate(buffer_t *json, buffer_t *ini, unsigned long sections, unsigned long keys) {
+    char line[160], value[96];
+    append(json, "{\n", 2);
+    for (unsigned long s = 0; s < sections; ++s) {
+        int length = snprintf(line, sizeof(line), "%s  \"section%lu\": {\n", s ? ",\n" : "", s);
+        append(json, line, (size_t)length);
+        length = snprintf(line, sizeof(line), "[section%lu]\n", s);
+        append(ini, line, (size_t)length);
+        for (unsigned long k = 0; k < keys; ++k) {
+            value_text(value, sizeof(value), s, k, 1);
+            length = snprintf(line, sizeof(line), "    \"key%lu\": %s%s\n", k, value, k + 1 < keys ? "," : "");
+            append(json, line, (size_t)length);
+            value_text(value, sizeof(value), s, k, 0);
+            length = snprintf(line, sizeof(line), "key%lu = %s\n", k, value);
+            append(ini, line, (size_t)length);
+        }
+        append(json, "  }", 3);
+    }
+    append(json, "\n}\n", 3);
+}
+
+static void run(const char *name, const buffer_t *source, cfsource_t format, unsigned threads) {
+    cfcompileopts_t options = {format, 0, threads};
+    uint64_t entrycount = 0;
+    double start = now_seconds();
+    if (!cfcompilebuffer(source->data, source->size, "bench_compile.bin", &options, &entrycount)) {
+        fprintf(stderr, "%s: compile failed\n", name);
+        exit(1);
+    }
+    double elapsed = now_seconds() - start;
+    printf("%-5s threads: %2u   %8.1f MB   %10llu entries   %6.3f GB/s\n", name, threads,
+           (double)source->size / 1e6, (unsigned long long)entrycount, (double)source->size / elapsed / 1e9);
+}
+
+int main(int argc, char **argv) {
+    unsigned long sections = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000;
+    unsigned long keys = argc > 2 ? strtoul(argv[2], NULL, 10) : 500;
+    unsigned maxthreads = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 4;
+
+    buffer_t json = {NULL, 0, 0}, ini = {NULL, 0, 0};
+    generate(&json, &ini, sections, keys);
+
+    run("json", &json, CONFIN_SOURCE_JSON, 1);
+    for (unsigned threads = 1; threads <= maxthreads; threads *= 2) {
+        run("ini", &ini, CONFIN_SOURCE_INI, threads);
+    }
+
+    remove("bench_compile.bin");
+    free(json.data);
+    free(ini.data);
+    return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file bench_frozen.c
+ * @brief Lookups on a configuration larger than the cache, loaded and frozen.
+ *
+ * Builds the configuration of bench_lookup, freezes it, and looks up the same
+ * random keys in both forms. Each lookup of the first pass is timed on its own
+ * and reported as p50/p99/p999, less the cost of reading the clock; the second
+ * pass reports the throughput of single and batched lookups. Every lookup reads
+ * the first byte of its value.
+ *
+ * Usage: bench_frozen [entrycount] [lookups] [mlock]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+#define KEY_SIZE 40
+#define BATCH 32
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_nanoseconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t*)a, right = *(const uint64_t*)b;
+    return (left > right) - (left < right);
+}
+
+static const cfentry_t *lookup(cffile_t *config, cffrozen_t *frozen, const char *key) {
+    return config ? cfget(config, key) : cffrozenget(frozen, key);
+}
+
+// Times every lookup and prints the percentiles
+static unsigned long latencies(cffile_t *config, cffrozen_t *frozen, const char **keys, size_t lookups,
+                               uint64_t *samples, uint64_t overhead, const char *label) {
+    unsigned long sum = 0;
+    for (size_t i = 0; i < lookups; ++i) {
+        uint64_t start = now_nanoseconds();
+        const cfentry_t *entry = lookup(config, frozen, keys[i]);
+        sum += entry ? *(const unsigned char*)CF_ENTRYVAL(entry) : 0;
+        uint64_t elapsed = now_nanoseconds() - start;
+        samples[i] = elapsed > overhead ? elapsed - overhead : 0;
+    }
+    qsort(samples, lookups, sizeof(*samples), compare_u64);
+    printf("%-22s p50 %5llu ns  p99 %5llu ns  p999 %6llu ns\n", label, (unsigned long long)samples[lookups / 2],
+           (unsigned long long)samples[lookups * 99 / 100], (unsigned long long)samples[lookups * 999 / 1000]);
+    return sum;
+}
+
+static unsigned long single(cffile_t *config, cffrozen_t *frozen, const char **keys, size_t lookups) {
+    unsigned long sum = 0;
+    for (size_t i = 0; i < lookups; ++i) {
+        const cfentry_t *entry = lookup(config, frozen, keys[i]);
+        sum += entry ? *(const unsigned char*)CF_ENTRYVAL(entry) : 0;
+    }
+    return sum;
+}
+
+static unsigned long batched(cffile_t *config, cffrozen_t *frozen, const char **keys, size_t lookups) {
+    const cfentry_t *out[BATCH];
+    unsigned long sum = 0;
+    for (size_t i = 0; i < lookups; i += BATCH) {
+        size_t n = lookups - i < BATCH ? lookups - i : BATCH;
+        if (config) {
+            cfgetmany(config, keys + i, n, out);
+        } else {
+            cffrozengetmany(frozen, keys + i, n, out);
+        }
+        for (size_t j = 0; j < n; ++j) {
+            sum += out[j] ? *(const unsigned char*)CF_ENTRYVAL(out[j]) : 0;
+        }
+    }
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 4000000;
+    size_t lookups = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 2000000;
+    uint32_t flags = argc > 3 && atoi(argv[3]) ? CONFIN_FREEZE_MLOCK : 0;
+    const char *filename = "bench_frozen.bin";
+    if (count == 0 || lookups == 0) {
+        fprintf(stderr, "Usage: bench_frozen [entrycount] [lookups] [mlock]\n");
+        return 2;
+    }
+
+    char value[48];
+    memset(value, 'v', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    cfwriter_t *writer = cfwriteropen(filename);
+    if (!writer) {
+        return 1;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        char key[KEY_SIZE];
+        snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)i);
+        value[0] = (char)('a' + i % 26);
+        cfwriterappend(writer, key, CONFIN_ANNOTYPE_STRING, value, sizeof(value));
+    }
+    if (!cfwriterclose(writer)) {
+        return 1;
+    }
+
+    cffile_t *config = cfreadcfg(filename);
+    if (!config) {
+        return 1;
+    }
+    double start = now_seconds();
+    cffrozen_t *frozen = cffreeze(config, flags);
+    double freezing = now_seconds() - start;
+    if (!frozen) {
+        return 1;
+    }
+
+    char (*names)[KEY_SIZE] = (char(*)[KEY_SIZE])malloc(KEY_SIZE * lookups);
+    const char **keys = (const char**)malloc(sizeof(char*) * lookups);
+    uint64_t *samples = (uint64_t*)malloc(sizeof(uint64_t) * lookups);
+    if (!names || !keys || !samples) {
+        perror("malloc");
+        return 1;
+    }
+    uint64_t state = 88172645463325252ull;
+    for (size_t i = 0; i < lookups; ++i) {
+        snprintf(names[i], KEY_SIZE, "service.key.%llu", (unsigned long long)(next_random(&state) % count));
+        keys[i] = names[i];
+    }
+
+    // Cost of reading the clock twice
+    uint64_t overhead = UINT64_MAX;
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t first = now_nanoseconds();
+        uint64_t elapsed = now_nanoseconds() - first;
+        overhead = elapsed < overhead ? elapsed : overhead;
+    }
+
+    printf("%llu entries, %zu random lookups\n", (unsigned long long)count, lookups);
+    printf("frozen in %.0f ms: %.1f MB block%s%s\n", freezing * 1e3, (double)cffrozensize(frozen) / (1024.0 * 1024.0),
+           cffrozenflags(frozen) & CONFIN_FROZEN_HUGEPAGES ? ", huge pages advised" : "",
+           cffrozenflags(frozen) & CONFIN_FREEZE_MLOCK ? ", locked" : "");
+    unsigned long sums[6];
+    sums[0] = latencies(config, NULL, keys, lookups, samples, overhead, "confin_get");
+    sums[1] = latencies(NULL, frozen, keys, lookups, samples, overhead, "confin_frozen_get");
+
+    start = now_seconds();
+    sums[2] = single(config, NULL, keys, lookups);
+    double loaded = now_seconds() - start;
+    start = now_seconds();
+    sums[3] = single(NULL, frozen, keys, lookups);
+    double frozen_single = now_seconds() - start;
+    start = now_seconds();
+    sums[4] = batched(config, NULL, keys, lookups);
+    double loaded_batched = now_seconds() - start;
+    start = now_seconds();
+    sums[5] = batched(NULL, frozen, keys, lookups);
+    double frozen_batched = now_seconds() - start;
+
+    for (int i = 1; i < 6; ++i) {
+        if (sums[i] != sums[0]) {
+            fprintf(stderr, "Checksums differ\n");
+            return 1;
+        }
+    }
+    printf("confin_get             %6.1f ns/key\n", loaded * 1e9 / (double)lookups);
+    printf("confin_frozen_get      %6.1f ns/key  (%.2fx)\n", frozen_single * 1e9 / (double)lookups, loaded / frozen_single);
+    printf("confin_get_many        %6.1f ns/key\n", loaded_batched * 1e9 / (double)lookups);
+    printf("confin_frozen_get_many %6.1f ns/key  (%.2fx)\n", frozen_batched * 1e9 / (double)lookups,
+           loaded_batched / frozen_batched);
+
+    cffrozenfree(frozen);
+    cffreecfgfile(config);
+    free(names);
+    free((void*)keys);
+    free(samples);
+    remove(filename);
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file bench_inline.c
+ * @brief Scalar lookup throughput with inline versus heap-allocated values.
+ * 
+ * Builds a configuration of integer entries and measures sequential scans and
+ * random lookups twice: once on entries as loaded by `confin_read_config` (values
+ * stored inline) and once with every value moved to its own heap block, which is
+ * the layout used before small values were stored inline.
+ * 
+ * Usage: bench_inline [entrycount] [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static long long scan(const cffile_t *config, unsigned rounds) {
+    long long sum = 0;
+    for (unsigned r = 0; r < rounds; ++r) {
+        for (uint64_t i = 0; i < config->header.entrycount; ++i) {
+            sum += CF_UNREF_ENTRYVAL(CF_ENTRYVAL(&config->entries[i]), int);
+        }
+    }
+    return sum;
+}
+
+static long long lookup(const cffile_t *config, const uint32_t *order, uint64_t count, unsigned rounds) {
+    long long sum = 0;
+    for (unsigned r = 0; r < rounds; ++r) {
+        for (uint64_t i = 0; i < count; ++i) {
+            sum += CF_UNREF_ENTRYVAL(CF_ENTRYVAL(&config->entries[order[i]]), int);
+        }
+    }
+    return sum;
+}
+
+static void report(const char *name, const cffile_t *config, const uint32_t *order, unsigned rounds) {
+    uint64_t count = config->header.entrycount;
+    double ops = (double)count * rounds;
+
+    double start = now_seconds();
+    long long sum = scan(config, rounds);
+    double scan_time = now_seconds() - start;
+
+    start = now_seconds();
+    sum += lookup(config, order, count, rounds);
+    double lookup_time = now_seconds() - start;
+
+    printf("%-8s scan: %8.1f M/s   random lookup: %8.1f M/s   (checksum %lld)\n",
+           name, ops / scan_time / 1e6, ops / lookup_time / 1e6, sum);
+}
+
+int main(int argc, char **argv) {
+    uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    unsigned rounds = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 100;
+    const char *filename = "bench_inline.bin";
+
+    cfentry_t *entries = (cfentry_t*)malloc(sizeof(cfentry_t) * count);
+    uint32_t *order = (uint32_t*)malloc(sizeof(uint32_t) * count);
+    if (!entries || !order) {
+        perror("malloc");
+        return 1;
+    }
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (uint64_t i = 0; i < count; ++i) {
+        char key[__CONFIN_STRUCT_MAX_KEYLEN];
+        int value = (int)(i & 0xFFFF);
+        snprintf(key, sizeof(key), "scalar.%llu", (unsigned long long)i);
+        entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_INT, &value, sizeof(value));
+        order[i] = (uint32_t)i;
+    }
+    for (uint64_t i = count; i > 1; --i) {
+        uint64_t j = next_random(&state) % i;
+        uint32_t tmp = order[i - 1];
+        order[i - 1] = order[j];
+        order[j] = tmp;
+    }
+
+    cfwritecfg(filename, entries, count);
+    for (uint64_t i = 0; i < count; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+    free(entries);
+
+    cffile_t *config = cfreadcfg(filename);
+    if (!config) {
+        return 1;
+    }
+
+    // Same entries with every value in its own heap block, allocated in shuffled order
+    cffile_t *boxed = (cffile_t*)malloc(sizeof(cffile_t) + sizeof(cfentry_t) * count);
+    if (!boxed) {
+        perror("malloc");
+        return 1;
+    }
+    memcpy(boxed, config, sizeof(cffile_t) + sizeof(cfentry_t) * count);
+    for (uint64_t i = 0; i < count; ++i) {
+        cfentry_t *entry = &boxed->entries[order[i]];
+        void *value = malloc(entry->size);
+        memcpy(value, CF_ENTRYVAL(&config->entries[order[i]]), entry->size);
+        entry->flags &= ~CONFIN_ENTRY_INLINE;
+        entry->value = value;
+    }
+
+    printf("%llu entries, %u rounds, sizeof(cfentry_t) = %u\n",
+           (unsigned long long)count, rounds, (unsigned)sizeof(cfentry_t));
+    report("heap", boxed, order, rounds);
+    report("inline", config, order, rounds);
+
+    cffreecfgfile(boxed);
+    cffreecfgfile(config);
+    free(order);
+    remove(filename);
+    return 0;
+}
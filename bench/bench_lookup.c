@@ -0,0 +1,127 @@
+/**
+ * @file bench_lookup.c
+ * @brief Batched versus individual key lookups on a configuration larger than the cache.
+ * 
+ * Builds a configuration whose entries, index and out-of-line values exceed the
+ * last-level cache, then looks up random batches of keys once with one
+ * `confin_get` per key and once with `confin_get_many` per batch. Both variants
+ * read the first byte of every value.
+ * 
+ * Usage: bench_lookup [entrycount] [batch size] [lookups]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+#define KEY_SIZE 32
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static unsigned long single(cffile_t *config, const char **keys, size_t lookups) {
+    unsigned long sum = 0;
+    for (size_t i = 0; i < lookups; ++i) {
+        const cfentry_t *entry = cfget(config, keys[i]);
+        sum += entry ? *(const unsigned char*)CF_ENTRYVAL(entry) : 0;
+    }
+    return sum;
+}
+
+static unsigned long batched(cffile_t *config, const char **keys, size_t lookups, size_t batch, const cfentry_t **out) {
+    unsigned long sum = 0;
+    for (size_t i = 0; i < lookups; i += batch) {
+        size_t n = lookups - i < batch ? lookups - i : batch;
+        cfgetmany(config, keys + i, n, out);
+        for (size_t j = 0; j < n; ++j) {
+            sum += out[j] ? *(const unsigned char*)CF_ENTRYVAL(out[j]) : 0;
+        }
+    }
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 4000000;
+    size_t batch = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 32;
+    size_t lookups = argc > 3 ? (size_t)strtoul(argv[3], NULL, 10) : 2000000;
+    const char *filename = "bench_lookup.bin";
+    if (batch == 0) {
+        batch = 1;
+    }
+
+    char value[48];
+    memset(value, 'v', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    cfentry_t *entries = (cfentry_t*)malloc(sizeof(cfentry_t) * count);
+    if (!entries) {
+        perror("malloc");
+        return 1;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        char key[KEY_SIZE];
+        snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)i);
+        value[0] = (char)('a' + i % 26);
+        entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_STRING, value, sizeof(value));
+    }
+    cfwritecfg(filename, entries, count);
+    for (uint64_t i = 0; i < count; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+    free(entries);
+
+    cffile_t *config = cfreadcfg(filename);
+    if (!config || !cfindexcfg(config)) {
+        return 1;
+    }
+
+    char *keydata = (char*)malloc(KEY_SIZE * lookups);
+    const char **keys = (const char**)malloc(sizeof(char*) * lookups);
+    const cfentry_t **out = (const cfentry_t**)malloc(sizeof(cfentry_t*) * batch);
+    if (!keydata || !keys || !out) {
+        perror("malloc");
+        return 1;
+    }
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < lookups; ++i) {
+        keys[i] = keydata + KEY_SIZE * i;
+        snprintf(keydata + KEY_SIZE * i, KEY_SIZE, "service.key.%llu", (unsigned long long)(next_random(&state) % count));
+    }
+
+    printf("%llu entries (%.0f MB of entries and values), batches of %zu\n", (unsigned long long)count,
+           (double)count * (sizeof(cfentry_t) + sizeof(value)) / 1e6, batch);
+
+    // Warm up page tables and the branch predictors before timing either variant
+    unsigned long sum = single(config, keys, lookups);
+
+    double start = now_seconds();
+    sum += single(config, keys, lookups);
+    double single_time = now_seconds() - start;
+
+    start = now_seconds();
+    sum += batched(config, keys, lookups, batch, out);
+    double batched_time = now_seconds() - start;
+
+    printf("single:  %7.1f ns/key\n", single_time / (double)lookups * 1e9);
+    printf("batched: %7.1f ns/key   speedup %.2fx   (checksum %lu)\n",
+           batched_time / (double)lookups * 1e9, single_time / batched_time, sum);
+
+    cffreecfgfile(config);
+    free(keydata);
+    free(keys);
+    free(out);
+    remove(filename);
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file bench_mutable.c
+ * @brief Throughput of small transactions on a large mutable configuration.
+ * 
+ * Commits transactions of `batch` random updates to a mutable configuration while
+ * every version stays readable, and compares with copying the whole entry array
+ * for each batch, which is what editing a `cffile_t` takes. The last 64 versions
+ * are retained, and a rollback to the oldest of them is timed.
+ * 
+ * Usage: bench_mutable [entrycount] [batch size] [transactions]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+int main(int argc, char **argv) {
+    uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    unsigned batch = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 16;
+    unsigned transactions = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 20000;
+    if (count == 0 || batch == 0 || transactions == 0) {
+        return 1;
+    }
+
+    cffile_t *config = (cffile_t*)calloc(1, sizeof(cffile_t) + sizeof(cfentry_t) * count);
+    if (!config) {
+        perror("malloc");
+        return 1;
+    }
+    config->header.entrycount = count;
+    for (uint64_t i = 0; i < count; ++i) {
+        char key[__CONFIN_STRUCT_MAX_KEYLEN];
+        snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)i);
+        config->entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_INT, &i, sizeof(int));
+    }
+
+    double start = now_seconds();
+    cfmutable_t *mutableconfig = cfmutcreate(config);
+    if (!mutableconfig) {
+        return 1;
+    }
+    printf("%llu entries, loaded in %.1f ms, transactions of %u updates\n", (unsigned long long)count,
+           (now_seconds() - start) * 1e3, batch);
+
+    if (!cfmutsethistory(mutableconfig, 64)) {
+        return 1;
+    }
+
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    start = now_seconds();
+    for (unsigned t = 0; t < transactions; ++t) {
+        cftxn_t *txn = cftxnbegin(mutableconfig);
+        for (unsigned i = 0; i < batch; ++i) {
+            char key[__CONFIN_STRUCT_MAX_KEYLEN];
+            int value = (int)t;
+            snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)(next_random(&state) % count));
+            cftxnset(txn, key, CONFIN_ANNOTYPE_INT, &value, sizeof(value));
+        }
+        if (!cftxncommit(txn)) {
+            return 1;
+        }
+    }
+    double cow = (now_seconds() - start) / transactions;
+    printf("copy-on-write:  %9.2f us/transaction  %10.0f updates/s\n", cow * 1e6, batch / cow);
+
+    // Copy the entry array per batch, a fraction of the transactions being enough
+    unsigned copies = transactions / 100 ? transactions / 100 : 1;
+    cffile_t *copy = (cffile_t*)malloc(sizeof(cffile_t) + sizeof(cfentry_t) * count);
+    if (!copy) {
+        perror("malloc");
+        return 1;
+    }
+    unsigned long sum = 0;
+    start = now_seconds();
+    for (unsigned t = 0; t < copies; ++t) {
+        memcpy(copy, config, sizeof(cffile_t) + sizeof(cfentry_t) * count);
+        for (unsigned i = 0; i < batch; ++i) {
+            int value = (int)t;
+            cfentry_t *entry = &copy->entries[next_random(&state) % count];
+            memcpy(entry->inlinevalue, &value, sizeof(value));
+        }
+        sum += copy->entries[next_random(&state) % count].inlinevalue[0];
+    }
+    double full = (now_seconds() - start) / copies;
+    printf("full copy:      %9.2f us/transaction  %10.0f updates/s   (%.0fx slower, checksum %lu)\n",
+           full * 1e6, batch / full, full / cow, sum);
+
+    uint64_t versions[64];
+    uint32_t retained = cfmutversions(mutableconfig, versions, 64);
+    uint64_t oldest = versions[(retained < 64 ? retained : 64) - 1];
+    start = now_seconds();
+    if (!cfmutrollback(mutableconfig, oldest)) {
+        return 1;
+    }
+    double rollback = now_seconds() - start;
+
+    cfsnapshot_t *snapshot = cfmutsnapshot(mutableconfig);
+    printf("rollback to version %llu of %u retained: %.2f us, now version %llu, %llu entries\n", (unsigned long long)oldest,
+           retained, rollback * 1e6, (unsigned long long)cfsnapversion(snapshot), (unsigned long long)cfsnapcount(snapshot));
+    cfsnaprelease(snapshot);
+    cfmutfree(mutableconfig);
+    free(copy);
+    free(config);
+    return 0;
+}
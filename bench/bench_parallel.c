@@ -0,0 +1,96 @@
+/**
+ * @file bench_parallel.c
+ * @brief Serial versus parallel loading of a large configuration file.
+ * 
+ * Writes a file with the streaming writer, then loads it with `confin_read_config`
+ * and with `confin_read_config_parallel` on 1 to `max threads` threads, using the
+ * offset table and, with a plain copy of the file, the header prescan. The file
+ * is in the page cache, so the times measure decoding rather than the disk.
+ * 
+ * Usage: bench_parallel [entrycount] [max threads] [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Best time of `rounds` loads; threads == 0 selects the serial reader
+static double best_load(const char *filename, unsigned threads, int rounds, uint64_t count) {
+    double best = 0;
+    for (int round = 0; round < rounds; ++round) {
+        double start = now_seconds();
+        cffile_t *config = threads ? cfreadcfgparallel(filename, threads) : cfreadcfg(filename);
+        double elapsed = now_seconds() - start;
+        if (!config || config->header.entrycount != count) {
+            fprintf(stderr, "Load of %s failed\n", filename);
+            exit(1);
+        }
+        cffreecfgfile(config);
+        if (round == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 2000000;
+    unsigned max_threads = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 8;
+    int rounds = argc > 3 ? atoi(argv[3]) : 5;
+    const char *filename = "bench_parallel.bin";
+    const char *plain_filename = "bench_parallel_plain.bin";
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+    if (rounds <= 0) {
+        rounds = 1;
+    }
+
+    char value[48];
+    memset(value, 'v', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    cfwriter_t *writer = cfwriteropen(filename);
+    if (!writer) {
+        return 1;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        char key[__CONFIN_STRUCT_MAX_KEYLEN];
+        snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)i);
+        value[0] = (char)('a' + i % 26);
+        // Mix inline and out-of-line values
+        cfwriterappend(writer, key, CONFIN_ANNOTYPE_STRING, value, i % 4 ? sizeof(value) : 8);
+    }
+    if (!cfwriterclose(writer)) {
+        return 1;
+    }
+
+    cffile_t *config = cfreadcfg(filename);
+    if (!config) {
+        return 1;
+    }
+    cfwritecfgfile(plain_filename, config);
+    cffreecfgfile(config);
+
+    printf("%llu entries, best of %d rounds\n", (unsigned long long)count, rounds);
+    double serial = best_load(filename, 0, rounds, count);
+    printf("serial:              %8.1f ms\n", serial * 1e3);
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        double table = best_load(filename, threads, rounds, count);
+        double prescan = best_load(plain_filename, threads, rounds, count);
+        printf("parallel %2u threads: %8.1f ms (%.2fx)   prescan %8.1f ms (%.2fx)\n", threads,
+               table * 1e3, serial / table, prescan * 1e3, serial / prescan);
+    }
+
+    remove(filename);
+    remove(plain_filename);
+    return 0;
+}
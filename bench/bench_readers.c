@@ -0,0 +1,489 @@
+/**
+ * @file bench_readers.c
+ * @brief Read scaling of a shared configuration while it is reloaded.
+ *
+ * Runs 1, 2, 4, ... up to `max threads` reader threads, each doing random
+ * lookups on one shared configuration for `step ms` milliseconds, while a writer
+ * thread reloads it every `reload ms` milliseconds (0 disables the writer). A
+ * reader acquires the configuration, looks up `lookups per acquire` keys, reading
+ * the first byte of each value, and releases it; each such operation is timed.
+ *
+ * The readers are compared through the implementations of @ref reader_impl_t:
+ *  - `rwlock`: a loaded configuration behind a read-write lock; a reload
+ *    rewrites the file, reads it and swaps it in under the write lock.
+ *  - `frozen`: the same, with the configuration frozen after it is read.
+ *  - `mutable`: a mutable configuration; readers hold a snapshot, and a reload
+ *    commits a transaction updating `updates` keys, without rewriting the file.
+ * Another one is added by filling a @ref reader_impl_t and listing it in `impls`.
+ *
+ * Per step, reported are the lookups per second of all threads and the least,
+ * average and most of one thread, the latency percentiles of an operation, the
+ * speedup over one thread and the reloads done with their average duration.
+ *
+ * Usage: bench_readers [entrycount] [max threads] [step ms] [reload ms] [lookups per acquire] [implementation] [updates]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#include "../confin/cfself.h"
+
+#ifdef __linux__
+
+#define BUCKETS_PER_POWER 8
+#define BUCKETS (64 * BUCKETS_PER_POWER)
+#define KEY_SIZE 40
+#define KEY_POOL (1u << 20)
+
+static uint64_t now_nanoseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void sleep_milliseconds(unsigned milliseconds) {
+    struct timespec ts;
+    ts.tv_sec = milliseconds / 1000;
+    ts.tv_nsec = (long)(milliseconds % 1000) * 1000000;
+    nanosleep(&ts, NULL);
+}
+
+/* latency histogram: eight linear buckets per power of two */
+
+static unsigned bucket_of(uint64_t nanoseconds) {
+    if (nanoseconds < BUCKETS_PER_POWER) {
+        return (unsigned)nanoseconds;
+    }
+    unsigned power = 63 - (unsigned)__builtin_clzll(nanoseconds);
+    return (power - 2) * BUCKETS_PER_POWER + (unsigned)((nanoseconds >> (power - 3)) & (BUCKETS_PER_POWER - 1));
+}
+
+static uint64_t bucket_floor(unsigned bucket) {
+    if (bucket < BUCKETS_PER_POWER) {
+        return bucket;
+    }
+    unsigned power = bucket / BUCKETS_PER_POWER + 2;
+    return (uint64_t)(BUCKETS_PER_POWER + bucket % BUCKETS_PER_POWER) << (power - 3);
+}
+
+static uint64_t percentile(const uint64_t *histogram, uint64_t total, double fraction) {
+    uint64_t rank = (uint64_t)((double)total * fraction);
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < BUCKETS; ++i) {
+        seen += histogram[i];
+        if (seen > rank) {
+            return bucket_floor(i);
+        }
+    }
+    return bucket_floor(BUCKETS - 1);
+}
+
+/* configurations shared by the readers */
+
+typedef struct {
+    const char *filename;
+    char (*keys)[KEY_SIZE]; // KEY_POOL random keys, so that readers do not format them
+    uint64_t entrycount;
+    unsigned updates;
+    pthread_rwlock_t lock;
+    cffile_t *config;
+    cffrozen_t *frozen;
+    cfmutable_t *mutable_config;
+} store_t;
+
+/**
+ * @brief A way for readers to share a configuration that is reloaded.
+ */
+typedef struct {
+    const char *name;
+    bool (*open)(store_t *store);                               /**< Loads the configuration written to `store->filename` */
+    void *(*acquire)(store_t *store);                           /**< Returns a handle that stays valid until released */
+    const cfentry_t *(*get)(void *handle, const char *key);     /**< Finds a key through the handle */
+    void (*release)(store_t *store, void *handle);
+    bool (*reload)(store_t *store, uint64_t generation);        /**< Publishes the values of `generation` */
+    void (*close)(store_t *store);
+} reader_impl_t;
+
+// Writes every key with the value of its index plus the generation
+static bool rewrite(const store_t *store, uint64_t generation) {
+    cfwriter_t *writer = cfwriteropen(store->filename);
+    if (!writer) {
+        return false;
+    }
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    for (uint64_t i = 0; i < store->entrycount; ++i) {
+        uint64_t value = i + generation;
+        snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)i);
+        cfwriterappend(writer, key, CONFIN_ANNOTYPE_INT, &value, sizeof(value));
+    }
+    return cfwriterclose(writer);
+}
+
+static void *locked_acquire(store_t *store) {
+    pthread_rwlock_rdlock(&store->lock);
+    return store->frozen ? (void*)store->frozen : (void*)store->config;
+}
+
+static void locked_release(store_t *store, void *handle) {
+    (void)handle;
+    pthread_rwlock_unlock(&store->lock);
+}
+
+// The key index is built before the configuration is shared, see cflookup.h
+static bool rwlock_open(store_t *store) {
+    store->config = cfreadcfg(store->filename);
+    return store->config != NULL && cfindexcfg(store->config);
+}
+
+static const cfentry_t *rwlock_get(void *handle, const char *key) {
+    return cfget((cffile_t*)handle, key);
+}
+
+static bool rwlock_reload(store_t *store, uint64_t generation) {
+    cffile_t *config = rewrite(store, generation) ? cfreadcfg(store->filename) : NULL;
+    if (!config || !cfindexcfg(config)) {
+        if (config) {
+            cffreecfgfile(config);
+        }
+        return false;
+    }
+    pthread_rwlock_wrlock(&store->lock);
+    cffile_t *old = store->config;
+    store->config = config;
+    pthread_rwlock_unlock(&store->lock);
+    cffreecfgfile(old);
+    return true;
+}
+
+static void rwlock_close(store_t *store) {
+    cffreecfgfile(store->config);
+    store->config = NULL;
+}
+
+static bool frozen_open(store_t *store) {
+    cffile_t *config = cfreadcfg(store->filename);
+    if (!config) {
+        return false;
+    }
+    store->frozen = cffreeze(config, 0);
+    cffreecfgfile(config);
+    return store->frozen != NULL;
+}
+
+static const cfentry_t *frozen_get(void *handle, const char *key) {
+    return cffrozenget((cffrozen_t*)handle, key);
+}
+
+static bool frozen_reload(store_t *store, uint64_t generation) {
+    cffile_t *config = rewrite(store, generation) ? cfreadcfg(store->filename) : NULL;
+    if (!config) {
+        return false;
+    }
+    cffrozen_t *frozen = cffreeze(config, 0);
+    cffreecfgfile(config);
+    if (!frozen) {
+        return false;
+    }
+    pthread_rwlock_wrlock(&store->lock);
+    cffrozen_t *old = store->frozen;
+    store->frozen = frozen;
+    pthread_rwlock_unlock(&store->lock);
+    cffrozenfree(old);
+    return true;
+}
+
+static void frozen_close(store_t *store) {
+    cffrozenfree(store->frozen);
+    store->frozen = NULL;
+}
+
+static bool mutable_open(store_t *store) {
+    cffile_t *config = cfreadcfg(store->filename);
+    if (!config) {
+        return false;
+    }
+    store->mutable_config = cfmutcreate(config);
+    cffreecfgfile(config);
+    return store->mutable_config != NULL;
+}
+
+static void *mutable_acquire(store_t *store) {
+    return cfmutsnapshot(store->mutable_config);
+}
+
+static const cfentry_t *mutable_get(void *handle, const char *key) {
+    return cfsnapget((cfsnapshot_t*)handle, key);
+}
+
+static void mutable_release(store_t *store, void *handle) {
+    (void)store;
+    cfsnaprelease((cfsnapshot_t*)handle);
+}
+
+static bool mutable_reload(store_t *store, uint64_t generation) {
+    cftxn_t *txn = cftxnbegin(store->mutable_config);
+    if (!txn) {
+        return false;
+    }
+    uint64_t state = generation * 0x9E3779B97F4A7C15ULL + 1;
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    for (unsigned i = 0; i < store->updates; ++i) {
+        uint64_t index = next_random(&state) % store->entrycount;
+        uint64_t value = index + generation;
+        snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)index);
+        if (!cftxnset(txn, key, CONFIN_ANNOTYPE_INT, &value, sizeof(value))) {
+            cftxnabort(txn);
+            return false;
+        }
+    }
+    return cftxncommit(txn);
+}
+
+static void mutable_close(store_t *store) {
+    cfmutfree(store->mutable_config);
+    store->mutable_config = NULL;
+}
+
+static const reader_impl_t impls[] = {
+    {"rwlock", rwlock_open, locked_acquire, rwlock_get, locked_release, rwlock_reload, rwlock_close},
+    {"frozen", frozen_open, locked_acquire, frozen_get, locked_release, frozen_reload, frozen_close},
+    {"mutable", mutable_open, mutable_acquire, mutable_get, mutable_release, mutable_reload, mutable_close},
+};
+
+/* threads */
+
+typedef struct {
+    const reader_impl_t *impl;
+    store_t *store;
+    unsigned hold;
+    uint64_t seed;
+    int *stop;
+    uint64_t lookups;
+    uint64_t missing;
+    uint64_t sum;
+    double seconds;
+    uint64_t histogram[BUCKETS];
+} reader_t;
+
+typedef struct {
+    const reader_impl_t *impl;
+    store_t *store;
+    unsigned interval;
+    uint64_t generation;
+    int *stop;
+    uint64_t reloads;
+    uint64_t nanoseconds;
+    int failed;
+} writer_t;
+
+static void *run_reader(void *argument) {
+    reader_t *reader = (reader_t*)argument;
+    uint64_t state = reader->seed;
+    uint64_t start = now_nanoseconds();
+    while (!__atomic_load_n(reader->stop, __ATOMIC_RELAXED)) {
+        uint64_t begin = now_nanoseconds();
+        void *handle = reader->impl->acquire(reader->store);
+        for (unsigned i = 0; i < reader->hold; ++i) {
+            const char *key = reader->store->keys[next_random(&state) & (KEY_POOL - 1)];
+            const cfentry_t *entry = reader->impl->get(handle, key);
+            if (entry) {
+                reader->sum += *(const unsigned char*)CF_ENTRYVAL(entry);
+            } else {
+                ++reader->missing;
+            }
+        }
+        reader->impl->release(reader->store, handle);
+        ++reader->histogram[bucket_of(now_nanoseconds() - begin)];
+        reader->lookups += reader->hold;
+    }
+    reader->seconds = (double)(now_nanoseconds() - start) * 1e-9;
+    return NULL;
+}
+
+static void *run_writer(void *argument) {
+    writer_t *writer = (writer_t*)argument;
+    while (!__atomic_load_n(writer->stop, __ATOMIC_RELAXED)) {
+        sleep_milliseconds(writer->interval);
+        if (__atomic_load_n(writer->stop, __ATOMIC_RELAXED)) {
+            break;
+        }
+        uint64_t begin = now_nanoseconds();
+        if (!writer->impl->reload(writer->store, ++writer->generation)) {
+            writer->failed = 1;
+            break;
+        }
+        writer->nanoseconds += now_nanoseconds() - begin;
+        ++writer->reloads;
+    }
+    return NULL;
+}
+
+// Runs one step; returns the lookups per second of all threads, or a negative value on failure
+static double run_step(const reader_impl_t *impl, store_t *store, unsigned threads, unsigned milliseconds,
+                       unsigned interval, unsigned hold, uint64_t *generation, double baseline) {
+    reader_t *readers = (reader_t*)calloc(threads, sizeof(reader_t));
+    pthread_t *reader_threads = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    if (!readers || !reader_threads) {
+        perror("malloc");
+        return -1;
+    }
+    int stop = 0;
+    writer_t writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.impl = impl;
+    writer.store = store;
+    writer.interval = interval;
+    writer.generation = *generation;
+    writer.stop = &stop;
+    pthread_t writer_thread;
+    if (interval && pthread_create(&writer_thread, NULL, run_writer, &writer) != 0) {
+        perror("pthread_create");
+        return -1;
+    }
+    unsigned started = 0;
+    for (; started < threads; ++started) {
+        readers[started].impl = impl;
+        readers[started].store = store;
+        readers[started].hold = hold;
+        readers[started].seed = 0x9E3779B97F4A7C15ULL * (started + 1);
+        readers[started].stop = &stop;
+        if (pthread_create(&reader_threads[started], NULL, run_reader, &readers[started]) != 0) {
+            perror("pthread_create");
+            break;
+        }
+    }
+    sleep_milliseconds(milliseconds);
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (unsigned t = 0; t < started; ++t) {
+        pthread_join(reader_threads[t], NULL);
+    }
+    if (interval) {
+        pthread_join(writer_thread, NULL);
+    }
+    *generation = writer.generation;
+
+    uint64_t histogram[BUCKETS] = {0};
+    uint64_t operations = 0, missing = 0;
+    double total = 0, least = 0, most = 0;
+    for (unsigned t = 0; t < started; ++t) {
+        double rate = readers[t].seconds > 0 ? (double)readers[t].lookups / readers[t].seconds : 0;
+        least = t == 0 || rate < least ? rate : least;
+        most = rate > most ? rate : most;
+        total += rate;
+        missing += readers[t].missing;
+        for (unsigned i = 0; i < BUCKETS; ++i) {
+            histogram[i] += readers[t].histogram[i];
+            operations += readers[t].histogram[i];
+        }
+    }
+    free(readers);
+    free(reader_threads);
+    if (started < threads || writer.failed || missing || operations == 0) {
+        fprintf(stderr, "%s: step with %u threads failed\n", impl->name, threads);
+        return -1;
+    }
+    printf("%-8s %7u %9.2f %8.0f %8.0f %8.0f %7llu %7llu %8llu %7.2fx %7llu %9.1f\n", impl->name, threads,
+           total / 1e6, least / 1e3, total / threads / 1e3, most / 1e3,
+           (unsigned long long)percentile(histogram, operations, 0.5),
+           (unsigned long long)percentile(histogram, operations, 0.99),
+           (unsigned long long)percentile(histogram, operations, 0.999), baseline > 0 ? total / baseline : 1.0,
+           (unsigned long long)writer.reloads, writer.reloads ? (double)writer.nanoseconds / writer.reloads / 1e6 : 0.0);
+    fflush(stdout);
+    return total;
+}
+
+int main(int argc, char **argv) {
+    uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 200000;
+    unsigned max_threads = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 64;
+    unsigned milliseconds = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 500;
+    unsigned interval = argc > 4 ? (unsigned)strtoul(argv[4], NULL, 10) : 50;
+    unsigned hold = argc > 5 ? (unsigned)strtoul(argv[5], NULL, 10) : 1;
+    const char *only = argc > 6 && strcmp(argv[6], "all") != 0 ? argv[6] : NULL;
+    unsigned updates = argc > 7 ? (unsigned)strtoul(argv[7], NULL, 10) : 1000;
+    if (count == 0 || max_threads == 0 || milliseconds == 0 || hold == 0 || updates == 0) {
+        fprintf(stderr, "Usage: bench_readers [entrycount] [max threads] [step ms] [reload ms] [lookups per acquire] "
+                        "[implementation] [updates]\n");
+        return 2;
+    }
+
+    char (*keys)[KEY_SIZE] = (char(*)[KEY_SIZE])malloc(KEY_SIZE * (size_t)KEY_POOL);
+    if (!keys) {
+        perror("malloc");
+        return 1;
+    }
+    uint64_t state = 88172645463325252ull;
+    for (unsigned i = 0; i < KEY_POOL; ++i) {
+        snprintf(keys[i], KEY_SIZE, "service.key.%llu", (unsigned long long)(next_random(&state) % count));
+    }
+
+    printf("%llu entries, %u ms per step, ", (unsigned long long)count, milliseconds);
+    if (interval) {
+        printf("reload every %u ms, ", interval);
+    } else {
+        printf("no reload, ");
+    }
+    printf("%u lookups per acquire\n", hold);
+    printf("%-8s %7s %9s %8s %8s %8s %7s %7s %8s %8s %7s %9s\n", "impl", "threads", "Mlookup/s", "min k/s",
+           "avg k/s", "max k/s", "p50 ns", "p99 ns", "p999 ns", "speedup", "reloads", "reload ms");
+    bool matched = false;
+    for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); ++i) {
+        const reader_impl_t *impl = &impls[i];
+        if (only && strcmp(only, impl->name) != 0) {
+            continue;
+        }
+        matched = true;
+        store_t store;
+        memset(&store, 0, sizeof(store));
+        store.filename = "bench_readers.bin";
+        store.entrycount = count;
+        store.updates = updates;
+        store.keys = keys;
+        pthread_rwlock_init(&store.lock, NULL);
+        if (!rewrite(&store, 0) || !impl->open(&store)) {
+            return 1;
+        }
+        uint64_t generation = 0;
+        double baseline = 0;
+        for (unsigned threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+            double total = run_step(impl, &store, threads, milliseconds, interval, hold, &generation, baseline);
+            if (total < 0) {
+                return 1;
+            }
+            baseline = baseline > 0 ? baseline : total;
+            if (threads == max_threads) {
+                break;
+            }
+        }
+        impl->close(&store);
+        pthread_rwlock_destroy(&store.lock);
+        remove(store.filename);
+    }
+    if (!matched) {
+        fprintf(stderr, "Unknown implementation '%s'\n", only);
+        return 2;
+    }
+    free(keys);
+    return 0;
+}
+
+#else // __linux__
+
+int main(void) {
+    fprintf(stderr, "bench_readers requires Linux\n");
+    return 1;
+}
+
+#endif // __linux__
@@ -0,0 +1,228 @@
+/**
+ * @file bench_server.c
+ * @brief Load generator for the configuration server.
+ *
+ * Writes a configuration of `entrycount` keys and serves it from a server thread,
+ * or targets the server already listening on `socket`, which must serve keys named
+ * `service.key.<n>` in its first configuration. Every client thread holds an equal
+ * share of the connections; each round it sends one batched lookup of random keys
+ * on each of its connections, then reads the replies. Reported are the requests
+ * and keys per second and the latency percentiles of a request, from the send to
+ * the end of its reply.
+ *
+ * Usage: bench_server [entrycount] [connections] [threads] [batch] [rounds] [socket]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sys/resource.h>
+#endif
+
+#include "../confin/cfself.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+    return (left > right) - (left < right);
+}
+
+#ifndef _WIN32
+
+typedef struct {
+    const char *path;
+    uint64_t entrycount;
+    unsigned connections;
+    unsigned batch;
+    unsigned rounds;
+    uint64_t seed;
+    double *latencies; // rounds * connections
+    uint64_t found;
+    int failed;
+} worker_t;
+
+static uint64_t next_random(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void *run_worker(void *argument) {
+    worker_t *worker = (worker_t*)argument;
+    cfclient_t **clients = (cfclient_t**)calloc(worker->connections, sizeof(cfclient_t*));
+    double *sent = (double*)malloc(sizeof(double) * worker->connections);
+    char (*keys)[__CONFIN_STRUCT_MAX_KEYLEN] = (char (*)[__CONFIN_STRUCT_MAX_KEYLEN])malloc(sizeof(*keys) * worker->batch);
+    const char **names = (const char**)malloc(sizeof(const char*) * worker->batch);
+    if (!clients || !sent || !keys || !names) {
+        worker->failed = 1;
+        return NULL;
+    }
+    for (unsigned i = 0; i < worker->batch; ++i) {
+        names[i] = keys[i];
+    }
+    for (unsigned c = 0; c < worker->connections && !worker->failed; ++c) {
+        clients[c] = cfclientconnect(worker->path);
+        worker->failed = clients[c] == NULL;
+    }
+
+    uint64_t state = worker->seed;
+    for (unsigned round = 0; round < worker->rounds && !worker->failed; ++round) {
+        for (unsigned c = 0; c < worker->connections; ++c) {
+            for (unsigned k = 0; k < worker->batch; ++k) {
+                snprintf(keys[k], sizeof(keys[k]), "service.key.%llu",
+                         (unsigned long long)(next_random(&state) % worker->entrycount));
+            }
+            sent[c] = now_seconds();
+            if (!cfclientsend(clients[c], CONFIN_REQUEST_GET, NULL, names, worker->batch)) {
+                worker->failed = 1;
+                break;
+            }
+        }
+        for (unsigned c = 0; c < worker->connections && !worker->failed; ++c) {
+            cffile_t *reply = cfclientreceive(clients[c]);
+            if (!reply) {
+                worker->failed = 1;
+                break;
+            }
+            worker->latencies[(size_t)round * worker->connections + c] = now_seconds() - sent[c];
+            worker->found += reply->header.entrycount;
+            cffreecfgfile(reply);
+        }
+    }
+
+    for (unsigned c = 0; c < worker->connections; ++c) {
+        cfclientclose(clients[c]);
+    }
+    free(clients);
+    free(sent);
+    free(keys);
+    free(names);
+    return NULL;
+}
+
+static void *run_server(void *server) {
+    return cfserverrun((cfserver_t*)server) ? server : NULL;
+}
+
+int main(int argc, char **argv) {
+    uint64_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    unsigned connections = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 1000;
+    unsigned threads = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 4;
+    unsigned batch = argc > 4 ? (unsigned)strtoul(argv[4], NULL, 10) : 16;
+    unsigned rounds = argc > 5 ? (unsigned)strtoul(argv[5], NULL, 10) : 100;
+    const char *path = argc > 6 ? argv[6] : "bench_server.sock";
+    const char *filename = "bench_server.bin";
+    if (count == 0 || connections == 0 || threads == 0 || batch == 0 || batch > 65535 || rounds == 0) {
+        fprintf(stderr, "Usage: bench_server [entrycount] [connections] [threads] [batch] [rounds] [socket]\n");
+        return 2;
+    }
+    if (threads > connections) {
+        threads = connections;
+    }
+
+    // Both ends of every connection may live in this process
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    cfserver_t *server = NULL;
+    pthread_t server_thread;
+    if (argc <= 6) {
+        cfwriter_t *writer = cfwriteropen(filename);
+        if (!writer) {
+            return 1;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            char key[__CONFIN_STRUCT_MAX_KEYLEN];
+            snprintf(key, sizeof(key), "service.key.%llu", (unsigned long long)i);
+            cfwriterappend(writer, key, CONFIN_ANNOTYPE_INT, &i, sizeof(i));
+        }
+        if (!cfwriterclose(writer)) {
+            return 1;
+        }
+        server = cfservercreate(path, &filename, 1);
+        if (!server || pthread_create(&server_thread, NULL, run_server, server) != 0) {
+            return 1;
+        }
+    }
+
+    worker_t *workers = (worker_t*)calloc(threads, sizeof(worker_t));
+    pthread_t *worker_threads = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    size_t samples = (size_t)rounds * connections;
+    double *latencies = (double*)malloc(sizeof(double) * samples);
+    if (!workers || !worker_threads || !latencies) {
+        return 1;
+    }
+    size_t offset = 0;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers[t].path = path;
+        workers[t].entrycount = count;
+        workers[t].connections = connections / threads + (t < connections % threads);
+        workers[t].batch = batch;
+        workers[t].rounds = rounds;
+        workers[t].seed = 0x9E3779B97F4A7C15ULL * (t + 1);
+        workers[t].latencies = latencies + offset;
+        offset += (size_t)rounds * workers[t].connections;
+    }
+
+    double start = now_seconds();
+    for (unsigned t = 0; t < threads; ++t) {
+        pthread_create(&worker_threads[t], NULL, run_worker, &workers[t]);
+    }
+    uint64_t found = 0;
+    int failed = 0;
+    for (unsigned t = 0; t < threads; ++t) {
+        pthread_join(worker_threads[t], NULL);
+        found += workers[t].found;
+        failed |= workers[t].failed;
+    }
+    double elapsed = now_seconds() - start;
+
+    if (server) {
+        cfserverstop(server);
+        pthread_join(server_thread, NULL);
+        cfserverfree(server);
+        remove(filename);
+    }
+    if (failed) {
+        fprintf(stderr, "A client failed\n");
+        return 1;
+    }
+
+    qsort(latencies, samples, sizeof(double), compare_doubles);
+    printf("%llu entries, %u connections on %u threads, %u keys per request, %u rounds\n",
+           (unsigned long long)count, connections, threads, batch, rounds);
+    printf("%.0f requests/s, %.0f keys/s (%llu found, connecting included)\n", (double)samples / elapsed,
+           (double)samples * batch / elapsed, (unsigned long long)found);
+    printf("latency p50 %.1f us, p99 %.1f us, p999 %.1f us, max %.1f us\n", latencies[samples / 2] * 1e6,
+           latencies[samples * 99 / 100] * 1e6, latencies[samples * 999 / 1000] * 1e6, latencies[samples - 1] * 1e6);
+
+    free(latencies);
+    free(workers);
+    free(worker_threads);
+    return 0;
+}
+
+#else // _WIN32
+
+int main(void) {
+    fprintf(stderr, "The configuration server is not supported on this platform\n");
+    (void)now_seconds;
+    (void)compare_doubles;
+    return 1;
+}
+
+#endif // _WIN32
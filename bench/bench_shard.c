@@ -0,0 +1,138 @@
+/**
+ * @file bench_shard.c
+ * @brief Startup of a host serving a few tenants: one file versus shards.
+ *
+ * Writes `tenants` tenants of `keys per tenant` keys each as one file and as a
+ * sharded configuration split by tenant, then looks up every key of `served`
+ * tenants after loading the whole file, and after loading only their shards.
+ * Reported are the time, the bytes of the files read and the entries held in
+ * memory. The files are in the page cache, so the times measure decoding.
+ *
+ * Usage: bench_shard [tenants] [keys per tenant] [shards] [served]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../confin/cfself.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static double file_megabytes(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return (double)size / (1024.0 * 1024.0);
+}
+
+static uint64_t lookup_served(cffile_t *config, cfsharded_t *sharded, uint64_t tenants, unsigned keys, unsigned served) {
+    uint64_t found = 0;
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    for (unsigned s = 0; s < served; ++s) {
+        uint64_t tenant = (uint64_t)s * (tenants / served);
+        for (unsigned k = 0; k < keys; ++k) {
+            snprintf(key, sizeof(key), "tenant%llu.limit%u", (unsigned long long)tenant, k);
+            found += (config ? cfget(config, key) : cfshardedget(sharded, key)) != NULL;
+        }
+    }
+    return found;
+}
+
+int main(int argc, char **argv) {
+    uint64_t tenants = argc > 1 ? strtoull(argv[1], NULL, 10) : 500000;
+    unsigned keys = argc > 2 ? (unsigned)strtoul(argv[2], NULL, 10) : 4;
+    unsigned shards = argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : 64;
+    unsigned served = argc > 4 ? (unsigned)strtoul(argv[4], NULL, 10) : 4;
+    const char *filename = "bench_shard.bin";
+    const char *manifest = "bench_shard.cfm";
+    if (tenants == 0 || keys == 0 || shards == 0 || served == 0 || served > tenants) {
+        fprintf(stderr, "Usage: bench_shard [tenants] [keys per tenant] [shards] [served]\n");
+        return 2;
+    }
+
+    cfwriter_t *writer = cfwriteropen(filename);
+    cfshardwriter_t *shardwriter = cfshardwriteropen(manifest, shards, CONFIN_SHARD_PREFIX);
+    if (!writer || !shardwriter) {
+        return 1;
+    }
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    for (uint64_t t = 0; t < tenants; ++t) {
+        for (unsigned k = 0; k < keys; ++k) {
+            uint64_t value = t * keys + k;
+            snprintf(key, sizeof(key), "tenant%llu.limit%u", (unsigned long long)t, k);
+            cfwriterappend(writer, key, CONFIN_ANNOTYPE_INT, &value, sizeof(value));
+            cfshardwriterappend(shardwriter, key, CONFIN_ANNOTYPE_INT, &value, sizeof(value));
+        }
+    }
+    if (!cfwriterclose(writer) || !cfshardwriterclose(shardwriter)) {
+        return 1;
+    }
+
+    double start = now_seconds();
+    cffile_t *config = cfreadcfg(filename);
+    if (!config) {
+        return 1;
+    }
+    uint64_t found = lookup_served(config, NULL, tenants, keys, served);
+    double whole = now_seconds() - start;
+    uint64_t whole_entries = config->header.entrycount;
+    double whole_megabytes = file_megabytes(filename);
+    cffreecfgfile(config);
+
+    start = now_seconds();
+    cfsharded_t *sharded = cfshardedopen(manifest);
+    if (!sharded) {
+        return 1;
+    }
+    for (unsigned s = 0; s < served; ++s) {
+        snprintf(key, sizeof(key), "tenant%llu", (unsigned long long)((uint64_t)s * (tenants / served)));
+        if (!cfshardedloadkey(sharded, key)) {
+            return 1;
+        }
+    }
+    uint64_t sharded_found = lookup_served(NULL, sharded, tenants, keys, served);
+    double partial = now_seconds() - start;
+    uint64_t sharded_entries = 0;
+    unsigned loaded = 0;
+    char shardname[__CONFIN_STRUCT_MAX_KEYLEN + 16];
+    double sharded_megabytes = file_megabytes(manifest);
+    for (unsigned i = 0; i < shards; ++i) {
+        cffile_t *shard = cfshardedshard(sharded, i);
+        if (shard) {
+            ++loaded;
+            sharded_entries += shard->header.entrycount;
+            snprintf(shardname, sizeof(shardname), "bench_shard.%u.bin", i);
+            sharded_megabytes += file_megabytes(shardname);
+        }
+    }
+    cfshardedclose(sharded);
+
+    if (found != sharded_found || found != (uint64_t)served * keys) {
+        fprintf(stderr, "Lookups disagree: %llu and %llu keys found\n", (unsigned long long)found,
+                (unsigned long long)sharded_found);
+        return 1;
+    }
+    printf("%llu tenants of %u keys, %u tenants served, %u shards\n", (unsigned long long)tenants, keys, served, shards);
+    printf("one file:   %8.1f ms  %8.1f MB read  %10llu entries in memory\n", whole * 1e3, whole_megabytes,
+           (unsigned long long)whole_entries);
+    printf("%2u shards:  %8.1f ms  %8.1f MB read  %10llu entries in memory  (%.1fx faster)\n", loaded, partial * 1e3,
+           sharded_megabytes, (unsigned long long)sharded_entries, whole / partial);
+
+    remove(filename);
+    remove(manifest);
+    for (unsigned i = 0; i < shards; ++i) {
+        snprintf(shardname, sizeof(shardname), "bench_shard.%u.bin", i);
+        remove(shardname);
+    }
+    return 0;
+}
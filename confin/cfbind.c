@@ -0,0 +1,224 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfbind.h" // confin/cfbind.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Reads a signed integer of 1, 2, 4 or 8 bytes.
+ */
+static int64_t confin_load_int(const void *value, uint64_t size) {
+    switch (size) {
+        case 1: { int8_t v; memcpy(&v, value, sizeof(v)); return v; }
+        case 2: { int16_t v; memcpy(&v, value, sizeof(v)); return v; }
+        case 4: { int32_t v; memcpy(&v, value, sizeof(v)); return v; }
+        default: { int64_t v; memcpy(&v, value, sizeof(v)); return v; }
+    }
+}
+
+/**
+ * @brief Stores an integer into a field of 1, 2, 4 or 8 bytes.
+ *
+ * Values that fit the signed or unsigned range of the field are accepted.
+ *
+ * @return false if the value does not fit.
+ */
+static bool confin_store_int(unsigned char *field, size_t size, int64_t value) {
+    if (size < 8) {
+        int64_t low = -((int64_t)1 << (size * 8 - 1));
+        int64_t high = ((int64_t)1 << (size * 8)) - 1;
+        if (value < low || value > high) {
+            return false;
+        }
+    }
+    uint64_t bits = (uint64_t)value;
+    switch (size) {
+        case 1: { uint8_t v = (uint8_t)bits; memcpy(field, &v, sizeof(v)); break; }
+        case 2: { uint16_t v = (uint16_t)bits; memcpy(field, &v, sizeof(v)); break; }
+        case 4: { uint32_t v = (uint32_t)bits; memcpy(field, &v, sizeof(v)); break; }
+        default: memcpy(field, &bits, sizeof(bits)); break;
+    }
+    return true;
+}
+
+static bool confin_is_scalar_size(uint64_t size, bool floating) {
+    return floating ? size == 4 || size == 8 : size == 1 || size == 2 || size == 4 || size == 8;
+}
+
+/**
+ * @brief Copies an entry into its field, converting between widths.
+ */
+static cfbindstatus_t confin_bind_field(const cfentry_t *entry, const cfbinding_t *binding, unsigned char *field) {
+    const void *value = CF_ENTRYVAL(entry);
+    if (entry->type != binding->type) {
+        return CONFIN_BIND_MISTYPED;
+    }
+
+    switch (entry->type) {
+        case CONFIN_ANNOTYPE_INT:
+            if (!confin_is_scalar_size(entry->size, false) || !confin_is_scalar_size(binding->size, false)) {
+                return CONFIN_BIND_MISTYPED;
+            }
+            return confin_store_int(field, binding->size, confin_load_int(value, entry->size)) ? CONFIN_BIND_OK : CONFIN_BIND_MISTYPED;
+        case CONFIN_ANNOTYPE_FLOAT: {
+            if (!confin_is_scalar_size(entry->size, true) || !confin_is_scalar_size(binding->size, true)) {
+                return CONFIN_BIND_MISTYPED;
+            }
+            double number;
+            if (entry->size == sizeof(float)) {
+                float narrow;
+                memcpy(&narrow, value, sizeof(narrow));
+                number = narrow;
+            } else {
+                memcpy(&number, value, sizeof(number));
+            }
+            if (binding->size == sizeof(float)) {
+                float narrow = (float)number;
+                memcpy(field, &narrow, sizeof(narrow));
+            } else {
+                memcpy(field, &number, sizeof(number));
+            }
+            return CONFIN_BIND_OK;
+        }
+        case CONFIN_ANNOTYPE_STRING: {
+            const char *end = (const char*)memchr(value, '\0', (size_t)entry->size);
+            size_t length = end ? (size_t)(end - (const char*)value) : (size_t)entry->size;
+            if (length + 1 > binding->size) {
+                return CONFIN_BIND_MISTYPED;
+            }
+            memcpy(field, value, length);
+            field[length] = '\0';
+            return CONFIN_BIND_OK;
+        }
+        default:
+            if (entry->size != binding->size) {
+                return CONFIN_BIND_MISTYPED;
+            }
+            memcpy(field, value, binding->size);
+            return CONFIN_BIND_OK;
+    }
+}
+
+/**
+ * @brief Computes the key hashes of a descriptor table.
+ * @param bindings The descriptors.
+ * @param count The number of descriptors.
+ */
+void confin_bind_prepare(cfbinding_t *bindings, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        bindings[i].hash = confin_hash_key(bindings[i].key);
+    }
+}
+
+/**
+ * @brief Fills a structure from a configuration in a single pass over its entries.
+ * @param config Pointer to the configuration.
+ * @param bindings The descriptors.
+ * @param count The number of descriptors.
+ * @param target The structure to fill.
+ * @param status Receives the outcome of each descriptor, may be NULL.
+ * @return true if every key was bound or defaulted, false otherwise.
+ */
+bool confin_bind(const cffile_t *config, const cfbinding_t *bindings, size_t count, void *target, cfbindstatus_t *status) {
+    cfallocator_t allocator = config->allocator;
+
+    // Open-addressing table over the descriptors: slot holds (descriptor index + 1)
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity <<= 1;
+    }
+    size_t mask = capacity - 1;
+    size_t bytes = sizeof(uint64_t) * capacity + sizeof(uint32_t) * capacity + sizeof(unsigned char) * count;
+    unsigned char *memory = (unsigned char*)confin_alloc(&allocator, bytes);
+    if (!memory) {
+        perror("malloc");
+        return false;
+    }
+    memset(memory, 0, bytes);
+    uint64_t *hashes = (uint64_t*)memory;
+    uint32_t *slots = (uint32_t*)(hashes + capacity);
+    unsigned char *found = (unsigned char*)(slots + capacity);
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t hash = bindings[i].hash ? bindings[i].hash : confin_hash_key(bindings[i].key);
+        size_t slot = (size_t)hash & mask;
+        while (slots[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        hashes[slot] = hash;
+        slots[slot] = (uint32_t)(i + 1);
+    }
+
+    unsigned char *base = (unsigned char*)target;
+    size_t remaining = count;
+    bool ok = true;
+    for (uint64_t e = 0; e < config->header.entrycount && remaining; ++e) {
+        const cfentry_t *entry = &config->entries[e];
+        uint64_t hash = confin_hash_key(entry->key);
+        for (size_t slot = (size_t)hash & mask; slots[slot]; slot = (slot + 1) & mask) {
+            size_t i = slots[slot] - 1;
+            if (hashes[slot] != hash || found[i] ||
+                strncmp(entry->key, bindings[i].key, __CONFIN_STRUCT_MAX_KEYLEN) != 0) {
+                continue;
+            }
+            found[i] = 1;
+            --remaining;
+
+            cfbindstatus_t result = confin_bind_field(entry, &bindings[i], base + bindings[i].offset);
+            if (result == CONFIN_BIND_MISTYPED) {
+                ok = false;
+                if (bindings[i].defvalue) {
+                    memcpy(base + bindings[i].offset, bindings[i].defvalue, bindings[i].size);
+                }
+            }
+            if (status) {
+                status[i] = result;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count && remaining; ++i) {
+        if (found[i]) {
+            continue;
+        }
+        cfbindstatus_t result = CONFIN_BIND_MISSING;
+        if (bindings[i].defvalue) {
+            memcpy(base + bindings[i].offset, bindings[i].defvalue, bindings[i].size);
+            result = CONFIN_BIND_DEFAULT;
+        } else {
+            ok = false;
+        }
+        if (status) {
+            status[i] = result;
+        }
+    }
+
+    confin_free(&allocator, memory);
+    return ok;
+}
+
+/**
+ * @brief Gets the printable name of a binding outcome.
+ * @param status The outcome.
+ * @return The name, such as "missing".
+ */
+const char *confin_bind_status_name(cfbindstatus_t status) {
+    switch (status) {
+        case CONFIN_BIND_OK: return "ok";
+        case CONFIN_BIND_DEFAULT: return "default";
+        case CONFIN_BIND_MISSING: return "missing";
+        case CONFIN_BIND_MISTYPED: return "mistyped";
+        default: return "unknown";
+    }
+}
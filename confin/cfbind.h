@@ -0,0 +1,114 @@
+/**
+ * @file cfbind.h
+ * @brief Functions and macros for binding a configuration into a user structure.
+ * 
+ * This header file provides the binder. A static table of descriptors names the key,
+ * expected type, offset, size and default value of every field of a settings
+ * structure, and @ref confin_bind fills the structure in a single pass over the
+ * entries. Keys are matched by their precomputed 64-bit hash, without string
+ * comparisons.
+ * 
+ * Integers and floats are converted between widths (a 4-byte INT entry binds to an
+ * `int64_t` field, an 8-byte one to an `int32_t` field when the value fits), strings
+ * are copied into `char` arrays including the NUL terminator and structures must
+ * match the field size exactly.
+ */
+
+#ifndef _CONFIN_BIND_H
+#define _CONFIN_BIND_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#include <stddef.h>
+#else
+#include <cstddef>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def CONFIN_BINDING
+ * @brief Macro to build the descriptor of a structure member.
+ * @param Type The target structure type.
+ * @param Member The member of `Type` to fill.
+ * @param Key The key of the entry.
+ * @param AnnoType The expected `cfannotype_t` of the entry.
+ * @param Default Pointer to the default value, or NULL.
+ */
+#define CONFIN_BINDING(Type, Member, Key, AnnoType, Default) \
+    { (Key), (AnnoType), offsetof(Type, Member), sizeof(((Type*)0)->Member), (Default), 0 }
+
+/**
+ * @def cfbindprepare
+ * @brief Macro to compute the key hashes of a descriptor table.
+ * @param bindings The descriptors.
+ * @param count The number of descriptors.
+ */
+#define cfbindprepare(bindings, count) confin_bind_prepare(bindings, count)
+
+/**
+ * @brief Computes the key hashes of a descriptor table.
+ * 
+ * Call it once for a static table; @ref confin_bind hashes the keys of
+ * descriptors that were not prepared on every call.
+ * 
+ * @param bindings The descriptors.
+ * @param count The number of descriptors.
+ */
+void confin_bind_prepare(cfbinding_t *bindings, size_t count);
+
+/**
+ * @def cfbind
+ * @brief Macro to fill a structure from a configuration.
+ * @param config Pointer to the configuration.
+ * @param bindings The descriptors.
+ * @param count The number of descriptors.
+ * @param target The structure to fill.
+ * @param status Receives the outcome of each descriptor, may be NULL.
+ * @return true if every key was bound or defaulted, false otherwise.
+ */
+#define cfbind(config, bindings, count, target, status) \
+    confin_bind(config, bindings, count, target, status)
+
+/**
+ * @brief Fills a structure from a configuration in a single pass over its entries.
+ * 
+ * Descriptors whose key is absent get their default value, or are left untouched
+ * without one. When a key appears several times, the first entry is bound. Keys
+ * are found by hash and then compared. The descriptor table is allocated with the
+ * allocator of the configuration.
+ * 
+ * @param config Pointer to the configuration.
+ * @param bindings The descriptors.
+ * @param count The number of descriptors.
+ * @param target The structure to fill.
+ * @param status Receives the outcome of each descriptor (`count` elements), may be NULL.
+ * @return true if every key was bound or defaulted, false if a key is missing
+ *         without a default, mistyped, or memory could not be allocated.
+ */
+bool confin_bind(const cffile_t *config, const cfbinding_t *bindings, size_t count, void *target, cfbindstatus_t *status);
+
+/**
+ * @def cfbindstatusname
+ * @brief Macro to get the printable name of a binding outcome.
+ * @param status The outcome.
+ * @return The name, such as "missing".
+ */
+#define cfbindstatusname(status) confin_bind_status_name(status)
+
+/**
+ * @brief Gets the printable name of a binding outcome.
+ * @param status The outcome.
+ * @return The name, such as "missing".
+ */
+const char *confin_bind_status_name(cfbindstatus_t status);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_BIND_H
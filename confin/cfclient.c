@@ -0,0 +1,361 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#define CONFIN_CLIENT_SOCKETS 1
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfutils.h" // confin/cfutils.h
+#include "cfclient.h" // confin/cfclient.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+#ifdef CONFIN_CLIENT_SOCKETS
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct __s_confin_client {
+    int fd;                    /**< Connected socket */
+    uint32_t sent;             /**< Number of the last request sent */
+    uint32_t received;         /**< Number of the last reply received */
+    cfallocator_t allocator;   /**< Allocator of the client and of the replies */
+};
+
+static bool confin_send_all(int fd, const char *data, size_t size) {
+    while (size) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("send");
+            return false;
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+static bool confin_receive_all(int fd, void *buffer, size_t size) {
+    char *data = (char*)buffer;
+    while (size) {
+        ssize_t received = recv(fd, data, size, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("recv");
+            return false;
+        }
+        if (received == 0) {
+            fprintf(stderr, "Connection closed by the server\n");
+            return false;
+        }
+        data += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+/**
+ * @brief Connects to a configuration server.
+ * @param path The path of the socket of the server.
+ * @return Pointer to the client, or NULL on failure.
+ */
+cfclient_t *confin_client_connect(const char *path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path '%s' is too long\n", path);
+        return NULL;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path, strlen(path));
+
+    cfallocator_t allocator = confin_resolve_allocator(NULL);
+    cfclient_t *client = (cfclient_t*)confin_alloc(&allocator, sizeof(cfclient_t));
+    if (!client) {
+        perror("malloc");
+        return NULL;
+    }
+    client->sent = 0;
+    client->received = 0;
+    client->allocator = allocator;
+    client->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client->fd < 0 || connect(client->fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        perror("connect");
+        if (client->fd >= 0) {
+            close(client->fd);
+        }
+        confin_free(&allocator, client);
+        return NULL;
+    }
+    return client;
+}
+
+static void confin_put_string(char **cursor, const char *string, size_t length) {
+    uint16_t prefix = (uint16_t)length;
+    memcpy(*cursor, &prefix, sizeof(prefix));
+    memcpy(*cursor + sizeof(prefix), string, length);
+    *cursor += sizeof(prefix) + length;
+}
+
+/**
+ * @brief Sends a request without waiting for the reply.
+ * @param client Pointer to the client.
+ * @param op The operation.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param keys The keys, or the prefix for @ref CONFIN_REQUEST_PREFIX.
+ * @param count The number of keys, at most 65535; 1 for @ref CONFIN_REQUEST_PREFIX.
+ * @return true on success, false on failure.
+ */
+bool confin_client_send(cfclient_t *client, cfrequestop_t op, const char *config, const char **keys, size_t count) {
+    if (count > UINT16_MAX) {
+        fprintf(stderr, "A request holds at most %u keys\n", (unsigned)UINT16_MAX);
+        return false;
+    }
+    if (!config) {
+        config = "";
+    }
+    size_t size = sizeof(uint16_t) + strlen(config);
+    for (size_t i = 0; i < count; ++i) {
+        size_t length = strlen(keys[i]);
+        if (length > UINT16_MAX) {
+            fprintf(stderr, "Key is too long\n");
+            return false;
+        }
+        size += sizeof(uint16_t) + length;
+    }
+    if (strlen(config) > UINT16_MAX || size > __CONFIN_SERVER_MAX_REQUEST) {
+        fprintf(stderr, "Request is too large\n");
+        return false;
+    }
+
+    cfrequesthdr_t request;
+    request.size = (uint32_t)size;
+    request.id = client->sent + 1;
+    request.op = (uint16_t)op;
+    request.count = (uint16_t)count;
+    char *frame = (char*)confin_alloc(&client->allocator, sizeof(request) + size);
+    if (!frame) {
+        perror("malloc");
+        return false;
+    }
+    memcpy(frame, &request, sizeof(request));
+    char *cursor = frame + sizeof(request);
+    confin_put_string(&cursor, config, strlen(config));
+    for (size_t i = 0; i < count; ++i) {
+        confin_put_string(&cursor, keys[i], strlen(keys[i]));
+    }
+    bool ok = confin_send_all(client->fd, frame, sizeof(request) + size);
+    confin_free(&client->allocator, frame);
+    if (ok) {
+        ++client->sent;
+    }
+    return ok;
+}
+
+// Walks the items of a reply body; fills the entries when config is not NULL
+static bool confin_reply_walk(char *body, uint64_t size, uint32_t count, cffile_t *config, uint64_t *found) {
+    uint64_t offset = 0;
+    *found = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        cfreplyitem_t item;
+        if (size - offset < sizeof(item)) {
+            return false;
+        }
+        memcpy(&item, body + offset, sizeof(item));
+        offset += sizeof(item);
+        uint64_t keyspan = (item.keylength + __CONFIN_POOL_ALIGN - 1) / __CONFIN_POOL_ALIGN * __CONFIN_POOL_ALIGN;
+        if (size - offset < keyspan || item.size > size - offset - keyspan) {
+            return false;
+        }
+        const char *key = body + offset;
+        char *value = body + offset + keyspan;
+        offset += keyspan + (item.size + __CONFIN_POOL_ALIGN - 1) / __CONFIN_POOL_ALIGN * __CONFIN_POOL_ALIGN;
+        if (offset > size) {
+            return false;
+        }
+        if (item.flags & CONFIN_REPLY_MISSING) {
+            continue;
+        }
+        if (item.keylength >= __CONFIN_STRUCT_MAX_KEYLEN) {
+            return false;
+        }
+        if (config) {
+            cfentry_t *entry = &config->entries[*found];
+            memset(entry->key, 0, sizeof(entry->key));
+            memcpy(entry->key, key, item.keylength);
+            entry->type = (cfannotype_t)item.type;
+            entry->size = item.size;
+            // Values that do not fit inline stay in the reply, which becomes the pool
+            if (item.size <= __CONFIN_INLINE_VALUE_MAX) {
+                entry->flags = CONFIN_ENTRY_INLINE;
+                entry->value = entry->inlinevalue;
+                memcpy(entry->inlinevalue, value, (size_t)item.size);
+            } else {
+                entry->flags = CONFIN_ENTRY_SHARED;
+                entry->value = value;
+            }
+            ++config->header.entrycount;
+        }
+        ++*found;
+    }
+    return offset == size;
+}
+
+/**
+ * @brief Waits for the reply to the oldest request sent.
+ * @param client Pointer to the client.
+ * @return Pointer to the entries of the reply, or NULL on failure or if the
+ *         server did not serve the request.
+ */
+cffile_t *confin_client_receive(cfclient_t *client) {
+    cfreplyhdr_t reply;
+    if (!confin_receive_all(client->fd, &reply, sizeof(reply))) {
+        return NULL;
+    }
+    char *body = NULL;
+    if (reply.size) {
+        body = (char*)confin_alloc(&client->allocator, reply.size);
+        if (!body) {
+            perror("malloc");
+            return NULL;
+        }
+        if (!confin_receive_all(client->fd, body, reply.size)) {
+            confin_free(&client->allocator, body);
+            return NULL;
+        }
+    }
+    ++client->received;
+    if (reply.id != client->received) {
+        fprintf(stderr, "Reply %u does not match request %u\n", reply.id, client->received);
+        confin_free(&client->allocator, body);
+        return NULL;
+    }
+    if (reply.status != CONFIN_REPLY_OK) {
+        static const char *const reasons[] = {"ok", "malformed request", "unknown configuration", "reply too large"};
+        fprintf(stderr, "Request %u failed: %s\n", reply.id,
+                reply.status < sizeof(reasons) / sizeof(reasons[0]) ? reasons[reply.status] : "unknown status");
+        confin_free(&client->allocator, body);
+        return NULL;
+    }
+
+    uint64_t found;
+    if (!confin_reply_walk(body, reply.size, reply.count, NULL, &found)) {
+        fprintf(stderr, "Reply %u is malformed\n", reply.id);
+        confin_free(&client->allocator, body);
+        return NULL;
+    }
+    cffile_t *config = confin_alloc_config(&client->allocator, found);
+    if (!config) {
+        confin_free(&client->allocator, body);
+        return NULL;
+    }
+    config->pool = body;
+    confin_reply_walk(body, reply.size, reply.count, config, &found);
+    return config;
+}
+
+/**
+ * @brief Looks up several keys.
+ * @param client Pointer to the client.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param keys The keys to find.
+ * @param count The number of keys, at most 65535.
+ * @return Pointer to the entries found, in the order of the keys, or NULL on failure.
+ */
+cffile_t *confin_client_get(cfclient_t *client, const char *config, const char **keys, size_t count) {
+    if (!confin_client_send(client, CONFIN_REQUEST_GET, config, keys, count)) {
+        return NULL;
+    }
+    return confin_client_receive(client);
+}
+
+/**
+ * @brief Lists the entries whose key starts with a prefix.
+ * @param client Pointer to the client.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param prefix The prefix; an empty prefix lists every entry.
+ * @return Pointer to the entries found, ordered by key, or NULL on failure.
+ */
+cffile_t *confin_client_prefix(cfclient_t *client, const char *config, const char *prefix) {
+    if (!confin_client_send(client, CONFIN_REQUEST_PREFIX, config, &prefix, 1)) {
+        return NULL;
+    }
+    return confin_client_receive(client);
+}
+
+/**
+ * @brief Closes a connection to a configuration server and frees the client.
+ * @param client Pointer to the client; NULL is ignored.
+ */
+void confin_client_close(cfclient_t *client) {
+    if (!client) {
+        return;
+    }
+    cfallocator_t allocator = client->allocator;
+    close(client->fd);
+    confin_free(&allocator, client);
+}
+
+#else // CONFIN_CLIENT_SOCKETS
+
+cfclient_t *confin_client_connect(const char *path) {
+    (void)path;
+    fprintf(stderr, "The configuration client is not supported on this platform\n");
+    return NULL;
+}
+
+bool confin_client_send(cfclient_t *client, cfrequestop_t op, const char *config, const char **keys, size_t count) {
+    (void)client;
+    (void)op;
+    (void)config;
+    (void)keys;
+    (void)count;
+    return false;
+}
+
+cffile_t *confin_client_receive(cfclient_t *client) {
+    (void)client;
+    return NULL;
+}
+
+cffile_t *confin_client_get(cfclient_t *client, const char *config, const char **keys, size_t count) {
+    (void)client;
+    (void)config;
+    (void)keys;
+    (void)count;
+    return NULL;
+}
+
+cffile_t *confin_client_prefix(cfclient_t *client, const char *config, const char *prefix) {
+    (void)client;
+    (void)config;
+    (void)prefix;
+    return NULL;
+}
+
+void confin_client_close(cfclient_t *client) {
+    (void)client;
+}
+
+#endif // CONFIN_CLIENT_SOCKETS
@@ -0,0 +1,147 @@
+/**
+ * @file cfclient.h
+ * @brief Functions and macros for querying a configuration server.
+ *
+ * This header file provides the client of the server declared in `cfserver.h`.
+ * The entries of a reply are returned as a configuration file structure whose
+ * values point into the reply, so they are read with the usual functions and
+ * freed with `confin_free_config_file`.
+ *
+ * Requests can be pipelined: @ref confin_client_send may be called several times
+ * before the replies are read, in order, with @ref confin_client_receive. A client
+ * must not be used by several threads at once. The client is not available on
+ * Windows.
+ */
+
+#ifndef _CONFIN_CLIENT_H
+#define _CONFIN_CLIENT_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfclientconnect
+ * @brief Macro to connect to a configuration server.
+ * @param path The path of the socket of the server.
+ * @return Pointer to the client, or NULL on failure.
+ */
+#define cfclientconnect(path) confin_client_connect(path)
+
+/**
+ * @brief Connects to a configuration server.
+ * @param path The path of the socket of the server.
+ * @return Pointer to the client, or NULL on failure.
+ */
+cfclient_t *confin_client_connect(const char *path);
+
+/**
+ * @def cfclientsend
+ * @brief Macro to send a request without waiting for the reply.
+ * @param client Pointer to the client.
+ * @param op The operation.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param keys The keys, or the prefix for @ref CONFIN_REQUEST_PREFIX.
+ * @param count The number of keys.
+ * @return true on success, false on failure.
+ */
+#define cfclientsend(client, op, config, keys, count) confin_client_send(client, op, config, keys, count)
+
+/**
+ * @brief Sends a request without waiting for the reply.
+ * @param client Pointer to the client.
+ * @param op The operation.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param keys The keys, or the prefix for @ref CONFIN_REQUEST_PREFIX.
+ * @param count The number of keys, at most 65535; 1 for @ref CONFIN_REQUEST_PREFIX.
+ * @return true on success, false on failure.
+ */
+bool confin_client_send(cfclient_t *client, cfrequestop_t op, const char *config, const char **keys, size_t count);
+
+/**
+ * @def cfclientreceive
+ * @brief Macro to wait for the reply to the oldest request sent.
+ * @param client Pointer to the client.
+ * @return Pointer to the entries of the reply, or NULL on failure.
+ */
+#define cfclientreceive(client) confin_client_receive(client)
+
+/**
+ * @brief Waits for the reply to the oldest request sent.
+ *
+ * Keys that are not present are left out, so the result may have fewer entries
+ * than the request had keys; the found entries are in the order of the request.
+ *
+ * @param client Pointer to the client.
+ * @return Pointer to the entries of the reply, or NULL on failure or if the
+ *         server did not serve the request.
+ */
+cffile_t *confin_client_receive(cfclient_t *client);
+
+/**
+ * @def cfclientget
+ * @brief Macro to look up several keys.
+ * @param client Pointer to the client.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param keys The keys to find.
+ * @param count The number of keys.
+ * @return Pointer to the entries found, or NULL on failure.
+ */
+#define cfclientget(client, config, keys, count) confin_client_get(client, config, keys, count)
+
+/**
+ * @brief Looks up several keys.
+ * @param client Pointer to the client.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param keys The keys to find.
+ * @param count The number of keys, at most 65535.
+ * @return Pointer to the entries found, in the order of the keys, or NULL on failure.
+ */
+cffile_t *confin_client_get(cfclient_t *client, const char *config, const char **keys, size_t count);
+
+/**
+ * @def cfclientprefix
+ * @brief Macro to list the entries whose key starts with a prefix.
+ * @param client Pointer to the client.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param prefix The prefix.
+ * @return Pointer to the entries found, or NULL on failure.
+ */
+#define cfclientprefix(client, config, prefix) confin_client_prefix(client, config, prefix)
+
+/**
+ * @brief Lists the entries whose key starts with a prefix.
+ * @param client Pointer to the client.
+ * @param config The name of the configuration, or NULL for the first one.
+ * @param prefix The prefix; an empty prefix lists every entry.
+ * @return Pointer to the entries found, ordered by key, or NULL on failure.
+ */
+cffile_t *confin_client_prefix(cfclient_t *client, const char *config, const char *prefix);
+
+/**
+ * @def cfclientclose
+ * @brief Macro to close a connection to a configuration server.
+ * @param client Pointer to the client.
+ */
+#define cfclientclose(client) confin_client_close(client)
+
+/**
+ * @brief Closes a connection to a configuration server and frees the client.
+ * @param client Pointer to the client; NULL is ignored.
+ */
+void confin_client_close(cfclient_t *client);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_CLIENT_H
@@ -0,0 +1,674 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfcompact.h" // confin/cfcompact.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Longest key of a compact configuration, without its terminator.
+ */
+#define CONFIN_COMPACT_MAX_KEY (__CONFIN_STRUCT_MAX_KEYLEN - 1)
+
+/**
+ * @brief Number of heads between two fences; their 512 bytes are prefetched at once.
+ */
+#define CONFIN_COMPACT_FENCE 64
+
+/**
+ * @brief Position of the first key and of the first value of a block.
+ */
+typedef struct {
+    uint64_t keys;             /**< Offset of the first key record of the block */
+    uint64_t values;           /**< Offset of the value of that record */
+} confin_compact_block_t;
+
+/**
+ * @brief Key record being decoded.
+ *
+ * A record is the length of the prefix shared with the previous key (one byte),
+ * the length of the rest (one byte), the rest, the type (one byte) and the size
+ * of the value as a LEB128 varint. The first record of a block shares nothing.
+ */
+typedef struct {
+    const unsigned char *cursor; /**< Next record */
+    char key[__CONFIN_STRUCT_MAX_KEYLEN]; /**< Key of the current record */
+    size_t length;             /**< Length of the key of the current record */
+    uint32_t type;             /**< Type of the current value */
+    uint64_t size;             /**< Size of the current value */
+    uint64_t value;            /**< Offset of the current value */
+    uint64_t next;             /**< Offset of the next value */
+} confin_compact_cursor_t;
+
+struct __s_confin_compact {
+    cfallocator_t allocator;   /**< Allocator of this structure and of the data */
+    void *data;                /**< Block index, keys and values in one allocation */
+    uint64_t count;            /**< Number of entries */
+    uint64_t blockcount;       /**< Number of blocks */
+    uint64_t keybytes;         /**< Size of the key records */
+    uint64_t valuebytes;       /**< Size of the values */
+    const confin_compact_block_t *blocks; /**< Start of every block */
+    uint64_t *heads;           /**< Eight bytes of the first key of every block, after the common prefix, big-endian */
+    uint64_t *fences;          /**< Every CONFIN_COMPACT_FENCE-th head, small enough to stay in the cache */
+    uint64_t fencecount;       /**< Number of fences */
+    char prefix[__CONFIN_STRUCT_MAX_KEYLEN]; /**< Prefix shared by every key */
+    size_t prefixlength;       /**< Length of the shared prefix */
+    const unsigned char *keys; /**< Key records */
+    const unsigned char *values; /**< Values in key order, each aligned to __CONFIN_POOL_ALIGN */
+};
+
+static uint64_t confin_value_span(uint64_t size) {
+    return (size + __CONFIN_POOL_ALIGN - 1) / __CONFIN_POOL_ALIGN * __CONFIN_POOL_ALIGN;
+}
+
+static size_t confin_varint_size(uint64_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+static int confin_compare_entries(const void *a, const void *b) {
+    const cfentry_t *left = *(const cfentry_t *const*)a;
+    const cfentry_t *right = *(const cfentry_t *const*)b;
+    int order = strncmp(left->key, right->key, CONFIN_COMPACT_MAX_KEY);
+    // Repeated keys stay in file order, so the first one is kept
+    return order ? order : (left > right) - (left < right);
+}
+
+// Orders keys as strcmp does
+static int confin_compare_keys(const char *left, size_t leftlength, const char *right, size_t rightlength) {
+    int order = memcmp(left, right, leftlength < rightlength ? leftlength : rightlength);
+    return order ? order : (leftlength > rightlength) - (leftlength < rightlength);
+}
+
+// Eight bytes of a key from the end of the common prefix, so that comparing heads orders keys
+static uint64_t confin_key_head(const char *key, size_t length, size_t prefixlength) {
+    uint64_t head = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        size_t at = prefixlength + i;
+        head = (head << 8) | (at < length ? (unsigned char)key[at] : 0);
+    }
+    return head;
+}
+
+// First position in [low, high) whose value is above `value`, or not below it if `strict` is false
+static uint64_t confin_bound(const uint64_t *values, uint64_t low, uint64_t high, uint64_t value, bool strict) {
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (strict ? values[middle] <= value : values[middle] < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* records */
+
+static void confin_cursor_start(confin_compact_cursor_t *cursor, const cfcompact_t *compact, uint64_t block) {
+    cursor->cursor = compact->keys + compact->blocks[block].keys;
+    cursor->length = 0;
+    cursor->next = compact->blocks[block].values;
+}
+
+static void confin_cursor_next(confin_compact_cursor_t *cursor) {
+    const unsigned char *record = cursor->cursor;
+    size_t shared = record[0];
+    size_t suffix = record[1];
+    memcpy(cursor->key + shared, record + 2, suffix);
+    cursor->length = shared + suffix;
+    cursor->key[cursor->length] = '\0';
+    record += 2 + suffix;
+    cursor->type = *record++;
+    uint64_t size = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        unsigned char byte = *record++;
+        size |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+    cursor->cursor = record;
+    cursor->size = size;
+    cursor->value = cursor->next;
+    cursor->next += confin_value_span(size);
+}
+
+// Checks one record before it is decoded: it fits in the data and its key follows the previous one
+static bool confin_cursor_check(const confin_compact_cursor_t *cursor, const unsigned char *end, bool first, bool previous) {
+    const unsigned char *record = cursor->cursor;
+    if (end - record < 3) {
+        return false;
+    }
+    size_t shared = record[0];
+    size_t suffix = record[1];
+    if ((first ? shared != 0 : shared > cursor->length) || shared + suffix > CONFIN_COMPACT_MAX_KEY ||
+        (size_t)(end - record) < 3 + suffix || memchr(record + 2, '\0', suffix)) {
+        return false;
+    }
+    const unsigned char *size = record + 3 + suffix;
+    for (unsigned i = 0;; ++i) {
+        if (size + i >= end || i == 10) {
+            return false;
+        }
+        if (!(size[i] & 0x80)) {
+            break;
+        }
+    }
+    // Keys are strictly increasing, so the binary search over blocks is sound
+    if (!previous) {
+        return true;
+    }
+    if (first) {
+        return confin_compare_keys((const char*)record + 2, suffix, cursor->key, cursor->length) > 0;
+    }
+    return suffix && (shared == cursor->length || record[2] > (unsigned char)cursor->key[shared]);
+}
+
+// Finds the position of a key and decodes its record into cursor
+static uint64_t confin_compact_locate(const cfcompact_t *compact, const char *key, confin_compact_cursor_t *cursor) {
+    size_t length = strlen(key);
+    if (compact->count == 0 || length > CONFIN_COMPACT_MAX_KEY) {
+        return UINT64_MAX;
+    }
+
+    // Every key starts with the common prefix
+    if (length < compact->prefixlength || memcmp(key, compact->prefix, compact->prefixlength) != 0) {
+        return UINT64_MAX;
+    }
+
+    // Blocks whose head is below the one of the key start with a smaller key, and
+    // blocks whose head is above it with a greater one; the heads are searched
+    // first since they are dense, then the first keys of the blocks with an equal head
+    uint64_t head = confin_key_head(key, length, compact->prefixlength);
+    uint64_t fence = confin_bound(compact->fences, 0, compact->fencecount, head, false);
+    uint64_t low = fence ? (fence - 1) * CONFIN_COMPACT_FENCE : 0;
+    uint64_t high = fence * CONFIN_COMPACT_FENCE < compact->blockcount ? fence * CONFIN_COMPACT_FENCE : compact->blockcount;
+    for (uint64_t i = low; i < high; i += 64 / sizeof(uint64_t)) {
+        CONFIN_PREFETCH(&compact->heads[i]);
+    }
+    for (uint64_t i = low; i < high; i += 64 / sizeof(confin_compact_block_t)) {
+        CONFIN_PREFETCH(&compact->blocks[i]);
+    }
+    uint64_t equal = confin_bound(compact->heads, low, high, head, false);
+
+    // Blocks with an equal head are usually few; gallop over them
+    uint64_t step = 1;
+    low = equal;
+    while (low + step < compact->blockcount && compact->heads[low + step] <= head) {
+        low += step;
+        step *= 2;
+    }
+    high = low + step < compact->blockcount ? low + step : compact->blockcount;
+    low = confin_bound(compact->heads, low, high, head, true);
+
+    // Last block whose first key is not greater than the key
+    high = low;
+    low = equal ? equal - 1 : 0;
+    if (high - low <= CONFIN_COMPACT_FENCE / 8) {
+        for (uint64_t i = low + 1; i < high; ++i) {
+            CONFIN_PREFETCH(compact->keys + compact->blocks[i].keys);
+        }
+    }
+    while (high - low > 1) {
+        uint64_t middle = low + (high - low) / 2;
+        const unsigned char *first = compact->keys + compact->blocks[middle].keys;
+        if (confin_compare_keys((const char*)first + 2, first[1], key, length) <= 0) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Scans the block knowing only how much of the key the previous record matched:
+    // a record sharing more with the previous one is still smaller than the key, a
+    // record sharing less is greater, and only the others are compared
+    uint64_t base = low * __CONFIN_COMPACT_BLOCK;
+    uint64_t records = compact->count - base < __CONFIN_COMPACT_BLOCK ? compact->count - base : __CONFIN_COMPACT_BLOCK;
+    const unsigned char *record = compact->keys + compact->blocks[low].keys;
+    uint64_t value = compact->blocks[low].values;
+    CONFIN_PREFETCH(compact->values + value);
+    CONFIN_PREFETCH(compact->values + value + 64);
+    size_t matched = 0;
+    for (uint64_t i = 0; i < records; ++i) {
+        size_t shared = record[0];
+        size_t suffix = record[1];
+        const unsigned char *rest = record + 2;
+        record += 2 + suffix;
+        uint32_t type = *record++;
+        uint64_t size = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            unsigned char byte = *record++;
+            size |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        if (shared < matched) {
+            break;
+        }
+        if (shared == matched) {
+            size_t common = 0;
+            while (common < suffix && matched + common < length && rest[common] == (unsigned char)key[matched + common]) {
+                ++common;
+            }
+            matched += common;
+            if (common == suffix && matched == length) {
+                memcpy(cursor->key, key, length + 1);
+                cursor->length = length;
+                cursor->type = type;
+                cursor->size = size;
+                cursor->value = value;
+                return base + i;
+            }
+            // The record is greater if the key is a prefix of it or has a smaller byte
+            if (matched == length || (common < suffix && rest[common] > (unsigned char)key[matched])) {
+                break;
+            }
+        }
+        value += confin_value_span(size);
+    }
+    return UINT64_MAX;
+}
+
+static void confin_compact_fill(const cfcompact_t *compact, const confin_compact_cursor_t *cursor, cfentry_t *out) {
+    memset(out, 0, sizeof(*out));
+    memcpy(out->key, cursor->key, cursor->length + 1);
+    out->type = (cfannotype_t)cursor->type;
+    out->flags = CONFIN_ENTRY_SHARED;
+    out->size = cursor->size;
+    out->value = (char*)(compact->values + cursor->value);
+}
+
+// Length of the prefix a sorted key shares with the previous one; none at the start of a block
+static size_t confin_shared_prefix(const cfentry_t **sorted, uint64_t i) {
+    size_t shared = 0;
+    if (i % __CONFIN_COMPACT_BLOCK) {
+        const char *key = sorted[i]->key;
+        const char *last = sorted[i - 1]->key;
+        while (shared < CONFIN_COMPACT_MAX_KEY && key[shared] && key[shared] == last[shared]) {
+            ++shared;
+        }
+    }
+    return shared;
+}
+
+// Finds the prefix shared by every key and the head of every block
+static bool confin_compact_index(cfcompact_t *compact) {
+    compact->fencecount = (compact->blockcount + CONFIN_COMPACT_FENCE - 1) / CONFIN_COMPACT_FENCE;
+    compact->heads = (uint64_t*)confin_alloc(&compact->allocator, sizeof(uint64_t) * (size_t)(compact->blockcount + compact->fencecount + 1));
+    if (!compact->heads) {
+        perror("malloc");
+        return false;
+    }
+    if (compact->count == 0) {
+        return true;
+    }
+    // Keys are sorted, so the prefix of the first and the last key is shared by all
+    confin_compact_cursor_t last;
+    confin_cursor_start(&last, compact, compact->blockcount - 1);
+    for (uint64_t i = (compact->blockcount - 1) * __CONFIN_COMPACT_BLOCK; i < compact->count; ++i) {
+        confin_cursor_next(&last);
+    }
+    const unsigned char *first = compact->keys;
+    size_t length = 0;
+    while (length < first[1] && length < last.length && (char)first[2 + length] == last.key[length]) {
+        ++length;
+    }
+    memcpy(compact->prefix, first + 2, length);
+    compact->prefixlength = length;
+    for (uint64_t b = 0; b < compact->blockcount; ++b) {
+        const unsigned char *record = compact->keys + compact->blocks[b].keys;
+        compact->heads[b] = confin_key_head((const char*)record + 2, record[1], length);
+    }
+    compact->fences = compact->heads + compact->blockcount;
+    for (uint64_t f = 0; f < compact->fencecount; ++f) {
+        compact->fences[f] = compact->heads[f * CONFIN_COMPACT_FENCE];
+    }
+    return true;
+}
+
+static cfcompact_t *confin_compact_alloc(const cfallocator_t *allocator, uint64_t count, uint64_t keybytes, uint64_t valuebytes) {
+    cfcompact_t *compact = (cfcompact_t*)confin_alloc(allocator, sizeof(cfcompact_t));
+    if (!compact) {
+        perror("malloc");
+        return NULL;
+    }
+    memset(compact, 0, sizeof(*compact));
+    compact->allocator = *allocator;
+    compact->count = count;
+    compact->blockcount = (count + __CONFIN_COMPACT_BLOCK - 1) / __CONFIN_COMPACT_BLOCK;
+    compact->keybytes = keybytes;
+    compact->valuebytes = valuebytes;
+    uint64_t blockbytes = compact->blockcount * sizeof(confin_compact_block_t);
+    uint64_t valuestart = confin_value_span(blockbytes + keybytes);
+    compact->data = confin_alloc(allocator, (size_t)(valuestart + valuebytes) + 1);
+    if (!compact->data) {
+        perror("malloc");
+        confin_free(allocator, compact);
+        return NULL;
+    }
+    compact->blocks = (const confin_compact_block_t*)compact->data;
+    compact->keys = (const unsigned char*)compact->data + blockbytes;
+    compact->values = (const unsigned char*)compact->data + valuestart;
+    return compact;
+}
+
+/**
+ * @brief Builds the compact form of a configuration.
+ * @param config Pointer to the configuration.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact(const cffile_t *config) {
+    return confin_compact_ctx(config, NULL);
+}
+
+/**
+ * @brief Builds the compact form of a configuration with a context.
+ * @param config Pointer to the configuration.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact_ctx(const cffile_t *config, cfcontext_t *ctx) {
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    uint64_t entrycount = config->header.entrycount;
+    const cfentry_t **sorted = (const cfentry_t**)confin_alloc(&allocator, sizeof(*sorted) * (entrycount ? entrycount : 1));
+    if (!sorted) {
+        perror("malloc");
+        return NULL;
+    }
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        sorted[i] = &config->entries[i];
+    }
+    qsort(sorted, (size_t)entrycount, sizeof(*sorted), confin_compare_entries);
+
+    // Drops repeated keys, then sizes the records
+    uint64_t count = 0, keybytes = 0, valuebytes = 0;
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        if (count == 0 || strncmp(sorted[count - 1]->key, sorted[i]->key, CONFIN_COMPACT_MAX_KEY) != 0) {
+            sorted[count++] = sorted[i];
+        }
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        size_t length = strnlen(sorted[i]->key, CONFIN_COMPACT_MAX_KEY);
+        keybytes += 3 + length - confin_shared_prefix(sorted, i) + confin_varint_size(sorted[i]->size);
+        valuebytes += confin_value_span(sorted[i]->size);
+    }
+
+    cfcompact_t *compact = confin_compact_alloc(&allocator, count, keybytes, valuebytes);
+    if (!compact) {
+        confin_free(&allocator, (void*)sorted);
+        return NULL;
+    }
+    confin_compact_block_t *blocks = (confin_compact_block_t*)compact->data;
+    unsigned char *keys = (unsigned char*)compact->keys;
+    unsigned char *values = (unsigned char*)compact->values;
+    uint64_t keyoffset = 0, valueoffset = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const cfentry_t *entry = sorted[i];
+        size_t length = strnlen(entry->key, CONFIN_COMPACT_MAX_KEY);
+        size_t shared = confin_shared_prefix(sorted, i);
+        if (i % __CONFIN_COMPACT_BLOCK == 0) {
+            blocks[i / __CONFIN_COMPACT_BLOCK].keys = keyoffset;
+            blocks[i / __CONFIN_COMPACT_BLOCK].values = valueoffset;
+        }
+        unsigned char *record = keys + keyoffset;
+        record[0] = (unsigned char)shared;
+        record[1] = (unsigned char)(length - shared);
+        memcpy(record + 2, entry->key + shared, length - shared);
+        record += 2 + (length - shared);
+        *record++ = (unsigned char)entry->type;
+        uint64_t size = entry->size;
+        while (size >= 0x80) {
+            *record++ = (unsigned char)(size | 0x80);
+            size >>= 7;
+        }
+        *record++ = (unsigned char)size;
+        keyoffset = (uint64_t)(record - keys);
+
+        if (entry->size) {
+            memcpy(values + valueoffset, CF_ENTRYVAL(entry), (size_t)entry->size);
+        }
+        memset(values + valueoffset + entry->size, 0, (size_t)(confin_value_span(entry->size) - entry->size));
+        valueoffset += confin_value_span(entry->size);
+    }
+    confin_free(&allocator, (void*)sorted);
+    if (!confin_compact_index(compact)) {
+        confin_compact_free(compact);
+        return NULL;
+    }
+    return compact;
+}
+
+/**
+ * @brief Finds the position of a key in a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @param key The key to find.
+ * @return The position of the key in key order, or UINT64_MAX if it is not present.
+ */
+uint64_t confin_compact_find(const cfcompact_t *compact, const char *key) {
+    confin_compact_cursor_t cursor;
+    return confin_compact_locate(compact, key, &cursor);
+}
+
+/**
+ * @brief Finds an entry of a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @param key The key to find.
+ * @param out Receives the entry.
+ * @return true if the key is present, false otherwise.
+ */
+bool confin_compact_get(const cfcompact_t *compact, const char *key, cfentry_t *out) {
+    confin_compact_cursor_t cursor;
+    if (confin_compact_locate(compact, key, &cursor) == UINT64_MAX) {
+        return false;
+    }
+    confin_compact_fill(compact, &cursor, out);
+    return true;
+}
+
+/**
+ * @brief Decodes an entry of a compact configuration by position, in key order.
+ * @param compact Pointer to the compact configuration.
+ * @param index The position of the entry.
+ * @param out Receives the entry.
+ * @return true on success, false if the position is out of range.
+ */
+bool confin_compact_entry(const cfcompact_t *compact, uint64_t index, cfentry_t *out) {
+    if (index >= compact->count) {
+        return false;
+    }
+    confin_compact_cursor_t cursor;
+    confin_cursor_start(&cursor, compact, index / __CONFIN_COMPACT_BLOCK);
+    for (uint64_t i = 0; i <= index % __CONFIN_COMPACT_BLOCK; ++i) {
+        confin_cursor_next(&cursor);
+    }
+    confin_compact_fill(compact, &cursor, out);
+    return true;
+}
+
+/**
+ * @brief Returns the number of entries of a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @return The number of entries, without repeated keys.
+ */
+uint64_t confin_compact_count(const cfcompact_t *compact) {
+    return compact->count;
+}
+
+/**
+ * @brief Returns the memory used by a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @return The size in bytes of the block index, keys and values.
+ */
+size_t confin_compact_size(const cfcompact_t *compact) {
+    return (size_t)(compact->values - (const unsigned char*)compact->data + compact->valuebytes) +
+           (size_t)(compact->blockcount + compact->fencecount) * sizeof(uint64_t) + sizeof(cfcompact_t);
+}
+
+/**
+ * @brief Writes a compact configuration to a file.
+ * @param compact Pointer to the compact configuration.
+ * @param filename The name of the file.
+ * @return true on success, false on failure.
+ */
+bool confin_compact_write(const cfcompact_t *compact, const char *filename) {
+    cfcompacthdr_t header;
+    header.magic = __CONFIN_COMPACT_MAGIC_NUMBER;
+    header.version = _CF_VER;
+    header.entrycount = compact->count;
+    header.blockcount = compact->blockcount;
+    header.keybytes = compact->keybytes;
+    header.valuebytes = compact->valuebytes;
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        perror("fopen");
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(compact->blocks, sizeof(confin_compact_block_t), (size_t)compact->blockcount, file) == compact->blockcount &&
+              fwrite(compact->keys, 1, (size_t)compact->keybytes, file) == compact->keybytes &&
+              fwrite(compact->values, 1, (size_t)compact->valuebytes, file) == compact->valuebytes;
+    if (!ok) {
+        perror("fwrite");
+    }
+    if (fclose(file) != 0) {
+        perror("fclose");
+        ok = false;
+    }
+    if (!ok) {
+        remove(filename);
+    }
+    return ok;
+}
+
+// Decodes every record once, checking that it stays within the data
+static bool confin_compact_check(const cfcompact_t *compact) {
+    confin_compact_cursor_t cursor;
+    cursor.length = 0;
+    cursor.next = 0;
+    cursor.cursor = compact->keys;
+    const unsigned char *end = compact->keys + compact->keybytes;
+    for (uint64_t i = 0; i < compact->count; ++i) {
+        bool first = i % __CONFIN_COMPACT_BLOCK == 0;
+        if (first) {
+            const confin_compact_block_t *block = &compact->blocks[i / __CONFIN_COMPACT_BLOCK];
+            if (block->keys != (uint64_t)(cursor.cursor - compact->keys) || block->values != cursor.next) {
+                return false;
+            }
+        }
+        if (!confin_cursor_check(&cursor, end, first, i > 0)) {
+            return false;
+        }
+        confin_cursor_next(&cursor);
+        if (cursor.size > compact->valuebytes || confin_value_span(cursor.size) > compact->valuebytes ||
+            cursor.value > compact->valuebytes - confin_value_span(cursor.size)) {
+            return false;
+        }
+    }
+    return cursor.cursor == end && cursor.next == compact->valuebytes;
+}
+
+/**
+ * @brief Reads a compact configuration from a file.
+ * @param filename The name of the file.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact_read(const char *filename) {
+    return confin_compact_read_ctx(filename, NULL);
+}
+
+/**
+ * @brief Reads a compact configuration from a file with a context.
+ * @param filename The name of the file.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact_read_ctx(const char *filename, cfcontext_t *ctx) {
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("fopen");
+        return NULL;
+    }
+    cfcompacthdr_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+        fprintf(stderr, "Unexpected end of file\n");
+        fclose(file);
+        return NULL;
+    }
+    if (header.magic != __CONFIN_COMPACT_MAGIC_NUMBER ||
+        __CONFIN_GET_MAJOR_VERSION(header.version) != __CONFIN_MAJOR_VERSION) {
+        fprintf(stderr, "%s is not a compact configuration\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    // The sizes are bounded by the file before anything is allocated
+    long start = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long end = ftell(file);
+    fseek(file, start, SEEK_SET);
+    uint64_t available = start >= 0 && end >= start ? (uint64_t)(end - start) : 0;
+    if (header.blockcount != (header.entrycount + __CONFIN_COMPACT_BLOCK - 1) / __CONFIN_COMPACT_BLOCK ||
+        header.blockcount > available / sizeof(confin_compact_block_t) || header.keybytes > available ||
+        header.valuebytes > available ||
+        header.blockcount * sizeof(confin_compact_block_t) + header.keybytes + header.valuebytes != available) {
+        fprintf(stderr, "Invalid compact configuration %s\n", filename);
+        fclose(file);
+        return NULL;
+    }
+
+    cfcompact_t *compact = confin_compact_alloc(&allocator, header.entrycount, header.keybytes, header.valuebytes);
+    if (!compact) {
+        fclose(file);
+        return NULL;
+    }
+    bool ok = fread(compact->data, sizeof(confin_compact_block_t), (size_t)header.blockcount, file) == header.blockcount &&
+              fread((void*)compact->keys, 1, (size_t)header.keybytes, file) == header.keybytes &&
+              fread((void*)compact->values, 1, (size_t)header.valuebytes, file) == header.valuebytes;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "Unexpected end of file\n");
+        confin_compact_free(compact);
+        return NULL;
+    }
+    if (!confin_compact_check(compact)) {
+        fprintf(stderr, "Invalid compact configuration %s\n", filename);
+        confin_compact_free(compact);
+        return NULL;
+    }
+    if (!confin_compact_index(compact)) {
+        confin_compact_free(compact);
+        return NULL;
+    }
+    return compact;
+}
+
+/**
+ * @brief Frees a compact configuration.
+ * @param compact Pointer to the compact configuration; NULL is ignored.
+ */
+void confin_compact_free(cfcompact_t *compact) {
+    if (!compact) {
+        return;
+    }
+    cfallocator_t allocator = compact->allocator;
+    confin_free(&allocator, compact->heads);
+    confin_free(&allocator, compact->data);
+    confin_free(&allocator, compact);
+}
@@ -0,0 +1,243 @@
+/**
+ * @file cfcompact.h
+ * @brief Functions and macros for compact configurations with front-coded keys.
+ *
+ * This header file provides the compact form of a configuration. A loaded entry
+ * reserves the whole 64-byte key array; a compact configuration instead sorts
+ * the keys and front-codes them in blocks of @ref __CONFIN_COMPACT_BLOCK: each
+ * key is stored as the length of the prefix it shares with the previous key and
+ * the bytes that follow, together with the type and size of its value. The
+ * values are packed, in key order, in a separate area.
+ *
+ * A small index records where each block starts, with the eight bytes of its
+ * first key that follow the prefix shared by all keys. A lookup searches these
+ * heads, compares full first keys only between blocks with an equal head, and
+ * then scans one block, so keys are decoded on demand and never stored in full.
+ * Hierarchical keys sharing long prefixes take a few bytes each.
+ *
+ * A compact configuration can be written to a file and read back in one piece.
+ */
+
+#ifndef _CONFIN_COMPACT_H
+#define _CONFIN_COMPACT_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfcompact
+ * @brief Macro to build the compact form of a configuration.
+ * @param config Pointer to the configuration.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+#define cfcompact(config) confin_compact(config)
+
+/**
+ * @brief Builds the compact form of a configuration.
+ *
+ * The compact configuration owns a copy of every key and value, so `config`
+ * can be freed afterwards. When a key appears several times, the first entry
+ * is kept, as @ref confin_get would return it.
+ *
+ * @param config Pointer to the configuration.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact(const cffile_t *config);
+
+/**
+ * @def cfcompactctx
+ * @brief Macro to build the compact form of a configuration with a context.
+ * @param config Pointer to the configuration.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+#define cfcompactctx(config, ctx) confin_compact_ctx(config, ctx)
+
+/**
+ * @brief Builds the compact form of a configuration with a context.
+ *
+ * The allocator of the context is used for the compact configuration and its data.
+ *
+ * @param config Pointer to the configuration.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact_ctx(const cffile_t *config, cfcontext_t *ctx);
+
+/**
+ * @def cfcompactfind
+ * @brief Macro to find the position of a key in a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @param key The key to find.
+ * @return The position of the key in key order, or UINT64_MAX if it is not present.
+ */
+#define cfcompactfind(compact, key) confin_compact_find(compact, key)
+
+/**
+ * @brief Finds the position of a key in a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @param key The key to find.
+ * @return The position of the key in key order, or UINT64_MAX if it is not present.
+ */
+uint64_t confin_compact_find(const cfcompact_t *compact, const char *key);
+
+/**
+ * @def cfcompactget
+ * @brief Macro to find an entry of a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @param key The key to find.
+ * @param out Receives the entry.
+ * @return true if the key is present, false otherwise.
+ */
+#define cfcompactget(compact, key, out) confin_compact_get(compact, key, out)
+
+/**
+ * @brief Finds an entry of a compact configuration.
+ *
+ * The entry is filled with the key, its type and size, and a pointer to the value
+ * in the compact configuration (@ref CONFIN_ENTRY_SHARED): read it with
+ * @ref CF_ENTRYVAL while the compact configuration lives, and do not free it.
+ *
+ * @param compact Pointer to the compact configuration.
+ * @param key The key to find.
+ * @param out Receives the entry.
+ * @return true if the key is present, false otherwise.
+ */
+bool confin_compact_get(const cfcompact_t *compact, const char *key, cfentry_t *out);
+
+/**
+ * @def cfcompactentry
+ * @brief Macro to decode an entry of a compact configuration by position.
+ * @param compact Pointer to the compact configuration.
+ * @param index The position of the entry.
+ * @param out Receives the entry.
+ * @return true on success, false if the position is out of range.
+ */
+#define cfcompactentry(compact, index, out) confin_compact_entry(compact, index, out)
+
+/**
+ * @brief Decodes an entry of a compact configuration by position, in key order.
+ *
+ * The entry is filled as by @ref confin_compact_get.
+ *
+ * @param compact Pointer to the compact configuration.
+ * @param index The position of the entry.
+ * @param out Receives the entry.
+ * @return true on success, false if the position is out of range.
+ */
+bool confin_compact_entry(const cfcompact_t *compact, uint64_t index, cfentry_t *out);
+
+/**
+ * @def cfcompactcount
+ * @brief Macro to get the number of entries of a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @return The number of entries.
+ */
+#define cfcompactcount(compact) confin_compact_count(compact)
+
+/**
+ * @brief Returns the number of entries of a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @return The number of entries, without repeated keys.
+ */
+uint64_t confin_compact_count(const cfcompact_t *compact);
+
+/**
+ * @def cfcompactsize
+ * @brief Macro to get the memory used by a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @return The size in bytes.
+ */
+#define cfcompactsize(compact) confin_compact_size(compact)
+
+/**
+ * @brief Returns the memory used by a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ * @return The size in bytes of the block index, keys and values.
+ */
+size_t confin_compact_size(const cfcompact_t *compact);
+
+/**
+ * @def cfcompactwrite
+ * @brief Macro to write a compact configuration to a file.
+ * @param compact Pointer to the compact configuration.
+ * @param filename The name of the file.
+ * @return true on success, false on failure.
+ */
+#define cfcompactwrite(compact, filename) confin_compact_write(compact, filename)
+
+/**
+ * @brief Writes a compact configuration to a file.
+ * @param compact Pointer to the compact configuration.
+ * @param filename The name of the file.
+ * @return true on success, false on failure.
+ */
+bool confin_compact_write(const cfcompact_t *compact, const char *filename);
+
+/**
+ * @def cfcompactread
+ * @brief Macro to read a compact configuration from a file.
+ * @param filename The name of the file.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+#define cfcompactread(filename) confin_compact_read(filename)
+
+/**
+ * @brief Reads a compact configuration from a file.
+ *
+ * The file is read into one allocation and every block is checked before the
+ * compact configuration is returned.
+ *
+ * @param filename The name of the file.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact_read(const char *filename);
+
+/**
+ * @def cfcompactreadctx
+ * @brief Macro to read a compact configuration from a file with a context.
+ * @param filename The name of the file.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+#define cfcompactreadctx(filename, ctx) confin_compact_read_ctx(filename, ctx)
+
+/**
+ * @brief Reads a compact configuration from a file with a context.
+ *
+ * The allocator of the context is used for the compact configuration and its data.
+ *
+ * @param filename The name of the file.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the compact configuration, or NULL on failure.
+ */
+cfcompact_t *confin_compact_read_ctx(const char *filename, cfcontext_t *ctx);
+
+/**
+ * @def cfcompactfree
+ * @brief Macro to free a compact configuration.
+ * @param compact Pointer to the compact configuration.
+ */
+#define cfcompactfree(compact) confin_compact_free(compact)
+
+/**
+ * @brief Frees a compact configuration.
+ * @param compact Pointer to the compact configuration; NULL is ignored.
+ */
+void confin_compact_free(cfcompact_t *compact);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_COMPACT_H
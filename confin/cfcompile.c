@@ -0,0 +1,979 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define CONFIN_COMPILE_SSE2 1
+#endif
+
+#ifndef _WIN32
+#include <pthread.h>
+#define CONFIN_COMPILE_THREADS 1
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfcompile.h" // confin/cfcompile.h
+#include "cfwriter.h" // confin/cfwriter.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Maximum nesting of JSON objects and arrays.
+ */
+#define CONFIN_COMPILE_MAX_DEPTH 256
+
+/* output targets */
+
+/**
+ * @brief Destination of the compiled entries.
+ *
+ * Entries go to a streaming writer, or for a worker thread are encoded in memory
+ * exactly as in the file until the main thread hands them to the writer.
+ */
+typedef struct {
+    cfwriter_t *writer;              /**< Output writer, or NULL to encode in memory */
+    unsigned char *data;             /**< Encoded entries when `writer` is NULL */
+    size_t size;                     /**< Bytes used in `data` */
+    size_t capacity;                 /**< Bytes allocated for `data` */
+    uint64_t count;                  /**< Number of entries encoded in `data` */
+    const cfallocator_t *allocator;  /**< Allocator for `data` */
+} confin_target_t;
+
+static bool confin_target_append(confin_target_t *target, const void *bytes, size_t size) {
+    if (target->size + size > target->capacity) {
+        size_t capacity = target->capacity ? target->capacity : 4096;
+        while (capacity < target->size + size) {
+            capacity *= 2;
+        }
+        unsigned char *data = (unsigned char*)confin_realloc(target->allocator, target->data, capacity);
+        if (!data) {
+            perror("malloc");
+            return false;
+        }
+        target->data = data;
+        target->capacity = capacity;
+    }
+    memcpy(target->data + target->size, bytes, size);
+    target->size += size;
+    return true;
+}
+
+static bool confin_target_emit(confin_target_t *target, const char *key, size_t keylen, cfannotype_t type, const void *value, uint64_t size) {
+    if (target->writer) {
+        return confin_writer_append(target->writer, key, type, value, size);
+    }
+    cfentryhdr_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.key, key, keylen);
+    hdr.type = (uint32_t)type;
+    hdr.size = size;
+    target->count++;
+    return confin_target_append(target, &hdr, sizeof(hdr)) && confin_target_append(target, value, (size_t)size);
+}
+
+/* parser */
+
+/**
+ * @brief State of the INI and JSON parsers.
+ */
+typedef struct {
+    const char *begin;                     /**< Start of the source, for error positions */
+    const char *cur;                       /**< Current position */
+    const char *end;                       /**< End of the source */
+    const char *name;                      /**< Name of the source, for error messages */
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];  /**< Dotted key of the current value */
+    size_t keylen;                         /**< Length of `key` */
+    char *scratch;                         /**< Unescaped string being parsed */
+    size_t scratchlen;                     /**< Length of `scratch` */
+    size_t scratchcap;                     /**< Bytes allocated for `scratch` */
+    uint32_t flags;                        /**< Compiler options (CONFIN_COMPILE_*) */
+    int depth;                             /**< Current JSON nesting */
+    bool failed;                           /**< Set once an error has been reported */
+    confin_target_t *target;               /**< Destination of the entries */
+    const cfallocator_t *allocator;        /**< Allocator for `scratch` */
+} confin_parser_t;
+
+static bool confin_parse_error(confin_parser_t *p, const char *message) {
+    if (!p->failed) {
+        unsigned long line = 1;
+        for (const char *c = p->begin; c < p->cur && c < p->end; ++c) {
+            line += *c == '\n';
+        }
+        fprintf(stderr, "%s:%lu: %s\n", p->name, line, message);
+        p->failed = true;
+    }
+    return false;
+}
+
+static bool confin_scratch_reserve(confin_parser_t *p, size_t extra) {
+    if (p->scratchlen + extra + 1 <= p->scratchcap) {
+        return true;
+    }
+    size_t capacity = p->scratchcap ? p->scratchcap : 256;
+    while (capacity < p->scratchlen + extra + 1) {
+        capacity *= 2;
+    }
+    char *scratch = (char*)confin_realloc(p->allocator, p->scratch, capacity);
+    if (!scratch) {
+        perror("malloc");
+        return confin_parse_error(p, "out of memory");
+    }
+    p->scratch = scratch;
+    p->scratchcap = capacity;
+    return true;
+}
+
+static bool confin_scratch_append(confin_parser_t *p, const char *bytes, size_t size) {
+    if (!confin_scratch_reserve(p, size)) {
+        return false;
+    }
+    memcpy(p->scratch + p->scratchlen, bytes, size);
+    p->scratchlen += size;
+    p->scratch[p->scratchlen] = '\0';
+    return true;
+}
+
+/**
+ * @brief Appends a component to the current key.
+ * @return The length of the key before the component, to restore it afterwards.
+ */
+static bool confin_key_push(confin_parser_t *p, const char *name, size_t length, size_t *saved) {
+    *saved = p->keylen;
+    size_t total = p->keylen + (p->keylen ? 1 : 0) + length;
+    if (total >= __CONFIN_STRUCT_MAX_KEYLEN) {
+        return confin_parse_error(p, "key too long");
+    }
+    if (p->keylen) {
+        p->key[p->keylen++] = '.';
+    }
+    memcpy(p->key + p->keylen, name, length);
+    p->keylen = total;
+    p->key[total] = '\0';
+    return true;
+}
+
+static void confin_key_pop(confin_parser_t *p, size_t saved) {
+    p->keylen = saved;
+    p->key[saved] = '\0';
+}
+
+static bool confin_emit(confin_parser_t *p, cfannotype_t type, const void *value, uint64_t size) {
+    if (!confin_target_emit(p->target, p->key, p->keylen, type, value, size)) {
+        return confin_parse_error(p, "write error");
+    }
+    return true;
+}
+
+static bool confin_emit_int(confin_parser_t *p, int64_t value) {
+    if (value >= INT32_MIN && value <= INT32_MAX) {
+        int32_t narrow = (int32_t)value;
+        return confin_emit(p, CONFIN_ANNOTYPE_INT, &narrow, sizeof(narrow));
+    }
+    return confin_emit(p, CONFIN_ANNOTYPE_INT, &value, sizeof(value));
+}
+
+static bool confin_emit_float(confin_parser_t *p, double value) {
+    if (p->flags & CONFIN_COMPILE_DOUBLE) {
+        return confin_emit(p, CONFIN_ANNOTYPE_FLOAT, &value, sizeof(value));
+    }
+    float narrow = (float)value;
+    return confin_emit(p, CONFIN_ANNOTYPE_FLOAT, &narrow, sizeof(narrow));
+}
+
+/**
+ * @brief Emits `text` as a number if it is one.
+ *
+ * Accepts an optional sign, decimal digits, and a fraction and/or exponent for
+ * floating-point numbers. Integers that overflow 64 bits become floats.
+ *
+ * @return 1 if a number was emitted, 0 if `text` is not a number, -1 on a write error.
+ */
+static int confin_emit_number(confin_parser_t *p, const char *text, size_t length) {
+    const char *c = text, *end = text + length;
+    bool negative = false;
+    if (c < end && (*c == '-' || *c == '+')) {
+        negative = *c == '-';
+        ++c;
+    }
+    const char *digits = c;
+    uint64_t magnitude = 0;
+    bool overflow = false;
+    while (c < end && *c >= '0' && *c <= '9') {
+        unsigned digit = (unsigned)(*c - '0');
+        overflow |= magnitude > (UINT64_MAX - digit) / 10;
+        magnitude = magnitude * 10 + digit;
+        ++c;
+    }
+    if (c == digits) {
+        return 0;
+    }
+
+    bool fractional = false;
+    if (c < end && *c == '.') {
+        fractional = true;
+        const char *fraction = ++c;
+        while (c < end && *c >= '0' && *c <= '9') {
+            ++c;
+        }
+        if (c == fraction) {
+            return 0;
+        }
+    }
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        fractional = true;
+        ++c;
+        if (c < end && (*c == '-' || *c == '+')) {
+            ++c;
+        }
+        const char *exponent = c;
+        while (c < end && *c >= '0' && *c <= '9') {
+            ++c;
+        }
+        if (c == exponent) {
+            return 0;
+        }
+    }
+    if (c != end) {
+        return 0;
+    }
+
+    bool fits = !overflow && (negative ? magnitude <= (uint64_t)INT64_MAX + 1 : magnitude <= (uint64_t)INT64_MAX);
+    if (!fractional && fits) {
+        int64_t value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+        return confin_emit_int(p, value) ? 1 : -1;
+    }
+
+    char buffer[128];
+    if (length >= sizeof(buffer)) {
+        return 0;
+    }
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    return confin_emit_float(p, strtod(buffer, NULL)) ? 1 : -1;
+}
+
+/* scanner */
+
+static inline unsigned confin_ctz(unsigned mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(mask);
+#else
+    unsigned count = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+static inline bool confin_is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * @brief Skips JSON whitespace.
+ * @return The first non-whitespace character, or `end`.
+ */
+static const char *confin_skip_space(const char *c, const char *end) {
+    if (c < end && !confin_is_space(*c)) {
+        return c;
+    }
+#ifdef CONFIN_COMPILE_SSE2
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - c >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)c);
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage), _mm_cmpeq_epi8(chunk, tab)));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(blank) & 0xFFFFu;
+        if (mask) {
+            return c + confin_ctz(mask);
+        }
+        c += 16;
+    }
+#endif
+    while (c < end && confin_is_space(*c)) {
+        ++c;
+    }
+    return c;
+}
+
+/**
+ * @brief Finds the end of the plain run of a JSON string.
+ * @return The first quote, backslash or control character, or `end`.
+ */
+static const char *confin_scan_string(const char *c, const char *end) {
+#ifdef CONFIN_COMPILE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (end - c >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)c);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        unsigned mask = (unsigned)_mm_movemask_epi8(special);
+        if (mask) {
+            return c + confin_ctz(mask);
+        }
+        c += 16;
+    }
+#endif
+    while (c < end && *c != '"' && *c != '\\' && (unsigned char)*c >= 0x20) {
+        ++c;
+    }
+    return c;
+}
+
+/* JSON */
+
+static int confin_hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool confin_json_hex4(confin_parser_t *p, uint32_t *codepoint) {
+    if (p->end - p->cur < 4) {
+        return confin_parse_error(p, "invalid \\u escape");
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        int digit = confin_hex_digit(p->cur[i]);
+        if (digit < 0) {
+            return confin_parse_error(p, "invalid \\u escape");
+        }
+        value = (value << 4) | (uint32_t)digit;
+    }
+    p->cur += 4;
+    *codepoint = value;
+    return true;
+}
+
+static bool confin_json_unicode(confin_parser_t *p) {
+    uint32_t codepoint;
+    if (!confin_json_hex4(p, &codepoint)) {
+        return false;
+    }
+    if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+        uint32_t low;
+        if (p->end - p->cur < 2 || p->cur[0] != '\\' || p->cur[1] != 'u') {
+            return confin_parse_error(p, "unpaired surrogate");
+        }
+        p->cur += 2;
+        if (!confin_json_hex4(p, &low)) {
+            return false;
+        }
+        if (low < 0xDC00 || low > 0xDFFF) {
+            return confin_parse_error(p, "unpaired surrogate");
+        }
+        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+    } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+        return confin_parse_error(p, "unpaired surrogate");
+    }
+
+    char utf8[4];
+    size_t length;
+    if (codepoint < 0x80) {
+        utf8[0] = (char)codepoint;
+        length = 1;
+    } else if (codepoint < 0x800) {
+        utf8[0] = (char)(0xC0 | (codepoint >> 6));
+        utf8[1] = (char)(0x80 | (codepoint & 0x3F));
+        length = 2;
+    } else if (codepoint < 0x10000) {
+        utf8[0] = (char)(0xE0 | (codepoint >> 12));
+        utf8[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (codepoint & 0x3F));
+        length = 3;
+    } else {
+        utf8[0] = (char)(0xF0 | (codepoint >> 18));
+        utf8[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        utf8[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        utf8[3] = (char)(0x80 | (codepoint & 0x3F));
+        length = 4;
+    }
+    return confin_scratch_append(p, utf8, length);
+}
+
+/**
+ * @brief Parses a JSON string into the scratch buffer.
+ *
+ * The current position is on the opening quote and ends after the closing one.
+ */
+static bool confin_json_string(confin_parser_t *p) {
+    p->scratchlen = 0;
+    if (!confin_scratch_reserve(p, 0)) {
+        return false;
+    }
+    p->scratch[0] = '\0';
+    ++p->cur;
+
+    for (;;) {
+        const char *stop = confin_scan_string(p->cur, p->end);
+        if (stop != p->cur && !confin_scratch_append(p, p->cur, (size_t)(stop - p->cur))) {
+            return false;
+        }
+        p->cur = stop;
+        if (stop == p->end) {
+            return confin_parse_error(p, "unterminated string");
+        }
+        if (*stop == '"') {
+            ++p->cur;
+            return true;
+        }
+        if (*stop != '\\') {
+            return confin_parse_error(p, "control character in string");
+        }
+        if (p->end - stop < 2) {
+            return confin_parse_error(p, "unterminated string");
+        }
+
+        char escaped;
+        p->cur = stop + 2;
+        switch (stop[1]) {
+            case '"': escaped = '"'; break;
+            case '\\': escaped = '\\'; break;
+            case '/': escaped = '/'; break;
+            case 'b': escaped = '\b'; break;
+            case 'f': escaped = '\f'; break;
+            case 'n': escaped = '\n'; break;
+            case 'r': escaped = '\r'; break;
+            case 't': escaped = '\t'; break;
+            case 'u':
+                if (!confin_json_unicode(p)) {
+                    return false;
+                }
+                continue;
+            default:
+                return confin_parse_error(p, "invalid escape");
+        }
+        if (!confin_scratch_append(p, &escaped, 1)) {
+            return false;
+        }
+    }
+}
+
+static bool confin_json_value(confin_parser_t *p);
+
+static bool confin_json_literal(confin_parser_t *p, const char *literal, size_t length) {
+    if ((size_t)(p->end - p->cur) < length || memcmp(p->cur, literal, length) != 0) {
+        return confin_parse_error(p, "invalid literal");
+    }
+    p->cur += length;
+    return true;
+}
+
+static bool confin_json_object(confin_parser_t *p) {
+    ++p->cur;
+    p->cur = confin_skip_space(p->cur, p->end);
+    if (p->cur < p->end && *p->cur == '}') {
+        ++p->cur;
+        return true;
+    }
+
+    for (;;) {
+        if (p->cur >= p->end || *p->cur != '"') {
+            return confin_parse_error(p, "expected a key");
+        }
+        if (!confin_json_string(p)) {
+            return false;
+        }
+        size_t saved;
+        if (!confin_key_push(p, p->scratch, p->scratchlen, &saved)) {
+            return false;
+        }
+
+        p->cur = confin_skip_space(p->cur, p->end);
+        if (p->cur >= p->end || *p->cur != ':') {
+            return confin_parse_error(p, "expected ':'");
+        }
+        p->cur = confin_skip_space(p->cur + 1, p->end);
+        if (!confin_json_value(p)) {
+            return false;
+        }
+        confin_key_pop(p, saved);
+
+        p->cur = confin_skip_space(p->cur, p->end);
+        if (p->cur < p->end && *p->cur == ',') {
+            p->cur = confin_skip_space(p->cur + 1, p->end);
+            continue;
+        }
+        if (p->cur < p->end && *p->cur == '}') {
+            ++p->cur;
+            return true;
+        }
+        return confin_parse_error(p, "expected ',' or '}'");
+    }
+}
+
+static bool confin_json_array(confin_parser_t *p) {
+    ++p->cur;
+    p->cur = confin_skip_space(p->cur, p->end);
+    if (p->cur < p->end && *p->cur == ']') {
+        ++p->cur;
+        return true;
+    }
+
+    for (unsigned long index = 0;; ++index) {
+        char name[24];
+        int length = snprintf(name, sizeof(name), "%lu", index);
+        size_t saved;
+        if (!confin_key_push(p, name, (size_t)length, &saved)) {
+            return false;
+        }
+        if (!confin_json_value(p)) {
+            return false;
+        }
+        confin_key_pop(p, saved);
+
+        p->cur = confin_skip_space(p->cur, p->end);
+        if (p->cur < p->end && *p->cur == ',') {
+            p->cur = confin_skip_space(p->cur + 1, p->end);
+            continue;
+        }
+        if (p->cur < p->end && *p->cur == ']') {
+            ++p->cur;
+            return true;
+        }
+        return confin_parse_error(p, "expected ',' or ']'");
+    }
+}
+
+static bool confin_json_value(confin_parser_t *p) {
+    if (p->cur >= p->end) {
+        return confin_parse_error(p, "expected a value");
+    }
+
+    bool ok;
+    switch (*p->cur) {
+        case '{':
+        case '[':
+            if (++p->depth > CONFIN_COMPILE_MAX_DEPTH) {
+                return confin_parse_error(p, "nesting too deep");
+            }
+            ok = *p->cur == '{' ? confin_json_object(p) : confin_json_array(p);
+            --p->depth;
+            return ok;
+        case '"':
+            return confin_json_string(p) &&
+                   confin_emit(p, CONFIN_ANNOTYPE_STRING, p->scratch, p->scratchlen + 1);
+        case 't':
+            return confin_json_literal(p, "true", 4) && confin_emit_int(p, 1);
+        case 'f':
+            return confin_json_literal(p, "false", 5) && confin_emit_int(p, 0);
+        case 'n':
+            return confin_json_literal(p, "null", 4);
+        default: {
+            const char *start = p->cur;
+            while (p->cur < p->end && ((*p->cur >= '0' && *p->cur <= '9') || *p->cur == '-' || *p->cur == '+' ||
+                                       *p->cur == '.' || *p->cur == 'e' || *p->cur == 'E')) {
+                ++p->cur;
+            }
+            int emitted = *start == '+' ? 0 : confin_emit_number(p, start, (size_t)(p->cur - start));
+            if (emitted == 0) {
+                p->cur = start;
+                return confin_parse_error(p, "invalid value");
+            }
+            return emitted > 0;
+        }
+    }
+}
+
+static bool confin_json_document(confin_parser_t *p) {
+    p->cur = confin_skip_space(p->cur, p->end);
+    if (p->cur >= p->end || (*p->cur != '{' && *p->cur != '[')) {
+        return confin_parse_error(p, "expected an object or array");
+    }
+    if (!confin_json_value(p)) {
+        return false;
+    }
+    p->cur = confin_skip_space(p->cur, p->end);
+    if (p->cur != p->end) {
+        return confin_parse_error(p, "trailing characters");
+    }
+    return true;
+}
+
+/* INI */
+
+static const char *confin_trim_left(const char *c, const char *end) {
+    while (c < end && (*c == ' ' || *c == '\t')) {
+        ++c;
+    }
+    return c;
+}
+
+static const char *confin_trim_right(const char *begin, const char *c) {
+    while (c > begin && (c[-1] == ' ' || c[-1] == '\t' || c[-1] == '\r')) {
+        --c;
+    }
+    return c;
+}
+
+static bool confin_ini_equals(const char *text, size_t length, const char *word) {
+    size_t i = 0;
+    for (; i < length && word[i]; ++i) {
+        char c = text[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (char)(c - 'A' + 'a');
+        }
+        if (c != word[i]) {
+            return false;
+        }
+    }
+    return i == length && !word[i];
+}
+
+/**
+ * @brief Parses and emits the value of an INI line.
+ */
+static bool confin_ini_value(confin_parser_t *p, const char *value, const char *end) {
+    if (value < end && *value == '"') {
+        p->scratchlen = 0;
+        if (!confin_scratch_reserve(p, 0)) {
+            return false;
+        }
+        p->scratch[0] = '\0';
+        const char *c = value + 1;
+        while (c < end && *c != '"') {
+            char ch = *c++;
+            if (ch == '\\' && c < end) {
+                ch = *c++;
+                ch = ch == 'n' ? '\n' : ch == 't' ? '\t' : ch == 'r' ? '\r' : ch;
+            }
+            if (!confin_scratch_append(p, &ch, 1)) {
+                return false;
+            }
+        }
+        if (c >= end) {
+            return confin_parse_error(p, "unterminated string");
+        }
+        c = confin_trim_left(c + 1, end);
+        if (c < end && *c != ';' && *c != '#') {
+            return confin_parse_error(p, "trailing characters after string");
+        }
+        return confin_emit(p, CONFIN_ANNOTYPE_STRING, p->scratch, p->scratchlen + 1);
+    }
+
+    // Inline comments start with ';' or '#' after whitespace
+    for (const char *c = value; c < end; ++c) {
+        if ((*c == ';' || *c == '#') && c > value && (c[-1] == ' ' || c[-1] == '\t')) {
+            end = confin_trim_right(value, c);
+            break;
+        }
+    }
+
+    size_t length = (size_t)(end - value);
+    if (confin_ini_equals(value, length, "true")) {
+        return confin_emit_int(p, 1);
+    }
+    if (confin_ini_equals(value, length, "false")) {
+        return confin_emit_int(p, 0);
+    }
+    int emitted = confin_emit_number(p, value, length);
+    if (emitted != 0) {
+        return emitted > 0;
+    }
+
+    p->scratchlen = 0;
+    if (!confin_scratch_reserve(p, length) || !confin_scratch_append(p, value, length)) {
+        return false;
+    }
+    return confin_emit(p, CONFIN_ANNOTYPE_STRING, p->scratch, p->scratchlen + 1);
+}
+
+static bool confin_ini_document(confin_parser_t *p) {
+    size_t section = 0;
+    while (p->cur < p->end) {
+        const char *newline = (const char*)memchr(p->cur, '\n', (size_t)(p->end - p->cur));
+        const char *lineend = newline ? newline : p->end;
+        const char *line = confin_trim_left(p->cur, lineend);
+        const char *last = confin_trim_right(line, lineend);
+
+        if (line == last || *line == ';' || *line == '#') {
+            p->cur = newline ? newline + 1 : p->end;
+            continue;
+        }
+
+        if (*line == '[') {
+            if (last[-1] != ']') {
+                return confin_parse_error(p, "expected ']'");
+            }
+            const char *name = confin_trim_left(line + 1, last - 1);
+            const char *nameend = confin_trim_right(name, last - 1);
+            confin_key_pop(p, 0);
+            if (!confin_key_push(p, name, (size_t)(nameend - name), &section)) {
+                return false;
+            }
+            section = p->keylen;
+            p->cur = newline ? newline + 1 : p->end;
+            continue;
+        }
+
+        const char *separator = line;
+        while (separator < last && *separator != '=' && *separator != ':') {
+            ++separator;
+        }
+        if (separator == last) {
+            return confin_parse_error(p, "expected 'key = value'");
+        }
+
+        const char *keyend = confin_trim_right(line, separator);
+        if (keyend == line) {
+            return confin_parse_error(p, "empty key");
+        }
+        size_t saved;
+        if (!confin_key_push(p, line, (size_t)(keyend - line), &saved)) {
+            return false;
+        }
+        if (!confin_ini_value(p, confin_trim_left(separator + 1, last), last)) {
+            return false;
+        }
+        confin_key_pop(p, section);
+        p->cur = newline ? newline + 1 : p->end;
+    }
+    return true;
+}
+
+/* driver */
+
+static void confin_parser_init(confin_parser_t *p, const char *data, size_t size, const char *name,
+                               uint32_t flags, confin_target_t *target, const cfallocator_t *allocator) {
+    memset(p, 0, sizeof(*p));
+    p->begin = data;
+    p->cur = data;
+    p->end = data + size;
+    p->name = name;
+    p->flags = flags;
+    p->target = target;
+    p->allocator = allocator;
+}
+
+#ifdef CONFIN_COMPILE_THREADS
+
+/**
+ * @brief Work item of an INI worker thread.
+ */
+typedef struct {
+    confin_parser_t parser; /**< Parser over the chunk of the worker */
+    confin_target_t target; /**< Entries encoded by the worker */
+    bool ok;                /**< Result of the worker */
+} confin_ini_job_t;
+
+static void *confin_ini_worker(void *arg) {
+    confin_ini_job_t *job = (confin_ini_job_t*)arg;
+    job->ok = confin_ini_document(&job->parser);
+    return NULL;
+}
+
+/**
+ * @brief Finds the start of the first section header at or after `c`.
+ */
+static const char *confin_ini_next_section(const char *c, const char *begin, const char *end) {
+    while (c > begin && c < end && c[-1] != '\n') {
+        const char *newline = (const char*)memchr(c, '\n', (size_t)(end - c));
+        c = newline ? newline + 1 : end;
+    }
+    while (c < end) {
+        const char *line = confin_trim_left(c, end);
+        if (line < end && *line == '[') {
+            return c;
+        }
+        const char *newline = (const char*)memchr(c, '\n', (size_t)(end - c));
+        c = newline ? newline + 1 : end;
+    }
+    return end;
+}
+
+/**
+ * @brief Compiles an INI source on several threads.
+ *
+ * The source is split at section headers, each worker encodes the entries of its
+ * chunk in memory and the chunks are then written in order.
+ */
+static bool confin_ini_parallel(const char *data, size_t size, const char *name, uint32_t flags, unsigned threads,
+                                confin_target_t *target, const cfallocator_t *allocator) {
+    confin_ini_job_t *jobs = (confin_ini_job_t*)confin_alloc(allocator, sizeof(confin_ini_job_t) * threads);
+    pthread_t *handles = (pthread_t*)confin_alloc(allocator, sizeof(pthread_t) * threads);
+    if (!jobs || !handles) {
+        perror("malloc");
+        confin_free(allocator, jobs);
+        confin_free(allocator, handles);
+        return false;
+    }
+
+    const char *end = data + size;
+    const char *start = data;
+    unsigned started = 0;
+    for (unsigned i = 0; i < threads && start < end; ++i) {
+        const char *stop = i + 1 == threads ? end : confin_ini_next_section(data + size / threads * (i + 1), data, end);
+        if (stop < start) {
+            stop = start;
+        }
+        confin_ini_job_t *job = &jobs[started];
+        memset(&job->target, 0, sizeof(job->target));
+        job->target.allocator = allocator;
+        confin_parser_init(&job->parser, start, (size_t)(stop - start), name, flags, &job->target, allocator);
+        job->parser.begin = data;
+        job->ok = false;
+        if (pthread_create(&handles[started], NULL, confin_ini_worker, job) != 0) {
+            job->ok = confin_ini_document(&job->parser);
+            handles[started] = pthread_self();
+        }
+        ++started;
+        start = stop;
+    }
+
+    bool ok = true;
+    for (unsigned i = 0; i < started; ++i) {
+        if (!pthread_equal(handles[i], pthread_self())) {
+            pthread_join(handles[i], NULL);
+        }
+        ok = ok && jobs[i].ok &&
+             confin_writer_append_encoded(target->writer, jobs[i].target.data, jobs[i].target.size, jobs[i].target.count);
+        confin_free(allocator, jobs[i].target.data);
+        confin_free(allocator, jobs[i].parser.scratch);
+    }
+
+    confin_free(allocator, jobs);
+    confin_free(allocator, handles);
+    return ok;
+}
+
+#endif
+
+static bool confin_compile(const char *data, size_t size, const char *name, const char *output,
+                           const cfcompileopts_t *options, uint64_t *entrycount) {
+    cfcompileopts_t defaults = {CONFIN_SOURCE_AUTO, 0, 0};
+    if (!options) {
+        options = &defaults;
+    }
+    cfallocator_t allocator = confin_resolve_allocator(NULL);
+
+    cfsource_t format = options->format;
+    if (format == CONFIN_SOURCE_AUTO) {
+        const char *first = confin_skip_space(data, data + size);
+        format = first < data + size && (*first == '{' || *first == '[') ? CONFIN_SOURCE_JSON : CONFIN_SOURCE_INI;
+    }
+
+    confin_target_t target;
+    memset(&target, 0, sizeof(target));
+    target.writer = confin_writer_open(output);
+    target.allocator = &allocator;
+    if (!target.writer) {
+        return false;
+    }
+
+    // Without POSIX threads, INI sources are compiled on the calling thread whatever `threads` asks for
+    bool ok;
+#ifdef CONFIN_COMPILE_THREADS
+    if (format == CONFIN_SOURCE_INI && options->threads > 1) {
+        ok = confin_ini_parallel(data, size, name, options->flags, options->threads, &target, &allocator);
+    } else
+#endif
+    {
+        confin_parser_t parser;
+        confin_parser_init(&parser, data, size, name, options->flags, &target, &allocator);
+        ok = format == CONFIN_SOURCE_JSON ? confin_json_document(&parser) : confin_ini_document(&parser);
+        confin_free(&allocator, parser.scratch);
+    }
+
+    uint64_t count = confin_writer_count(target.writer);
+    if (!ok) {
+        confin_writer_abort(target.writer);
+        return false;
+    }
+    if (!confin_writer_close(target.writer)) {
+        return false;
+    }
+    if (entrycount) {
+        *entrycount = count;
+    }
+    return true;
+}
+
+/**
+ * @brief Compiles INI or JSON text held in memory into a Confin file.
+ * @param data The text; it does not need to be NUL-terminated.
+ * @param size Size of the text in bytes.
+ * @param output The name of the Confin file to write.
+ * @param options Compiler options, or NULL for the defaults.
+ * @param entrycount Receives the number of entries written, may be NULL.
+ * @return true on success, false on a parse or write error.
+ */
+bool confin_compile_buffer(const char *data, size_t size, const char *output, const cfcompileopts_t *options, uint64_t *entrycount) {
+    return confin_compile(data, size, "<buffer>", output, options, entrycount);
+}
+
+/**
+ * @brief Compiles an INI or JSON file into a Confin file.
+ * @param source The name of the text file.
+ * @param output The name of the Confin file to write.
+ * @param options Compiler options, or NULL for the defaults.
+ * @param entrycount Receives the number of entries written, may be NULL.
+ * @return true on success, false on a read, parse or write error.
+ */
+bool confin_compile_file(const char *source, const char *output, const cfcompileopts_t *options, uint64_t *entrycount) {
+    cfallocator_t allocator = confin_resolve_allocator(NULL);
+    FILE *file = fopen(source, "rb");
+    if (!file) {
+        perror("fopen");
+        return false;
+    }
+    if (fseek(file, 0, SEEK_END) != 0) {
+        perror("fseek");
+        fclose(file);
+        return false;
+    }
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length < 0) {
+        perror("ftell");
+        fclose(file);
+        return false;
+    }
+
+    char *data = (char*)confin_alloc(&allocator, (size_t)length + 1);
+    if (!data) {
+        perror("malloc");
+        fclose(file);
+        return false;
+    }
+    bool ok = length == 0 || fread(data, (size_t)length, 1, file) == 1;
+    fclose(file);
+    if (!ok) {
+        fprintf(stderr, "%s: read error\n", source);
+        confin_free(&allocator, data);
+        return false;
+    }
+
+    cfcompileopts_t detected = {CONFIN_SOURCE_AUTO, 0, 0};
+    if (options) {
+        detected = *options;
+    }
+    if (detected.format == CONFIN_SOURCE_AUTO) {
+        const char *extension = strrchr(source, '.');
+        if (extension && (strcmp(extension, ".json") == 0 || strcmp(extension, ".JSON") == 0)) {
+            detected.format = CONFIN_SOURCE_JSON;
+        } else if (extension && (strcmp(extension, ".ini") == 0 || strcmp(extension, ".INI") == 0)) {
+            detected.format = CONFIN_SOURCE_INI;
+        }
+    }
+
+    ok = confin_compile(data, (size_t)length, source, output, &detected, entrycount);
+    confin_free(&allocator, data);
+    return ok;
+}
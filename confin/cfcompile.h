@@ -0,0 +1,87 @@
+/**
+ * @file cfcompile.h
+ * @brief Functions and macros for compiling INI and JSON text into Confin files.
+ * 
+ * This header file provides the text compiler. Sources are scanned in a single pass
+ * (with SSE2 when available) and every scalar is streamed straight into the output
+ * file as it is parsed, without building a tree.
+ * 
+ * Nested objects, arrays and INI sections are flattened into dotted keys
+ * (`server.ports.0`). Types are inferred: integers become `CONFIN_ANNOTYPE_INT`
+ * (4 bytes, or 8 when they do not fit), other numbers `CONFIN_ANNOTYPE_FLOAT`
+ * (4-byte float, 8-byte double with @ref CONFIN_COMPILE_DOUBLE), `true`/`false`
+ * an INT of 1/0 and everything else a NUL-terminated `CONFIN_ANNOTYPE_STRING`.
+ * JSON `null` values are skipped.
+ */
+
+#ifndef _CONFIN_COMPILE_H
+#define _CONFIN_COMPILE_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfcompilefile
+ * @brief Macro to compile an INI or JSON file into a Confin file.
+ * @param source The name of the text file.
+ * @param output The name of the Confin file to write.
+ * @param options Compiler options, or NULL for the defaults.
+ * @param entrycount Receives the number of entries written, may be NULL.
+ * @return true on success, false on a read, parse or write error.
+ */
+#define cfcompilefile(source, output, options, entrycount) \
+    confin_compile_file(source, output, options, entrycount)
+
+/**
+ * @brief Compiles an INI or JSON file into a Confin file.
+ * 
+ * Parse errors are reported on `stderr` with the line they occurred on.
+ * 
+ * @param source The name of the text file.
+ * @param output The name of the Confin file to write.
+ * @param options Compiler options, or NULL for the defaults.
+ * @param entrycount Receives the number of entries written, may be NULL.
+ * @return true on success, false on a read, parse or write error.
+ */
+bool confin_compile_file(const char *source, const char *output, const cfcompileopts_t *options, uint64_t *entrycount);
+
+/**
+ * @def cfcompilebuffer
+ * @brief Macro to compile INI or JSON text held in memory into a Confin file.
+ * @param data The text.
+ * @param size Size of the text in bytes.
+ * @param output The name of the Confin file to write.
+ * @param options Compiler options, or NULL for the defaults.
+ * @param entrycount Receives the number of entries written, may be NULL.
+ * @return true on success, false on a parse or write error.
+ */
+#define cfcompilebuffer(data, size, output, options, entrycount) \
+    confin_compile_buffer(data, size, output, options, entrycount)
+
+/**
+ * @brief Compiles INI or JSON text held in memory into a Confin file.
+ * 
+ * With @ref CONFIN_SOURCE_AUTO the format is detected from the first
+ * non-blank character: `{` or `[` selects JSON, anything else INI.
+ * 
+ * @param data The text; it does not need to be NUL-terminated.
+ * @param size Size of the text in bytes.
+ * @param output The name of the Confin file to write.
+ * @param options Compiler options, or NULL for the defaults.
+ * @param entrycount Receives the number of entries written, may be NULL.
+ * @return true on success, false on a parse or write error.
+ */
+bool confin_compile_buffer(const char *data, size_t size, const char *output, const cfcompileopts_t *options, uint64_t *entrycount);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_COMPILE_H
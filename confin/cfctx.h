@@ -0,0 +1,61 @@
+/**
+ * @file cfctx.h
+ * @brief Functions and macros for the allocator and per-call context of the Confin library.
+ * 
+ * This header file provides the functions to install the global allocator used by
+ * every allocation of the library. The same settings can be overridden for a single
+ * call by passing a context (`cfcontext_t`) to the `*_ctx` functions.
+ */
+
+#ifndef _CONFIN_CONTEXT_H
+#define _CONFIN_CONTEXT_H
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Macro to set the global allocator.
+ * 
+ * This macro calls the `confin_set_allocator` function.
+ * 
+ * @param allocator The allocator to install, or NULL to restore `malloc`/`realloc`/`free`.
+ */
+#define cfsetallocator(allocator) \
+    confin_set_allocator(allocator)
+
+/**
+ * @brief Sets the global allocator.
+ * 
+ * The allocator is copied. It is used by every allocation that is not made with
+ * a context overriding it. Configurations and entries must be freed with the
+ * allocator they were created with, so install it before creating any of them.
+ * 
+ * @param allocator The allocator to install, or NULL to restore `malloc`/`realloc`/`free`.
+ */
+void confin_set_allocator(const cfallocator_t *allocator);
+
+/**
+ * @brief Macro to get the global allocator.
+ * 
+ * This macro calls the `confin_get_allocator` function.
+ * 
+ * @return The global allocator.
+ */
+#define cfgetallocator() \
+    confin_get_allocator()
+
+/**
+ * @brief Gets the global allocator.
+ * 
+ * @return The global allocator.
+ */
+const cfallocator_t *confin_get_allocator(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_CONTEXT_H
@@ -16,6 +16,24 @@
  */
 #define __CONFIN_STRUCT_MAGIC_NUMBER    0xDEADBEEF // 4 bytes (32-bits)
 
+/**
+ * @def __CONFIN_DELTA_MAGIC_NUMBER
+ * @brief Magic number of a delta file produced by `confin_diff`.
+ */
+#define __CONFIN_DELTA_MAGIC_NUMBER    0xDEADD17A // 4 bytes (32-bits)
+
+/**
+ * @def __CONFIN_MANIFEST_MAGIC_NUMBER
+ * @brief Magic number of the manifest of a sharded configuration.
+ */
+#define __CONFIN_MANIFEST_MAGIC_NUMBER    0xDEAD5A4D // 4 bytes (32-bits)
+
+/**
+ * @def __CONFIN_COMPACT_MAGIC_NUMBER
+ * @brief Magic number of a compact configuration file written by `confin_compact_write`.
+ */
+#define __CONFIN_COMPACT_MAGIC_NUMBER    0xDEADC0DE // 4 bytes (32-bits)
+
 /**
  * @def __CONFIN_MAJOR_VERSION
  * @brief Major version of the configuration file format.
@@ -26,7 +44,7 @@
  * @def __CONFIN_MINOR_VERSION
  * @brief Minor version of the configuration file format.
  */
-#define __CONFIN_MINOR_VERSION 1
+#define __CONFIN_MINOR_VERSION 2
 
 /**
  * @def __CONFIN_VERSION
@@ -56,12 +74,138 @@
  */
 #define _CF_VER __CONFIN_VERSION
 
+/**
+ * @def __CONFIN_LAYOUT_VERSION
+ * @brief First format version whose header is followed by a layout block.
+ *
+ * Files written with an older version have their entries immediately after
+ * the header and are read as if the layout block was zeroed.
+ */
+#define __CONFIN_LAYOUT_VERSION ((1 << 16) | 2)
+
 /**
  * @def __CONFIN_STRUCT_MAX_KEYLEN
  * @brief Maximum length of a key in the configuration entry.
  */
 #define __CONFIN_STRUCT_MAX_KEYLEN 64
 
+/**
+ * @def __CONFIN_ENABLE_STATS
+ * @brief Compiles the instrumentation counters and timers into the library.
+ * 
+ * Collection is still off until it is enabled at run time; define it to 0 to
+ * remove the instrumentation entirely.
+ */
+#ifndef __CONFIN_ENABLE_STATS
+#define __CONFIN_ENABLE_STATS 1
+#endif
+
+/**
+ * @def __CONFIN_INLINE_VALUE_MAX
+ * @brief Largest value stored inline in the entries of a loaded configuration instead of a separate heap block.
+ */
+#define __CONFIN_INLINE_VALUE_MAX 16
+
+/**
+ * @def __CONFIN_POOL_ALIGN
+ * @brief Alignment of every payload stored in the value pool.
+ */
+#define __CONFIN_POOL_ALIGN 8
+
+/**
+ * @def CONFIN_ENTRY_SHARED
+ * @brief Entry flag: the value is borrowed (e.g. from the value pool) and is not freed with the entry.
+ */
+#define CONFIN_ENTRY_SHARED (1u << 0)
+
+/**
+ * @def CONFIN_ENTRY_INLINE
+ * @brief Entry flag: the value is stored inline in the entry (see @ref __CONFIN_INLINE_VALUE_MAX).
+ */
+#define CONFIN_ENTRY_INLINE (1u << 1)
+
+/**
+ * @def CONFIN_LAYOUT_POOLED
+ * @brief Layout flag: values are stored once in a pool and entries reference pool offsets.
+ */
+#define CONFIN_LAYOUT_POOLED (1u << 0)
+
+/**
+ * @def CONFIN_LAYOUT_OFFSETS
+ * @brief Layout flag: the file ends with an offset table (see @ref __s_confin_offset_table).
+ */
+#define CONFIN_LAYOUT_OFFSETS (1u << 1)
+
+/**
+ * @def __CONFIN_OFFSET_STRIDE
+ * @brief Number of entries between two positions recorded in an offset table.
+ */
+#define __CONFIN_OFFSET_STRIDE 1024
+
+/**
+ * @def CONFIN_WRITE_DEDUP
+ * @brief Writer option: store identical values once in a value pool.
+ */
+#define CONFIN_WRITE_DEDUP (1u << 0)
+
+/**
+ * @def CONFIN_WRITE_OFFSETS
+ * @brief Writer option: append an offset table so the file can be loaded in parallel.
+ */
+#define CONFIN_WRITE_OFFSETS (1u << 1)
+
+/**
+ * @def CONFIN_COMPILE_DOUBLE
+ * @brief Compiler option: store floating-point numbers as 8-byte doubles instead of floats.
+ */
+#define CONFIN_COMPILE_DOUBLE (1u << 0)
+
+/**
+ * @def CONFIN_FREEZE_MLOCK
+ * @brief Freeze option: lock the frozen layout in memory; freezing fails if it cannot be locked.
+ */
+#define CONFIN_FREEZE_MLOCK (1u << 0)
+
+/**
+ * @def CONFIN_FROZEN_HUGEPAGES
+ * @brief Frozen layout flag: the layout was mapped on its own and advised for transparent huge pages.
+ */
+#define CONFIN_FROZEN_HUGEPAGES (1u << 1)
+
+/**
+ * @def __CONFIN_COMPACT_BLOCK
+ * @brief Number of keys per front-coded block of a compact configuration.
+ * 
+ * The first key of a block is stored in full and the others as the length of the
+ * prefix they share with the previous key followed by the rest, so a lookup
+ * decodes at most this many keys after finding the block.
+ */
+#define __CONFIN_COMPACT_BLOCK 16
+
+/**
+ * @def __CONFIN_SHARD_SEPARATOR
+ * @brief Character ending the part of a key that selects its shard with @ref CONFIN_SHARD_PREFIX.
+ */
+#define __CONFIN_SHARD_SEPARATOR '.'
+
+/**
+ * @def __CONFIN_SERVER_MAX_REQUEST
+ * @brief Largest body of a request accepted by the configuration server.
+ */
+#define __CONFIN_SERVER_MAX_REQUEST (1 << 20)
+
+/**
+ * @def __CONFIN_SERVER_POLL_MS
+ * @brief Interval in milliseconds at which the configuration server checks its files for changes.
+ */
+#define __CONFIN_SERVER_POLL_MS 1000
+
+/**
+ * @def CONFIN_REPLY_MISSING
+ * @brief Reply item flag: the requested key is not present, no value follows.
+ */
+#define CONFIN_REPLY_MISSING (1u << 0)
+
 /**
  * @def __CONFIN_REF_ENTRY_VALUE
  * @brief Macro to reference a value pointer of a given type.
@@ -98,4 +242,26 @@
  */
 #define CF_UNREF_ENTRYVAL(V, T) __CONFIN_UNREF_ENTRY_VALUE(V, T)
 
+/**
+ * @def __CONFIN_ENTRY_VALUE
+ * @brief Macro to get the value pointer of a configuration entry.
+ * 
+ * Hides whether the value is stored inline in the entry or in a separate block.
+ * An entry whose `flags` are 0, such as one initialized as `{key, type, size, value}`,
+ * is read through its `value` pointer.
+ * 
+ * @param Entry Pointer to the configuration entry.
+ * @return Pointer to the value of the entry.
+ */
+#define __CONFIN_ENTRY_VALUE(Entry) \
+    (((Entry)->flags & CONFIN_ENTRY_INLINE) ? (void*)(Entry)->inlinevalue : (Entry)->value)
+
+/**
+ * @def CF_ENTRYVAL
+ * @brief Macro alias for __CONFIN_ENTRY_VALUE.
+ * @param E Pointer to the configuration entry.
+ * @return Pointer to the value of the entry.
+ */
+#define CF_ENTRYVAL(E) __CONFIN_ENTRY_VALUE(E)
+
 #endif // _CONFIN_DEFINE_H
@@ -0,0 +1,358 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfutils.h" // confin/cfutils.h
+#include "cfdiff.h" // confin/cfdiff.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Marker of a delta record that was moved into the new configuration.
+ */
+#define CONFIN_DELTA_CONSUMED 0xFF
+
+/**
+ * @brief Describes a configuration as the base of a delta.
+ */
+static cfdeltabase_t confin_delta_base(const cffile_t *config) {
+    cfdeltabase_t base = {config->header.entrycount, 0};
+    for (uint64_t i = 0; i < config->header.entrycount; ++i) {
+        base.checksum += confin_entry_checksum(&config->entries[i]);
+    }
+    return base;
+}
+
+/**
+ * @brief Writes the header of a delta file and the description of its base configuration.
+ * @param file The delta file, positioned at its start.
+ * @param count Number of records.
+ * @param base The configuration the delta applies to.
+ * @return true on success, false on a write error.
+ */
+bool confin_write_delta_header(FILE *file, uint64_t count, const cfdeltabase_t *base) {
+    cfheader_t header = {__CONFIN_DELTA_MAGIC_NUMBER, _CF_VER, count};
+    return fwrite(&header, sizeof(cfheader_t), 1, file) == 1 && fwrite(base, sizeof(cfdeltabase_t), 1, file) == 1;
+}
+
+/**
+ * @brief Writes one record of a delta file.
+ * @param file The delta file.
+ * @param entry The entry the record is about.
+ * @param op The operation of the record.
+ * @return true on success, false on a write error.
+ */
+bool confin_write_delta_record(FILE *file, const cfentry_t *entry, cfdeltaop_t op) {
+    cfentryhdr_t hdr;
+    confin_entry_to_header(entry, &hdr);
+    hdr.reserved = (uint32_t)op;
+    if (op == CONFIN_DELTA_REMOVE) {
+        hdr.size = 0;
+    }
+    if (fwrite(&hdr, sizeof(cfentryhdr_t), 1, file) != 1) {
+        return false;
+    }
+    return hdr.size == 0 || fwrite(CF_ENTRYVAL(entry), hdr.size, 1, file) == 1;
+}
+
+/**
+ * @brief Checks whether two entries with the same key differ.
+ */
+static bool confin_entries_differ(const cfentry_t *a, const cfentry_t *b) {
+    return a->type != b->type || a->size != b->size ||
+           memcmp(CF_ENTRYVAL(a), CF_ENTRYVAL(b), a->size) != 0;
+}
+
+/**
+ * @brief Checks that no two entries share a key.
+ * @param index A key index built over the entries.
+ * @param entries The entries.
+ * @param entrycount Number of entries.
+ * @param what What the entries are, for the error message.
+ * @return true if every key is unique, false otherwise.
+ */
+static bool confin_unique_keys(const confin_keyindex_t *index, const cfentry_t *entries, uint64_t entrycount, const char *what) {
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        // The index keeps the first entry of a key, so a later one is a duplicate
+        if (confin_keyindex_find(index, entries, entries[i].key, confin_hash_key(entries[i].key)) != i) {
+            fprintf(stderr, "Duplicate key in %s: %.*s\n", what, __CONFIN_STRUCT_MAX_KEYLEN, entries[i].key);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the delta between two configurations to a file.
+ * 
+ * Entries are matched by key through a hash index of the old configuration, so
+ * the comparison is linear in the number of entries. Configurations with
+ * duplicate keys are refused.
+ * 
+ * @param oldcfg The old configuration.
+ * @param newcfg The new configuration.
+ * @param deltafile The name of the delta file to write.
+ * @param summary Receives the number of records of each kind, may be NULL.
+ * @return true on success, false otherwise.
+ */
+bool confin_diff(const cffile_t *oldcfg, const cffile_t *newcfg, const char *deltafile, cfdiffsummary_t *summary) {
+    cfallocator_t allocator = oldcfg->allocator;
+    uint64_t oldcount = oldcfg->header.entrycount;
+
+    confin_keyindex_t index;
+    if (!confin_keyindex_build(&index, newcfg->entries, newcfg->header.entrycount, &allocator)) {
+        return false;
+    }
+    bool unique = confin_unique_keys(&index, newcfg->entries, newcfg->header.entrycount, "new configuration");
+    confin_keyindex_free(&index, &allocator);
+    if (!unique || !confin_keyindex_build(&index, oldcfg->entries, oldcount, &allocator)) {
+        return false;
+    }
+    if (!confin_unique_keys(&index, oldcfg->entries, oldcount, "old configuration")) {
+        confin_keyindex_free(&index, &allocator);
+        return false;
+    }
+    unsigned char *seen = (unsigned char*)confin_alloc(&allocator, oldcount ? oldcount : 1);
+    if (!seen) {
+        perror("malloc");
+        confin_keyindex_free(&index, &allocator);
+        return false;
+    }
+    memset(seen, 0, oldcount ? oldcount : 1);
+
+    FILE *file = fopen(deltafile, "wb");
+    if (!file) {
+        perror("fopen");
+        confin_free(&allocator, seen);
+        confin_keyindex_free(&index, &allocator);
+        return false;
+    }
+
+    cfdiffsummary_t counts = {0, 0, 0};
+    cfdeltabase_t base = confin_delta_base(oldcfg);
+    bool ok = confin_write_delta_header(file, 0, &base);
+
+    for (uint64_t i = 0; ok && i < newcfg->header.entrycount; ++i) {
+        const cfentry_t *entry = &newcfg->entries[i];
+        uint64_t match = confin_keyindex_find(&index, oldcfg->entries, entry->key, confin_hash_key(entry->key));
+        if (match == UINT64_MAX) {
+            ok = confin_write_delta_record(file, entry, CONFIN_DELTA_ADD);
+            counts.added++;
+            continue;
+        }
+        seen[match] = 1;
+        if (confin_entries_differ(&oldcfg->entries[match], entry)) {
+            ok = confin_write_delta_record(file, entry, CONFIN_DELTA_CHANGE);
+            counts.changed++;
+        }
+    }
+
+    for (uint64_t i = 0; ok && i < oldcount; ++i) {
+        if (!seen[i]) {
+            ok = confin_write_delta_record(file, &oldcfg->entries[i], CONFIN_DELTA_REMOVE);
+            counts.removed++;
+        }
+    }
+
+    // Backpatch the number of records
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && confin_write_delta_header(file, counts.added + counts.changed + counts.removed, &base);
+    if (!ok) {
+        perror("fwrite");
+    }
+
+    fclose(file);
+    confin_free(&allocator, seen);
+    confin_keyindex_free(&index, &allocator);
+    if (summary) {
+        *summary = counts;
+    }
+    return ok;
+}
+
+/**
+ * @brief Reads the records of a delta file.
+ * @param file The delta file positioned right after its header.
+ * @param count Number of records.
+ * @param records Array receiving the records, each owning its value.
+ * @param ops Array receiving the operation of each record.
+ * @param allocator The allocator for the values.
+ * @return Number of records read; less than `count` on failure.
+ */
+static uint64_t confin_read_delta_records(FILE *file, uint64_t count, cfentry_t *records, unsigned char *ops, const cfallocator_t *allocator) {
+    for (uint64_t i = 0; i < count; ++i) {
+        cfentryhdr_t hdr;
+        if (fread(&hdr, sizeof(cfentryhdr_t), 1, file) != 1 || hdr.reserved > CONFIN_DELTA_REMOVE) {
+            fprintf(stderr, "Invalid delta record\n");
+            return i;
+        }
+
+        cfentry_t *record = &records[i];
+        confin_entry_from_header(&hdr, record);
+        ops[i] = (unsigned char)hdr.reserved;
+
+        void *value = record->inlinevalue;
+        if (record->size <= __CONFIN_INLINE_VALUE_MAX) {
+            record->flags = CONFIN_ENTRY_INLINE;
+            record->value = record->inlinevalue;
+        } else {
+            record->value = confin_alloc(allocator, record->size);
+            if (!record->value) {
+                perror("malloc");
+                return i;
+            }
+            value = record->value;
+        }
+        if (record->size && fread(value, record->size, 1, file) != 1) {
+            fprintf(stderr, "Unexpected end of file\n");
+            return i + 1;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Applies a delta file to a configuration.
+ * 
+ * The result keeps the entries of the old configuration in their order, with
+ * changed entries updated and removed entries dropped, followed by the added
+ * entries. The delta is refused if its base does not describe `oldcfg`, if
+ * `oldcfg` has duplicate keys, or if two records share a key.
+ * 
+ * @param oldcfg The configuration the delta was computed from.
+ * @param deltafile The name of the delta file to apply.
+ * @return The new configuration, allocated with the allocator of `oldcfg`, or NULL on failure.
+ */
+cffile_t *confin_apply_delta(const cffile_t *oldcfg, const char *deltafile) {
+    cfallocator_t allocator = oldcfg->allocator;
+    cfcontext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.allocator = allocator;
+
+    FILE *file = fopen(deltafile, "rb");
+    if (!file) {
+        perror("fopen");
+        return NULL;
+    }
+
+    cfheader_t header;
+    if (fread(&header, sizeof(cfheader_t), 1, file) != 1 || header.magic != __CONFIN_DELTA_MAGIC_NUMBER) {
+        fprintf(stderr, "Invalid magic number\n");
+        fclose(file);
+        return NULL;
+    }
+    if (header.version > _CF_VER) {
+        fprintf(stderr, "Invalid version\n");
+        fclose(file);
+        return NULL;
+    }
+    cfdeltabase_t base, expected = confin_delta_base(oldcfg);
+    if (fread(&base, sizeof(cfdeltabase_t), 1, file) != 1) {
+        fprintf(stderr, "Unexpected end of file\n");
+        fclose(file);
+        return NULL;
+    }
+    if (base.entrycount != expected.entrycount || base.checksum != expected.checksum) {
+        fprintf(stderr, "Delta was not computed from this configuration\n");
+        fclose(file);
+        return NULL;
+    }
+
+    uint64_t count = header.entrycount;
+    uint64_t oldcount = oldcfg->header.entrycount;
+    cfentry_t *records = (cfentry_t*)confin_alloc(&allocator, sizeof(cfentry_t) * (count ? count : 1));
+    unsigned char *ops = (unsigned char*)confin_alloc(&allocator, count ? count : 1);
+    uint64_t *patches = (uint64_t*)confin_alloc(&allocator, sizeof(uint64_t) * (oldcount ? oldcount : 1));
+    confin_keyindex_t index = {0, NULL}, recordindex = {0, NULL};
+    cffile_t *config = NULL;
+    uint64_t loaded = 0;
+    bool ok = records && ops && patches;
+    if (!ok) {
+        perror("malloc");
+    }
+
+    if (ok) {
+        loaded = confin_read_delta_records(file, count, records, ops, &allocator);
+        ok = loaded == count &&
+             confin_keyindex_build(&index, oldcfg->entries, oldcount, &allocator) &&
+             confin_unique_keys(&index, oldcfg->entries, oldcount, "configuration") &&
+             confin_keyindex_build(&recordindex, records, count, &allocator) &&
+             confin_unique_keys(&recordindex, records, count, "delta");
+    }
+
+    // Map every changed or removed old entry to its record
+    uint64_t added = 0, removed = 0;
+    if (ok) {
+        memset(patches, 0, sizeof(uint64_t) * (oldcount ? oldcount : 1));
+        for (uint64_t i = 0; ok && i < count; ++i) {
+            uint64_t match = confin_keyindex_find(&index, oldcfg->entries, records[i].key, confin_hash_key(records[i].key));
+            if ((ops[i] == CONFIN_DELTA_ADD) != (match == UINT64_MAX)) {
+                fprintf(stderr, "Delta does not apply: %s\n", records[i].key);
+                ok = false;
+                break;
+            }
+            if (ops[i] == CONFIN_DELTA_ADD) {
+                added++;
+                continue;
+            }
+            removed += ops[i] == CONFIN_DELTA_REMOVE;
+            patches[match] = i + 1;
+        }
+    }
+
+    if (ok) {
+        config = confin_alloc_config(&allocator, oldcount - removed + added);
+        ok = config != NULL;
+    }
+
+    for (uint64_t i = 0; ok && i < oldcount; ++i) {
+        cfentry_t *target = &config->entries[config->header.entrycount];
+        if (!patches[i]) {
+            ok = confin_copy_entry(target, &oldcfg->entries[i], &allocator);
+            config->header.entrycount += ok;
+            continue;
+        }
+        uint64_t record = patches[i] - 1;
+        if (ops[record] == CONFIN_DELTA_CHANGE) {
+            confin_move_entry(target, &records[record]);
+            config->header.entrycount++;
+        } else {
+            confin_free_config_entry_ctx(&records[record], &ctx);
+        }
+        ops[record] = CONFIN_DELTA_CONSUMED;
+    }
+
+    for (uint64_t i = 0; ok && i < count; ++i) {
+        if (ops[i] == CONFIN_DELTA_ADD) {
+            confin_move_entry(&config->entries[config->header.entrycount++], &records[i]);
+            ops[i] = CONFIN_DELTA_CONSUMED;
+        }
+    }
+
+    // Release the records that were not moved into the new configuration
+    for (uint64_t i = 0; i < loaded; ++i) {
+        if (ops[i] != CONFIN_DELTA_CONSUMED) {
+            confin_free_config_entry_ctx(&records[i], &ctx);
+        }
+    }
+    if (!ok && config) {
+        confin_free_config_file(config);
+        config = NULL;
+    }
+
+    fclose(file);
+    confin_keyindex_free(&index, &allocator);
+    confin_keyindex_free(&recordindex, &allocator);
+    confin_free(&allocator, records);
+    confin_free(&allocator, ops);
+    confin_free(&allocator, patches);
+    return config;
+}
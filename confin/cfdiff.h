@@ -0,0 +1,86 @@
+/**
+ * @file cfdiff.h
+ * @brief Functions and macros for structural diffs between configurations.
+ * 
+ * This header file provides functions to compare two configurations and record the
+ * added, changed and removed entries in a compact delta file, and to apply such a
+ * delta to the old configuration to produce the new one.
+ * 
+ * A delta file starts with a header carrying @ref __CONFIN_DELTA_MAGIC_NUMBER and the
+ * number of records, and the entry count and checksum of the configuration it was
+ * computed from (@ref __s_confin_delta_base). One entry header per record follows
+ * (with the operation in its `reserved` field) and, for added and changed entries,
+ * the new value.
+ */
+
+#ifndef _CONFIN_DIFF_H
+#define _CONFIN_DIFF_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfdiff
+ * @brief Macro to write the delta between two configurations to a file.
+ * @param oldcfg The old configuration.
+ * @param newcfg The new configuration.
+ * @param deltafile The name of the delta file to write.
+ * @param summary Receives the number of records of each kind, may be NULL.
+ * @return true on success, false otherwise.
+ */
+#define cfdiff(oldcfg, newcfg, deltafile, summary) confin_diff(oldcfg, newcfg, deltafile, summary)
+
+/**
+ * @brief Writes the delta between two configurations to a file.
+ * 
+ * Entries are matched by key through a hash index of the old configuration, so
+ * the comparison is linear in the number of entries. Entries whose type, size or
+ * value bytes differ are recorded as changed. Configurations with duplicate keys
+ * are refused, as a key could not name one of their entries.
+ * 
+ * @param oldcfg The old configuration.
+ * @param newcfg The new configuration.
+ * @param deltafile The name of the delta file to write.
+ * @param summary Receives the number of records of each kind, may be NULL.
+ * @return true on success, false otherwise.
+ */
+bool confin_diff(const cffile_t *oldcfg, const cffile_t *newcfg, const char *deltafile, cfdiffsummary_t *summary);
+
+/**
+ * @def cfapplydelta
+ * @brief Macro to apply a delta file to a configuration.
+ * @param oldcfg The configuration the delta was computed from.
+ * @param deltafile The name of the delta file to apply.
+ * @return The new configuration, or NULL on failure.
+ */
+#define cfapplydelta(oldcfg, deltafile) confin_apply_delta(oldcfg, deltafile)
+
+/**
+ * @brief Applies a delta file to a configuration.
+ * 
+ * The result keeps the entries of the old configuration in their order, with
+ * changed entries updated and removed entries dropped, followed by the added
+ * entries. Every value is copied, the old configuration is left untouched. The
+ * delta is refused if the entry count or checksum of `oldcfg` differs from those
+ * it was computed from, if `oldcfg` has duplicate keys, or if two of its records
+ * share a key.
+ * 
+ * @param oldcfg The configuration the delta was computed from.
+ * @param deltafile The name of the delta file to apply.
+ * @return The new configuration, allocated with the allocator of `oldcfg` and to be
+ *         freed with `confin_free_config_file`, or NULL on failure.
+ */
+cffile_t *confin_apply_delta(const cffile_t *oldcfg, const char *deltafile);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_DIFF_H
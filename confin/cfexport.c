@@ -0,0 +1,554 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfexport.h" // confin/cfexport.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Size of the output buffer, flushed with a single write when full.
+ */
+#define CONFIN_EXPORT_BUFSIZE (256 * 1024)
+
+/**
+ * @brief Size of the chunks values are read and rendered in.
+ */
+#define CONFIN_EXPORT_CHUNK 4096
+
+/* output buffer */
+
+/**
+ * @brief Buffered JSON output.
+ */
+typedef struct {
+    FILE *file;    /**< Output file */
+    char *data;    /**< Pending output */
+    size_t size;   /**< Bytes used in `data` */
+    bool ok;       /**< Cleared on the first write error */
+} confin_jsonout_t;
+
+static void confin_out_flush(confin_jsonout_t *out) {
+    if (out->size && out->ok && fwrite(out->data, out->size, 1, out->file) != 1) {
+        perror("fwrite");
+        out->ok = false;
+    }
+    out->size = 0;
+}
+
+/**
+ * @brief Returns room for at least `size` bytes (at most @ref CONFIN_EXPORT_BUFSIZE).
+ */
+static inline char *confin_out_reserve(confin_jsonout_t *out, size_t size) {
+    if (out->size + size > CONFIN_EXPORT_BUFSIZE) {
+        confin_out_flush(out);
+    }
+    return out->data + out->size;
+}
+
+static inline void confin_out_write(confin_jsonout_t *out, const char *text, size_t size) {
+    while (size) {
+        size_t room = CONFIN_EXPORT_BUFSIZE - out->size;
+        if (room == 0) {
+            confin_out_flush(out);
+            room = CONFIN_EXPORT_BUFSIZE;
+        }
+        size_t part = size < room ? size : room;
+        memcpy(out->data + out->size, text, part);
+        out->size += part;
+        text += part;
+        size -= part;
+    }
+}
+
+static inline void confin_out_literal(confin_jsonout_t *out, const char *text) {
+    confin_out_write(out, text, strlen(text));
+}
+
+/* number formatting */
+
+static const char confin_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * @brief Formats an unsigned integer two digits at a time.
+ * @return The number of characters written (at most 20).
+ */
+static size_t confin_format_u64(char *out, uint64_t value) {
+    char buffer[20];
+    char *p = buffer + sizeof(buffer);
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--p = confin_digit_pairs[pair + 1];
+        *--p = confin_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        *--p = confin_digit_pairs[pair + 1];
+        *--p = confin_digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    size_t length = (size_t)(buffer + sizeof(buffer) - p);
+    memcpy(out, p, length);
+    return length;
+}
+
+static void confin_out_int(confin_jsonout_t *out, int64_t value) {
+    char *p = confin_out_reserve(out, 21);
+    size_t length = 0;
+    uint64_t magnitude = (uint64_t)value;
+    if (value < 0) {
+        p[length++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    length += confin_format_u64(p + length, magnitude);
+    out->size += length;
+}
+
+/**
+ * @brief Writes a floating-point number with the shortest of two precisions that round-trips.
+ *
+ * Integral values below 2^53 take the integer path; non-finite values become `null`.
+ */
+static void confin_out_float(confin_jsonout_t *out, double value, bool single) {
+    if (!isfinite(value)) {
+        confin_out_write(out, "null", 4);
+        return;
+    }
+    double magnitude = value < 0 ? -value : value;
+    if (magnitude < 9007199254740992.0 && value == (double)(int64_t)value) {
+        char *p = confin_out_reserve(out, 24);
+        size_t length = 0;
+        if (signbit(value)) {
+            p[length++] = '-';
+        }
+        length += confin_format_u64(p + length, (uint64_t)magnitude);
+        p[length++] = '.';
+        p[length++] = '0';
+        out->size += length;
+        return;
+    }
+
+    char *p = confin_out_reserve(out, 32);
+    int length = snprintf(p, 32, "%.*g", single ? 7 : 15, value);
+    bool exact = single ? strtof(p, NULL) == (float)value : strtod(p, NULL) == value;
+    if (!exact) {
+        length = snprintf(p, 32, "%.*g", single ? 9 : 17, value);
+    }
+    out->size += (size_t)length;
+}
+
+/* value sources */
+
+/**
+ * @brief Value being exported, read either from memory or from a file.
+ */
+typedef struct {
+    const unsigned char *data; /**< Value in memory, or NULL to read from `file` */
+    FILE *file;                /**< File positioned at the value */
+    uint64_t remaining;        /**< Bytes of the value not consumed yet */
+} confin_valuesrc_t;
+
+/**
+ * @brief Pulls the next chunk of the value.
+ * @return The number of bytes copied into `buffer`, 0 at the end of the value or on a read error.
+ */
+static size_t confin_value_pull(confin_valuesrc_t *src, unsigned char *buffer, size_t max) {
+    size_t size = src->remaining < max ? (size_t)src->remaining : max;
+    if (size == 0) {
+        return 0;
+    }
+    if (src->data) {
+        memcpy(buffer, src->data, size);
+        src->data += size;
+    } else if (fread(buffer, size, 1, src->file) != 1) {
+        return 0;
+    }
+    src->remaining -= size;
+    return size;
+}
+
+/**
+ * @brief Consumes the rest of the value.
+ * @return false if the file ended early.
+ */
+static bool confin_value_skip(confin_valuesrc_t *src) {
+    if (src->remaining && !src->data && fseek(src->file, (long)src->remaining, SEEK_CUR) != 0) {
+        return false;
+    }
+    src->remaining = 0;
+    return true;
+}
+
+/* JSON rendering */
+
+/**
+ * @brief Bytes that need escaping in a JSON string, with their short escape or 'u'.
+ */
+static char confin_escape_of(unsigned char c) {
+    switch (c) {
+        case '"': return '"';
+        case '\\': return '\\';
+        case '\b': return 'b';
+        case '\f': return 'f';
+        case '\n': return 'n';
+        case '\r': return 'r';
+        case '\t': return 't';
+        default: return c < 0x20 ? 'u' : 0;
+    }
+}
+
+/**
+ * @brief Writes the escaped bytes of a string, without the quotes.
+ * @return The number of bytes consumed, stopping at a NUL byte.
+ */
+static size_t confin_out_escaped(confin_jsonout_t *out, const unsigned char *text, size_t size, bool *terminated) {
+    size_t run = 0, i = 0;
+    for (; i < size; ++i) {
+        unsigned char c = text[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        confin_out_write(out, (const char*)text + run, i - run);
+        run = i + 1;
+        if (c == 0) {
+            *terminated = true;
+            return i + 1;
+        }
+        char escape = confin_escape_of(c);
+        char *p = confin_out_reserve(out, 6);
+        p[0] = '\\';
+        p[1] = escape;
+        if (escape == 'u') {
+            p[2] = '0';
+            p[3] = '0';
+            p[4] = "0123456789abcdef"[c >> 4];
+            p[5] = "0123456789abcdef"[c & 0xF];
+            out->size += 6;
+        } else {
+            out->size += 2;
+        }
+    }
+    confin_out_write(out, (const char*)text + run, i - run);
+    return size;
+}
+
+static void confin_out_key(confin_jsonout_t *out, const char *key) {
+    const char *end = (const char*)memchr(key, '\0', __CONFIN_STRUCT_MAX_KEYLEN);
+    size_t length = end ? (size_t)(end - key) : __CONFIN_STRUCT_MAX_KEYLEN;
+    bool terminated = false;
+    confin_out_write(out, "\"", 1);
+    confin_out_escaped(out, (const unsigned char*)key, length, &terminated);
+    confin_out_write(out, "\"", 1);
+}
+
+static bool confin_out_string(confin_jsonout_t *out, confin_valuesrc_t *src) {
+    unsigned char chunk[CONFIN_EXPORT_CHUNK];
+    bool terminated = false;
+    confin_out_write(out, "\"", 1);
+    while (!terminated && src->remaining) {
+        size_t size = confin_value_pull(src, chunk, sizeof(chunk));
+        if (size == 0) {
+            return false;
+        }
+        confin_out_escaped(out, chunk, size, &terminated);
+    }
+    confin_out_write(out, "\"", 1);
+    return confin_value_skip(src);
+}
+
+static bool confin_out_base64(confin_jsonout_t *out, confin_valuesrc_t *src) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    // Chunks are a multiple of 3 bytes so only the last one is padded
+    unsigned char chunk[CONFIN_EXPORT_CHUNK / 3 * 3];
+    confin_out_write(out, "\"", 1);
+    while (src->remaining) {
+        size_t size = confin_value_pull(src, chunk, sizeof(chunk));
+        if (size == 0) {
+            return false;
+        }
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3) {
+            char *p = confin_out_reserve(out, 4);
+            uint32_t bits = ((uint32_t)chunk[i] << 16) | ((uint32_t)chunk[i + 1] << 8) | chunk[i + 2];
+            p[0] = alphabet[bits >> 18];
+            p[1] = alphabet[(bits >> 12) & 0x3F];
+            p[2] = alphabet[(bits >> 6) & 0x3F];
+            p[3] = alphabet[bits & 0x3F];
+            out->size += 4;
+        }
+        if (i < size) {
+            char *p = confin_out_reserve(out, 4);
+            uint32_t bits = (uint32_t)chunk[i] << 16;
+            if (i + 1 < size) {
+                bits |= (uint32_t)chunk[i + 1] << 8;
+            }
+            p[0] = alphabet[bits >> 18];
+            p[1] = alphabet[(bits >> 12) & 0x3F];
+            p[2] = i + 1 < size ? alphabet[(bits >> 6) & 0x3F] : '=';
+            p[3] = '=';
+            out->size += 4;
+        }
+    }
+    confin_out_write(out, "\"", 1);
+    return true;
+}
+
+/**
+ * @brief Writes a value according to its type.
+ *
+ * INT values of 1, 2, 4 or 8 bytes and FLOAT values of 4 or 8 bytes are written
+ * as numbers, STRING values as strings up to their first NUL byte; everything
+ * else, including STRUCT values, as a base64 string.
+ */
+static bool confin_out_value(confin_jsonout_t *out, cfannotype_t type, confin_valuesrc_t *src) {
+    unsigned char scalar[8];
+    uint64_t size = src->remaining;
+
+    if (type == CONFIN_ANNOTYPE_STRING) {
+        return confin_out_string(out, src);
+    }
+    if ((type == CONFIN_ANNOTYPE_INT && (size == 1 || size == 2 || size == 4 || size == 8)) ||
+        (type == CONFIN_ANNOTYPE_FLOAT && (size == 4 || size == 8))) {
+        if (confin_value_pull(src, scalar, (size_t)size) != size) {
+            return false;
+        }
+        if (type == CONFIN_ANNOTYPE_FLOAT && size == 4) {
+            float value;
+            memcpy(&value, scalar, sizeof(value));
+            confin_out_float(out, value, true);
+        } else if (type == CONFIN_ANNOTYPE_FLOAT) {
+            double value;
+            memcpy(&value, scalar, sizeof(value));
+            confin_out_float(out, value, false);
+        } else if (size == 1) {
+            confin_out_int(out, (int8_t)scalar[0]);
+        } else if (size == 2) {
+            int16_t value;
+            memcpy(&value, scalar, sizeof(value));
+            confin_out_int(out, value);
+        } else if (size == 4) {
+            int32_t value;
+            memcpy(&value, scalar, sizeof(value));
+            confin_out_int(out, value);
+        } else {
+            int64_t value;
+            memcpy(&value, scalar, sizeof(value));
+            confin_out_int(out, value);
+        }
+        return true;
+    }
+    return confin_out_base64(out, src);
+}
+
+static const char *confin_type_name(cfannotype_t type) {
+    switch (type) {
+        case CONFIN_ANNOTYPE_INT: return "INT";
+        case CONFIN_ANNOTYPE_FLOAT: return "FLOAT";
+        case CONFIN_ANNOTYPE_STRING: return "STRING";
+        case CONFIN_ANNOTYPE_STRUCT: return "STRUCT";
+        default: return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Writes one entry: a `"key": value` member or a JSON Lines record.
+ */
+static bool confin_out_entry(confin_jsonout_t *out, cfexportfmt_t format, uint64_t index, const char *key, cfannotype_t type, confin_valuesrc_t *src) {
+    if (format == CONFIN_EXPORT_JSONL) {
+        confin_out_write(out, "{\"key\":", 7);
+        confin_out_key(out, key);
+        confin_out_write(out, ",\"type\":\"", 9);
+        confin_out_literal(out, confin_type_name(type));
+        confin_out_write(out, "\",\"value\":", 10);
+        bool ok = confin_out_value(out, type, src);
+        confin_out_write(out, "}\n", 2);
+        return ok;
+    }
+
+    confin_out_write(out, index ? ",\n  " : "{\n  ", 4);
+    confin_out_key(out, key);
+    confin_out_write(out, ": ", 2);
+    return confin_out_value(out, type, src);
+}
+
+static void confin_out_end(confin_jsonout_t *out, cfexportfmt_t format, uint64_t entrycount) {
+    if (format == CONFIN_EXPORT_JSON) {
+        confin_out_literal(out, entrycount ? "\n}\n" : "{}\n");
+    }
+}
+
+/* exporters */
+
+static bool confin_out_open(confin_jsonout_t *out, const char *output, const cfallocator_t *allocator) {
+    out->size = 0;
+    out->ok = true;
+    out->data = (char*)confin_alloc(allocator, CONFIN_EXPORT_BUFSIZE);
+    if (!out->data) {
+        perror("malloc");
+        return false;
+    }
+    out->file = output ? fopen(output, "wb") : stdout;
+    if (!out->file) {
+        perror("fopen");
+        confin_free(allocator, out->data);
+        return false;
+    }
+    return true;
+}
+
+static bool confin_out_close(confin_jsonout_t *out, bool ok, const char *output, const cfallocator_t *allocator) {
+    confin_out_flush(out);
+    ok = ok && out->ok;
+    if (output) {
+        ok = fclose(out->file) == 0 && ok;
+        if (!ok) {
+            remove(output);
+        }
+    } else {
+        ok = fflush(out->file) == 0 && ok;
+    }
+    confin_free(allocator, out->data);
+    return ok;
+}
+
+/**
+ * @brief Exports a configuration in memory as JSON or JSON Lines.
+ * @param config Pointer to the configuration.
+ * @param output The name of the file to write, or NULL for `stdout`.
+ * @param format The output format.
+ * @return true on success, false on a write error.
+ */
+bool confin_export_config(const cffile_t *config, const char *output, cfexportfmt_t format) {
+    cfallocator_t allocator = confin_resolve_allocator(NULL);
+    confin_jsonout_t out;
+    if (!confin_out_open(&out, output, &allocator)) {
+        return false;
+    }
+
+    bool ok = true;
+    for (uint64_t i = 0; i < config->header.entrycount && ok; ++i) {
+        const cfentry_t *entry = &config->entries[i];
+        confin_valuesrc_t src = {(const unsigned char*)CF_ENTRYVAL(entry), NULL, entry->size};
+        ok = confin_out_entry(&out, format, i, entry->key, entry->type, &src);
+    }
+    confin_out_end(&out, format, config->header.entrycount);
+
+    return confin_out_close(&out, ok, output, &allocator);
+}
+
+/**
+ * @brief Exports a Confin file as JSON or JSON Lines without loading it.
+ * @param filename The name of the Confin file.
+ * @param output The name of the file to write, or NULL for `stdout`.
+ * @param format The output format.
+ * @return true on success, false on an invalid input or a read or write error.
+ */
+bool confin_export_file(const char *filename, const char *output, cfexportfmt_t format) {
+    cfallocator_t allocator = confin_resolve_allocator(NULL);
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("fopen");
+        return false;
+    }
+
+    cfheader_t header;
+    cflayout_t layout = {0, 0};
+    bool ok = fread(&header, sizeof(header), 1, file) == 1;
+    if (ok && header.version >= __CONFIN_LAYOUT_VERSION) {
+        ok = fread(&layout, sizeof(layout), 1, file) == 1;
+    }
+    if (!ok) {
+        fprintf(stderr, "Unexpected end of file\n");
+    } else if (header.magic != __CONFIN_STRUCT_MAGIC_NUMBER) {
+        fprintf(stderr, "Invalid magic number\n");
+        ok = false;
+    } else if (header.version > _CF_VER) {
+        fprintf(stderr, "Invalid version\n");
+        ok = false;
+    }
+
+    // Pooled values are read through a second handle so entries keep streaming
+    bool pooled = ok && (layout.flags & CONFIN_LAYOUT_POOLED) != 0;
+    long poolstart = pooled ? ftell(file) : 0;
+    FILE *pool = NULL;
+    if (pooled) {
+        pool = fopen(filename, "rb");
+        ok = pool != NULL && poolstart >= 0 && fseek(file, poolstart + (long)layout.poolsize, SEEK_SET) == 0;
+        if (!ok) {
+            perror("fopen");
+        }
+    }
+
+    confin_jsonout_t out;
+    if (!ok || !confin_out_open(&out, output, &allocator)) {
+        if (pool) {
+            fclose(pool);
+        }
+        fclose(file);
+        return false;
+    }
+
+    for (uint64_t i = 0; i < header.entrycount && ok; ++i) {
+        cfentryhdr_t hdr;
+        if (fread(&hdr, sizeof(hdr), 1, file) != 1) {
+            fprintf(stderr, "Unexpected end of file\n");
+            ok = false;
+            break;
+        }
+
+        confin_valuesrc_t src = {NULL, file, hdr.size};
+        if (pooled) {
+            uint64_t offset;
+            if (fread(&offset, sizeof(offset), 1, file) != 1) {
+                fprintf(stderr, "Unexpected end of file\n");
+                ok = false;
+                break;
+            }
+            if (offset > layout.poolsize || hdr.size > layout.poolsize - offset) {
+                fprintf(stderr, "Invalid pool offset\n");
+                ok = false;
+                break;
+            }
+            src.file = pool;
+            if (fseek(pool, poolstart + (long)offset, SEEK_SET) != 0) {
+                ok = false;
+                break;
+            }
+        }
+
+        ok = confin_out_entry(&out, format, i, hdr.key, (cfannotype_t)hdr.type, &src);
+        if (!ok) {
+            fprintf(stderr, "Unexpected end of file\n");
+        }
+    }
+    confin_out_end(&out, format, header.entrycount);
+
+    if (pool) {
+        fclose(pool);
+    }
+    fclose(file);
+    return confin_out_close(&out, ok, output, &allocator);
+}
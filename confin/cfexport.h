@@ -0,0 +1,72 @@
+/**
+ * @file cfexport.h
+ * @brief Functions and macros for exporting Confin files as JSON.
+ * 
+ * This header file provides the JSON exporter. Values are rendered by type:
+ * INT and FLOAT as numbers, STRING as strings and STRUCT (or any value of an
+ * unusual size) as base64. Output is written in large buffered chunks, and
+ * files are streamed entry by entry so memory use does not depend on their size.
+ */
+
+#ifndef _CONFIN_EXPORT_H
+#define _CONFIN_EXPORT_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfexportfile
+ * @brief Macro to export a Confin file as JSON or JSON Lines.
+ * @param filename The name of the Confin file.
+ * @param output The name of the file to write, or NULL for `stdout`.
+ * @param format The output format.
+ * @return true on success, false on an invalid input or a read or write error.
+ */
+#define cfexportfile(filename, output, format) \
+    confin_export_file(filename, output, format)
+
+/**
+ * @brief Exports a Confin file as JSON or JSON Lines without loading it.
+ * 
+ * Entries are read one at a time and values are rendered in fixed-size chunks,
+ * so memory use is constant.
+ * 
+ * @param filename The name of the Confin file.
+ * @param output The name of the file to write, or NULL for `stdout`.
+ * @param format The output format.
+ * @return true on success, false on an invalid input or a read or write error.
+ */
+bool confin_export_file(const char *filename, const char *output, cfexportfmt_t format);
+
+/**
+ * @def cfexportcfg
+ * @brief Macro to export a configuration in memory as JSON or JSON Lines.
+ * @param config Pointer to the configuration.
+ * @param output The name of the file to write, or NULL for `stdout`.
+ * @param format The output format.
+ * @return true on success, false on a write error.
+ */
+#define cfexportcfg(config, output, format) \
+    confin_export_config(config, output, format)
+
+/**
+ * @brief Exports a configuration in memory as JSON or JSON Lines.
+ * @param config Pointer to the configuration.
+ * @param output The name of the file to write, or NULL for `stdout`.
+ * @param format The output format.
+ * @return true on success, false on a write error.
+ */
+bool confin_export_config(const cffile_t *config, const char *output, cfexportfmt_t format);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_EXPORT_H
@@ -14,6 +14,8 @@
 #include <stdbool.h>
 #endif
 
+#include "cftype.h" // confin/cftype.h
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,6 +35,23 @@ extern "C" {
  */
 bool confin_validate_file(const char *filename);
 
+/**
+ * @def cfvalidatefilectx
+ * @brief Macro to validate if a file conforms to the Confin format with a context.
+ * @param filename The name of the file to validate.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return true if the file format is valid, false otherwise.
+ */
+#define cfvalidatefilectx(filename, ctx) confin_validate_file_ctx(filename, ctx)
+
+/**
+ * @brief Function to validate if a file conforms to the Confin format with a context.
+ * @param filename The name of the file to validate.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return true if the file format is valid, false otherwise.
+ */
+bool confin_validate_file_ctx(const char *filename, cfcontext_t *ctx);
+
 /**
  * @def cfscanfile
  * @brief Macro to scan and write all information from a Confin format file to a string.
@@ -52,6 +71,27 @@ bool confin_validate_file(const char *filename);
  */
 bool confin_scan_file(const char *filename, char *output, size_t output_size);
 
+/**
+ * @def cfscanfilectx
+ * @brief Macro to scan and write all information from a Confin format file to a string with a context.
+ * @param filename The name of the file to scan.
+ * @param outputstr The output string in which information about the file will be written.
+ * @param outpusz Buffer size for output string.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return true if the file format is valid and information is displayed, false otherwise.
+ */
+#define cfscanfilectx(filename, outputstr, outpusz, ctx) confin_scan_file_ctx(filename, outputstr, outpusz, ctx)
+
+/**
+ * @brief Function to scan and write all information from a Confin format file to a string with a context.
+ * @param filename The name of the file to scan.
+ * @param output The output string in which information about the file will be written.
+ * @param output_size Buffer size for output string.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return true if the file format is valid and information is displayed, false otherwise.
+ */
+bool confin_scan_file_ctx(const char *filename, char *output, size_t output_size, cfcontext_t *ctx);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,411 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#define CONFIN_FROZEN_MMAP 1
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cffrozen.h" // confin/cffrozen.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Entries indexed by one bucket; a bucket fills one cache line.
+ */
+#define CONFIN_FROZEN_SLOTS 8
+
+/**
+ * @brief Entries per bucket on average, leaving every probe sequence an empty slot.
+ */
+#define CONFIN_FROZEN_LOAD 6
+
+/**
+ * @brief Reference of an empty slot.
+ */
+#define CONFIN_FROZEN_EMPTY UINT32_MAX
+
+/**
+ * @brief Unit of the entry references; entries are aligned to it.
+ */
+#define CONFIN_FROZEN_UNIT 8
+
+/**
+ * @brief Size and alignment of a transparent huge page.
+ */
+#define CONFIN_FROZEN_HUGEPAGE ((size_t)2 << 20)
+
+/**
+ * @brief Bucket of the frozen index.
+ */
+typedef struct {
+    uint32_t tags[CONFIN_FROZEN_SLOTS]; /**< High 32 bits of the hash of each key */
+    uint32_t refs[CONFIN_FROZEN_SLOTS]; /**< Position of each entry in CONFIN_FROZEN_UNIT units, or CONFIN_FROZEN_EMPTY */
+} confin_bucket_t;
+
+struct __s_confin_frozen {
+    cfallocator_t allocator;   /**< Allocator of this structure, and of the block when it is not mapped */
+    void *base;                /**< Start of the allocation or mapping */
+    size_t mapped;             /**< Size of the mapping, 0 if the block was allocated */
+    size_t size;               /**< Size of the block */
+    uint32_t flags;            /**< CONFIN_FREEZE_MLOCK and CONFIN_FROZEN_HUGEPAGES */
+    uint64_t mask;             /**< Number of buckets minus one */
+    uint64_t count;            /**< Number of entries */
+    const confin_bucket_t *buckets; /**< Buckets, at the start of the block */
+    const uint32_t *order;     /**< Reference of each entry in key order */
+    const char *records;       /**< Entries and their values */
+};
+
+static size_t confin_round_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static int confin_compare_entries(const void *a, const void *b) {
+    const cfentry_t *left = *(const cfentry_t *const*)a;
+    const cfentry_t *right = *(const cfentry_t *const*)b;
+    int order = strncmp(left->key, right->key, __CONFIN_STRUCT_MAX_KEYLEN);
+    // Repeated keys stay in file order, so the first one is kept
+    return order ? order : (left > right) - (left < right);
+}
+
+static size_t confin_record_size(const cfentry_t *entry) {
+    size_t size = sizeof(cfentry_t);
+    if (entry->size > __CONFIN_INLINE_VALUE_MAX) {
+        size += confin_round_up((size_t)entry->size, CONFIN_FROZEN_UNIT);
+    }
+    return size;
+}
+
+/* block */
+
+// Maps or allocates the block; huge pages are advised before the block is first touched
+static char *confin_frozen_reserve(cffrozen_t *frozen, size_t size) {
+#ifdef CONFIN_FROZEN_MMAP
+    size_t length = confin_round_up(size, CONFIN_FROZEN_HUGEPAGE);
+    char *mapping = (char*)mmap(NULL, length + CONFIN_FROZEN_HUGEPAGE, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping != (char*)MAP_FAILED) {
+        // Trims the mapping to a huge page boundary
+        char *start = (char*)confin_round_up((size_t)(uintptr_t)mapping, CONFIN_FROZEN_HUGEPAGE);
+        if (start > mapping) {
+            munmap(mapping, (size_t)(start - mapping));
+        }
+        size_t tail = (size_t)(mapping + length + CONFIN_FROZEN_HUGEPAGE - (start + length));
+        if (tail) {
+            munmap(start + length, tail);
+        }
+        frozen->base = start;
+        frozen->mapped = length;
+#ifdef MADV_HUGEPAGE
+        if (madvise(start, length, MADV_HUGEPAGE) == 0) {
+            frozen->flags |= CONFIN_FROZEN_HUGEPAGES;
+        }
+#endif
+        return start;
+    }
+#endif
+    frozen->base = confin_alloc(&frozen->allocator, size + 64);
+    if (!frozen->base) {
+        perror("malloc");
+        return NULL;
+    }
+    return (char*)confin_round_up((size_t)(uintptr_t)frozen->base, 64);
+}
+
+static void confin_frozen_release(cffrozen_t *frozen) {
+#ifdef CONFIN_FROZEN_MMAP
+    // The locked range is the block, mapped or allocated
+    if (frozen->flags & CONFIN_FREEZE_MLOCK) {
+        munlock((void*)frozen->buckets, frozen->size);
+    }
+    if (frozen->mapped) {
+        munmap(frozen->base, frozen->mapped);
+        return;
+    }
+#endif
+    confin_free(&frozen->allocator, frozen->base);
+}
+
+/* lookups */
+
+static const cfentry_t *confin_frozen_probe(const cffrozen_t *frozen, const char *key, uint64_t hash) {
+    uint32_t tag = (uint32_t)(hash >> 32);
+    for (uint64_t bucket = hash & frozen->mask;; bucket = (bucket + 1) & frozen->mask) {
+        const confin_bucket_t *slots = &frozen->buckets[bucket];
+        for (unsigned i = 0; i < CONFIN_FROZEN_SLOTS; ++i) {
+            uint32_t ref = slots->refs[i];
+            if (ref == CONFIN_FROZEN_EMPTY) {
+                return NULL;
+            }
+            if (slots->tags[i] == tag) {
+                const cfentry_t *entry = (const cfentry_t*)(frozen->records + (size_t)ref * CONFIN_FROZEN_UNIT);
+                if (strncmp(entry->key, key, __CONFIN_STRUCT_MAX_KEYLEN) == 0) {
+                    return entry;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Freezes a configuration.
+ * @param config Pointer to the configuration.
+ * @param flags Freeze options (CONFIN_FREEZE_*).
+ * @return Pointer to the frozen configuration, or NULL on failure.
+ */
+cffrozen_t *confin_freeze(const cffile_t *config, uint32_t flags) {
+    return confin_freeze_ctx(config, flags, NULL);
+}
+
+/**
+ * @brief Freezes a configuration with a context.
+ * @param config Pointer to the configuration.
+ * @param flags Freeze options (CONFIN_FREEZE_*).
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the frozen configuration, or NULL on failure.
+ */
+cffrozen_t *confin_freeze_ctx(const cffile_t *config, uint32_t flags, cfcontext_t *ctx) {
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    uint64_t entrycount = config->header.entrycount;
+    const cfentry_t **sorted = (const cfentry_t**)confin_alloc(&allocator, sizeof(*sorted) * (entrycount ? entrycount : 1));
+    if (!sorted) {
+        perror("malloc");
+        return NULL;
+    }
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        sorted[i] = &config->entries[i];
+    }
+    qsort(sorted, (size_t)entrycount, sizeof(*sorted), confin_compare_entries);
+
+    uint64_t count = 0;
+    size_t records = 0;
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        if (i && strncmp(sorted[i]->key, sorted[count - 1]->key, __CONFIN_STRUCT_MAX_KEYLEN) == 0) {
+            continue;
+        }
+        sorted[count++] = sorted[i];
+        records += confin_record_size(sorted[i]);
+    }
+    if (records / CONFIN_FROZEN_UNIT >= CONFIN_FROZEN_EMPTY) {
+        fprintf(stderr, "Configuration is too large to freeze\n");
+        confin_free(&allocator, (void*)sorted);
+        return NULL;
+    }
+    uint64_t buckets = 1;
+    while (buckets * CONFIN_FROZEN_LOAD < count) {
+        buckets *= 2;
+    }
+    size_t indexsize = (size_t)buckets * sizeof(confin_bucket_t);
+    size_t ordersize = confin_round_up((size_t)count * sizeof(uint32_t), 64);
+    size_t size = indexsize + ordersize + records;
+
+    cffrozen_t *frozen = (cffrozen_t*)confin_alloc(&allocator, sizeof(cffrozen_t));
+    if (!frozen) {
+        perror("malloc");
+        confin_free(&allocator, (void*)sorted);
+        return NULL;
+    }
+    memset(frozen, 0, sizeof(*frozen));
+    frozen->allocator = allocator;
+    char *block = confin_frozen_reserve(frozen, size);
+    if (!block) {
+        confin_free(&allocator, frozen);
+        confin_free(&allocator, (void*)sorted);
+        return NULL;
+    }
+    confin_bucket_t *index = (confin_bucket_t*)block;
+    uint32_t *order = (uint32_t*)(block + indexsize);
+    char *base = block + indexsize + ordersize;
+    memset(index, 0xFF, indexsize);
+
+    // Entries in key order, each followed by its value
+    size_t offset = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const cfentry_t *source = sorted[i];
+        cfentry_t *entry = (cfentry_t*)(base + offset);
+        memcpy(entry->key, source->key, sizeof(entry->key));
+        entry->type = source->type;
+        entry->size = source->size;
+        if (source->size <= __CONFIN_INLINE_VALUE_MAX) {
+            entry->flags = CONFIN_ENTRY_INLINE;
+            entry->value = entry->inlinevalue;
+            memset(entry->inlinevalue, 0, sizeof(entry->inlinevalue));
+            if (source->size) {
+                memcpy(entry->inlinevalue, CF_ENTRYVAL(source), (size_t)source->size);
+            }
+        } else {
+            entry->flags = CONFIN_ENTRY_SHARED;
+            entry->value = (char*)entry + sizeof(cfentry_t);
+            memcpy(entry->value, CF_ENTRYVAL(source), (size_t)source->size);
+        }
+        order[i] = (uint32_t)(offset / CONFIN_FROZEN_UNIT);
+
+        uint64_t hash = confin_hash_key(entry->key);
+        for (uint64_t bucket = hash & (buckets - 1);; bucket = (bucket + 1) & (buckets - 1)) {
+            unsigned slot = 0;
+            while (slot < CONFIN_FROZEN_SLOTS && index[bucket].refs[slot] != CONFIN_FROZEN_EMPTY) {
+                ++slot;
+            }
+            if (slot < CONFIN_FROZEN_SLOTS) {
+                index[bucket].tags[slot] = (uint32_t)(hash >> 32);
+                index[bucket].refs[slot] = order[i];
+                break;
+            }
+        }
+        offset += confin_record_size(source);
+    }
+    confin_free(&allocator, (void*)sorted);
+
+    frozen->size = size;
+    frozen->mask = buckets - 1;
+    frozen->count = count;
+    frozen->buckets = index;
+    frozen->order = order;
+    frozen->records = base;
+#ifdef CONFIN_FROZEN_MMAP
+    if (frozen->mapped) {
+        mprotect(frozen->base, frozen->mapped, PROT_READ);
+    }
+    if (flags & CONFIN_FREEZE_MLOCK) {
+        if (mlock(block, size) != 0) {
+            perror("mlock");
+            confin_frozen_release(frozen);
+            confin_free(&allocator, frozen);
+            return NULL;
+        }
+        frozen->flags |= CONFIN_FREEZE_MLOCK;
+    }
+#else
+    if (flags & CONFIN_FREEZE_MLOCK) {
+        fprintf(stderr, "Locking memory is not supported on this platform\n");
+        confin_frozen_release(frozen);
+        confin_free(&allocator, frozen);
+        return NULL;
+    }
+#endif
+    return frozen;
+}
+
+/**
+ * @brief Finds an entry of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+const cfentry_t *confin_frozen_get(const cffrozen_t *frozen, const char *key) {
+    return confin_frozen_probe(frozen, key, confin_hash_key(key));
+}
+
+/**
+ * @brief Finds the entries of several keys of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @param keys The keys to find.
+ * @param count The number of keys.
+ * @param out Receives the entry of each key (`count` elements), or NULL if it is not present.
+ * @return The number of keys found.
+ */
+size_t confin_frozen_get_many(const cffrozen_t *frozen, const char **keys, size_t count, const cfentry_t **out) {
+    uint64_t hashes[CONFIN_LOOKUP_GROUP];
+    const cfentry_t *candidates[CONFIN_LOOKUP_GROUP];
+    size_t found = 0;
+
+    for (size_t base = 0; base < count; base += CONFIN_LOOKUP_GROUP) {
+        size_t group = count - base < CONFIN_LOOKUP_GROUP ? count - base : CONFIN_LOOKUP_GROUP;
+
+        // Hash every key and prefetch its bucket
+        for (size_t i = 0; i < group; ++i) {
+            hashes[i] = confin_hash_key(keys[base + i]);
+            CONFIN_PREFETCH(&frozen->buckets[hashes[i] & frozen->mask]);
+        }
+
+        // Find the first matching fingerprint of the bucket and prefetch both lines of its entry
+        for (size_t i = 0; i < group; ++i) {
+            const confin_bucket_t *slots = &frozen->buckets[hashes[i] & frozen->mask];
+            uint32_t tag = (uint32_t)(hashes[i] >> 32);
+            candidates[i] = NULL;
+            for (unsigned slot = 0; slot < CONFIN_FROZEN_SLOTS && slots->refs[slot] != CONFIN_FROZEN_EMPTY; ++slot) {
+                if (slots->tags[slot] == tag) {
+                    candidates[i] = (const cfentry_t*)(frozen->records + (size_t)slots->refs[slot] * CONFIN_FROZEN_UNIT);
+                    CONFIN_PREFETCH(candidates[i]);
+                    CONFIN_PREFETCH((const char*)candidates[i] + 64);
+                    break;
+                }
+            }
+        }
+
+        // Compare the keys; a miss in the home bucket takes the full probe
+        for (size_t i = 0; i < group; ++i) {
+            const cfentry_t *entry = candidates[i];
+            if (!entry || strncmp(entry->key, keys[base + i], __CONFIN_STRUCT_MAX_KEYLEN) != 0) {
+                entry = confin_frozen_probe(frozen, keys[base + i], hashes[i]);
+            }
+            out[base + i] = entry;
+            found += entry != NULL;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Returns the number of entries of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @return The number of entries, without repeated keys.
+ */
+uint64_t confin_frozen_count(const cffrozen_t *frozen) {
+    return frozen->count;
+}
+
+/**
+ * @brief Returns an entry of a frozen configuration by position, in key order.
+ * @param frozen Pointer to the frozen configuration.
+ * @param index The position of the entry.
+ * @return Pointer to the entry, or NULL if the position is out of range.
+ */
+const cfentry_t *confin_frozen_entry(const cffrozen_t *frozen, uint64_t index) {
+    if (index >= frozen->count) {
+        return NULL;
+    }
+    return (const cfentry_t*)(frozen->records + (size_t)frozen->order[index] * CONFIN_FROZEN_UNIT);
+}
+
+/**
+ * @brief Returns the size of the block of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @return The size in bytes of the index, entries and values.
+ */
+size_t confin_frozen_size(const cffrozen_t *frozen) {
+    return frozen->size;
+}
+
+/**
+ * @brief Returns how a frozen configuration is backed.
+ * @param frozen Pointer to the frozen configuration.
+ * @return CONFIN_FREEZE_MLOCK and CONFIN_FROZEN_HUGEPAGES when they apply.
+ */
+uint32_t confin_frozen_flags(const cffrozen_t *frozen) {
+    return frozen->flags;
+}
+
+/**
+ * @brief Frees a frozen configuration.
+ * @param frozen Pointer to the frozen configuration; NULL is ignored.
+ */
+void confin_frozen_free(cffrozen_t *frozen) {
+    if (!frozen) {
+        return;
+    }
+    cfallocator_t allocator = frozen->allocator;
+    confin_frozen_release(frozen);
+    confin_free(&allocator, frozen);
+}
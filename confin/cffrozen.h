@@ -0,0 +1,203 @@
+/**
+ * @file cffrozen.h
+ * @brief Functions and macros for frozen, read-optimized configurations.
+ *
+ * This header file provides the frozen layout. Freezing copies a configuration
+ * into one read-only block: a hash index made of 64-byte buckets, each holding
+ * eight 32-bit key fingerprints and the positions of their entries, followed by
+ * the entries ordered by key, every value stored right after its entry. A lookup
+ * reads one bucket and one entry, and the value is on the same or the next cache
+ * line, instead of an index slot, an entry and a separately allocated value.
+ *
+ * Where memory can be mapped, the block is aligned to 2 MiB, advised for
+ * transparent huge pages, so the whole index and entry array are covered by few
+ * TLB entries, and protected read-only once built. It can also be locked in memory.
+ */
+
+#ifndef _CONFIN_FROZEN_H
+#define _CONFIN_FROZEN_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cffreeze
+ * @brief Macro to freeze a configuration.
+ * @param config Pointer to the configuration.
+ * @param flags Freeze options (CONFIN_FREEZE_*).
+ * @return Pointer to the frozen configuration, or NULL on failure.
+ */
+#define cffreeze(config, flags) confin_freeze(config, flags)
+
+/**
+ * @brief Freezes a configuration.
+ *
+ * The frozen configuration owns a copy of every entry and value, so `config`
+ * can be freed afterwards. When a key appears several times, the first entry
+ * is kept, as @ref confin_get would return it.
+ *
+ * @param config Pointer to the configuration.
+ * @param flags Freeze options (CONFIN_FREEZE_*).
+ * @return Pointer to the frozen configuration, or NULL on failure.
+ */
+cffrozen_t *confin_freeze(const cffile_t *config, uint32_t flags);
+
+/**
+ * @def cffreezectx
+ * @brief Macro to freeze a configuration with a context.
+ * @param config Pointer to the configuration.
+ * @param flags Freeze options (CONFIN_FREEZE_*).
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the frozen configuration, or NULL on failure.
+ */
+#define cffreezectx(config, flags, ctx) confin_freeze_ctx(config, flags, ctx)
+
+/**
+ * @brief Freezes a configuration with a context.
+ *
+ * The allocator of the context is used for the frozen configuration, and for
+ * its block when the block is not mapped.
+ *
+ * @param config Pointer to the configuration.
+ * @param flags Freeze options (CONFIN_FREEZE_*).
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the frozen configuration, or NULL on failure.
+ */
+cffrozen_t *confin_freeze_ctx(const cffile_t *config, uint32_t flags, cfcontext_t *ctx);
+
+/**
+ * @def cffrozenget
+ * @brief Macro to find an entry of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+#define cffrozenget(frozen, key) confin_frozen_get(frozen, key)
+
+/**
+ * @brief Finds an entry of a frozen configuration.
+ *
+ * The entry is read-only and valid until the frozen configuration is freed.
+ *
+ * @param frozen Pointer to the frozen configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+const cfentry_t *confin_frozen_get(const cffrozen_t *frozen, const char *key);
+
+/**
+ * @def cffrozengetmany
+ * @brief Macro to find the entries of several keys of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @param keys The keys to find.
+ * @param count The number of keys.
+ * @param out Receives the entry of each key, or NULL if it is not present.
+ * @return The number of keys found.
+ */
+#define cffrozengetmany(frozen, keys, count, out) confin_frozen_get_many(frozen, keys, count, out)
+
+/**
+ * @brief Finds the entries of several keys of a frozen configuration.
+ *
+ * Like @ref confin_get_many, the buckets and then the entries of a group of keys
+ * are prefetched before any of them is compared.
+ *
+ * @param frozen Pointer to the frozen configuration.
+ * @param keys The keys to find.
+ * @param count The number of keys.
+ * @param out Receives the entry of each key (`count` elements), or NULL if it is not present.
+ * @return The number of keys found.
+ */
+size_t confin_frozen_get_many(const cffrozen_t *frozen, const char **keys, size_t count, const cfentry_t **out);
+
+/**
+ * @def cffrozencount
+ * @brief Macro to get the number of entries of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @return The number of entries.
+ */
+#define cffrozencount(frozen) confin_frozen_count(frozen)
+
+/**
+ * @brief Returns the number of entries of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @return The number of entries, without repeated keys.
+ */
+uint64_t confin_frozen_count(const cffrozen_t *frozen);
+
+/**
+ * @def cffrozenentry
+ * @brief Macro to get an entry of a frozen configuration by position.
+ * @param frozen Pointer to the frozen configuration.
+ * @param index The position of the entry.
+ * @return Pointer to the entry, or NULL if the position is out of range.
+ */
+#define cffrozenentry(frozen, index) confin_frozen_entry(frozen, index)
+
+/**
+ * @brief Returns an entry of a frozen configuration by position, in key order.
+ * @param frozen Pointer to the frozen configuration.
+ * @param index The position of the entry.
+ * @return Pointer to the entry, or NULL if the position is out of range.
+ */
+const cfentry_t *confin_frozen_entry(const cffrozen_t *frozen, uint64_t index);
+
+/**
+ * @def cffrozensize
+ * @brief Macro to get the size of the block of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @return The size in bytes.
+ */
+#define cffrozensize(frozen) confin_frozen_size(frozen)
+
+/**
+ * @brief Returns the size of the block of a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ * @return The size in bytes of the index, entries and values.
+ */
+size_t confin_frozen_size(const cffrozen_t *frozen);
+
+/**
+ * @def cffrozenflags
+ * @brief Macro to get how a frozen configuration is backed.
+ * @param frozen Pointer to the frozen configuration.
+ * @return @ref CONFIN_FREEZE_MLOCK and @ref CONFIN_FROZEN_HUGEPAGES when they apply.
+ */
+#define cffrozenflags(frozen) confin_frozen_flags(frozen)
+
+/**
+ * @brief Returns how a frozen configuration is backed.
+ * @param frozen Pointer to the frozen configuration.
+ * @return @ref CONFIN_FREEZE_MLOCK if the block is locked in memory, and
+ *         @ref CONFIN_FROZEN_HUGEPAGES if it was advised for huge pages.
+ */
+uint32_t confin_frozen_flags(const cffrozen_t *frozen);
+
+/**
+ * @def cffrozenfree
+ * @brief Macro to free a frozen configuration.
+ * @param frozen Pointer to the frozen configuration.
+ */
+#define cffrozenfree(frozen) confin_frozen_free(frozen)
+
+/**
+ * @brief Frees a frozen configuration.
+ * @param frozen Pointer to the frozen configuration; NULL is ignored.
+ */
+void confin_frozen_free(cffrozen_t *frozen);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_FROZEN_H
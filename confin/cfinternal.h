@@ -0,0 +1,181 @@
+/**
+ * @file cfinternal.h
+ * @brief Internal helpers shared by the translation units of the Confin library.
+ * 
+ * This header file is not part of the public interface and is not included by
+ * `cfself.h`. It declares the allocator, hashing, entry conversion and key index
+ * helpers implemented in `confin.c`, and the internal entry points of other units.
+ */
+
+#ifndef _CONFIN_INTERNAL_H
+#define _CONFIN_INTERNAL_H
+
+#ifdef __cplusplus
+#include <cstdio>
+#else
+#include <stdio.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Hints the processor to load the cache line of an address.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define CONFIN_PREFETCH(Address) __builtin_prefetch(Address)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define CONFIN_PREFETCH(Address) _mm_prefetch((const char*)(Address), _MM_HINT_T0)
+#else
+#define CONFIN_PREFETCH(Address) ((void)(Address))
+#endif
+
+/**
+ * @brief Number of keys whose lookups are interleaved by confin_get_many and confin_frozen_get_many.
+ */
+#define CONFIN_LOOKUP_GROUP 32
+
+/**
+ * @brief Slot of a key index.
+ */
+typedef struct {
+    uint64_t hash;  /**< Hash of the key */
+    uint64_t index; /**< Index of the entry plus one, 0 if the slot is empty */
+} confin_keyslot_t;
+
+/**
+ * @brief Open-addressing hash index from keys to entry indices.
+ */
+typedef struct {
+    uint64_t mask;           /**< Number of slots minus one */
+    confin_keyslot_t *slots; /**< Slots, a power of two of them */
+} confin_keyindex_t;
+
+/**
+ * @brief Returns a new configuration generation, unique for the process and never 0.
+ */
+uint64_t confin_next_generation(void);
+
+/**
+ * @brief Resolves the allocator used by a call.
+ * @param ctx The context of the call, or NULL.
+ * @return The allocator of the context if it has one, the global allocator otherwise.
+ */
+cfallocator_t confin_resolve_allocator(const cfcontext_t *ctx);
+
+/**
+ * @brief Allocates a block with an allocator.
+ */
+void *confin_alloc(const cfallocator_t *allocator, size_t size);
+
+/**
+ * @brief Resizes a block with an allocator.
+ */
+void *confin_realloc(const cfallocator_t *allocator, void *ptr, size_t size);
+
+/**
+ * @brief Frees a block with an allocator; NULL is ignored.
+ */
+void confin_free(const cfallocator_t *allocator, void *ptr);
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of a byte range.
+ */
+uint64_t confin_hash_bytes(const void *data, uint64_t size);
+
+/**
+ * @brief Computes the hash of a key, up to its terminator or @ref __CONFIN_STRUCT_MAX_KEYLEN bytes.
+ */
+uint64_t confin_hash_key(const char *key);
+
+/**
+ * @brief Computes the checksum of an entry: a hash of its key, type and value.
+ * 
+ * The checksum of a configuration is the wrapping sum of those of its entries
+ * (see @ref __s_confin_delta_base).
+ */
+uint64_t confin_entry_checksum(const cfentry_t *entry);
+
+/**
+ * @brief Fills the on-disk header of an entry.
+ */
+void confin_entry_to_header(const cfentry_t *entry, cfentryhdr_t *hdr);
+
+/**
+ * @brief Initializes an in-memory entry from its on-disk header; the value is cleared.
+ */
+void confin_entry_from_header(const cfentryhdr_t *hdr, cfentry_t *entry);
+
+/**
+ * @brief Allocates an empty configuration file structure for `entrycount` entries.
+ * 
+ * The header and layout are initialized for the current version and the entry
+ * count is set to 0; it is incremented by the caller as entries are filled in,
+ * so that a partially built structure can be freed with `confin_free_config_file`.
+ */
+cffile_t *confin_alloc_config(const cfallocator_t *allocator, uint64_t entrycount);
+
+/**
+ * @brief Copies an entry, giving the copy its own value.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_copy_entry(cfentry_t *dst, const cfentry_t *src, const cfallocator_t *allocator);
+
+/**
+ * @brief Moves an entry, pointing the value of an inline entry at its new place.
+ */
+void confin_move_entry(cfentry_t *dst, const cfentry_t *src);
+
+/**
+ * @brief Builds a key index over an array of entries.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_keyindex_build(confin_keyindex_t *index, const cfentry_t *entries, uint64_t entrycount, const cfallocator_t *allocator);
+
+/**
+ * @brief Finds a key in a key index.
+ * @param index The key index.
+ * @param entries The entries the index was built over.
+ * @param key The key to find.
+ * @param hash The hash of the key (see @ref confin_hash_key).
+ * @return The index of the entry, or UINT64_MAX if the key is not present.
+ */
+uint64_t confin_keyindex_find(const confin_keyindex_t *index, const cfentry_t *entries, const char *key, uint64_t hash);
+
+/**
+ * @brief Frees the slots of a key index.
+ */
+void confin_keyindex_free(confin_keyindex_t *index, const cfallocator_t *allocator);
+
+/**
+ * @brief Appends entries already encoded as in the file to a streaming writer.
+ */
+bool confin_writer_append_encoded(cfwriter_t *writer, const void *records, size_t size, uint64_t count);
+
+/**
+ * @brief Opens a streaming writer with a buffer of `capacity` bytes that only holds its file open while it flushes.
+ */
+cfwriter_t *confin_writer_open_detached(const char *filename, size_t capacity, cfcontext_t *ctx);
+
+/**
+ * @brief Writes the header of a delta file and the description of its base configuration.
+ * @return true on success, false on a write error.
+ */
+bool confin_write_delta_header(FILE *file, uint64_t count, const cfdeltabase_t *base);
+
+/**
+ * @brief Writes one record of a delta file.
+ * @return true on success, false on a write error.
+ */
+bool confin_write_delta_record(FILE *file, const cfentry_t *entry, cfdeltaop_t op);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_INTERNAL_H
@@ -41,6 +41,65 @@ extern "C" {
  */
 void confin_write_config(const char *filename, cfentry_t *entries, uint64_t entrycount);
 
+/**
+ * @brief Macro to write the configuration to a file with writer options.
+ * 
+ * This macro calls the `confin_write_config_ex` function to write the given
+ * configuration entries to the specified file.
+ * 
+ * @param filename The name of the file to write the configuration to.
+ * @param entries Array of configuration entries to write.
+ * @param entrycount Number of configuration entries.
+ * @param flags Writer options (CONFIN_WRITE_*).
+ */
+#define cfwritecfgex(filename, entries, entrycount, flags) \
+    confin_write_config_ex(filename, entries, entrycount, flags)
+
+/**
+ * @brief Writes the configuration to a file with writer options.
+ * 
+ * This function writes an array of configuration entries to a specified file.
+ * With @ref CONFIN_WRITE_DEDUP identical values are hashed and stored once in a
+ * value pool; entries reference their payload by pool offset, and reading such a
+ * file returns entries whose values are shared pointers into the pool. With
+ * @ref CONFIN_WRITE_OFFSETS an offset table is appended to files that are not
+ * pooled, so that they can be loaded in parallel.
+ * 
+ * @param filename The name of the file to write the configuration to.
+ * @param entries Array of configuration entries to write.
+ * @param entrycount Number of configuration entries.
+ * @param flags Writer options (CONFIN_WRITE_*).
+ */
+void confin_write_config_ex(const char *filename, cfentry_t *entries, uint64_t entrycount, uint32_t flags);
+
+/**
+ * @brief Macro to write the configuration to a file with writer options and a context.
+ * 
+ * This macro calls the `confin_write_config_ctx` function.
+ * 
+ * @param filename The name of the file to write the configuration to.
+ * @param entries Array of configuration entries to write.
+ * @param entrycount Number of configuration entries.
+ * @param flags Writer options (CONFIN_WRITE_*).
+ * @param ctx The context of the call, or NULL for the global settings.
+ */
+#define cfwritecfgctx(filename, entries, entrycount, flags, ctx) \
+    confin_write_config_ctx(filename, entries, entrycount, flags, ctx)
+
+/**
+ * @brief Writes the configuration to a file with writer options and a context.
+ * 
+ * Same as `confin_write_config_ex`; temporary memory is allocated with the
+ * allocator of the context.
+ * 
+ * @param filename The name of the file to write the configuration to.
+ * @param entries Array of configuration entries to write.
+ * @param entrycount Number of configuration entries.
+ * @param flags Writer options (CONFIN_WRITE_*).
+ * @param ctx The context of the call, or NULL for the global settings.
+ */
+void confin_write_config_ctx(const char *filename, cfentry_t *entries, uint64_t entrycount, uint32_t flags, cfcontext_t *ctx);
+
 /**
  * @brief Macro to write the configuration to a file using a configuration file structure.
  * 
@@ -86,6 +145,31 @@ void confin_write_config_file(const char *filename, cffile_t *file);
  */
 cffile_t *confin_read_config(const char *filename);
 
+/**
+ * @brief Macro to read the configuration from a file with a context.
+ * 
+ * This macro calls the `confin_read_config_ctx` function.
+ * 
+ * @param filename The name of the file to read the configuration from.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+#define cfreadcfgctx(filename, ctx) \
+    confin_read_config_ctx(filename, ctx)
+
+/**
+ * @brief Reads the configuration from a file with a context.
+ * 
+ * Same as `confin_read_config`; the returned structure, its pool and values are
+ * allocated with the allocator of the context, which is remembered so that
+ * `confin_free_config_file` releases them with the same allocator.
+ * 
+ * @param filename The name of the file to read the configuration from.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+cffile_t *confin_read_config_ctx(const char *filename, cfcontext_t *ctx);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,181 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cflookup.h" // confin/cflookup.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Finds the index of the first entry with a key.
+ * @return The index of the entry, or UINT64_MAX if the key is not present.
+ */
+static uint64_t confin_find_index(cffile_t *config, const char *key) {
+    if (config->index || confin_index_config(config)) {
+        return confin_keyindex_find((const confin_keyindex_t*)config->index, config->entries, key, confin_hash_key(key));
+    }
+    for (uint64_t i = 0; i < config->header.entrycount; ++i) {
+        if (strncmp(config->entries[i].key, key, __CONFIN_STRUCT_MAX_KEYLEN) == 0) {
+            return i;
+        }
+    }
+    return UINT64_MAX;
+}
+
+/**
+ * @brief Builds the key index of a configuration if it has none.
+ * @param config Pointer to the configuration.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_index_config(cffile_t *config) {
+    if (config->index) {
+        return true;
+    }
+    confin_keyindex_t *index = (confin_keyindex_t*)confin_alloc(&config->allocator, sizeof(confin_keyindex_t));
+    if (!index) {
+        perror("malloc");
+        return false;
+    }
+    if (!confin_keyindex_build(index, config->entries, config->header.entrycount, &config->allocator)) {
+        confin_free(&config->allocator, index);
+        return false;
+    }
+    config->index = index;
+    return true;
+}
+
+/**
+ * @brief Finds an entry by key.
+ * @param config Pointer to the configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+const cfentry_t *confin_get(cffile_t *config, const char *key) {
+    uint64_t i = confin_find_index(config, key);
+    return i == UINT64_MAX ? NULL : &config->entries[i];
+}
+
+/**
+ * @brief Finds the entries of several keys at once.
+ * @param config Pointer to the configuration.
+ * @param keys The keys to find.
+ * @param count The number of keys.
+ * @param out Receives the entry of each key, or NULL if it is not present.
+ * @return The number of keys found.
+ */
+size_t confin_get_many(cffile_t *config, const char **keys, size_t count, const cfentry_t **out) {
+    size_t found = 0;
+    if (!config->index && !confin_index_config(config)) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = confin_get(config, keys[i]);
+            found += out[i] != NULL;
+        }
+        return found;
+    }
+
+    const confin_keyindex_t *index = (const confin_keyindex_t*)config->index;
+    uint64_t hashes[CONFIN_LOOKUP_GROUP];
+    uint64_t candidates[CONFIN_LOOKUP_GROUP];
+
+    for (size_t base = 0; base < count; base += CONFIN_LOOKUP_GROUP) {
+        size_t group = count - base < CONFIN_LOOKUP_GROUP ? count - base : CONFIN_LOOKUP_GROUP;
+
+        // Hash every key and prefetch its home slot
+        for (size_t i = 0; i < group; ++i) {
+            hashes[i] = confin_hash_key(keys[base + i]);
+            CONFIN_PREFETCH(&index->slots[hashes[i] & index->mask]);
+        }
+
+        // Find the first slot with a matching hash and prefetch its entry
+        for (size_t i = 0; i < group; ++i) {
+            uint64_t slot = hashes[i] & index->mask;
+            candidates[i] = UINT64_MAX;
+            while (index->slots[slot].index) {
+                if (index->slots[slot].hash == hashes[i]) {
+                    candidates[i] = index->slots[slot].index - 1;
+                    CONFIN_PREFETCH(&config->entries[candidates[i]]);
+                    break;
+                }
+                slot = (slot + 1) & index->mask;
+            }
+        }
+
+        // Compare the keys, take the slow path on a hash collision, and prefetch the values
+        for (size_t i = 0; i < group; ++i) {
+            uint64_t entry = candidates[i];
+            if (entry != UINT64_MAX &&
+                strncmp(config->entries[entry].key, keys[base + i], __CONFIN_STRUCT_MAX_KEYLEN) != 0) {
+                entry = confin_keyindex_find(index, config->entries, keys[base + i], hashes[i]);
+            }
+            if (entry == UINT64_MAX) {
+                out[base + i] = NULL;
+                continue;
+            }
+            const cfentry_t *result = &config->entries[entry];
+            if (!(result->flags & CONFIN_ENTRY_INLINE)) {
+                CONFIN_PREFETCH(result->value);
+            }
+            out[base + i] = result;
+            ++found;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Resolves a key into a handle for repeated lookups.
+ * @param config Pointer to the configuration.
+ * @param key The key to resolve.
+ * @return The handle, with a zero generation if the key is not present.
+ */
+cfkeyhandle_t confin_resolve(cffile_t *config, const char *key) {
+    cfkeyhandle_t handle = {0, 0};
+    uint64_t i = confin_find_index(config, key);
+    if (i != UINT64_MAX) {
+        handle.generation = config->generation;
+        handle.index = i;
+    }
+    return handle;
+}
+
+/**
+ * @brief Gets the entry of a key handle.
+ * @param config Pointer to the configuration.
+ * @param handle The handle.
+ * @return Pointer to the entry, or NULL if the handle is not valid for `config`.
+ */
+const cfentry_t *confin_get_by_handle(const cffile_t *config, cfkeyhandle_t handle) {
+    if (handle.generation != config->generation || handle.index >= config->header.entrycount) {
+        return NULL;
+    }
+    return &config->entries[handle.index];
+}
+
+/**
+ * @brief Brings a key handle up to date with a configuration.
+ * @param config Pointer to the configuration.
+ * @param handle The handle to update.
+ * @param key The key the handle was resolved for.
+ * @return true if the key is present in `config`, false otherwise.
+ */
+bool confin_revalidate(cffile_t *config, cfkeyhandle_t *handle, const char *key) {
+    if (handle->generation == config->generation && handle->index < config->header.entrycount) {
+        return true;
+    }
+    if (handle->generation != 0 && handle->index < config->header.entrycount &&
+        strncmp(config->entries[handle->index].key, key, __CONFIN_STRUCT_MAX_KEYLEN) == 0) {
+        handle->generation = config->generation;
+        return true;
+    }
+    *handle = confin_resolve(config, key);
+    return handle->generation != 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file cflookup.h
+ * @brief Functions and macros for key lookups in a loaded configuration.
+ * 
+ * This header file provides hashed lookups by key and pre-resolved key handles.
+ * The key index of a configuration is built on its first lookup (or explicitly by
+ * @ref confin_index_config) and freed with the configuration. Building the index
+ * modifies the configuration, so build it before sharing a configuration between
+ * threads; lookups on an indexed configuration only read it.
+ * 
+ * A key handle records the position of an entry together with the generation of
+ * the configuration, a number unique to every loaded or built configuration. A
+ * lookup by handle is one compare and a bounds-checked array index, and a handle
+ * from a previous configuration is detected and can be revalidated after a reload.
+ */
+
+#ifndef _CONFIN_LOOKUP_H
+#define _CONFIN_LOOKUP_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfindexcfg
+ * @brief Macro to build the key index of a configuration.
+ * @param config Pointer to the configuration.
+ * @return true on success, false if memory could not be allocated.
+ */
+#define cfindexcfg(config) confin_index_config(config)
+
+/**
+ * @brief Builds the key index of a configuration if it has none.
+ * @param config Pointer to the configuration.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_index_config(cffile_t *config);
+
+/**
+ * @def cfget
+ * @brief Macro to find an entry by key.
+ * @param config Pointer to the configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+#define cfget(config, key) confin_get(config, key)
+
+/**
+ * @brief Finds an entry by key.
+ * 
+ * Uses the key index, building it on the first call; if it cannot be built the
+ * entries are searched linearly. When a key appears several times, the first
+ * entry is returned.
+ * 
+ * @param config Pointer to the configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+const cfentry_t *confin_get(cffile_t *config, const char *key);
+
+/**
+ * @def cfgetmany
+ * @brief Macro to find the entries of several keys at once.
+ * @param config Pointer to the configuration.
+ * @param keys The keys to find.
+ * @param count The number of keys.
+ * @param out Receives the entry of each key, or NULL if it is not present.
+ * @return The number of keys found.
+ */
+#define cfgetmany(config, keys, count, out) confin_get_many(config, keys, count, out)
+
+/**
+ * @brief Finds the entries of several keys at once.
+ * 
+ * Keys are processed in groups: every key of a group is hashed and its index slot
+ * prefetched, then the candidate entries are prefetched, then the keys are
+ * compared and the values prefetched. The cache misses of a group overlap instead
+ * of being taken one after the other, which pays off on configurations larger than
+ * the cache.
+ * 
+ * @param config Pointer to the configuration.
+ * @param keys The keys to find.
+ * @param count The number of keys.
+ * @param out Receives the entry of each key (`count` elements), or NULL if it is not present.
+ * @return The number of keys found.
+ */
+size_t confin_get_many(cffile_t *config, const char **keys, size_t count, const cfentry_t **out);
+
+/**
+ * @def cfresolve
+ * @brief Macro to resolve a key into a handle.
+ * @param config Pointer to the configuration.
+ * @param key The key to resolve.
+ * @return The handle, with a zero generation if the key is not present.
+ */
+#define cfresolve(config, key) confin_resolve(config, key)
+
+/**
+ * @brief Resolves a key into a handle for repeated lookups.
+ * @param config Pointer to the configuration.
+ * @param key The key to resolve.
+ * @return The handle, with a zero generation if the key is not present.
+ */
+cfkeyhandle_t confin_resolve(cffile_t *config, const char *key);
+
+/**
+ * @def cfgetbyhandle
+ * @brief Macro to get the entry of a key handle.
+ * @param config Pointer to the configuration.
+ * @param handle The handle.
+ * @return Pointer to the entry, or NULL if the handle is not valid for `config`.
+ */
+#define cfgetbyhandle(config, handle) confin_get_by_handle(config, handle)
+
+/**
+ * @brief Gets the entry of a key handle.
+ * @param config Pointer to the configuration.
+ * @param handle The handle.
+ * @return Pointer to the entry, or NULL if the handle was resolved in another
+ *         configuration or for a key that is not present.
+ */
+const cfentry_t *confin_get_by_handle(const cffile_t *config, cfkeyhandle_t handle);
+
+/**
+ * @def cfrevalidate
+ * @brief Macro to bring a key handle up to date with a configuration.
+ * @param config Pointer to the configuration.
+ * @param handle The handle to update.
+ * @param key The key the handle was resolved for.
+ * @return true if the key is present in `config`, false otherwise.
+ */
+#define cfrevalidate(config, handle, key) confin_revalidate(config, handle, key)
+
+/**
+ * @brief Brings a key handle up to date with a configuration, typically after a reload.
+ * 
+ * A handle that is already valid is left as is. Otherwise the entry at the same
+ * position is checked first, since reloads usually keep the order of the keys,
+ * and the key is resolved again only if it moved.
+ * 
+ * @param config Pointer to the configuration.
+ * @param handle The handle to update.
+ * @param key The key the handle was resolved for.
+ * @return true if the key is present in `config`, false otherwise.
+ */
+bool confin_revalidate(cffile_t *config, cfkeyhandle_t *handle, const char *key);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_LOOKUP_H
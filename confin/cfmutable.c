@@ -0,0 +1,1441 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfio.h" // confin/cfio.h
+#include "cfutils.h" // confin/cfutils.h
+#include "cfdiff.h" // confin/cfdiff.h
+#include "cfwriter.h" // confin/cfwriter.h
+#include "cfmutable.h" // confin/cfmutable.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Number of hash bits consumed by each level of the trie.
+ */
+#define CONFIN_TRIE_BITS 5
+
+/**
+ * @brief Shift from which nodes are collision nodes: items whose whole hashes are equal.
+ */
+#define CONFIN_TRIE_MAX_SHIFT 64
+
+/* reference counts and the head lock */
+
+static void confin_ref_acquire(uint64_t *refcount) {
+#ifdef _MSC_VER
+    _InterlockedIncrement64((volatile __int64*)refcount);
+#else
+    __atomic_add_fetch(refcount, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * @return true if the last reference was dropped.
+ */
+static bool confin_ref_drop(uint64_t *refcount) {
+#ifdef _MSC_VER
+    return _InterlockedDecrement64((volatile __int64*)refcount) == 0;
+#else
+    return __atomic_sub_fetch(refcount, 1, __ATOMIC_ACQ_REL) == 0;
+#endif
+}
+
+static void confin_spin_lock(long *lock) {
+#ifdef _MSC_VER
+    while (_InterlockedExchange((volatile long*)lock, 1)) {
+        while (*(volatile long*)lock) {
+        }
+    }
+#else
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+        }
+    }
+#endif
+}
+
+static void confin_spin_unlock(long *lock) {
+#ifdef _MSC_VER
+    _InterlockedExchange((volatile long*)lock, 0);
+#else
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+#endif
+}
+
+/* the commit lock, which may be held while a file is written */
+
+#ifdef _WIN32
+typedef SRWLOCK confin_mutex_t;
+#else
+typedef pthread_mutex_t confin_mutex_t;
+#endif
+
+static bool confin_mutex_init(confin_mutex_t *mutex) {
+#ifdef _WIN32
+    InitializeSRWLock(mutex);
+    return true;
+#else
+    return pthread_mutex_init(mutex, NULL) == 0;
+#endif
+}
+
+static void confin_mutex_destroy(confin_mutex_t *mutex) {
+#ifdef _WIN32
+    (void)mutex;
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+static void confin_mutex_lock(confin_mutex_t *mutex) {
+#ifdef _WIN32
+    AcquireSRWLockExclusive(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+static void confin_mutex_unlock(confin_mutex_t *mutex) {
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+static unsigned confin_popcount(uint32_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_popcount(bits);
+#else
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    return (unsigned)((((bits + (bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#endif
+}
+
+/* trie */
+
+/**
+ * @brief Entry of a version, shared by every version it belongs to.
+ *
+ * Values that are not stored inline follow the item in the same block.
+ */
+typedef struct {
+    uint64_t refcount;      /**< Number of nodes referencing the item */
+    uint64_t hash;          /**< Hash of the key */
+    uint64_t sequence;      /**< Insertion order, kept when the value is replaced */
+    uint64_t checksum;      /**< Checksum of the entry, summed into that of the versions */
+    cfentry_t entry;        /**< The entry */
+} confin_item_t;
+
+#ifdef _MSC_VER
+    #pragma warning(push)
+    #pragma warning(disable: 4200)
+#endif
+
+/**
+ * @brief Node of the hash trie.
+ *
+ * Each level consumes CONFIN_TRIE_BITS bits of the hash; a bit set in `datamap`
+ * selects an item and a bit set in `nodemap` a child. Items come first in `slots`,
+ * both in bit order. Below CONFIN_TRIE_MAX_SHIFT, nodes have empty maps and hold
+ * the items whose hashes collide. A node is modified in place only by the
+ * transaction that created it, before it is committed.
+ */
+typedef struct {
+    uint64_t refcount;      /**< Number of nodes or versions referencing the node */
+    uint64_t owner;         /**< Identifier of the transaction that created the node */
+    uint32_t datamap;       /**< Slots holding items */
+    uint32_t nodemap;       /**< Slots holding children */
+    uint32_t items;         /**< Number of items */
+    uint32_t children;      /**< Number of children */
+    void *slots[];          /**< Items, then children */
+} confin_node_t;
+
+#ifdef _MSC_VER
+    #pragma warning(pop)
+#endif
+
+/**
+ * @struct __s_confin_snapshot
+ * @brief Structure for a committed version of a mutable configuration.
+ */
+struct __s_confin_snapshot {
+    uint64_t refcount;       /**< Number of holders of the version */
+    confin_node_t *root;     /**< Root of the trie */
+    uint64_t count;          /**< Number of entries */
+    uint64_t checksum;       /**< Checksum of the entries, the base of a delta from this version */
+    uint64_t version;        /**< Number of the version, 1 for the initial one */
+    uint64_t nextsequence;   /**< Sequence of the next new key */
+    cfallocator_t allocator; /**< Allocator of the version, its nodes and items */
+};
+
+/**
+ * @struct __s_confin_mutable
+ * @brief Structure for a mutable configuration.
+ */
+struct __s_confin_mutable {
+    cfsnapshot_t *head;      /**< Current version */
+    long lock;               /**< Guards `head` and the history while they are read or replaced */
+    confin_mutex_t commitlock; /**< Serializes commits, held while a delta is written */
+    cfsnapshot_t **history;  /**< Retained versions, a ring of `depth` of them */
+    uint32_t depth;          /**< Number of versions retained, the current one included */
+    uint32_t retained;       /**< Number of versions in `history` */
+    uint32_t newest;         /**< Position of the current version in `history` */
+    char *directory;         /**< Directory versions are saved to, or NULL */
+    cfallocator_t allocator; /**< Allocator of the configuration and its versions */
+};
+
+/**
+ * @struct __s_confin_txn
+ * @brief Structure for a transaction on a mutable configuration.
+ */
+struct __s_confin_txn {
+    cfmutable_t *config;     /**< Configuration the transaction commits to */
+    cfsnapshot_t *base;      /**< Version the transaction started from */
+    confin_node_t *root;     /**< Root of the trie being edited */
+    uint64_t count;          /**< Number of entries */
+    uint64_t checksum;       /**< Checksum of the entries */
+    uint64_t nextsequence;   /**< Sequence of the next new key */
+    uint64_t id;             /**< Owner of the nodes created by the transaction */
+    bool failed;             /**< Set by the first failed allocation */
+    cfallocator_t allocator; /**< Allocator of the configuration */
+};
+
+static void confin_item_release(const cfallocator_t *allocator, confin_item_t *item) {
+    if (confin_ref_drop(&item->refcount)) {
+        confin_free(allocator, item);
+    }
+}
+
+static void confin_node_release(const cfallocator_t *allocator, confin_node_t *node) {
+    if (!confin_ref_drop(&node->refcount)) {
+        return;
+    }
+    for (uint32_t i = 0; i < node->items; ++i) {
+        confin_item_release(allocator, (confin_item_t*)node->slots[i]);
+    }
+    for (uint32_t i = 0; i < node->children; ++i) {
+        confin_node_release(allocator, (confin_node_t*)node->slots[node->items + i]);
+    }
+    confin_free(allocator, node);
+}
+
+static void confin_snapshot_drop(cfsnapshot_t *snapshot) {
+    if (confin_ref_drop(&snapshot->refcount)) {
+        cfallocator_t allocator = snapshot->allocator;
+        confin_node_release(&allocator, snapshot->root);
+        confin_free(&allocator, snapshot);
+    }
+}
+
+static confin_node_t *confin_node_alloc(cftxn_t *txn, uint32_t items, uint32_t children) {
+    confin_node_t *node = (confin_node_t*)confin_alloc(&txn->allocator, sizeof(confin_node_t) + sizeof(void*) * (items + children));
+    if (!node) {
+        perror("malloc");
+        txn->failed = true;
+        return NULL;
+    }
+    node->refcount = 1;
+    node->owner = txn->id;
+    node->datamap = 0;
+    node->nodemap = 0;
+    node->items = items;
+    node->children = children;
+    return node;
+}
+
+/**
+ * @brief Copies the slots `[from, from + count)` of a node, sharing what they reference.
+ */
+static void confin_node_share(void **dst, const confin_node_t *node, uint32_t from, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        dst[i] = node->slots[from + i];
+        confin_ref_acquire((uint64_t*)dst[i]);
+    }
+}
+
+/**
+ * @brief Returns a node the transaction may modify in place.
+ *
+ * The caller's reference to `node` is transferred to the result: a node created by
+ * the transaction is returned as is, any other node is copied and released.
+ * @return The node to modify, or NULL if memory could not be allocated (the
+ *         caller keeps its reference to `node`).
+ */
+static confin_node_t *confin_node_writable(cftxn_t *txn, confin_node_t *node) {
+    if (node->owner == txn->id) {
+        return node;
+    }
+    confin_node_t *copy = confin_node_alloc(txn, node->items, node->children);
+    if (!copy) {
+        return NULL;
+    }
+    copy->datamap = node->datamap;
+    copy->nodemap = node->nodemap;
+    confin_node_share(copy->slots, node, 0, node->items + node->children);
+    confin_node_release(&txn->allocator, node);
+    return copy;
+}
+
+static bool confin_item_matches(const confin_item_t *item, uint64_t hash, const char *key) {
+    return item->hash == hash && strncmp(item->entry.key, key, __CONFIN_STRUCT_MAX_KEYLEN) == 0;
+}
+
+static const confin_item_t *confin_node_find(const confin_node_t *node, uint64_t hash, const char *key) {
+    for (unsigned shift = 0;; shift += CONFIN_TRIE_BITS) {
+        if (shift >= CONFIN_TRIE_MAX_SHIFT) {
+            for (uint32_t i = 0; i < node->items; ++i) {
+                if (confin_item_matches((const confin_item_t*)node->slots[i], hash, key)) {
+                    return (const confin_item_t*)node->slots[i];
+                }
+            }
+            return NULL;
+        }
+        uint32_t bit = 1u << ((hash >> shift) & 31);
+        if (node->datamap & bit) {
+            const confin_item_t *item = (const confin_item_t*)node->slots[confin_popcount(node->datamap & (bit - 1))];
+            return confin_item_matches(item, hash, key) ? item : NULL;
+        }
+        if (!(node->nodemap & bit)) {
+            return NULL;
+        }
+        node = (const confin_node_t*)node->slots[node->items + confin_popcount(node->nodemap & (bit - 1))];
+    }
+}
+
+/**
+ * @brief Builds the subtrie holding two items whose hashes agree below `shift`.
+ *
+ * Takes a new reference to `existing` and the caller's reference to `item`, which
+ * is released on failure.
+ */
+static confin_node_t *confin_node_merge(cftxn_t *txn, confin_item_t *existing, confin_item_t *item, unsigned shift) {
+    if (shift >= CONFIN_TRIE_MAX_SHIFT) {
+        confin_node_t *node = confin_node_alloc(txn, 2, 0);
+        if (!node) {
+            confin_item_release(&txn->allocator, item);
+            return NULL;
+        }
+        confin_ref_acquire(&existing->refcount);
+        node->slots[0] = existing;
+        node->slots[1] = item;
+        return node;
+    }
+
+    uint32_t existingbit = 1u << ((existing->hash >> shift) & 31);
+    uint32_t itembit = 1u << ((item->hash >> shift) & 31);
+    if (existingbit == itembit) {
+        confin_node_t *child = confin_node_merge(txn, existing, item, shift + CONFIN_TRIE_BITS);
+        if (!child) {
+            return NULL;
+        }
+        confin_node_t *node = confin_node_alloc(txn, 0, 1);
+        if (!node) {
+            confin_node_release(&txn->allocator, child);
+            return NULL;
+        }
+        node->nodemap = itembit;
+        node->slots[0] = child;
+        return node;
+    }
+
+    confin_node_t *node = confin_node_alloc(txn, 2, 0);
+    if (!node) {
+        confin_item_release(&txn->allocator, item);
+        return NULL;
+    }
+    confin_ref_acquire(&existing->refcount);
+    node->datamap = existingbit | itembit;
+    node->slots[existingbit < itembit ? 0 : 1] = existing;
+    node->slots[existingbit < itembit ? 1 : 0] = item;
+    return node;
+}
+
+/**
+ * @brief Inserts or replaces an item in a subtrie.
+ *
+ * Takes the caller's references to `node` and `item` and returns the node to store
+ * in their place. `replaced` receives the checksum of the item replaced, if any. On
+ * failure the transaction is marked as failed, `item` is released and the subtrie is
+ * left unchanged.
+ */
+static confin_node_t *confin_node_set(cftxn_t *txn, confin_node_t *node, unsigned shift, confin_item_t *item, bool *added, uint64_t *replaced) {
+    if (shift >= CONFIN_TRIE_MAX_SHIFT) {
+        for (uint32_t i = 0; i < node->items; ++i) {
+            confin_item_t *existing = (confin_item_t*)node->slots[i];
+            if (confin_item_matches(existing, item->hash, item->entry.key)) {
+                confin_node_t *writable = confin_node_writable(txn, node);
+                if (!writable) {
+                    confin_item_release(&txn->allocator, item);
+                    return node;
+                }
+                item->sequence = existing->sequence;
+                *replaced = existing->checksum;
+                writable->slots[i] = item;
+                confin_item_release(&txn->allocator, existing);
+                return writable;
+            }
+        }
+        confin_node_t *grown = confin_node_alloc(txn, node->items + 1, 0);
+        if (!grown) {
+            confin_item_release(&txn->allocator, item);
+            return node;
+        }
+        confin_node_share(grown->slots, node, 0, node->items);
+        grown->slots[node->items] = item;
+        confin_node_release(&txn->allocator, node);
+        *added = true;
+        return grown;
+    }
+
+    uint32_t bit = 1u << ((item->hash >> shift) & 31);
+    uint32_t dataindex = confin_popcount(node->datamap & (bit - 1));
+    uint32_t childindex = confin_popcount(node->nodemap & (bit - 1));
+
+    if (node->datamap & bit) {
+        confin_item_t *existing = (confin_item_t*)node->slots[dataindex];
+        if (confin_item_matches(existing, item->hash, item->entry.key)) {
+            confin_node_t *writable = confin_node_writable(txn, node);
+            if (!writable) {
+                confin_item_release(&txn->allocator, item);
+                return node;
+            }
+            item->sequence = existing->sequence;
+            *replaced = existing->checksum;
+            writable->slots[dataindex] = item;
+            confin_item_release(&txn->allocator, existing);
+            return writable;
+        }
+
+        // Push both items down into a new child
+        confin_node_t *child = confin_node_merge(txn, existing, item, shift + CONFIN_TRIE_BITS);
+        if (!child) {
+            return node;
+        }
+        confin_node_t *moved = confin_node_alloc(txn, node->items - 1, node->children + 1);
+        if (!moved) {
+            confin_node_release(&txn->allocator, child);
+            return node;
+        }
+        moved->datamap = node->datamap & ~bit;
+        moved->nodemap = node->nodemap | bit;
+        confin_node_share(moved->slots, node, 0, dataindex);
+        confin_node_share(moved->slots + dataindex, node, dataindex + 1, node->items - dataindex - 1);
+        void **children = moved->slots + moved->items;
+        confin_node_share(children, node, node->items, childindex);
+        children[childindex] = child;
+        confin_node_share(children + childindex + 1, node, node->items + childindex, node->children - childindex);
+        confin_node_release(&txn->allocator, node);
+        *added = true;
+        return moved;
+    }
+
+    if (node->nodemap & bit) {
+        confin_node_t *writable = confin_node_writable(txn, node);
+        if (!writable) {
+            confin_item_release(&txn->allocator, item);
+            return node;
+        }
+        void **slot = &writable->slots[writable->items + childindex];
+        *slot = confin_node_set(txn, (confin_node_t*)*slot, shift + CONFIN_TRIE_BITS, item, added, replaced);
+        return writable;
+    }
+
+    if (node->owner == txn->id) {
+        // Grow a node of this transaction in place, without touching reference counts
+        size_t slots = node->items + node->children;
+        confin_node_t *grown = (confin_node_t*)confin_realloc(&txn->allocator, node, sizeof(confin_node_t) + sizeof(void*) * (slots + 1));
+        if (!grown) {
+            perror("malloc");
+            txn->failed = true;
+            confin_item_release(&txn->allocator, item);
+            return node;
+        }
+        memmove(&grown->slots[dataindex + 1], &grown->slots[dataindex], sizeof(void*) * (slots - dataindex));
+        grown->slots[dataindex] = item;
+        grown->datamap |= bit;
+        grown->items++;
+        *added = true;
+        return grown;
+    }
+
+    confin_node_t *grown = confin_node_alloc(txn, node->items + 1, node->children);
+    if (!grown) {
+        confin_item_release(&txn->allocator, item);
+        return node;
+    }
+    grown->datamap = node->datamap | bit;
+    grown->nodemap = node->nodemap;
+    confin_node_share(grown->slots, node, 0, dataindex);
+    grown->slots[dataindex] = item;
+    confin_node_share(grown->slots + dataindex + 1, node, dataindex, node->items - dataindex + node->children);
+    confin_node_release(&txn->allocator, node);
+    *added = true;
+    return grown;
+}
+
+/**
+ * @brief Removes an item known to be present from a subtrie.
+ *
+ * Takes the caller's reference to `node` and returns the node to store in its place.
+ * A child left with a single item is folded into its parent. On failure the
+ * transaction is marked as failed and the subtrie is left unchanged.
+ */
+static confin_node_t *confin_node_delete(cftxn_t *txn, confin_node_t *node, unsigned shift, uint64_t hash, const char *key, bool *removed) {
+    uint32_t bit = shift < CONFIN_TRIE_MAX_SHIFT ? 1u << ((hash >> shift) & 31) : 0;
+    uint32_t dataindex = 0;
+    if (shift >= CONFIN_TRIE_MAX_SHIFT) {
+        while (!confin_item_matches((const confin_item_t*)node->slots[dataindex], hash, key)) {
+            ++dataindex;
+        }
+    } else if (node->datamap & bit) {
+        dataindex = confin_popcount(node->datamap & (bit - 1));
+    } else {
+        uint32_t childindex = confin_popcount(node->nodemap & (bit - 1));
+        confin_node_t *writable = confin_node_writable(txn, node);
+        if (!writable) {
+            return node;
+        }
+        void **slot = &writable->slots[writable->items + childindex];
+        confin_node_t *child = confin_node_delete(txn, (confin_node_t*)*slot, shift + CONFIN_TRIE_BITS, hash, key, removed);
+        *slot = child;
+        if (child->items != 1 || child->children != 0) {
+            return writable;
+        }
+
+        // Fold the remaining item of the child into this node
+        uint32_t itemindex = confin_popcount(writable->datamap & (bit - 1));
+        confin_node_t *folded = confin_node_alloc(txn, writable->items + 1, writable->children - 1);
+        if (!folded) {
+            return writable;
+        }
+        folded->datamap = writable->datamap | bit;
+        folded->nodemap = writable->nodemap & ~bit;
+        confin_node_share(folded->slots, writable, 0, itemindex);
+        folded->slots[itemindex] = child->slots[0];
+        confin_ref_acquire((uint64_t*)child->slots[0]);
+        confin_node_share(folded->slots + itemindex + 1, writable, itemindex, writable->items - itemindex + childindex);
+        confin_node_share(folded->slots + folded->items + childindex, writable, writable->items + childindex + 1,
+                          writable->children - childindex - 1);
+        confin_node_release(&txn->allocator, writable);
+        return folded;
+    }
+
+    confin_node_t *shrunk = confin_node_alloc(txn, node->items - 1, node->children);
+    if (!shrunk) {
+        return node;
+    }
+    shrunk->datamap = node->datamap & ~bit;
+    shrunk->nodemap = node->nodemap;
+    confin_node_share(shrunk->slots, node, 0, dataindex);
+    confin_node_share(shrunk->slots + dataindex, node, dataindex + 1, node->items - dataindex - 1 + node->children);
+    confin_node_release(&txn->allocator, node);
+    *removed = true;
+    return shrunk;
+}
+
+/**
+ * @brief Appends the items of a subtrie to an array.
+ */
+static void confin_node_collect(const confin_node_t *node, const confin_item_t **items, uint64_t *count) {
+    for (uint32_t i = 0; i < node->items; ++i) {
+        items[(*count)++] = (const confin_item_t*)node->slots[i];
+    }
+    for (uint32_t i = 0; i < node->children; ++i) {
+        confin_node_collect((const confin_node_t*)node->slots[node->items + i], items, count);
+    }
+}
+
+static int confin_item_compare(const void *a, const void *b) {
+    uint64_t left = (*(const confin_item_t* const*)a)->sequence;
+    uint64_t right = (*(const confin_item_t* const*)b)->sequence;
+    return left < right ? -1 : left > right;
+}
+
+/**
+ * @brief Lists the items of a version in insertion order.
+ * @return The items, to be freed with the allocator of the version, or NULL on failure.
+ */
+static const confin_item_t **confin_snapshot_items(const cfsnapshot_t *snapshot) {
+    const confin_item_t **items = (const confin_item_t**)confin_alloc(&snapshot->allocator,
+                                                                        sizeof(confin_item_t*) * (snapshot->count ? snapshot->count : 1));
+    if (!items) {
+        perror("malloc");
+        return NULL;
+    }
+    uint64_t count = 0;
+    confin_node_collect(snapshot->root, items, &count);
+    qsort(items, (size_t)count, sizeof(confin_item_t*), confin_item_compare);
+    return items;
+}
+
+/* history */
+
+/**
+ * @brief Extension of a version saved in full.
+ */
+#define CONFIN_HISTORY_FULL ".bin"
+
+/**
+ * @brief Extension of a version saved as a delta from the previous one.
+ */
+#define CONFIN_HISTORY_DELTA ".delta"
+
+/**
+ * @brief Name of the list of the versions saved in full, as 64-bit numbers.
+ */
+#define CONFIN_HISTORY_INDEX "history.index"
+
+/**
+ * @brief Change between two versions.
+ */
+typedef struct {
+    const confin_item_t *item; /**< The new entry, or the removed one */
+    cfdeltaop_t op;            /**< Operation of the change */
+} confin_change_t;
+
+/**
+ * @brief Changes collected between two versions.
+ */
+typedef struct {
+    confin_change_t *list;           /**< Changes */
+    uint64_t count;                  /**< Number of changes */
+    uint64_t capacity;               /**< Changes allocated */
+    const cfallocator_t *allocator;  /**< Allocator of `list` */
+    bool failed;                     /**< Set if memory could not be allocated */
+} confin_changes_t;
+
+static void confin_changes_add(confin_changes_t *changes, const confin_item_t *item, cfdeltaop_t op) {
+    if (changes->failed) {
+        return;
+    }
+    if (changes->count == changes->capacity) {
+        uint64_t capacity = changes->capacity ? changes->capacity * 2 : 64;
+        confin_change_t *list = (confin_change_t*)confin_realloc(changes->allocator, changes->list, sizeof(confin_change_t) * capacity);
+        if (!list) {
+            perror("malloc");
+            changes->failed = true;
+            return;
+        }
+        changes->list = list;
+        changes->capacity = capacity;
+    }
+    changes->list[changes->count].item = item;
+    changes->list[changes->count].op = op;
+    changes->count++;
+}
+
+/**
+ * @brief Records the change of an item of one version against the other version.
+ */
+static void confin_changes_item(confin_changes_t *changes, const confin_item_t *item, const confin_node_t *otherroot, bool isnew) {
+    const confin_item_t *match = confin_node_find(otherroot, item->hash, item->entry.key);
+    if (!isnew) {
+        if (!match) {
+            confin_changes_add(changes, item, CONFIN_DELTA_REMOVE);
+        }
+    } else if (!match) {
+        confin_changes_add(changes, item, CONFIN_DELTA_ADD);
+    } else if (match != item && (match->entry.type != item->entry.type || match->entry.size != item->entry.size ||
+                                 memcmp(CF_ENTRYVAL(&match->entry), CF_ENTRYVAL(&item->entry), (size_t)item->entry.size) != 0)) {
+        confin_changes_add(changes, item, CONFIN_DELTA_CHANGE);
+    }
+}
+
+static void confin_changes_subtrie(confin_changes_t *changes, const confin_node_t *node, const confin_node_t *otherroot, bool isnew) {
+    for (uint32_t i = 0; i < node->items; ++i) {
+        confin_changes_item(changes, (const confin_item_t*)node->slots[i], otherroot, isnew);
+    }
+    for (uint32_t i = 0; i < node->children; ++i) {
+        confin_changes_subtrie(changes, (const confin_node_t*)node->slots[node->items + i], otherroot, isnew);
+    }
+}
+
+/**
+ * @brief Gets the slot of a bit in a node.
+ * @return The item or child, or NULL if the slot is empty.
+ */
+static const void *confin_node_slot(const confin_node_t *node, uint32_t bit, bool *ischild) {
+    *ischild = (node->nodemap & bit) != 0;
+    if (node->datamap & bit) {
+        return node->slots[confin_popcount(node->datamap & (bit - 1))];
+    }
+    return *ischild ? node->slots[node->items + confin_popcount(node->nodemap & (bit - 1))] : NULL;
+}
+
+/**
+ * @brief Collects the changes between two subtries, skipping the parts they share.
+ */
+static void confin_changes_diff(confin_changes_t *changes, const confin_node_t *oldroot, const confin_node_t *newroot,
+                                const confin_node_t *oldnode, const confin_node_t *newnode, unsigned shift) {
+    if (oldnode == newnode) {
+        return;
+    }
+    if (shift >= CONFIN_TRIE_MAX_SHIFT) {
+        confin_changes_subtrie(changes, oldnode, newroot, false);
+        confin_changes_subtrie(changes, newnode, oldroot, true);
+        return;
+    }
+    uint32_t bits = oldnode->datamap | oldnode->nodemap | newnode->datamap | newnode->nodemap;
+    while (bits) {
+        uint32_t bit = bits & (0u - bits);
+        bits &= bits - 1;
+        bool oldchild, newchild;
+        const void *oldslot = confin_node_slot(oldnode, bit, &oldchild);
+        const void *newslot = confin_node_slot(newnode, bit, &newchild);
+        if (oldslot == newslot) {
+            continue;
+        }
+        if (oldchild && newchild) {
+            confin_changes_diff(changes, oldroot, newroot, (const confin_node_t*)oldslot, (const confin_node_t*)newslot, shift + CONFIN_TRIE_BITS);
+            continue;
+        }
+        if (oldslot && oldchild) {
+            confin_changes_subtrie(changes, (const confin_node_t*)oldslot, newroot, false);
+        } else if (oldslot) {
+            confin_changes_item(changes, (const confin_item_t*)oldslot, newroot, false);
+        }
+        if (newslot && newchild) {
+            confin_changes_subtrie(changes, (const confin_node_t*)newslot, oldroot, true);
+        } else if (newslot) {
+            confin_changes_item(changes, (const confin_item_t*)newslot, oldroot, true);
+        }
+    }
+}
+
+// Added keys last, each group in insertion order, as confin_apply_delta appends added entries
+static int confin_change_compare(const void *a, const void *b) {
+    const confin_change_t *left = (const confin_change_t*)a;
+    const confin_change_t *right = (const confin_change_t*)b;
+    bool leftadded = left->op == CONFIN_DELTA_ADD, rightadded = right->op == CONFIN_DELTA_ADD;
+    if (leftadded != rightadded) {
+        return leftadded ? 1 : -1;
+    }
+    return left->item->sequence < right->item->sequence ? -1 : left->item->sequence > right->item->sequence;
+}
+
+/**
+ * @brief Writes the delta between two versions in the format of @ref confin_diff.
+ *
+ * Subtries shared by both versions are skipped, so the cost depends on the
+ * number of changes rather than on the number of entries.
+ */
+static bool confin_write_changes(const char *deltafile, const cfsnapshot_t *base, const confin_node_t *newroot, const cfallocator_t *allocator) {
+    const confin_node_t *oldroot = base->root;
+    confin_changes_t changes = {NULL, 0, 0, allocator, false};
+    confin_changes_diff(&changes, oldroot, newroot, oldroot, newroot, 0);
+    if (changes.failed) {
+        confin_free(allocator, changes.list);
+        return false;
+    }
+    qsort(changes.list, (size_t)changes.count, sizeof(confin_change_t), confin_change_compare);
+
+    FILE *file = fopen(deltafile, "wb");
+    if (!file) {
+        perror("fopen");
+        confin_free(allocator, changes.list);
+        return false;
+    }
+    cfdeltabase_t deltabase = {base->count, base->checksum};
+    bool ok = confin_write_delta_header(file, changes.count, &deltabase);
+    for (uint64_t i = 0; ok && i < changes.count; ++i) {
+        ok = confin_write_delta_record(file, &changes.list[i].item->entry, changes.list[i].op);
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        perror("fwrite");
+        remove(deltafile);
+    }
+    confin_free(allocator, changes.list);
+    return ok;
+}
+
+/**
+ * @brief Builds the name of a saved version.
+ * @return The name, to be freed with the allocator, or NULL on failure.
+ */
+static char *confin_history_path(const cfallocator_t *allocator, const char *directory, uint64_t version, const char *extension) {
+    size_t size = strlen(directory) + 32;
+    char *path = (char*)confin_alloc(allocator, size);
+    if (!path) {
+        perror("malloc");
+        return NULL;
+    }
+    snprintf(path, size, "%s/%llu%s", directory, (unsigned long long)version, extension);
+    return path;
+}
+
+/**
+ * @brief Builds the name of the list of the versions saved in full.
+ * @return The name, to be freed with the allocator, or NULL on failure.
+ */
+static char *confin_history_index_path(const cfallocator_t *allocator, const char *directory) {
+    size_t size = strlen(directory) + sizeof("/" CONFIN_HISTORY_INDEX);
+    char *path = (char*)confin_alloc(allocator, size);
+    if (!path) {
+        perror("malloc");
+        return NULL;
+    }
+    snprintf(path, size, "%s/%s", directory, CONFIN_HISTORY_INDEX);
+    return path;
+}
+
+/**
+ * @brief Adds a version saved in full to the list of a directory.
+ * @return true on success, false otherwise.
+ */
+static bool confin_history_index_add(const cfallocator_t *allocator, const char *directory, uint64_t version) {
+    char *path = confin_history_index_path(allocator, directory);
+    FILE *file = path ? fopen(path, "ab") : NULL;
+    confin_free(allocator, path);
+    if (!file) {
+        perror("fopen");
+        return false;
+    }
+    bool ok = fwrite(&version, sizeof(version), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        perror("fwrite");
+    }
+    return ok;
+}
+
+/**
+ * @brief Finds the newest version saved in full at or before a version.
+ * @return The version, or 0 if there is none.
+ */
+static uint64_t confin_history_index_find(const cfallocator_t *allocator, const char *directory, uint64_t version) {
+    char *path = confin_history_index_path(allocator, directory);
+    FILE *file = path ? fopen(path, "rb") : NULL;
+    confin_free(allocator, path);
+    uint64_t base = 0, saved;
+    while (file && fread(&saved, sizeof(saved), 1, file) == 1) {
+        if (saved <= version && saved > base) {
+            base = saved;
+        }
+    }
+    if (file) {
+        fclose(file);
+    }
+    return base;
+}
+
+/**
+ * @brief Makes a version the newest of the history; called with the lock held.
+ * @return The version evicted from the history, to be dropped once the lock is released, or NULL.
+ */
+static cfsnapshot_t *confin_history_push(cfmutable_t *config, cfsnapshot_t *snapshot) {
+    confin_ref_acquire(&snapshot->refcount);
+    config->newest = (config->newest + 1) % config->depth;
+    cfsnapshot_t *evicted = config->retained == config->depth ? config->history[config->newest] : NULL;
+    if (!evicted) {
+        config->retained++;
+    }
+    config->history[config->newest] = snapshot;
+    return evicted;
+}
+
+/**
+ * @brief Finds a retained version; called with the lock held.
+ */
+static cfsnapshot_t *confin_history_find(const cfmutable_t *config, uint64_t version) {
+    for (uint32_t k = 0; k < config->retained; ++k) {
+        cfsnapshot_t *snapshot = config->history[(config->newest + config->depth - k) % config->depth];
+        if (snapshot->version == version) {
+            return snapshot;
+        }
+    }
+    return NULL;
+}
+
+/* cfmutable implementation */
+
+/**
+ * @brief Creates a mutable configuration from a loaded one.
+ * @param config The initial entries, or NULL for an empty configuration.
+ * @return The mutable configuration, or NULL on failure.
+ */
+cfmutable_t *confin_mutable_create(const cffile_t *config) {
+    return confin_mutable_create_ctx(config, NULL);
+}
+
+/**
+ * @brief Creates a mutable configuration from a loaded one with a context.
+ * @param config The initial entries, or NULL for an empty configuration.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The mutable configuration, or NULL on failure.
+ */
+cfmutable_t *confin_mutable_create_ctx(const cffile_t *config, cfcontext_t *ctx) {
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    cfmutable_t *mutableconfig = (cfmutable_t*)confin_alloc(&allocator, sizeof(cfmutable_t));
+    cfsnapshot_t *snapshot = (cfsnapshot_t*)confin_alloc(&allocator, sizeof(cfsnapshot_t));
+    if (!mutableconfig || !snapshot) {
+        perror("malloc");
+        confin_free(&allocator, mutableconfig);
+        confin_free(&allocator, snapshot);
+        return NULL;
+    }
+    mutableconfig->lock = 0;
+    mutableconfig->allocator = allocator;
+    mutableconfig->head = snapshot;
+    mutableconfig->history = (cfsnapshot_t**)confin_alloc(&allocator, sizeof(cfsnapshot_t*));
+    mutableconfig->depth = 1;
+    mutableconfig->retained = 1;
+    mutableconfig->newest = 0;
+    mutableconfig->directory = NULL;
+    snapshot->refcount = 1;
+    snapshot->count = 0;
+    snapshot->checksum = 0;
+    snapshot->version = 1;
+    snapshot->nextsequence = 0;
+    snapshot->allocator = allocator;
+
+    cftxn_t txn;
+    memset(&txn, 0, sizeof(txn));
+    txn.id = confin_next_generation();
+    txn.allocator = allocator;
+    snapshot->root = confin_node_alloc(&txn, 0, 0);
+    if (!snapshot->root || !mutableconfig->history || !confin_mutex_init(&mutableconfig->commitlock)) {
+        if (!mutableconfig->history) {
+            perror("malloc");
+        } else if (snapshot->root) {
+            fprintf(stderr, "Failed to create the commit lock\n");
+        }
+        confin_free(&allocator, snapshot->root);
+        confin_free(&allocator, snapshot);
+        confin_free(&allocator, mutableconfig->history);
+        confin_free(&allocator, mutableconfig);
+        return NULL;
+    }
+    mutableconfig->history[0] = snapshot;
+    snapshot->refcount++;
+
+    // The initial entries form version 1; as with confin_get, the first of duplicate keys wins
+    cftxn_t *load = confin_txn_begin(mutableconfig);
+    bool ok = load != NULL;
+    for (uint64_t i = 0; ok && config && i < config->header.entrycount; ++i) {
+        const cfentry_t *entry = &config->entries[i];
+        if (!confin_txn_get(load, entry->key)) {
+            ok = confin_txn_set(load, entry->key, entry->type, CF_ENTRYVAL(entry), entry->size);
+        }
+    }
+    if (load) {
+        if (ok) {
+            ok = confin_txn_commit(load);
+        } else {
+            confin_txn_abort(load);
+        }
+    }
+    if (!ok) {
+        confin_mutable_free(mutableconfig);
+        return NULL;
+    }
+    mutableconfig->head->version = 1;
+    return mutableconfig;
+}
+
+/**
+ * @brief Frees a mutable configuration.
+ *
+ * Versions still held by readers stay valid until they are released.
+ * @param config The mutable configuration, without transactions in progress.
+ */
+void confin_mutable_free(cfmutable_t *config) {
+    if (!config) {
+        return;
+    }
+    cfallocator_t allocator = config->allocator;
+    for (uint32_t k = 0; k < config->retained; ++k) {
+        confin_snapshot_drop(config->history[(config->newest + config->depth - k) % config->depth]);
+    }
+    confin_snapshot_drop(config->head);
+    confin_free(&allocator, config->history);
+    confin_free(&allocator, config->directory);
+    confin_mutex_destroy(&config->commitlock);
+    confin_free(&allocator, config);
+}
+
+/**
+ * @brief Acquires the current version of a mutable configuration.
+ * @param config The mutable configuration.
+ * @return The version, to be released with @ref confin_snapshot_release.
+ */
+cfsnapshot_t *confin_mutable_snapshot(cfmutable_t *config) {
+    confin_spin_lock(&config->lock);
+    cfsnapshot_t *snapshot = config->head;
+    confin_ref_acquire(&snapshot->refcount);
+    confin_spin_unlock(&config->lock);
+    return snapshot;
+}
+
+/**
+ * @brief Releases a version acquired with @ref confin_mutable_snapshot.
+ * @param snapshot The version; NULL is ignored.
+ */
+void confin_snapshot_release(cfsnapshot_t *snapshot) {
+    if (snapshot) {
+        confin_snapshot_drop(snapshot);
+    }
+}
+
+/**
+ * @brief Finds an entry by key in a version.
+ * @param snapshot The version.
+ * @param key The key to find.
+ * @return Pointer to the entry, valid while the version is held, or NULL if the key is not present.
+ */
+const cfentry_t *confin_snapshot_get(const cfsnapshot_t *snapshot, const char *key) {
+    const confin_item_t *item = confin_node_find(snapshot->root, confin_hash_key(key), key);
+    return item ? &item->entry : NULL;
+}
+
+/**
+ * @brief Gets the number of entries of a version.
+ */
+uint64_t confin_snapshot_count(const cfsnapshot_t *snapshot) {
+    return snapshot->count;
+}
+
+/**
+ * @brief Gets the number of a version, incremented by every commit that changes entries.
+ */
+uint64_t confin_snapshot_version(const cfsnapshot_t *snapshot) {
+    return snapshot->version;
+}
+
+/**
+ * @brief Copies a version into a configuration file structure.
+ * @param snapshot The version.
+ * @return The configuration, entries in insertion order, or NULL on failure.
+ */
+cffile_t *confin_snapshot_to_config(const cfsnapshot_t *snapshot) {
+    const confin_item_t **items = confin_snapshot_items(snapshot);
+    cffile_t *config = items ? confin_alloc_config(&snapshot->allocator, snapshot->count) : NULL;
+    if (!config) {
+        confin_free(&snapshot->allocator, items);
+        return NULL;
+    }
+    for (uint64_t i = 0; i < snapshot->count; ++i) {
+        if (!confin_copy_entry(&config->entries[i], &items[i]->entry, &snapshot->allocator)) {
+            confin_free(&snapshot->allocator, items);
+            confin_free_config_file(config);
+            return NULL;
+        }
+        config->header.entrycount++;
+    }
+    confin_free(&snapshot->allocator, items);
+    return config;
+}
+
+/**
+ * @brief Writes a version to a file with the streaming writer, entries in insertion order.
+ * @param snapshot The version.
+ * @param filename The name of the file to write.
+ * @return true on success, false otherwise.
+ */
+bool confin_snapshot_write(const cfsnapshot_t *snapshot, const char *filename) {
+    const confin_item_t **items = confin_snapshot_items(snapshot);
+    if (!items) {
+        return false;
+    }
+    cfcontext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.allocator = snapshot->allocator;
+    cfwriter_t *writer = confin_writer_open_ctx(filename, &ctx);
+    bool ok = writer != NULL;
+    for (uint64_t i = 0; ok && i < snapshot->count; ++i) {
+        ok = confin_writer_append_entry(writer, &items[i]->entry);
+    }
+    confin_free(&snapshot->allocator, items);
+    if (!writer) {
+        return false;
+    }
+    if (!ok) {
+        confin_writer_abort(writer);
+        return false;
+    }
+    return confin_writer_close(writer);
+}
+
+/**
+ * @brief Starts a transaction on the current version of a mutable configuration.
+ * @param config The mutable configuration.
+ * @return The transaction, or NULL if memory could not be allocated.
+ */
+cftxn_t *confin_txn_begin(cfmutable_t *config) {
+    cftxn_t *txn = (cftxn_t*)confin_alloc(&config->allocator, sizeof(cftxn_t));
+    if (!txn) {
+        perror("malloc");
+        return NULL;
+    }
+    txn->config = config;
+    txn->base = confin_mutable_snapshot(config);
+    txn->root = txn->base->root;
+    confin_ref_acquire(&txn->root->refcount);
+    txn->count = txn->base->count;
+    txn->checksum = txn->base->checksum;
+    txn->nextsequence = txn->base->nextsequence;
+    txn->id = confin_next_generation();
+    txn->failed = false;
+    txn->allocator = config->allocator;
+    return txn;
+}
+
+/**
+ * @brief Sets the value of a key in a transaction, adding the key if it is not present.
+ * @param txn The transaction.
+ * @param key The key, shorter than @ref __CONFIN_STRUCT_MAX_KEYLEN.
+ * @param type The type of the value.
+ * @param value The value.
+ * @param size The size of the value.
+ * @return true on success, false if the key is too long or memory could not be allocated.
+ */
+bool confin_txn_set(cftxn_t *txn, const char *key, cfannotype_t type, const void *value, uint64_t size) {
+    size_t length = 0;
+    while (length < __CONFIN_STRUCT_MAX_KEYLEN && key[length]) {
+        ++length;
+    }
+    if (length == __CONFIN_STRUCT_MAX_KEYLEN) {
+        fprintf(stderr, "Key '%.*s' is too long\n", __CONFIN_STRUCT_MAX_KEYLEN, key);
+        return false;
+    }
+    if (txn->failed) {
+        return false;
+    }
+
+    size_t valuesize = size > __CONFIN_INLINE_VALUE_MAX ? (size_t)size : 0;
+    confin_item_t *item = (confin_item_t*)confin_alloc(&txn->allocator, sizeof(confin_item_t) + valuesize);
+    if (!item) {
+        perror("malloc");
+        txn->failed = true;
+        return false;
+    }
+    item->refcount = 1;
+    item->hash = confin_hash_key(key);
+    item->sequence = txn->nextsequence;
+    memset(item->entry.key, 0, sizeof(item->entry.key));
+    memcpy(item->entry.key, key, length);
+    item->entry.type = type;
+    item->entry.size = size;
+    if (valuesize) {
+        item->entry.flags = CONFIN_ENTRY_SHARED;
+        item->entry.value = item + 1;
+    } else {
+        item->entry.flags = CONFIN_ENTRY_INLINE;
+        item->entry.value = item->entry.inlinevalue;
+    }
+    memcpy(CF_ENTRYVAL(&item->entry), value, (size_t)size);
+    item->checksum = confin_entry_checksum(&item->entry);
+
+    bool added = false;
+    uint64_t replaced = 0, checksum = item->checksum;
+    txn->root = confin_node_set(txn, txn->root, 0, item, &added, &replaced);
+    if (added) {
+        txn->count++;
+        txn->nextsequence++;
+    }
+    if (!txn->failed) {
+        txn->checksum += checksum - replaced;
+    }
+    return !txn->failed;
+}
+
+/**
+ * @brief Deletes a key in a transaction.
+ * @param txn The transaction.
+ * @param key The key to delete.
+ * @return true if the key was present and deleted, false otherwise.
+ */
+bool confin_txn_delete(cftxn_t *txn, const char *key) {
+    uint64_t hash = confin_hash_key(key);
+    const confin_item_t *item = txn->failed ? NULL : confin_node_find(txn->root, hash, key);
+    if (!item) {
+        return false;
+    }
+    uint64_t checksum = item->checksum;
+    bool removed = false;
+    txn->root = confin_node_delete(txn, txn->root, 0, hash, key, &removed);
+    if (removed) {
+        txn->count--;
+        txn->checksum -= checksum;
+    }
+    return removed;
+}
+
+/**
+ * @brief Finds an entry by key in a transaction, including its uncommitted changes.
+ * @param txn The transaction.
+ * @param key The key to find.
+ * @return Pointer to the entry, valid until the next change in the transaction, or NULL if the key is not present.
+ */
+const cfentry_t *confin_txn_get(const cftxn_t *txn, const char *key) {
+    const confin_item_t *item = confin_node_find(txn->root, confin_hash_key(key), key);
+    return item ? &item->entry : NULL;
+}
+
+/**
+ * @brief Commits a transaction and frees it.
+ *
+ * The changes become the current version at once. The commit fails if another
+ * transaction committed since this one started; the caller can then start over
+ * from the new version.
+ * @param txn The transaction.
+ * @return true if the changes were committed, false on a conflict or a failed allocation.
+ */
+bool confin_txn_commit(cftxn_t *txn) {
+    cfmutable_t *config = txn->config;
+    cfallocator_t allocator = txn->allocator;
+    bool ok = !txn->failed;
+
+    if (ok && txn->root != txn->base->root) {
+        cfsnapshot_t *snapshot = (cfsnapshot_t*)confin_alloc(&allocator, sizeof(cfsnapshot_t));
+        if (!snapshot) {
+            perror("malloc");
+            ok = false;
+        } else {
+            snapshot->refcount = 1;
+            snapshot->root = txn->root;
+            snapshot->count = txn->count;
+            snapshot->checksum = txn->checksum;
+            snapshot->version = txn->base->version + 1;
+            snapshot->nextsequence = txn->nextsequence;
+            snapshot->allocator = allocator;
+
+            // The current version only changes under the commit lock, so it can be checked before the delta is written
+            confin_mutex_lock(&config->commitlock);
+            ok = config->head == txn->base;
+            if (ok && config->directory) {
+                char *deltafile = confin_history_path(&allocator, config->directory, snapshot->version, CONFIN_HISTORY_DELTA);
+                ok = deltafile && confin_write_changes(deltafile, txn->base, txn->root, &allocator);
+                confin_free(&allocator, deltafile);
+            }
+            cfsnapshot_t *evicted = NULL;
+            if (ok) {
+                confin_spin_lock(&config->lock);
+                config->head = snapshot;
+                evicted = confin_history_push(config, snapshot);
+                confin_spin_unlock(&config->lock);
+            }
+            confin_mutex_unlock(&config->commitlock);
+
+            if (ok) {
+                // The trie now belongs to the version, and the configuration no longer holds the base
+                txn->root = NULL;
+                confin_snapshot_drop(txn->base);
+                if (evicted) {
+                    confin_snapshot_drop(evicted);
+                }
+            } else {
+                confin_free(&allocator, snapshot);
+            }
+        }
+    }
+
+    if (txn->root) {
+        confin_node_release(&allocator, txn->root);
+    }
+    confin_snapshot_drop(txn->base);
+    confin_free(&allocator, txn);
+    return ok;
+}
+
+/**
+ * @brief Discards a transaction and frees it.
+ * @param txn The transaction; NULL is ignored.
+ */
+void confin_txn_abort(cftxn_t *txn) {
+    if (!txn) {
+        return;
+    }
+    cfallocator_t allocator = txn->allocator;
+    confin_node_release(&allocator, txn->root);
+    confin_snapshot_drop(txn->base);
+    confin_free(&allocator, txn);
+}
+
+/**
+ * @brief Sets the number of versions retained in memory.
+ * @param config The mutable configuration.
+ * @param depth The number of versions, the current one included; 0 is taken as 1.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_mutable_set_history(cfmutable_t *config, uint32_t depth) {
+    if (depth == 0) {
+        depth = 1;
+    }
+    cfsnapshot_t **history = (cfsnapshot_t**)confin_alloc(&config->allocator, sizeof(cfsnapshot_t*) * depth);
+    if (!history) {
+        perror("malloc");
+        return false;
+    }
+
+    confin_spin_lock(&config->lock);
+    cfsnapshot_t **previous = config->history;
+    uint32_t previousdepth = config->depth, previousretained = config->retained, previousnewest = config->newest;
+    uint32_t kept = previousretained < depth ? previousretained : depth;
+    for (uint32_t k = 0; k < kept; ++k) {
+        history[kept - 1 - k] = previous[(previousnewest + previousdepth - k) % previousdepth];
+    }
+    config->history = history;
+    config->depth = depth;
+    config->retained = kept;
+    config->newest = kept - 1;
+    confin_spin_unlock(&config->lock);
+
+    for (uint32_t k = kept; k < previousretained; ++k) {
+        confin_snapshot_drop(previous[(previousnewest + previousdepth - k) % previousdepth]);
+    }
+    confin_free(&config->allocator, previous);
+    return true;
+}
+
+/**
+ * @brief Lists the retained versions.
+ * @param config The mutable configuration.
+ * @param versions Receives the numbers of the versions, newest first.
+ * @param capacity The number of elements of `versions`.
+ * @return The number of retained versions, which may exceed `capacity`.
+ */
+uint32_t confin_mutable_versions(cfmutable_t *config, uint64_t *versions, uint32_t capacity) {
+    confin_spin_lock(&config->lock);
+    uint32_t retained = config->retained;
+    for (uint32_t k = 0; k < retained && k < capacity; ++k) {
+        versions[k] = config->history[(config->newest + config->depth - k) % config->depth]->version;
+    }
+    confin_spin_unlock(&config->lock);
+    return retained;
+}
+
+/**
+ * @brief Acquires a retained version.
+ * @param config The mutable configuration.
+ * @param version The number of the version.
+ * @return The version, to be released with @ref confin_snapshot_release, or NULL if it is not retained.
+ */
+cfsnapshot_t *confin_mutable_version(cfmutable_t *config, uint64_t version) {
+    confin_spin_lock(&config->lock);
+    cfsnapshot_t *snapshot = confin_history_find(config, version);
+    if (snapshot) {
+        confin_ref_acquire(&snapshot->refcount);
+    }
+    confin_spin_unlock(&config->lock);
+    return snapshot;
+}
+
+/**
+ * @brief Makes the entries of a retained version current again.
+ *
+ * The entries become a new version, committed like a transaction that would
+ * restore them, so later versions stay retained and the rollback can be undone.
+ * @param config The mutable configuration.
+ * @param version The number of the version to restore.
+ * @return true on success, false if the version is not retained or the commit failed.
+ */
+bool confin_mutable_rollback(cfmutable_t *config, uint64_t version) {
+    cfsnapshot_t *target = confin_mutable_version(config, version);
+    if (!target) {
+        fprintf(stderr, "Version %llu is not retained\n", (unsigned long long)version);
+        return false;
+    }
+    cftxn_t *txn = confin_txn_begin(config);
+    if (!txn) {
+        confin_snapshot_drop(target);
+        return false;
+    }
+    confin_node_release(&txn->allocator, txn->root);
+    txn->root = target->root;
+    confin_ref_acquire(&txn->root->refcount);
+    txn->count = target->count;
+    txn->checksum = target->checksum;
+    confin_snapshot_drop(target);
+    return confin_txn_commit(txn);
+}
+
+/**
+ * @brief Saves the versions of a mutable configuration to a directory.
+ *
+ * The current version is written in full, then every commit writes a delta from
+ * the previous version before it becomes current.
+ * @param config The mutable configuration.
+ * @param directory An existing directory, or NULL to stop saving versions.
+ * @return true on success, false otherwise.
+ */
+bool confin_mutable_persist(cfmutable_t *config, const char *directory) {
+    confin_mutex_lock(&config->commitlock);
+    confin_free(&config->allocator, config->directory);
+    config->directory = NULL;
+
+    bool ok = true;
+    if (directory) {
+        size_t length = strlen(directory) + 1;
+        char *copy = (char*)confin_alloc(&config->allocator, length);
+        char *fullfile = copy ? confin_history_path(&config->allocator, directory, config->head->version, CONFIN_HISTORY_FULL) : NULL;
+        if (!copy) {
+            perror("malloc");
+        }
+        ok = fullfile && confin_snapshot_write(config->head, fullfile) &&
+             confin_history_index_add(&config->allocator, directory, config->head->version);
+        if (ok) {
+            memcpy(copy, directory, length);
+            config->directory = copy;
+        } else {
+            confin_free(&config->allocator, copy);
+        }
+        confin_free(&config->allocator, fullfile);
+    }
+    confin_mutex_unlock(&config->commitlock);
+    return ok;
+}
+
+/**
+ * @brief Loads a version saved by @ref confin_mutable_persist.
+ * @param directory The directory the versions were saved to.
+ * @param version The number of the version.
+ * @return The configuration, or NULL on failure.
+ */
+cffile_t *confin_history_load(const char *directory, uint64_t version) {
+    cfallocator_t allocator = confin_resolve_allocator(NULL);
+
+    // Start from the newest version saved in full, then apply the deltas that follow it
+    uint64_t base = confin_history_index_find(&allocator, directory, version);
+    if (!base) {
+        fprintf(stderr, "No saved version at or before %llu\n", (unsigned long long)version);
+        return NULL;
+    }
+    char *path = confin_history_path(&allocator, directory, base, CONFIN_HISTORY_FULL);
+    if (!path) {
+        return NULL;
+    }
+
+    cffile_t *config = confin_read_config(path);
+    confin_free(&allocator, path);
+    for (uint64_t next = base + 1; config && next <= version; ++next) {
+        path = confin_history_path(&allocator, directory, next, CONFIN_HISTORY_DELTA);
+        cffile_t *applied = path ? confin_apply_delta(config, path) : NULL;
+        confin_free(&allocator, path);
+        confin_free_config_file(config);
+        config = applied;
+    }
+    return config;
+}
@@ -0,0 +1,452 @@
+/**
+ * @file cfmutable.h
+ * @brief Functions and macros for editing a configuration in transactions.
+ * 
+ * This header file provides mutable configurations. Every committed change set is
+ * a new version, and versions share their unchanged entries: entries are kept in
+ * a hash trie whose nodes and entries are reference counted, and a transaction
+ * copies only the nodes on the path to each key it changes. A transaction is
+ * private to its thread until it commits, when its version replaces the current
+ * one at once.
+ * 
+ * Readers acquire the current version and can use it, from any thread, for as long
+ * as they hold it; they are never blocked by transactions, only for the few
+ * instructions it takes to swap the current version. Several transactions may run
+ * at the same time: the first to commit wins and the others fail and can be retried.
+ * 
+ * The last versions can be retained for rollback. Since versions share their
+ * unchanged entries, each retained version costs memory in proportion to what it
+ * changed. Versions can also be saved to a directory: one version in full, then a
+ * delta per commit in the format of @ref confin_diff.
+ */
+
+#ifndef _CONFIN_MUTABLE_H
+#define _CONFIN_MUTABLE_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfmutcreate
+ * @brief Macro to create a mutable configuration.
+ * @param config The initial entries, or NULL for an empty configuration.
+ * @return The mutable configuration, or NULL on failure.
+ */
+#define cfmutcreate(config) confin_mutable_create(config)
+
+/**
+ * @brief Creates a mutable configuration from a loaded one.
+ * 
+ * The entries are copied into version 1; when a key appears several times, the
+ * first entry is kept, as with @ref confin_get.
+ * 
+ * @param config The initial entries, or NULL for an empty configuration.
+ * @return The mutable configuration, or NULL on failure.
+ */
+cfmutable_t *confin_mutable_create(const cffile_t *config);
+
+/**
+ * @def cfmutcreatectx
+ * @brief Macro to create a mutable configuration with a context.
+ * @param config The initial entries, or NULL for an empty configuration.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The mutable configuration, or NULL on failure.
+ */
+#define cfmutcreatectx(config, ctx) confin_mutable_create_ctx(config, ctx)
+
+/**
+ * @brief Creates a mutable configuration with a context.
+ * 
+ * The allocator of the context is used for the configuration and all its versions.
+ * 
+ * @param config The initial entries, or NULL for an empty configuration.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The mutable configuration, or NULL on failure.
+ */
+cfmutable_t *confin_mutable_create_ctx(const cffile_t *config, cfcontext_t *ctx);
+
+/**
+ * @def cfmutfree
+ * @brief Macro to free a mutable configuration.
+ * @param config The mutable configuration.
+ */
+#define cfmutfree(config) confin_mutable_free(config)
+
+/**
+ * @brief Frees a mutable configuration.
+ * 
+ * Transactions must be committed or aborted first. Versions still held by readers
+ * stay valid until they are released.
+ * 
+ * @param config The mutable configuration; NULL is ignored.
+ */
+void confin_mutable_free(cfmutable_t *config);
+
+/**
+ * @def cfmutsnapshot
+ * @brief Macro to acquire the current version of a mutable configuration.
+ * @param config The mutable configuration.
+ * @return The version, to be released with @ref cfsnaprelease.
+ */
+#define cfmutsnapshot(config) confin_mutable_snapshot(config)
+
+/**
+ * @brief Acquires the current version of a mutable configuration.
+ * @param config The mutable configuration.
+ * @return The version, to be released with @ref confin_snapshot_release.
+ */
+cfsnapshot_t *confin_mutable_snapshot(cfmutable_t *config);
+
+/**
+ * @def cfsnaprelease
+ * @brief Macro to release a version.
+ * @param snapshot The version.
+ */
+#define cfsnaprelease(snapshot) confin_snapshot_release(snapshot)
+
+/**
+ * @brief Releases a version acquired with @ref confin_mutable_snapshot.
+ * @param snapshot The version; NULL is ignored.
+ */
+void confin_snapshot_release(cfsnapshot_t *snapshot);
+
+/**
+ * @def cfsnapget
+ * @brief Macro to find an entry by key in a version.
+ * @param snapshot The version.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+#define cfsnapget(snapshot, key) confin_snapshot_get(snapshot, key)
+
+/**
+ * @brief Finds an entry by key in a version.
+ * @param snapshot The version.
+ * @param key The key to find.
+ * @return Pointer to the entry, valid while the version is held, or NULL if the key is not present.
+ */
+const cfentry_t *confin_snapshot_get(const cfsnapshot_t *snapshot, const char *key);
+
+/**
+ * @def cfsnapcount
+ * @brief Macro to get the number of entries of a version.
+ * @param snapshot The version.
+ * @return The number of entries.
+ */
+#define cfsnapcount(snapshot) confin_snapshot_count(snapshot)
+
+/**
+ * @brief Gets the number of entries of a version.
+ * @param snapshot The version.
+ * @return The number of entries.
+ */
+uint64_t confin_snapshot_count(const cfsnapshot_t *snapshot);
+
+/**
+ * @def cfsnapversion
+ * @brief Macro to get the number of a version.
+ * @param snapshot The version.
+ * @return The number of the version.
+ */
+#define cfsnapversion(snapshot) confin_snapshot_version(snapshot)
+
+/**
+ * @brief Gets the number of a version: 1 for the initial entries, incremented by
+ *        every commit that changes entries.
+ * @param snapshot The version.
+ * @return The number of the version.
+ */
+uint64_t confin_snapshot_version(const cfsnapshot_t *snapshot);
+
+/**
+ * @def cfsnaptocfg
+ * @brief Macro to copy a version into a configuration file structure.
+ * @param snapshot The version.
+ * @return The configuration, or NULL on failure.
+ */
+#define cfsnaptocfg(snapshot) confin_snapshot_to_config(snapshot)
+
+/**
+ * @brief Copies a version into a configuration file structure.
+ * 
+ * Entries are in insertion order: the initial entries first, in their order, then
+ * keys in the order they were added. Replacing a value keeps the position of its key.
+ * 
+ * @param snapshot The version.
+ * @return The configuration, to be freed with @ref confin_free_config_file, or NULL on failure.
+ */
+cffile_t *confin_snapshot_to_config(const cfsnapshot_t *snapshot);
+
+/**
+ * @def cfsnapwrite
+ * @brief Macro to write a version to a file.
+ * @param snapshot The version.
+ * @param filename The name of the file to write.
+ * @return true on success, false otherwise.
+ */
+#define cfsnapwrite(snapshot, filename) confin_snapshot_write(snapshot, filename)
+
+/**
+ * @brief Writes a version to a file, entries in insertion order.
+ * 
+ * Entries are streamed from the version with the streaming writer, without
+ * copying the values.
+ * 
+ * @param snapshot The version.
+ * @param filename The name of the file to write.
+ * @return true on success, false otherwise.
+ */
+bool confin_snapshot_write(const cfsnapshot_t *snapshot, const char *filename);
+
+/**
+ * @def cftxnbegin
+ * @brief Macro to start a transaction.
+ * @param config The mutable configuration.
+ * @return The transaction, or NULL on failure.
+ */
+#define cftxnbegin(config) confin_txn_begin(config)
+
+/**
+ * @brief Starts a transaction on the current version of a mutable configuration.
+ * 
+ * A transaction is used by one thread at a time and ends with
+ * @ref confin_txn_commit or @ref confin_txn_abort.
+ * 
+ * @param config The mutable configuration.
+ * @return The transaction, or NULL if memory could not be allocated.
+ */
+cftxn_t *confin_txn_begin(cfmutable_t *config);
+
+/**
+ * @def cftxnset
+ * @brief Macro to set the value of a key in a transaction.
+ * @param txn The transaction.
+ * @param key The key.
+ * @param type The type of the value.
+ * @param value The value.
+ * @param size The size of the value.
+ * @return true on success, false otherwise.
+ */
+#define cftxnset(txn, key, type, value, size) confin_txn_set(txn, key, type, value, size)
+
+/**
+ * @brief Sets the value of a key in a transaction, adding the key if it is not present.
+ * 
+ * After a failed allocation the transaction refuses further changes and cannot be committed.
+ * 
+ * @param txn The transaction.
+ * @param key The key, shorter than @ref __CONFIN_STRUCT_MAX_KEYLEN.
+ * @param type The type of the value.
+ * @param value The value, copied.
+ * @param size The size of the value.
+ * @return true on success, false if the key is too long or memory could not be allocated.
+ */
+bool confin_txn_set(cftxn_t *txn, const char *key, cfannotype_t type, const void *value, uint64_t size);
+
+/**
+ * @def cftxndelete
+ * @brief Macro to delete a key in a transaction.
+ * @param txn The transaction.
+ * @param key The key to delete.
+ * @return true if the key was deleted, false otherwise.
+ */
+#define cftxndelete(txn, key) confin_txn_delete(txn, key)
+
+/**
+ * @brief Deletes a key in a transaction.
+ * @param txn The transaction.
+ * @param key The key to delete.
+ * @return true if the key was present and deleted, false otherwise.
+ */
+bool confin_txn_delete(cftxn_t *txn, const char *key);
+
+/**
+ * @def cftxnget
+ * @brief Macro to find an entry by key in a transaction.
+ * @param txn The transaction.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if the key is not present.
+ */
+#define cftxnget(txn, key) confin_txn_get(txn, key)
+
+/**
+ * @brief Finds an entry by key in a transaction, including its uncommitted changes.
+ * @param txn The transaction.
+ * @param key The key to find.
+ * @return Pointer to the entry, valid until the next change in the transaction, or NULL if the key is not present.
+ */
+const cfentry_t *confin_txn_get(const cftxn_t *txn, const char *key);
+
+/**
+ * @def cftxncommit
+ * @brief Macro to commit a transaction.
+ * @param txn The transaction.
+ * @return true if the changes were committed, false otherwise.
+ */
+#define cftxncommit(txn) confin_txn_commit(txn)
+
+/**
+ * @brief Commits a transaction and frees it.
+ * 
+ * The changes become the current version at once. The commit fails if another
+ * transaction committed since this one started, or if an allocation failed; the
+ * caller can then start over from the current version. A transaction without
+ * changes commits without creating a version.
+ * 
+ * @param txn The transaction.
+ * @return true if the changes were committed, false otherwise.
+ */
+bool confin_txn_commit(cftxn_t *txn);
+
+/**
+ * @def cftxnabort
+ * @brief Macro to discard a transaction.
+ * @param txn The transaction.
+ */
+#define cftxnabort(txn) confin_txn_abort(txn)
+
+/**
+ * @brief Discards a transaction and frees it.
+ * @param txn The transaction; NULL is ignored.
+ */
+void confin_txn_abort(cftxn_t *txn);
+
+/**
+ * @def cfmutsethistory
+ * @brief Macro to set the number of versions retained in memory.
+ * @param config The mutable configuration.
+ * @param depth The number of versions, the current one included.
+ * @return true on success, false otherwise.
+ */
+#define cfmutsethistory(config, depth) confin_mutable_set_history(config, depth)
+
+/**
+ * @brief Sets the number of versions retained in memory.
+ * 
+ * Only the current version is retained by default. Lowering the depth releases
+ * the oldest versions, unless readers still hold them.
+ * 
+ * @param config The mutable configuration.
+ * @param depth The number of versions, the current one included; 0 is taken as 1.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_mutable_set_history(cfmutable_t *config, uint32_t depth);
+
+/**
+ * @def cfmutversions
+ * @brief Macro to list the retained versions.
+ * @param config The mutable configuration.
+ * @param versions Receives the numbers of the versions, newest first.
+ * @param capacity The number of elements of `versions`.
+ * @return The number of retained versions.
+ */
+#define cfmutversions(config, versions, capacity) confin_mutable_versions(config, versions, capacity)
+
+/**
+ * @brief Lists the retained versions.
+ * @param config The mutable configuration.
+ * @param versions Receives the numbers of the versions, newest first.
+ * @param capacity The number of elements of `versions`.
+ * @return The number of retained versions, which may exceed `capacity`.
+ */
+uint32_t confin_mutable_versions(cfmutable_t *config, uint64_t *versions, uint32_t capacity);
+
+/**
+ * @def cfmutversion
+ * @brief Macro to acquire a retained version.
+ * @param config The mutable configuration.
+ * @param version The number of the version.
+ * @return The version, or NULL if it is not retained.
+ */
+#define cfmutversion(config, version) confin_mutable_version(config, version)
+
+/**
+ * @brief Acquires a retained version.
+ * @param config The mutable configuration.
+ * @param version The number of the version.
+ * @return The version, to be released with @ref confin_snapshot_release, or NULL if it is not retained.
+ */
+cfsnapshot_t *confin_mutable_version(cfmutable_t *config, uint64_t version);
+
+/**
+ * @def cfmutrollback
+ * @brief Macro to make the entries of a retained version current again.
+ * @param config The mutable configuration.
+ * @param version The number of the version to restore.
+ * @return true on success, false otherwise.
+ */
+#define cfmutrollback(config, version) confin_mutable_rollback(config, version)
+
+/**
+ * @brief Makes the entries of a retained version current again.
+ * 
+ * The retained version already holds every entry, so the rollback commits a new
+ * version sharing its trie: no entry is copied or compared, unless versions are
+ * saved to a directory and the delta has to be written. Later versions stay
+ * retained, so a rollback can itself be rolled back. Like a commit, it fails if
+ * another transaction commits at the same time.
+ * 
+ * @param config The mutable configuration.
+ * @param version The number of the version to restore.
+ * @return true on success, false if the version is not retained or the commit failed.
+ */
+bool confin_mutable_rollback(cfmutable_t *config, uint64_t version);
+
+/**
+ * @def cfmutpersist
+ * @brief Macro to save the versions of a mutable configuration to a directory.
+ * @param config The mutable configuration.
+ * @param directory An existing directory, or NULL to stop saving versions.
+ * @return true on success, false otherwise.
+ */
+#define cfmutpersist(config, directory) confin_mutable_persist(config, directory)
+
+/**
+ * @brief Saves the versions of a mutable configuration to a directory.
+ * 
+ * The current version is written in full as `<version>.bin` and its number is added
+ * to `history.index`, the list of the versions saved in full. From then on, every
+ * commit and rollback writes `<version>.delta` before the version becomes current,
+ * and fails if the delta cannot be written. Deltas are computed from the tries,
+ * skipping the parts the versions share, so their cost is proportional to the
+ * changes. Commits block on a mutex while a delta is written; readers do not wait.
+ * 
+ * @param config The mutable configuration.
+ * @param directory An existing directory, or NULL to stop saving versions.
+ * @return true on success, false otherwise.
+ */
+bool confin_mutable_persist(cfmutable_t *config, const char *directory);
+
+/**
+ * @def cfhistoryload
+ * @brief Macro to load a saved version.
+ * @param directory The directory the versions were saved to.
+ * @param version The number of the version.
+ * @return The configuration, or NULL on failure.
+ */
+#define cfhistoryload(directory, version) confin_history_load(directory, version)
+
+/**
+ * @brief Loads a version saved by @ref confin_mutable_persist.
+ * 
+ * The newest version saved in full at or before `version` is found in
+ * `history.index`, read, and the deltas that follow it are applied in order.
+ * 
+ * @param directory The directory the versions were saved to.
+ * @param version The number of the version.
+ * @return The configuration, to be freed with @ref confin_free_config_file, or NULL on failure.
+ */
+cffile_t *confin_history_load(const char *directory, uint64_t version);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_MUTABLE_H
@@ -0,0 +1,508 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <unistd.h>
+#include <pthread.h>
+#define CONFIN_PARALLEL_THREADS 1
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfio.h" // confin/cfio.h
+#include "cfutils.h" // confin/cfutils.h
+#include "cfparallel.h" // confin/cfparallel.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Size of a pooled entry record: header and pool offset.
+ */
+#define CONFIN_POOLED_RECORD (sizeof(cfentryhdr_t) + sizeof(uint64_t))
+
+/**
+ * @brief Smallest byte range worth reading on its own thread.
+ */
+#define CONFIN_PARALLEL_MIN_RANGE (1 << 20)
+
+/* file helpers */
+
+static bool confin_seek(FILE *file, uint64_t offset, int whence) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, whence) == 0;
+#else
+    return fseeko(file, (off_t)offset, whence) == 0;
+#endif
+}
+
+static uint64_t confin_tell(FILE *file) {
+#ifdef _WIN32
+    return (uint64_t)_ftelli64(file);
+#else
+    return (uint64_t)ftello(file);
+#endif
+}
+
+static unsigned confin_default_threads(void) {
+#ifdef CONFIN_PARALLEL_THREADS
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (unsigned)online : 1;
+#else
+    return 1;
+#endif
+}
+
+/* jobs */
+
+/**
+ * @brief Stages of the loader, each run on every job before the next one starts.
+ */
+typedef enum {
+    CONFIN_STAGE_READ,   /**< Read a byte range of the body */
+    CONFIN_STAGE_DECODE, /**< Decode the headers of a range of entries */
+    CONFIN_STAGE_PACK    /**< Move the out-of-line values of a range of entries to the pool */
+} confin_load_stage_t;
+
+/**
+ * @brief Work item of a loader thread.
+ */
+typedef struct {
+    confin_load_stage_t stage; /**< Stage to run */
+    const char *filename;   /**< File to read */
+    uint64_t filestart;     /**< File position of the body */
+    unsigned char *raw;     /**< Body of the file */
+    uint64_t rawsize;       /**< Size of the body */
+    uint64_t readbegin;     /**< First body byte to read */
+    uint64_t readend;       /**< End of the body bytes to read */
+    const uint64_t *starts; /**< Body position of every __CONFIN_OFFSET_STRIDE-th entry */
+    uint64_t first;         /**< First entry to decode */
+    uint64_t last;          /**< End of the entries to decode */
+    uint64_t entrycount;    /**< Number of entries of the file */
+    const cflayout_t *layout; /**< Layout of the file */
+    cffile_t *config;       /**< Configuration being filled */
+    uint64_t packsize;      /**< Pool bytes taken by the out-of-line values of the range */
+    unsigned char *pack;    /**< Where those values go in the pool */
+    bool ok;                /**< Result of the job */
+} confin_load_job_t;
+
+static void confin_job_read(confin_load_job_t *job) {
+    if (job->readbegin == job->readend) {
+        return;
+    }
+    FILE *file = fopen(job->filename, "rb");
+    job->ok = file != NULL && confin_seek(file, job->filestart + job->readbegin, SEEK_SET) &&
+              fread(job->raw + job->readbegin, (size_t)(job->readend - job->readbegin), 1, file) == 1;
+    if (file) {
+        fclose(file);
+    }
+}
+
+/**
+ * @brief Decodes the entries of a job, leaving the body unchanged.
+ * 
+ * Every recorded position inside the range, and the position following it, is
+ * checked against the headers, so the ranges of the jobs are known to be disjoint
+ * before any value is moved.
+ */
+static void confin_job_decode(confin_load_job_t *job) {
+    bool pooled = (job->layout->flags & CONFIN_LAYOUT_POOLED) != 0;
+    uint64_t poolsize = job->layout->poolsize;
+    uint64_t record = pooled ? CONFIN_POOLED_RECORD : sizeof(cfentryhdr_t);
+    if (job->first == job->last) {
+        return;
+    }
+
+    uint64_t position = pooled ? poolsize + job->first * record : job->starts[job->first / __CONFIN_OFFSET_STRIDE];
+    for (uint64_t i = job->first; i < job->last; ++i) {
+        if (position > job->rawsize || job->rawsize - position < record) {
+            fprintf(stderr, "Unexpected end of file\n");
+            job->ok = false;
+            return;
+        }
+
+        cfentryhdr_t hdr;
+        memcpy(&hdr, job->raw + position, sizeof(hdr));
+        cfentry_t *entry = &job->config->entries[i];
+        confin_entry_from_header(&hdr, entry);
+
+        const unsigned char *value;
+        if (pooled) {
+            uint64_t offset;
+            memcpy(&offset, job->raw + position + sizeof(hdr), sizeof(offset));
+            if (offset > poolsize || hdr.size > poolsize - offset) {
+                fprintf(stderr, "Invalid pool offset\n");
+                job->ok = false;
+                return;
+            }
+            value = job->raw + offset;
+        } else {
+            if (hdr.size > job->rawsize - position - sizeof(hdr)) {
+                fprintf(stderr, "Unexpected end of file\n");
+                job->ok = false;
+                return;
+            }
+            value = job->raw + position + sizeof(hdr);
+        }
+
+        if (!pooled && hdr.size <= __CONFIN_INLINE_VALUE_MAX) {
+            memcpy(entry->inlinevalue, value, (size_t)hdr.size);
+            entry->value = entry->inlinevalue;
+            entry->flags |= CONFIN_ENTRY_INLINE;
+        } else {
+            entry->value = (void*)value;
+            entry->flags |= CONFIN_ENTRY_SHARED;
+            if (!pooled) {
+                job->packsize += (hdr.size + __CONFIN_POOL_ALIGN - 1) & ~(uint64_t)(__CONFIN_POOL_ALIGN - 1);
+            }
+        }
+        position += record + (pooled ? 0 : hdr.size);
+
+        if (!pooled && (i + 1) % __CONFIN_OFFSET_STRIDE == 0 && i + 1 < job->entrycount &&
+            position != job->starts[(i + 1) / __CONFIN_OFFSET_STRIDE]) {
+            fprintf(stderr, "Invalid offset table\n");
+            job->ok = false;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Points the out-of-line values of a job into the pool that replaces the body.
+ * 
+ * The values of a plain file are copied to the part of the pool reserved for the
+ * job, each at an 8-byte boundary; those of a pooled file already sit at the same
+ * offset in the pool, which is a copy of the start of the body.
+ */
+static void confin_job_pack(confin_load_job_t *job) {
+    bool pooled = (job->layout->flags & CONFIN_LAYOUT_POOLED) != 0;
+    unsigned char *pack = job->pack;
+    for (uint64_t i = job->first; i < job->last; ++i) {
+        cfentry_t *entry = &job->config->entries[i];
+        if (!(entry->flags & CONFIN_ENTRY_SHARED)) {
+            continue;
+        }
+        if (pooled) {
+            entry->value = (unsigned char*)job->config->pool + ((unsigned char*)entry->value - job->raw);
+            continue;
+        }
+        memcpy(pack, entry->value, (size_t)entry->size);
+        entry->value = pack;
+        pack += (entry->size + __CONFIN_POOL_ALIGN - 1) & ~(uint64_t)(__CONFIN_POOL_ALIGN - 1);
+    }
+}
+
+static void confin_job_run(confin_load_job_t *job) {
+    job->ok = true;
+    switch (job->stage) {
+        case CONFIN_STAGE_READ: confin_job_read(job); break;
+        case CONFIN_STAGE_DECODE: confin_job_decode(job); break;
+        case CONFIN_STAGE_PACK: confin_job_pack(job); break;
+    }
+}
+
+#ifdef CONFIN_PARALLEL_THREADS
+
+static void *confin_job_thread(void *arg) {
+    confin_job_run((confin_load_job_t*)arg);
+    return NULL;
+}
+
+#endif
+
+/**
+ * @brief Runs one stage on every job, on threads when available.
+ * @return true if every job succeeded.
+ */
+static bool confin_run_jobs(confin_load_job_t *jobs, unsigned count, confin_load_stage_t stage, const cfallocator_t *allocator) {
+    for (unsigned i = 0; i < count; ++i) {
+        jobs[i].stage = stage;
+    }
+#ifdef CONFIN_PARALLEL_THREADS
+    pthread_t *handles = count > 1 ? (pthread_t*)confin_alloc(allocator, sizeof(pthread_t) * count) : NULL;
+    bool *started = count > 1 ? (bool*)confin_alloc(allocator, sizeof(bool) * count) : NULL;
+    if (handles && started) {
+        for (unsigned i = 1; i < count; ++i) {
+            started[i] = pthread_create(&handles[i], NULL, confin_job_thread, &jobs[i]) == 0;
+            if (!started[i]) {
+                confin_job_run(&jobs[i]);
+            }
+        }
+        confin_job_run(&jobs[0]);
+        for (unsigned i = 1; i < count; ++i) {
+            if (started[i]) {
+                pthread_join(handles[i], NULL);
+            }
+        }
+    } else {
+        for (unsigned i = 0; i < count; ++i) {
+            confin_job_run(&jobs[i]);
+        }
+    }
+    confin_free(allocator, handles);
+    confin_free(allocator, started);
+#else
+    (void)allocator;
+    for (unsigned i = 0; i < count; ++i) {
+        confin_job_run(&jobs[i]);
+    }
+#endif
+
+    bool ok = true;
+    for (unsigned i = 0; i < count; ++i) {
+        ok = ok && jobs[i].ok;
+    }
+    return ok;
+}
+
+/* entry positions */
+
+/**
+ * @brief Reads the offset table at the end of a file and rebases it on the body.
+ * @return The positions, or NULL if the table is invalid.
+ */
+static uint64_t *confin_read_offsets(FILE *file, uint64_t filesize, uint64_t bodystart, uint64_t entrycount,
+                                     uint64_t *bodyend, const cfallocator_t *allocator) {
+    cfoffsettable_t table;
+    uint64_t expected = (entrycount + __CONFIN_OFFSET_STRIDE - 1) / __CONFIN_OFFSET_STRIDE;
+    if (filesize - bodystart < sizeof(table) || !confin_seek(file, filesize - sizeof(table), SEEK_SET) ||
+        fread(&table, sizeof(table), 1, file) != 1 || table.stride != __CONFIN_OFFSET_STRIDE || table.count != expected ||
+        (filesize - bodystart - sizeof(table)) / sizeof(uint64_t) < table.count) {
+        fprintf(stderr, "Invalid offset table\n");
+        return NULL;
+    }
+
+    *bodyend = filesize - sizeof(table) - sizeof(uint64_t) * table.count;
+    uint64_t *starts = (uint64_t*)confin_alloc(allocator, sizeof(uint64_t) * (table.count ? table.count : 1));
+    if (!starts) {
+        perror("malloc");
+        return NULL;
+    }
+    if (table.count && (!confin_seek(file, *bodyend, SEEK_SET) ||
+                        fread(starts, sizeof(uint64_t) * table.count, 1, file) != 1)) {
+        fprintf(stderr, "Unexpected end of file\n");
+        confin_free(allocator, starts);
+        return NULL;
+    }
+    for (uint64_t i = 0; i < table.count; ++i) {
+        if ((i ? starts[i] <= starts[i - 1] : starts[i] != bodystart) || starts[i] >= *bodyend) {
+            fprintf(stderr, "Invalid offset table\n");
+            confin_free(allocator, starts);
+            return NULL;
+        }
+        starts[i] -= bodystart;
+    }
+    return starts;
+}
+
+/**
+ * @brief Finds the position of every __CONFIN_OFFSET_STRIDE-th entry by hopping over the headers.
+ * @return The positions, or NULL if the body is truncated.
+ */
+static uint64_t *confin_prescan(const unsigned char *raw, uint64_t rawsize, uint64_t entrycount, const cfallocator_t *allocator) {
+    uint64_t count = (entrycount + __CONFIN_OFFSET_STRIDE - 1) / __CONFIN_OFFSET_STRIDE;
+    uint64_t *starts = (uint64_t*)confin_alloc(allocator, sizeof(uint64_t) * (count ? count : 1));
+    if (!starts) {
+        perror("malloc");
+        return NULL;
+    }
+
+    uint64_t position = 0;
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        if (rawsize - position < sizeof(cfentryhdr_t)) {
+            fprintf(stderr, "Unexpected end of file\n");
+            confin_free(allocator, starts);
+            return NULL;
+        }
+        if (i % __CONFIN_OFFSET_STRIDE == 0) {
+            starts[i / __CONFIN_OFFSET_STRIDE] = position;
+        }
+        uint64_t size;
+        memcpy(&size, raw + position + offsetof(cfentryhdr_t, size), sizeof(size));
+        if (size > rawsize - position - sizeof(cfentryhdr_t)) {
+            fprintf(stderr, "Unexpected end of file\n");
+            confin_free(allocator, starts);
+            return NULL;
+        }
+        position += sizeof(cfentryhdr_t) + size;
+    }
+    return starts;
+}
+
+/* cfparallel implementation */
+
+/**
+ * @brief Reads a configuration file on several threads.
+ * @param filename The name of the file to read.
+ * @param threads The number of threads, 0 for one per online processor.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+cffile_t *confin_read_config_parallel(const char *filename, unsigned threads) {
+    return confin_read_config_parallel_ctx(filename, threads, NULL);
+}
+
+/**
+ * @brief Reads a configuration file on several threads with a context.
+ * @param filename The name of the file to read.
+ * @param threads The number of threads, 0 for one per online processor.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+cffile_t *confin_read_config_parallel_ctx(const char *filename, unsigned threads, cfcontext_t *ctx) {
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    if (threads == 0) {
+        threads = confin_default_threads();
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        perror("fopen");
+        return NULL;
+    }
+
+    cfheader_t header;
+    cflayout_t layout = {0, 0};
+    bool ok = fread(&header, sizeof(header), 1, file) == 1;
+    if (ok && header.version >= __CONFIN_LAYOUT_VERSION) {
+        ok = fread(&layout, sizeof(layout), 1, file) == 1;
+    }
+    if (!ok) {
+        fprintf(stderr, "Unexpected end of file\n");
+    } else if (header.magic != __CONFIN_STRUCT_MAGIC_NUMBER) {
+        fprintf(stderr, "Invalid magic number\n");
+        ok = false;
+    } else if (header.version > _CF_VER) {
+        fprintf(stderr, "Invalid version\n");
+        ok = false;
+    }
+
+    uint64_t bodystart = ok ? confin_tell(file) : 0;
+    uint64_t filesize = ok && confin_seek(file, 0, SEEK_END) ? confin_tell(file) : 0;
+    uint64_t bodyend = filesize;
+    bool pooled = (layout.flags & CONFIN_LAYOUT_POOLED) != 0;
+    uint64_t *starts = NULL;
+    if (ok && !pooled && (layout.flags & CONFIN_LAYOUT_OFFSETS)) {
+        starts = confin_read_offsets(file, filesize, bodystart, header.entrycount, &bodyend, &allocator);
+        ok = starts != NULL;
+    }
+    fclose(file);
+
+    // Reject entry counts the body cannot hold before allocating for them
+    uint64_t rawsize = ok ? bodyend - bodystart : 0;
+    uint64_t record = pooled ? CONFIN_POOLED_RECORD : sizeof(cfentryhdr_t);
+    if (ok && (rawsize < layout.poolsize || (rawsize - layout.poolsize) / record < header.entrycount)) {
+        fprintf(stderr, "Unexpected end of file\n");
+        ok = false;
+    }
+
+    unsigned char *raw = ok ? (unsigned char*)confin_alloc(&allocator, rawsize ? rawsize : 1) : NULL;
+    cffile_t *config = ok && raw ? confin_alloc_config(&allocator, header.entrycount) : NULL;
+    confin_load_job_t *jobs = config ? (confin_load_job_t*)confin_alloc(&allocator, sizeof(confin_load_job_t) * threads) : NULL;
+    if (!jobs) {
+        if (ok) {
+            perror("malloc");
+        }
+        confin_free(&allocator, starts);
+        confin_free(&allocator, raw);
+        if (config) {
+            confin_free_config_file(config);
+        }
+        return NULL;
+    }
+    config->header = header;
+    config->header.entrycount = 0;
+    config->layout = layout;
+
+    // Stage 1: read the body in equal byte ranges
+    unsigned readers = threads;
+    while (readers > 1 && rawsize / readers < CONFIN_PARALLEL_MIN_RANGE) {
+        --readers;
+    }
+    memset(jobs, 0, sizeof(confin_load_job_t) * threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        jobs[i].filename = filename;
+        jobs[i].filestart = bodystart;
+        jobs[i].raw = raw;
+        jobs[i].rawsize = rawsize;
+    }
+    for (unsigned i = 0; i < readers; ++i) {
+        jobs[i].readbegin = rawsize / readers * i;
+        jobs[i].readend = i + 1 == readers ? rawsize : rawsize / readers * (i + 1);
+    }
+    ok = confin_run_jobs(jobs, readers, CONFIN_STAGE_READ, &allocator);
+    if (!ok) {
+        fprintf(stderr, "Unexpected end of file\n");
+    }
+
+    // Stage 2: decode whole strides of entries, leaving their values in the body
+    if (ok && !pooled && !starts) {
+        starts = confin_prescan(raw, rawsize, header.entrycount, &allocator);
+        ok = starts != NULL;
+    }
+    unsigned decoders = 0;
+    if (ok) {
+        uint64_t strides = (header.entrycount + __CONFIN_OFFSET_STRIDE - 1) / __CONFIN_OFFSET_STRIDE;
+        decoders = strides < threads ? (unsigned)(strides ? strides : 1) : threads;
+        for (unsigned i = 0; i < decoders; ++i) {
+            jobs[i].starts = starts;
+            jobs[i].entrycount = header.entrycount;
+            jobs[i].layout = &layout;
+            jobs[i].config = config;
+            jobs[i].first = strides * i / decoders * __CONFIN_OFFSET_STRIDE;
+            jobs[i].last = strides * (i + 1) / decoders * __CONFIN_OFFSET_STRIDE;
+            if (jobs[i].first > header.entrycount) {
+                jobs[i].first = header.entrycount;
+            }
+            if (jobs[i].last > header.entrycount) {
+                jobs[i].last = header.entrycount;
+            }
+        }
+        ok = confin_run_jobs(jobs, decoders, CONFIN_STAGE_DECODE, &allocator);
+    }
+
+    // Stage 3: move the out-of-line values to a pool sized for them, so the
+    // headers and inline values of the body are not kept alive by the configuration
+    if (ok) {
+        uint64_t poolsize = pooled ? layout.poolsize : 0;
+        for (unsigned i = 0; i < decoders; ++i) {
+            poolsize += jobs[i].packsize;
+        }
+        config->pool = poolsize ? confin_alloc(&allocator, poolsize) : NULL;
+        ok = !poolsize || config->pool != NULL;
+        if (!ok) {
+            perror("malloc");
+        }
+    }
+    if (ok) {
+        unsigned char *pack = (unsigned char*)config->pool;
+        if (pooled && layout.poolsize) {
+            memcpy(pack, raw, (size_t)layout.poolsize);
+        }
+        for (unsigned i = 0; i < decoders; ++i) {
+            jobs[i].pack = pack;
+            pack += jobs[i].packsize;
+        }
+        ok = confin_run_jobs(jobs, decoders, CONFIN_STAGE_PACK, &allocator);
+    }
+
+    confin_free(&allocator, jobs);
+    confin_free(&allocator, starts);
+    confin_free(&allocator, raw);
+    if (!ok) {
+        // Decoded entries only borrow from the body or the pool, freeing the pool is enough
+        confin_free_config_file(config);
+        return NULL;
+    }
+    config->header.entrycount = header.entrycount;
+    return config;
+}
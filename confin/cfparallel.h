@@ -0,0 +1,70 @@
+/**
+ * @file cfparallel.h
+ * @brief Functions and macros for loading a configuration on several threads.
+ * 
+ * This header file provides the parallel loader. The body of the file is read
+ * into one buffer in equal byte ranges, one per thread, and the entries are then
+ * decoded by ranges of @ref __CONFIN_OFFSET_STRIDE entries. The start of each
+ * range comes from the offset table when the file has one, from the fixed record
+ * size of pooled files, or from a prescan that hops over the entry headers.
+ * 
+ * Once decoded, values larger than @ref __CONFIN_INLINE_VALUE_MAX are moved to a
+ * pool sized for them (the pool of the file when it has one) and the buffer is
+ * freed, so the configuration keeps no entry headers or inline values.
+ */
+
+#ifndef _CONFIN_PARALLEL_H
+#define _CONFIN_PARALLEL_H
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfreadcfgparallel
+ * @brief Macro to read a configuration file on several threads.
+ * @param filename The name of the file to read.
+ * @param threads The number of threads, 0 for one per online processor.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+#define cfreadcfgparallel(filename, threads) confin_read_config_parallel(filename, threads)
+
+/**
+ * @brief Reads a configuration file on several threads.
+ * 
+ * The result is the same as with @ref confin_read_config, except that values
+ * larger than @ref __CONFIN_INLINE_VALUE_MAX are shared pointers into one pool
+ * owned by the configuration. Without thread support the file is read serially.
+ * 
+ * @param filename The name of the file to read.
+ * @param threads The number of threads, 0 for one per online processor.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+cffile_t *confin_read_config_parallel(const char *filename, unsigned threads);
+
+/**
+ * @def cfreadcfgparallelctx
+ * @brief Macro to read a configuration file on several threads with a context.
+ * @param filename The name of the file to read.
+ * @param threads The number of threads, 0 for one per online processor.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+#define cfreadcfgparallelctx(filename, threads, ctx) confin_read_config_parallel_ctx(filename, threads, ctx)
+
+/**
+ * @brief Reads a configuration file on several threads with a context.
+ * @param filename The name of the file to read.
+ * @param threads The number of threads, 0 for one per online processor.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+cffile_t *confin_read_config_parallel_ctx(const char *filename, unsigned threads, cfcontext_t *ctx);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_PARALLEL_H
@@ -16,5 +16,20 @@
 #include "cfio.h"     // confin/cfio.h
 #include "cfutils.h"  // confin/cfutil.h
 #include "cffmt.h"    // confin/cffmt.h
+#include "cfctx.h"    // confin/cfctx.h
+#include "cfstats.h"  // confin/cfstats.h
+#include "cfdiff.h"   // confin/cfdiff.h
+#include "cfcompile.h" // confin/cfcompile.h
+#include "cfexport.h"  // confin/cfexport.h
+#include "cfbind.h"    // confin/cfbind.h
+#include "cflookup.h"  // confin/cflookup.h
+#include "cfwriter.h"  // confin/cfwriter.h
+#include "cfparallel.h" // confin/cfparallel.h
+#include "cfmutable.h"  // confin/cfmutable.h
+#include "cfserver.h"   // confin/cfserver.h
+#include "cfclient.h"   // confin/cfclient.h
+#include "cfshard.h"    // confin/cfshard.h
+#include "cffrozen.h"   // confin/cffrozen.h
+#include "cfcompact.h"  // confin/cfcompact.h
 
 #endif // _CONFIN_SELF_H
@@ -0,0 +1,948 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // accept4
+#endif
+
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#if defined(__linux__)
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#define CONFIN_SERVER_EPOLL 1
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfio.h" // confin/cfio.h
+#include "cfutils.h" // confin/cfutils.h
+#include "cflookup.h" // confin/cflookup.h
+#include "cfserver.h" // confin/cfserver.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+#ifdef CONFIN_SERVER_EPOLL
+
+/**
+ * @brief Size of the buffer every connection reads into.
+ */
+#define CONFIN_SERVER_READ_SIZE (64 * 1024)
+
+/**
+ * @brief Number of events taken from `epoll` at once.
+ */
+#define CONFIN_SERVER_EVENTS 256
+
+/**
+ * @brief A file served under a name.
+ */
+typedef struct {
+    char *name;                /**< Name of the configuration */
+    char *path;                /**< Path of the file */
+    cffile_t *config;          /**< Loaded configuration */
+    const cfentry_t **sorted;  /**< Entries ordered by key, for prefix lookups */
+    struct stat identity;      /**< Status of the file when it was loaded */
+    cffile_t *staged;          /**< Configuration read by the loader, not served yet, or NULL */
+    const cfentry_t **stagedsorted; /**< Entries of `staged` ordered by key */
+    struct stat stagedidentity; /**< Status of the file when `staged` was read */
+} confin_served_t;
+
+/**
+ * @brief Growable byte buffer.
+ */
+typedef struct {
+    char *data;                /**< Bytes, or NULL */
+    size_t length;             /**< Bytes in use */
+    size_t capacity;           /**< Bytes allocated */
+} confin_buffer_t;
+
+/**
+ * @brief Connection of a client.
+ */
+typedef struct confin_connection {
+    int fd;                    /**< Socket */
+    uint32_t events;           /**< Events the socket is registered for */
+    confin_buffer_t in;        /**< Incomplete request */
+    confin_buffer_t out;       /**< Replies not yet sent */
+    size_t sent;               /**< Bytes of `out` already sent */
+    struct confin_connection *prev; /**< Previous connection of the server */
+    struct confin_connection *next; /**< Next connection of the server */
+} confin_connection_t;
+
+struct __s_confin_server {
+    int listenfd;              /**< Listening socket */
+    int epollfd;               /**< Event queue */
+    int wakefd;                /**< Event counter written by stop and reload */
+    int stop;                  /**< Set by confin_server_stop */
+    int reload;                /**< Set by confin_server_reload */
+    pthread_t loader;          /**< Thread reading the files, valid while `loading` */
+    bool loading;              /**< Whether the loader thread runs or has to be joined */
+    bool loadforce;            /**< Whether the loader reads every file, changed or not */
+    int loaded;                /**< Set by the loader thread when it is done */
+    bool accepting;            /**< Whether the listening socket is registered */
+    char *path;                /**< Path of the socket */
+    cfallocator_t allocator;   /**< Allocator of the server */
+    confin_served_t *configs;  /**< Served configurations */
+    size_t configcount;        /**< Number of served configurations */
+    confin_connection_t *connections; /**< Open connections */
+    char *scratch;             /**< Buffer of CONFIN_SERVER_READ_SIZE bytes for reads */
+    char (*keys)[__CONFIN_STRUCT_MAX_KEYLEN]; /**< Keys of the request being served */
+    const char **keynames;     /**< Pointers to `keys` */
+    const cfentry_t **found;   /**< Entries of the keys */
+    size_t keycapacity;        /**< Number of keys the three arrays hold */
+};
+
+/* served configurations */
+
+static int confin_compare_keys(const void *a, const void *b) {
+    const cfentry_t *left = *(const cfentry_t *const*)a;
+    const cfentry_t *right = *(const cfentry_t *const*)b;
+    return strncmp(left->key, right->key, __CONFIN_STRUCT_MAX_KEYLEN);
+}
+
+static bool confin_served_changed(const confin_served_t *served) {
+    struct stat identity;
+    if (stat(served->path, &identity) != 0) {
+        return false;
+    }
+    return identity.st_dev != served->identity.st_dev || identity.st_ino != served->identity.st_ino ||
+           identity.st_size != served->identity.st_size ||
+           identity.st_mtim.tv_sec != served->identity.st_mtim.tv_sec ||
+           identity.st_mtim.tv_nsec != served->identity.st_mtim.tv_nsec;
+}
+
+// Reads, sorts and indexes a served file into its staged configuration; nothing is staged on failure
+static bool confin_served_prepare(confin_served_t *served, const cfallocator_t *allocator) {
+    struct stat identity;
+    if (stat(served->path, &identity) != 0) {
+        perror("stat");
+        return false;
+    }
+    cfcontext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.allocator = *allocator;
+    cffile_t *config = confin_read_config_ctx(served->path, &ctx);
+    if (!config) {
+        fprintf(stderr, "Failed to load %s\n", served->path);
+        return false;
+    }
+    uint64_t count = config->header.entrycount;
+    const cfentry_t **sorted = (const cfentry_t**)confin_alloc(allocator, sizeof(*sorted) * (count ? count : 1));
+    if (!sorted) {
+        perror("malloc");
+        confin_free_config_file(config);
+        return false;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        sorted[i] = &config->entries[i];
+    }
+    qsort(sorted, (size_t)count, sizeof(*sorted), confin_compare_keys);
+    // Without an index lookups fall back to a linear search
+    confin_index_config(config);
+
+    served->staged = config;
+    served->stagedsorted = sorted;
+    served->stagedidentity = identity;
+    return true;
+}
+
+// Serves the staged configuration of a file, if there is one
+static void confin_served_install(confin_served_t *served, const cfallocator_t *allocator) {
+    if (!served->staged) {
+        return;
+    }
+    if (served->config) {
+        confin_free_config_file(served->config);
+    }
+    confin_free(allocator, (void*)served->sorted);
+    served->config = served->staged;
+    served->sorted = served->stagedsorted;
+    served->identity = served->stagedidentity;
+    served->staged = NULL;
+    served->stagedsorted = NULL;
+}
+
+// Replaces the configuration of a served file; the previous one is kept on failure
+static bool confin_served_load(confin_served_t *served, const cfallocator_t *allocator) {
+    if (!confin_served_prepare(served, allocator)) {
+        return false;
+    }
+    confin_served_install(served, allocator);
+    return true;
+}
+
+static void confin_wake(cfserver_t *server);
+
+// Loader thread: stages the files to reload, then wakes the event loop to serve them
+static void *confin_served_stage(void *arg) {
+    cfserver_t *server = (cfserver_t*)arg;
+    for (size_t i = 0; i < server->configcount; ++i) {
+        if (server->loadforce || confin_served_changed(&server->configs[i])) {
+            confin_served_prepare(&server->configs[i], &server->allocator);
+        }
+    }
+    __atomic_store_n(&server->loaded, 1, __ATOMIC_RELEASE);
+    confin_wake(server);
+    return NULL;
+}
+
+// Serves the files staged by a finished loader thread
+static void confin_served_finish(cfserver_t *server) {
+    pthread_join(server->loader, NULL);
+    server->loading = false;
+    __atomic_store_n(&server->loaded, 0, __ATOMIC_RELAXED);
+    for (size_t i = 0; i < server->configcount; ++i) {
+        confin_served_install(&server->configs[i], &server->allocator);
+    }
+}
+
+/**
+ * @brief Advances the reload of the served files; called on the event loop.
+ *
+ * Files are read, sorted and indexed on a loader thread, so requests keep being
+ * served from the previous contents meanwhile; the loop only swaps the results
+ * in once the thread is done. A reload requested while one runs starts after it.
+ * @param check Whether to look for changed files if no reload was requested.
+ */
+static void confin_served_reload(cfserver_t *server, bool check) {
+    if (server->loading) {
+        if (!__atomic_load_n(&server->loaded, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+        confin_served_finish(server);
+    }
+    bool force = __atomic_exchange_n(&server->reload, 0, __ATOMIC_ACQ_REL) != 0;
+    bool changed = force;
+    for (size_t i = 0; !changed && check && i < server->configcount; ++i) {
+        changed = confin_served_changed(&server->configs[i]);
+    }
+    if (!changed) {
+        return;
+    }
+    server->loadforce = force;
+    server->loading = pthread_create(&server->loader, NULL, confin_served_stage, server) == 0;
+    if (!server->loading) {
+        // Without a thread the files are read on the event loop
+        for (size_t i = 0; i < server->configcount; ++i) {
+            if (force || confin_served_changed(&server->configs[i])) {
+                confin_served_load(&server->configs[i], &server->allocator);
+            }
+        }
+    }
+}
+
+static confin_served_t *confin_served_find(cfserver_t *server, const char *name, uint16_t length) {
+    if (length == 0) {
+        return &server->configs[0];
+    }
+    for (size_t i = 0; i < server->configcount; ++i) {
+        const char *candidate = server->configs[i].name;
+        if (strlen(candidate) == length && memcmp(candidate, name, length) == 0) {
+            return &server->configs[i];
+        }
+    }
+    return NULL;
+}
+
+/* buffers */
+
+static bool confin_buffer_reserve(confin_buffer_t *buffer, size_t size, const cfallocator_t *allocator) {
+    if (buffer->capacity - buffer->length >= size) {
+        return true;
+    }
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity - buffer->length < size) {
+        capacity *= 2;
+    }
+    char *data = (char*)confin_realloc(allocator, buffer->data, capacity);
+    if (!data) {
+        perror("realloc");
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool confin_buffer_append(confin_buffer_t *buffer, const void *data, size_t size, const cfallocator_t *allocator) {
+    if (!confin_buffer_reserve(buffer, size, allocator)) {
+        return false;
+    }
+    memcpy(buffer->data + buffer->length, data, size);
+    buffer->length += size;
+    return true;
+}
+
+static void confin_buffer_release(confin_buffer_t *buffer, const cfallocator_t *allocator) {
+    confin_free(allocator, buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+/* replies */
+
+static bool confin_reply_item(confin_buffer_t *out, const cfallocator_t *allocator, uint32_t type, uint16_t flags,
+                              const char *key, uint16_t keylength, const void *value, uint64_t size) {
+    static const char padding[__CONFIN_POOL_ALIGN] = {0};
+    size_t keypad = (__CONFIN_POOL_ALIGN - keylength % __CONFIN_POOL_ALIGN) % __CONFIN_POOL_ALIGN;
+    size_t valuepad = (size_t)((__CONFIN_POOL_ALIGN - size % __CONFIN_POOL_ALIGN) % __CONFIN_POOL_ALIGN);
+    cfreplyitem_t item;
+    item.type = type;
+    item.keylength = keylength;
+    item.flags = flags;
+    item.size = size;
+    if (!confin_buffer_reserve(out, sizeof(item) + keylength + keypad + (size_t)size + valuepad, allocator)) {
+        return false;
+    }
+    confin_buffer_append(out, &item, sizeof(item), allocator);
+    confin_buffer_append(out, key, keylength, allocator);
+    confin_buffer_append(out, padding, keypad, allocator);
+    if (size) {
+        confin_buffer_append(out, value, (size_t)size, allocator);
+    }
+    confin_buffer_append(out, padding, valuepad, allocator);
+    return true;
+}
+
+static bool confin_reply_entry(confin_buffer_t *out, const cfallocator_t *allocator, const cfentry_t *entry) {
+    uint16_t keylength = (uint16_t)strnlen(entry->key, __CONFIN_STRUCT_MAX_KEYLEN);
+    return confin_reply_item(out, allocator, (uint32_t)entry->type, 0, entry->key, keylength,
+                             CF_ENTRYVAL(entry), entry->size);
+}
+
+// Reads a length-prefixed string of a request body
+static bool confin_request_string(const char **cursor, const char *end, const char **string, uint16_t *length) {
+    if ((size_t)(end - *cursor) < sizeof(uint16_t)) {
+        return false;
+    }
+    memcpy(length, *cursor, sizeof(uint16_t));
+    *cursor += sizeof(uint16_t);
+    if ((size_t)(end - *cursor) < *length) {
+        return false;
+    }
+    *string = *cursor;
+    *cursor += *length;
+    return true;
+}
+
+static bool confin_reserve_keys(cfserver_t *server, size_t count) {
+    if (count <= server->keycapacity) {
+        return true;
+    }
+    size_t capacity = server->keycapacity ? server->keycapacity : 64;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    void *keys = confin_realloc(&server->allocator, server->keys, sizeof(*server->keys) * capacity);
+    if (keys) {
+        server->keys = (char (*)[__CONFIN_STRUCT_MAX_KEYLEN])keys;
+    }
+    void *keynames = confin_realloc(&server->allocator, (void*)server->keynames, sizeof(*server->keynames) * capacity);
+    if (keynames) {
+        server->keynames = (const char**)keynames;
+    }
+    void *found = confin_realloc(&server->allocator, (void*)server->found, sizeof(*server->found) * capacity);
+    if (found) {
+        server->found = (const cfentry_t**)found;
+    }
+    if (!keys || !keynames || !found) {
+        perror("realloc");
+        return false;
+    }
+    server->keycapacity = capacity;
+    return true;
+}
+
+static cfreplystatus_t confin_serve_get(cfserver_t *server, confin_buffer_t *out, confin_served_t *served,
+                                        const char *body, const char *end, uint16_t count) {
+    if (!confin_reserve_keys(server, count)) {
+        return CONFIN_REPLY_TOO_LARGE;
+    }
+    const char *cursor = body;
+    for (uint16_t i = 0; i < count; ++i) {
+        const char *key;
+        uint16_t length;
+        if (!confin_request_string(&cursor, end, &key, &length)) {
+            return CONFIN_REPLY_MALFORMED;
+        }
+        // A key too long for an entry is looked up as the empty key and reported missing
+        size_t kept = length < __CONFIN_STRUCT_MAX_KEYLEN ? length : 0;
+        memcpy(server->keys[i], key, kept);
+        server->keys[i][kept] = '\0';
+        server->keynames[i] = server->keys[i];
+    }
+    if (cursor != end) {
+        return CONFIN_REPLY_MALFORMED;
+    }
+    confin_get_many(served->config, server->keynames, count, server->found);
+
+    cursor = body;
+    for (uint16_t i = 0; i < count; ++i) {
+        const char *key = NULL;
+        uint16_t length = 0;
+        confin_request_string(&cursor, end, &key, &length);
+        bool ok = length < __CONFIN_STRUCT_MAX_KEYLEN && server->found[i]
+                      ? confin_reply_entry(out, &server->allocator, server->found[i])
+                      : confin_reply_item(out, &server->allocator, 0, CONFIN_REPLY_MISSING, key, length, NULL, 0);
+        if (!ok) {
+            return CONFIN_REPLY_TOO_LARGE;
+        }
+    }
+    return CONFIN_REPLY_OK;
+}
+
+static cfreplystatus_t confin_serve_prefix(cfserver_t *server, confin_buffer_t *out, confin_served_t *served,
+                                           const char *body, const char *end, uint16_t count, uint32_t *items) {
+    const char *prefix;
+    uint16_t length;
+    if (count != 1 || !confin_request_string(&body, end, &prefix, &length) || body != end) {
+        return CONFIN_REPLY_MALFORMED;
+    }
+    if (length >= __CONFIN_STRUCT_MAX_KEYLEN) {
+        return CONFIN_REPLY_OK;
+    }
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    memcpy(key, prefix, length);
+    key[length] = '\0';
+
+    // Keys starting with the prefix follow the first key not below it
+    uint64_t low = 0;
+    uint64_t high = served->config->header.entrycount;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (strncmp(served->sorted[middle]->key, key, __CONFIN_STRUCT_MAX_KEYLEN) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (; low < served->config->header.entrycount; ++low) {
+        const cfentry_t *entry = served->sorted[low];
+        if (strncmp(entry->key, key, length) != 0) {
+            break;
+        }
+        if (*items == UINT32_MAX || !confin_reply_entry(out, &server->allocator, entry)) {
+            return CONFIN_REPLY_TOO_LARGE;
+        }
+        ++*items;
+    }
+    return CONFIN_REPLY_OK;
+}
+
+// Appends the reply to one request to the output of a connection
+static bool confin_serve(cfserver_t *server, confin_connection_t *connection, const cfrequesthdr_t *request, const char *body) {
+    confin_buffer_t *out = &connection->out;
+    size_t start = out->length;
+    cfreplyhdr_t reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.id = request->id;
+    if (!confin_buffer_append(out, &reply, sizeof(reply), &server->allocator)) {
+        return false;
+    }
+
+    const char *end = body + request->size;
+    const char *name;
+    uint16_t length;
+    uint32_t items = 0;
+    cfreplystatus_t status = CONFIN_REPLY_MALFORMED;
+    if (confin_request_string(&body, end, &name, &length)) {
+        confin_served_t *served = confin_served_find(server, name, length);
+        if (!served) {
+            status = CONFIN_REPLY_UNKNOWN_CONFIG;
+        } else if (request->op == CONFIN_REQUEST_GET) {
+            status = confin_serve_get(server, out, served, body, end, request->count);
+            items = request->count;
+        } else if (request->op == CONFIN_REQUEST_PREFIX) {
+            status = confin_serve_prefix(server, out, served, body, end, request->count, &items);
+        }
+    }
+    if (status == CONFIN_REPLY_OK && out->length - start - sizeof(reply) > UINT32_MAX) {
+        status = CONFIN_REPLY_TOO_LARGE;
+    }
+    if (status != CONFIN_REPLY_OK) {
+        out->length = start + sizeof(reply);
+        items = 0;
+    }
+    reply.size = (uint32_t)(out->length - start - sizeof(reply));
+    reply.status = (uint16_t)status;
+    reply.count = items;
+    memcpy(out->data + start, &reply, sizeof(reply));
+    return true;
+}
+
+// Serves the complete requests at the start of a range; returns the bytes consumed or SIZE_MAX to drop the connection
+static size_t confin_serve_range(cfserver_t *server, confin_connection_t *connection, const char *data, size_t size) {
+    size_t consumed = 0;
+    while (size - consumed >= sizeof(cfrequesthdr_t)) {
+        cfrequesthdr_t request;
+        memcpy(&request, data + consumed, sizeof(request));
+        if (request.size > __CONFIN_SERVER_MAX_REQUEST) {
+            return SIZE_MAX;
+        }
+        if (size - consumed - sizeof(request) < request.size) {
+            break;
+        }
+        if (!confin_serve(server, connection, &request, data + consumed + sizeof(request))) {
+            return SIZE_MAX;
+        }
+        consumed += sizeof(request) + request.size;
+    }
+    return consumed;
+}
+
+/* connections */
+
+static bool confin_watch(cfserver_t *server, confin_connection_t *connection, uint32_t events) {
+    if (connection->events == events) {
+        return true;
+    }
+    struct epoll_event event;
+    event.events = events;
+    event.data.ptr = connection;
+    if (epoll_ctl(server->epollfd, EPOLL_CTL_MOD, connection->fd, &event) != 0) {
+        perror("epoll_ctl");
+        return false;
+    }
+    connection->events = events;
+    return true;
+}
+
+static void confin_set_accepting(cfserver_t *server, bool accepting) {
+    if (server->accepting == accepting) {
+        return;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &server->listenfd;
+    if (epoll_ctl(server->epollfd, accepting ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, server->listenfd, &event) == 0) {
+        server->accepting = accepting;
+    }
+}
+
+static void confin_close_connection(cfserver_t *server, confin_connection_t *connection) {
+    close(connection->fd);
+    if (connection->prev) {
+        connection->prev->next = connection->next;
+    } else {
+        server->connections = connection->next;
+    }
+    if (connection->next) {
+        connection->next->prev = connection->prev;
+    }
+    confin_buffer_release(&connection->in, &server->allocator);
+    confin_buffer_release(&connection->out, &server->allocator);
+    confin_free(&server->allocator, connection);
+    // A descriptor is free again
+    confin_set_accepting(server, true);
+}
+
+static void confin_accept(cfserver_t *server) {
+    for (;;) {
+        int fd = accept4(server->listenfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EMFILE || errno == ENFILE) {
+                // Out of descriptors: stop accepting until a connection closes
+                fprintf(stderr, "accept: %s, %s\n", strerror(errno), "pausing new connections");
+                confin_set_accepting(server, false);
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                perror("accept");
+            }
+            if (errno != EINTR && errno != ECONNABORTED) {
+                return;
+            }
+            continue;
+        }
+        confin_connection_t *connection = (confin_connection_t*)confin_alloc(&server->allocator, sizeof(*connection));
+        if (!connection) {
+            perror("malloc");
+            close(fd);
+            return;
+        }
+        memset(connection, 0, sizeof(*connection));
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (epoll_ctl(server->epollfd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            perror("epoll_ctl");
+            close(fd);
+            confin_free(&server->allocator, connection);
+            return;
+        }
+        connection->next = server->connections;
+        if (server->connections) {
+            server->connections->prev = connection;
+        }
+        server->connections = connection;
+    }
+}
+
+// Sends as much of the pending output as the socket takes
+static bool confin_flush(cfserver_t *server, confin_connection_t *connection) {
+    confin_buffer_t *out = &connection->out;
+    while (connection->sent < out->length) {
+        ssize_t sent = send(connection->fd, out->data + connection->sent, out->length - connection->sent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+        connection->sent += (size_t)sent;
+    }
+    if (connection->sent == out->length) {
+        connection->sent = 0;
+        out->length = 0;
+        if (out->capacity > CONFIN_SERVER_READ_SIZE) {
+            confin_buffer_release(out, &server->allocator);
+        }
+        return confin_watch(server, connection, EPOLLIN);
+    }
+    // Stop reading requests until the client reads its replies
+    return confin_watch(server, connection, EPOLLOUT);
+}
+
+static bool confin_receive(cfserver_t *server, confin_connection_t *connection) {
+    ssize_t received = recv(connection->fd, server->scratch, CONFIN_SERVER_READ_SIZE, 0);
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (received == 0) {
+        return false;
+    }
+
+    confin_buffer_t *in = &connection->in;
+    const char *data = server->scratch;
+    size_t size = (size_t)received;
+    if (in->length) {
+        if (!confin_buffer_append(in, server->scratch, size, &server->allocator)) {
+            return false;
+        }
+        data = in->data;
+        size = in->length;
+    }
+    size_t consumed = confin_serve_range(server, connection, data, size);
+    if (consumed == SIZE_MAX) {
+        return false;
+    }
+    // Keeps the incomplete request for the next read
+    if (in->length) {
+        memmove(in->data, in->data + consumed, size - consumed);
+        in->length = size - consumed;
+        if (in->length == 0 && in->capacity > CONFIN_SERVER_READ_SIZE) {
+            confin_buffer_release(in, &server->allocator);
+        }
+    } else if (consumed < size && !confin_buffer_append(in, data + consumed, size - consumed, &server->allocator)) {
+        return false;
+    }
+    return confin_flush(server, connection);
+}
+
+static uint64_t confin_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+static void confin_wake(cfserver_t *server) {
+    uint64_t one = 1;
+    ssize_t written = write(server->wakefd, &one, sizeof(one));
+    (void)written;
+}
+
+/* server */
+
+static char *confin_strdup(const cfallocator_t *allocator, const char *string, size_t length) {
+    char *copy = (char*)confin_alloc(allocator, length + 1);
+    if (copy) {
+        memcpy(copy, string, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+/**
+ * @brief Creates a configuration server.
+ * @param path The path of the socket.
+ * @param files The configuration files to serve.
+ * @param count The number of files, at least 1.
+ * @return Pointer to the server, or NULL on failure.
+ */
+cfserver_t *confin_server_create(const char *path, const char **files, size_t count) {
+    struct sockaddr_un address;
+    if (!path || !files || count == 0) {
+        fprintf(stderr, "A server needs a socket path and at least one file\n");
+        return NULL;
+    }
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Socket path '%s' is too long\n", path);
+        return NULL;
+    }
+    cfallocator_t allocator = confin_resolve_allocator(NULL);
+    cfserver_t *server = (cfserver_t*)confin_alloc(&allocator, sizeof(cfserver_t));
+    if (!server) {
+        perror("malloc");
+        return NULL;
+    }
+    memset(server, 0, sizeof(*server));
+    server->listenfd = -1;
+    server->epollfd = -1;
+    server->wakefd = -1;
+    server->allocator = allocator;
+    server->path = confin_strdup(&allocator, path, strlen(path));
+    server->scratch = (char*)confin_alloc(&allocator, CONFIN_SERVER_READ_SIZE);
+    server->configs = (confin_served_t*)confin_alloc(&allocator, sizeof(confin_served_t) * count);
+    if (!server->path || !server->scratch || !server->configs) {
+        perror("malloc");
+        confin_server_free(server);
+        return NULL;
+    }
+    memset(server->configs, 0, sizeof(confin_served_t) * count);
+
+    for (size_t i = 0; i < count; ++i) {
+        confin_served_t *served = &server->configs[i];
+        const char *name = strrchr(files[i], '/');
+        name = name ? name + 1 : files[i];
+        served->path = confin_strdup(&allocator, files[i], strlen(files[i]));
+        served->name = confin_strdup(&allocator, name, strcspn(name, "."));
+        ++server->configcount;
+        if (!served->path || !served->name) {
+            perror("malloc");
+            confin_server_free(server);
+            return NULL;
+        }
+        if (confin_served_find(server, served->name, (uint16_t)strlen(served->name)) != served) {
+            fprintf(stderr, "Configuration name '%s' is served twice\n", served->name);
+            confin_server_free(server);
+            return NULL;
+        }
+        if (!confin_served_load(served, &allocator)) {
+            confin_server_free(server);
+            return NULL;
+        }
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path, strlen(path));
+    // Only a socket left by a previous server is replaced
+    struct stat existing;
+    if (lstat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        unlink(path);
+    }
+    server->listenfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listenfd < 0 || bind(server->listenfd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        perror("bind");
+        // Nothing was bound, so nothing is unlinked
+        if (server->listenfd >= 0) {
+            close(server->listenfd);
+            server->listenfd = -1;
+        }
+        confin_server_free(server);
+        return NULL;
+    }
+    if (listen(server->listenfd, SOMAXCONN) != 0) {
+        perror("listen");
+        confin_server_free(server);
+        return NULL;
+    }
+    server->epollfd = epoll_create1(EPOLL_CLOEXEC);
+    server->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &server->wakefd;
+    if (server->epollfd < 0 || server->wakefd < 0 || epoll_ctl(server->epollfd, EPOLL_CTL_ADD, server->wakefd, &event) != 0) {
+        perror("epoll");
+        confin_server_free(server);
+        return NULL;
+    }
+    return server;
+}
+
+/**
+ * @brief Runs the event loop of a configuration server until it is stopped.
+ * @param server Pointer to the server.
+ * @return true if the server was stopped with @ref confin_server_stop, false on an error.
+ */
+bool confin_server_run(cfserver_t *server) {
+    struct epoll_event events[CONFIN_SERVER_EVENTS];
+    bool stopped = false;
+    bool failed = false;
+    uint64_t check = confin_now_ms() + __CONFIN_SERVER_POLL_MS;
+    confin_set_accepting(server, true);
+    if (!server->accepting) {
+        perror("epoll_ctl");
+        return false;
+    }
+
+    while (!stopped && !failed) {
+        uint64_t now = confin_now_ms();
+        int timeout = check > now ? (int)(check - now) : 0;
+        int ready = epoll_wait(server->epollfd, events, CONFIN_SERVER_EVENTS, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            failed = true;
+            break;
+        }
+        for (int i = 0; i < ready; ++i) {
+            void *source = events[i].data.ptr;
+            if (!source) {
+                continue;
+            }
+            if (source == &server->listenfd) {
+                confin_accept(server);
+            } else if (source == &server->wakefd) {
+                uint64_t counter;
+                ssize_t drained = read(server->wakefd, &counter, sizeof(counter));
+                (void)drained;
+                confin_served_reload(server, false);
+                stopped = __atomic_load_n(&server->stop, __ATOMIC_ACQUIRE) != 0;
+            } else {
+                confin_connection_t *connection = (confin_connection_t*)source;
+                bool alive = true;
+                if (events[i].events & EPOLLIN) {
+                    alive = confin_receive(server, connection);
+                } else if (events[i].events & EPOLLOUT) {
+                    alive = confin_flush(server, connection);
+                } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    alive = false;
+                }
+                if (!alive) {
+                    confin_close_connection(server, connection);
+                    // Later events of this batch may name the closed connection
+                    for (int j = i + 1; j < ready; ++j) {
+                        if (events[j].data.ptr == connection) {
+                            events[j].data.ptr = NULL;
+                        }
+                    }
+                }
+            }
+        }
+        now = confin_now_ms();
+        if (now >= check) {
+            confin_served_reload(server, true);
+            check = now + __CONFIN_SERVER_POLL_MS;
+        }
+    }
+    if (server->loading) {
+        confin_served_finish(server);
+    }
+
+    while (server->connections) {
+        confin_close_connection(server, server->connections);
+    }
+    confin_set_accepting(server, false);
+    __atomic_store_n(&server->stop, 0, __ATOMIC_RELEASE);
+    return stopped;
+}
+
+/**
+ * @brief Makes @ref confin_server_run return.
+ * @param server Pointer to the server.
+ */
+void confin_server_stop(cfserver_t *server) {
+    __atomic_store_n(&server->stop, 1, __ATOMIC_RELEASE);
+    confin_wake(server);
+}
+
+/**
+ * @brief Makes a configuration server reload every file, changed or not.
+ * @param server Pointer to the server.
+ */
+void confin_server_reload(cfserver_t *server) {
+    __atomic_store_n(&server->reload, 1, __ATOMIC_RELEASE);
+    confin_wake(server);
+}
+
+/**
+ * @brief Frees a configuration server and removes its socket.
+ * @param server Pointer to the server; NULL is ignored.
+ */
+void confin_server_free(cfserver_t *server) {
+    if (!server) {
+        return;
+    }
+    cfallocator_t allocator = server->allocator;
+    while (server->connections) {
+        confin_close_connection(server, server->connections);
+    }
+    if (server->listenfd >= 0) {
+        close(server->listenfd);
+        unlink(server->path);
+    }
+    if (server->epollfd >= 0) {
+        close(server->epollfd);
+    }
+    if (server->wakefd >= 0) {
+        close(server->wakefd);
+    }
+    for (size_t i = 0; i < server->configcount; ++i) {
+        confin_served_t *served = &server->configs[i];
+        confin_served_install(served, &allocator);
+        if (served->config) {
+            confin_free_config_file(served->config);
+        }
+        confin_free(&allocator, (void*)served->sorted);
+        confin_free(&allocator, served->name);
+        confin_free(&allocator, served->path);
+    }
+    confin_free(&allocator, server->configs);
+    confin_free(&allocator, server->keys);
+    confin_free(&allocator, (void*)server->keynames);
+    confin_free(&allocator, (void*)server->found);
+    confin_free(&allocator, server->scratch);
+    confin_free(&allocator, server->path);
+    confin_free(&allocator, server);
+}
+
+#else // CONFIN_SERVER_EPOLL
+
+cfserver_t *confin_server_create(const char *path, const char **files, size_t count) {
+    (void)path;
+    (void)files;
+    (void)count;
+    fprintf(stderr, "The configuration server is not supported on this platform\n");
+    return NULL;
+}
+
+bool confin_server_run(cfserver_t *server) {
+    (void)server;
+    return false;
+}
+
+void confin_server_stop(cfserver_t *server) {
+    (void)server;
+}
+
+void confin_server_reload(cfserver_t *server) {
+    (void)server;
+}
+
+void confin_server_free(cfserver_t *server) {
+    (void)server;
+}
+
+#endif // CONFIN_SERVER_EPOLL
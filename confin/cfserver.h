@@ -0,0 +1,133 @@
+/**
+ * @file cfserver.h
+ * @brief Functions and macros for serving configurations over a Unix domain socket.
+ *
+ * This header file provides the configuration server. It loads a set of files
+ * once and answers batched key and prefix lookups from any number of local
+ * clients, so that processes which cannot link the library read single keys
+ * without parsing the whole file. Each configuration is named after its file,
+ * without the directory and the extension.
+ *
+ * The server runs one event loop on the calling thread with `epoll`; sockets are
+ * non-blocking and a connection only holds buffers while a request or a reply is
+ * partially transferred. Requests and replies are the frames described by
+ * @ref __s_confin_request_header and @ref __s_confin_reply_header, and a client
+ * may send several requests before reading the replies.
+ *
+ * Files are checked every @ref __CONFIN_SERVER_POLL_MS milliseconds and reloaded
+ * when they are replaced or modified; a file that fails to load keeps serving its
+ * previous contents. Files are read and indexed on a loader thread, so requests
+ * keep being served from the previous contents until the new ones are swapped in. The server is only available on Linux.
+ */
+
+#ifndef _CONFIN_SERVER_H
+#define _CONFIN_SERVER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfservercreate
+ * @brief Macro to create a configuration server.
+ * @param path The path of the socket.
+ * @param files The configuration files to serve.
+ * @param count The number of files.
+ * @return Pointer to the server, or NULL on failure.
+ */
+#define cfservercreate(path, files, count) confin_server_create(path, files, count)
+
+/**
+ * @brief Creates a configuration server.
+ *
+ * Loads every file and binds the socket; a stale socket left at `path` is
+ * replaced. No connection is accepted before @ref confin_server_run.
+ *
+ * @param path The path of the socket.
+ * @param files The configuration files to serve.
+ * @param count The number of files, at least 1.
+ * @return Pointer to the server, or NULL on failure.
+ */
+cfserver_t *confin_server_create(const char *path, const char **files, size_t count);
+
+/**
+ * @def cfserverrun
+ * @brief Macro to run the event loop of a configuration server.
+ * @param server Pointer to the server.
+ * @return true if the server was stopped, false on an error.
+ */
+#define cfserverrun(server) confin_server_run(server)
+
+/**
+ * @brief Runs the event loop of a configuration server until it is stopped.
+ *
+ * Every connection is closed before the function returns.
+ *
+ * @param server Pointer to the server.
+ * @return true if the server was stopped with @ref confin_server_stop, false on an error.
+ */
+bool confin_server_run(cfserver_t *server);
+
+/**
+ * @def cfserverstop
+ * @brief Macro to stop a configuration server.
+ * @param server Pointer to the server.
+ */
+#define cfserverstop(server) confin_server_stop(server)
+
+/**
+ * @brief Makes @ref confin_server_run return.
+ *
+ * Can be called from any thread and from a signal handler.
+ *
+ * @param server Pointer to the server.
+ */
+void confin_server_stop(cfserver_t *server);
+
+/**
+ * @def cfserverreload
+ * @brief Macro to make a configuration server reload its files.
+ * @param server Pointer to the server.
+ */
+#define cfserverreload(server) confin_server_reload(server)
+
+/**
+ * @brief Makes a configuration server reload every file, changed or not.
+ *
+ * The files are read on the loader thread of the server, and requests are served
+ * from their previous contents until the reload completes. Can be called from any thread and from a signal handler.
+ *
+ * @param server Pointer to the server.
+ */
+void confin_server_reload(cfserver_t *server);
+
+/**
+ * @def cfserverfree
+ * @brief Macro to free a configuration server.
+ * @param server Pointer to the server.
+ */
+#define cfserverfree(server) confin_server_free(server)
+
+/**
+ * @brief Frees a configuration server and removes its socket.
+ *
+ * The server must not be running.
+ *
+ * @param server Pointer to the server; NULL is ignored.
+ */
+void confin_server_free(cfserver_t *server);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_SERVER_H
@@ -0,0 +1,484 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfio.h" // confin/cfio.h
+#include "cfutils.h" // confin/cfutils.h
+#include "cflookup.h" // confin/cflookup.h
+#include "cfwriter.h" // confin/cfwriter.h
+#include "cfshard.h" // confin/cfshard.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Output buffer of each shard writer.
+ *
+ * Shard writers are detached and hold no open file between flushes, so many
+ * shards cost this much memory each and no descriptors.
+ */
+#define CONFIN_SHARD_BUFSIZE (64 * 1024)
+
+/**
+ * @brief A shard of an opened sharded configuration.
+ */
+typedef struct {
+    cfshardrecord_t record;    /**< Record of the shard in the manifest */
+    cffile_t *config;          /**< Loaded configuration, or NULL */
+} confin_shard_t;
+
+struct __s_confin_shard_writer {
+    cfallocator_t allocator;   /**< Allocator of the writer */
+    char *manifest;            /**< Path of the manifest */
+    char *directory;           /**< Directory of the manifest, with its separator, or "" */
+    uint32_t mode;             /**< How keys are assigned to shards */
+    uint32_t count;            /**< Number of shards */
+    bool failed;               /**< Whether an append failed */
+    cfshardrecord_t *records;  /**< Record of each shard */
+    cfwriter_t **writers;      /**< Streaming writer of each shard */
+};
+
+struct __s_confin_sharded {
+    cfcontext_t ctx;           /**< Context the shards are loaded with */
+    char *directory;           /**< Directory of the manifest, with its separator, or "" */
+    uint32_t mode;             /**< How keys are assigned to shards */
+    uint32_t count;            /**< Number of shards */
+    confin_shard_t shards[];   /**< Shards */
+};
+
+/* routing */
+
+static uint32_t confin_shard_of(const char *key, uint32_t mode, uint32_t shards) {
+    size_t length = strnlen(key, __CONFIN_STRUCT_MAX_KEYLEN);
+    if (mode == CONFIN_SHARD_PREFIX) {
+        const char *separator = (const char*)memchr(key, __CONFIN_SHARD_SEPARATOR, length);
+        if (separator) {
+            length = (size_t)(separator - key);
+        }
+    }
+    return (uint32_t)(confin_hash_bytes(key, length) % shards);
+}
+
+// Copies the directory part of a path, including its last separator
+static char *confin_path_directory(const cfallocator_t *allocator, const char *path) {
+    const char *slash = strrchr(path, '/');
+#ifdef _WIN32
+    const char *backslash = strrchr(path, '\\');
+    if (backslash && (!slash || backslash > slash)) {
+        slash = backslash;
+    }
+#endif
+    size_t length = slash ? (size_t)(slash - path) + 1 : 0;
+    char *directory = (char*)confin_alloc(allocator, length + 1);
+    if (!directory) {
+        perror("malloc");
+        return NULL;
+    }
+    memcpy(directory, path, length);
+    directory[length] = '\0';
+    return directory;
+}
+
+static char *confin_shard_path(const cfallocator_t *allocator, const char *directory, const char *file) {
+    size_t length = strlen(directory) + strlen(file);
+    char *path = (char*)confin_alloc(allocator, length + 1);
+    if (!path) {
+        perror("malloc");
+        return NULL;
+    }
+    snprintf(path, length + 1, "%s%s", directory, file);
+    return path;
+}
+
+static void confin_remove_shard(const cfshardwriter_t *writer, uint32_t shard) {
+    char *path = confin_shard_path(&writer->allocator, writer->directory, writer->records[shard].file);
+    if (path) {
+        remove(path);
+        confin_free(&writer->allocator, path);
+    }
+}
+
+/* writer */
+
+static void confin_shard_writer_free(cfshardwriter_t *writer) {
+    confin_free(&writer->allocator, writer->manifest);
+    confin_free(&writer->allocator, writer->directory);
+    confin_free(&writer->allocator, writer->records);
+    confin_free(&writer->allocator, (void*)writer->writers);
+    confin_free(&writer->allocator, writer);
+}
+
+/**
+ * @brief Opens a writer of a sharded configuration.
+ * @param manifest The name of the manifest to write.
+ * @param shards The number of shards, at least 1.
+ * @param mode How keys are assigned to shards.
+ * @return Pointer to the writer, or NULL on failure.
+ */
+cfshardwriter_t *confin_shard_writer_open(const char *manifest, uint32_t shards, cfshardmode_t mode) {
+    return confin_shard_writer_open_ctx(manifest, shards, mode, NULL);
+}
+
+/**
+ * @brief Opens a writer of a sharded configuration with a context.
+ * @param manifest The name of the manifest to write.
+ * @param shards The number of shards, at least 1.
+ * @param mode How keys are assigned to shards.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the writer, or NULL on failure.
+ */
+cfshardwriter_t *confin_shard_writer_open_ctx(const char *manifest, uint32_t shards, cfshardmode_t mode, cfcontext_t *ctx) {
+    if (shards == 0 || (mode != CONFIN_SHARD_HASH && mode != CONFIN_SHARD_PREFIX)) {
+        fprintf(stderr, "A sharded configuration needs at least one shard and a valid mode\n");
+        return NULL;
+    }
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    cfshardwriter_t *writer = (cfshardwriter_t*)confin_alloc(&allocator, sizeof(cfshardwriter_t));
+    if (!writer) {
+        perror("malloc");
+        return NULL;
+    }
+    memset(writer, 0, sizeof(*writer));
+    writer->allocator = allocator;
+    writer->mode = (uint32_t)mode;
+    writer->manifest = confin_shard_path(&allocator, "", manifest);
+    writer->directory = confin_path_directory(&allocator, manifest);
+    writer->records = (cfshardrecord_t*)confin_alloc(&allocator, sizeof(cfshardrecord_t) * shards);
+    writer->writers = (cfwriter_t**)confin_alloc(&allocator, sizeof(cfwriter_t*) * shards);
+    if (!writer->manifest || !writer->directory || !writer->records || !writer->writers) {
+        perror("malloc");
+        confin_shard_writer_free(writer);
+        return NULL;
+    }
+    memset(writer->records, 0, sizeof(cfshardrecord_t) * shards);
+
+    // Shards of <dir>/<name>.<ext> are <dir>/<name>.<index>.bin
+    const char *name = manifest + strlen(writer->directory);
+    const char *extension = strrchr(name, '.');
+    int stem = extension ? (int)(extension - name) : (int)strlen(name);
+    for (uint32_t i = 0; i < shards; ++i) {
+        int length = snprintf(writer->records[i].file, sizeof(writer->records[i].file), "%.*s.%u.bin", stem, name, i);
+        if (length < 0 || (size_t)length >= sizeof(writer->records[i].file)) {
+            fprintf(stderr, "Manifest name '%s' is too long\n", name);
+            break;
+        }
+        char *path = confin_shard_path(&allocator, writer->directory, writer->records[i].file);
+        writer->writers[i] = path ? confin_writer_open_detached(path, CONFIN_SHARD_BUFSIZE, ctx) : NULL;
+        confin_free(&allocator, path);
+        if (!writer->writers[i]) {
+            break;
+        }
+        writer->count = i + 1;
+    }
+    if (writer->count != shards) {
+        confin_shard_writer_abort(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+/**
+ * @brief Appends an entry to the shard of its key.
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param value Pointer to the value.
+ * @param size The size of the value.
+ * @return true on success, false on failure; the files are then removed on close.
+ */
+bool confin_shard_writer_append(cfshardwriter_t *writer, const char *key, cfannotype_t type, const void *value, uint64_t size) {
+    uint32_t shard = confin_shard_of(key, writer->mode, writer->count);
+    if (!confin_writer_append(writer->writers[shard], key, type, value, size)) {
+        writer->failed = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Finishes the shards, writes the manifest and frees the writer.
+ * @param writer The writer.
+ * @return true if every file was written, false otherwise.
+ */
+bool confin_shard_writer_close(cfshardwriter_t *writer) {
+    bool ok = !writer->failed;
+    uint32_t closed = 0;
+    uint64_t entrycount = 0;
+    for (uint32_t i = 0; i < writer->count; ++i) {
+        writer->records[i].entrycount = confin_writer_count(writer->writers[i]);
+        entrycount += writer->records[i].entrycount;
+        if (ok && confin_writer_close(writer->writers[i])) {
+            closed = i + 1;
+        } else if (ok) {
+            ok = false;
+        } else {
+            confin_writer_abort(writer->writers[i]);
+        }
+    }
+
+    if (ok) {
+        cfmanifest_t header;
+        header.magic = __CONFIN_MANIFEST_MAGIC_NUMBER;
+        header.version = _CF_VER;
+        header.mode = writer->mode;
+        header.shardcount = writer->count;
+        header.entrycount = entrycount;
+        FILE *file = fopen(writer->manifest, "wb");
+        if (!file) {
+            perror("fopen");
+            ok = false;
+        } else {
+            ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(writer->records, sizeof(cfshardrecord_t), writer->count, file) == writer->count;
+            ok = fclose(file) == 0 && ok;
+            if (!ok) {
+                perror("fwrite");
+                remove(writer->manifest);
+            }
+        }
+    }
+    // Without a manifest no shard is kept
+    if (!ok) {
+        for (uint32_t i = 0; i < closed; ++i) {
+            confin_remove_shard(writer, i);
+        }
+    }
+    confin_shard_writer_free(writer);
+    return ok;
+}
+
+/**
+ * @brief Discards the shards and frees the writer.
+ * @param writer The writer.
+ */
+void confin_shard_writer_abort(cfshardwriter_t *writer) {
+    for (uint32_t i = 0; i < writer->count; ++i) {
+        confin_writer_abort(writer->writers[i]);
+    }
+    confin_shard_writer_free(writer);
+}
+
+/**
+ * @brief Writes an array of entries as a sharded configuration.
+ * @param manifest The name of the manifest to write.
+ * @param entries The entries.
+ * @param entrycount The number of entries.
+ * @param shards The number of shards, at least 1.
+ * @param mode How keys are assigned to shards.
+ * @return true on success, false on failure.
+ */
+bool confin_write_sharded(const char *manifest, const cfentry_t *entries, uint64_t entrycount, uint32_t shards, cfshardmode_t mode) {
+    cfshardwriter_t *writer = confin_shard_writer_open(manifest, shards, mode);
+    if (!writer) {
+        return false;
+    }
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        const cfentry_t *entry = &entries[i];
+        if (!confin_shard_writer_append(writer, entry->key, entry->type, CF_ENTRYVAL(entry), entry->size)) {
+            break;
+        }
+    }
+    return confin_shard_writer_close(writer);
+}
+
+/* reader */
+
+/**
+ * @brief Opens a sharded configuration.
+ * @param manifest The name of the manifest.
+ * @return Pointer to the sharded configuration, or NULL on failure.
+ */
+cfsharded_t *confin_sharded_open(const char *manifest) {
+    return confin_sharded_open_ctx(manifest, NULL);
+}
+
+/**
+ * @brief Opens a sharded configuration with a context.
+ * @param manifest The name of the manifest.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the sharded configuration, or NULL on failure.
+ */
+cfsharded_t *confin_sharded_open_ctx(const char *manifest, cfcontext_t *ctx) {
+    FILE *file = fopen(manifest, "rb");
+    if (!file) {
+        perror("fopen");
+        return NULL;
+    }
+    cfmanifest_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1) {
+        fprintf(stderr, "Unexpected end of file\n");
+        fclose(file);
+        return NULL;
+    }
+    if (header.magic != __CONFIN_MANIFEST_MAGIC_NUMBER ||
+        __CONFIN_GET_MAJOR_VERSION(header.version) != __CONFIN_MAJOR_VERSION) {
+        fprintf(stderr, "%s is not a manifest\n", manifest);
+        fclose(file);
+        return NULL;
+    }
+    if (header.shardcount == 0 || (header.mode != CONFIN_SHARD_HASH && header.mode != CONFIN_SHARD_PREFIX)) {
+        fprintf(stderr, "Invalid manifest %s\n", manifest);
+        fclose(file);
+        return NULL;
+    }
+
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    cfsharded_t *sharded = (cfsharded_t*)confin_alloc(&allocator, sizeof(cfsharded_t) + sizeof(confin_shard_t) * header.shardcount);
+    if (!sharded) {
+        perror("malloc");
+        fclose(file);
+        return NULL;
+    }
+    memset(&sharded->ctx, 0, sizeof(sharded->ctx));
+    if (ctx) {
+        sharded->ctx = *ctx;
+    }
+    sharded->ctx.allocator = allocator;
+    sharded->mode = header.mode;
+    sharded->count = header.shardcount;
+    sharded->directory = confin_path_directory(&allocator, manifest);
+    bool ok = sharded->directory != NULL;
+    uint64_t entrycount = 0;
+    for (uint32_t i = 0; ok && i < header.shardcount; ++i) {
+        confin_shard_t *shard = &sharded->shards[i];
+        shard->config = NULL;
+        if (fread(&shard->record, sizeof(shard->record), 1, file) != 1) {
+            fprintf(stderr, "Unexpected end of file\n");
+            ok = false;
+        } else if (shard->record.file[sizeof(shard->record.file) - 1] != '\0' || strchr(shard->record.file, '/')) {
+            // Shards live next to the manifest
+            fprintf(stderr, "Invalid shard name in %s\n", manifest);
+            ok = false;
+        }
+        entrycount += ok ? shard->record.entrycount : 0;
+    }
+    if (ok && entrycount != header.entrycount) {
+        fprintf(stderr, "Shards of %s hold %llu entries, the manifest lists %llu\n", manifest,
+                (unsigned long long)entrycount, (unsigned long long)header.entrycount);
+        ok = false;
+    }
+    fclose(file);
+    if (!ok) {
+        sharded->count = 0;
+        confin_sharded_close(sharded);
+        return NULL;
+    }
+    return sharded;
+}
+
+/**
+ * @brief Returns the number of shards of a sharded configuration.
+ * @param sharded Pointer to the sharded configuration.
+ * @return The number of shards.
+ */
+uint32_t confin_sharded_count(const cfsharded_t *sharded) {
+    return sharded->count;
+}
+
+/**
+ * @brief Finds the shard of a key.
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key.
+ * @return The index of the shard.
+ */
+uint32_t confin_sharded_route(const cfsharded_t *sharded, const char *key) {
+    return confin_shard_of(key, sharded->mode, sharded->count);
+}
+
+/**
+ * @brief Loads a shard; a shard already loaded is kept.
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ * @return true on success, false on failure.
+ */
+bool confin_sharded_load(cfsharded_t *sharded, uint32_t shard) {
+    if (shard >= sharded->count) {
+        fprintf(stderr, "Shard %u is out of range\n", shard);
+        return false;
+    }
+    confin_shard_t *entry = &sharded->shards[shard];
+    if (entry->config) {
+        return true;
+    }
+    char *path = confin_shard_path(&sharded->ctx.allocator, sharded->directory, entry->record.file);
+    if (!path) {
+        return false;
+    }
+    cffile_t *config = confin_read_config_ctx(path, &sharded->ctx);
+    if (config && config->header.entrycount != entry->record.entrycount) {
+        fprintf(stderr, "Shard %s has %llu entries, the manifest lists %llu\n", path,
+                (unsigned long long)config->header.entrycount, (unsigned long long)entry->record.entrycount);
+        confin_free_config_file(config);
+        config = NULL;
+    }
+    confin_free(&sharded->ctx.allocator, path);
+    entry->config = config;
+    return config != NULL;
+}
+
+/**
+ * @brief Loads the shard of a key.
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key, or a prefix with @ref CONFIN_SHARD_PREFIX.
+ * @return true on success, false on failure.
+ */
+bool confin_sharded_load_key(cfsharded_t *sharded, const char *key) {
+    return confin_sharded_load(sharded, confin_sharded_route(sharded, key));
+}
+
+/**
+ * @brief Unloads a shard, freeing its entries; a shard not loaded is ignored.
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ */
+void confin_sharded_unload(cfsharded_t *sharded, uint32_t shard) {
+    if (shard < sharded->count && sharded->shards[shard].config) {
+        confin_free_config_file(sharded->shards[shard].config);
+        sharded->shards[shard].config = NULL;
+    }
+}
+
+/**
+ * @brief Returns the configuration of a loaded shard.
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ * @return Pointer to the configuration of the shard, or NULL if it is not loaded.
+ */
+cffile_t *confin_sharded_shard(const cfsharded_t *sharded, uint32_t shard) {
+    return shard < sharded->count ? sharded->shards[shard].config : NULL;
+}
+
+/**
+ * @brief Finds an entry in the shard of its key.
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if it is not present or its shard is not loaded.
+ */
+const cfentry_t *confin_sharded_get(cfsharded_t *sharded, const char *key) {
+    cffile_t *config = sharded->shards[confin_sharded_route(sharded, key)].config;
+    return config ? confin_get(config, key) : NULL;
+}
+
+/**
+ * @brief Closes a sharded configuration, freeing every loaded shard.
+ * @param sharded Pointer to the sharded configuration; NULL is ignored.
+ */
+void confin_sharded_close(cfsharded_t *sharded) {
+    if (!sharded) {
+        return;
+    }
+    cfallocator_t allocator = sharded->ctx.allocator;
+    for (uint32_t i = 0; i < sharded->count; ++i) {
+        confin_sharded_unload(sharded, i);
+    }
+    confin_free(&allocator, sharded->directory);
+    confin_free(&allocator, sharded);
+}
@@ -0,0 +1,335 @@
+/**
+ * @file cfshard.h
+ * @brief Functions and macros for configurations split into shards.
+ *
+ * This header file provides the sharded writer and reader. The writer assigns
+ * every entry to one of N shard files, by the hash of its key or of the part of
+ * the key before the first @ref __CONFIN_SHARD_SEPARATOR, and finishes with a
+ * manifest listing the shards. The shards of a manifest `<dir>/<name>.<ext>` are
+ * `<dir>/<name>.<index>.bin`.
+ *
+ * The reader opens the manifest alone and loads the shards it is asked for, so
+ * a process that only needs a few keys or prefixes reads only their shards.
+ * Lookups are routed to the shard of the key.
+ */
+
+#ifndef _CONFIN_SHARD_H
+#define _CONFIN_SHARD_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfshardwriteropen
+ * @brief Macro to open a writer of a sharded configuration.
+ * @param manifest The name of the manifest to write.
+ * @param shards The number of shards.
+ * @param mode How keys are assigned to shards.
+ * @return Pointer to the writer, or NULL on failure.
+ */
+#define cfshardwriteropen(manifest, shards, mode) confin_shard_writer_open(manifest, shards, mode)
+
+/**
+ * @brief Opens a writer of a sharded configuration.
+ *
+ * Every shard is written by its own streaming writer, so memory use does not
+ * depend on the number of entries. Each shard buffers 64 KiB and only opens
+ * its file while it flushes, so many shards hold no file descriptors.
+ *
+ * @param manifest The name of the manifest to write.
+ * @param shards The number of shards, at least 1.
+ * @param mode How keys are assigned to shards.
+ * @return Pointer to the writer, or NULL on failure.
+ */
+cfshardwriter_t *confin_shard_writer_open(const char *manifest, uint32_t shards, cfshardmode_t mode);
+
+/**
+ * @def cfshardwriteropenctx
+ * @brief Macro to open a writer of a sharded configuration with a context.
+ * @param manifest The name of the manifest to write.
+ * @param shards The number of shards.
+ * @param mode How keys are assigned to shards.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the writer, or NULL on failure.
+ */
+#define cfshardwriteropenctx(manifest, shards, mode, ctx) confin_shard_writer_open_ctx(manifest, shards, mode, ctx)
+
+/**
+ * @brief Opens a writer of a sharded configuration with a context.
+ * @param manifest The name of the manifest to write.
+ * @param shards The number of shards, at least 1.
+ * @param mode How keys are assigned to shards.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the writer, or NULL on failure.
+ */
+cfshardwriter_t *confin_shard_writer_open_ctx(const char *manifest, uint32_t shards, cfshardmode_t mode, cfcontext_t *ctx);
+
+/**
+ * @def cfshardwriterappend
+ * @brief Macro to append an entry to the shard of its key.
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param value Pointer to the value.
+ * @param size The size of the value.
+ * @return true on success, false on failure.
+ */
+#define cfshardwriterappend(writer, key, type, value, size) confin_shard_writer_append(writer, key, type, value, size)
+
+/**
+ * @brief Appends an entry to the shard of its key.
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param value Pointer to the value.
+ * @param size The size of the value.
+ * @return true on success, false on failure; the files are then removed on close.
+ */
+bool confin_shard_writer_append(cfshardwriter_t *writer, const char *key, cfannotype_t type, const void *value, uint64_t size);
+
+/**
+ * @def cfshardwriterclose
+ * @brief Macro to finish the shards, write the manifest and free the writer.
+ * @param writer The writer.
+ * @return true if every file was written, false otherwise.
+ */
+#define cfshardwriterclose(writer) confin_shard_writer_close(writer)
+
+/**
+ * @brief Finishes the shards, writes the manifest and frees the writer.
+ *
+ * The manifest is written last. If an append failed or any file cannot be
+ * finished, every shard written is removed and no manifest is written.
+ *
+ * @param writer The writer.
+ * @return true if every file was written, false otherwise.
+ */
+bool confin_shard_writer_close(cfshardwriter_t *writer);
+
+/**
+ * @def cfshardwriterabort
+ * @brief Macro to discard the shards and free the writer.
+ * @param writer The writer.
+ */
+#define cfshardwriterabort(writer) confin_shard_writer_abort(writer)
+
+/**
+ * @brief Discards the shards and frees the writer.
+ * @param writer The writer.
+ */
+void confin_shard_writer_abort(cfshardwriter_t *writer);
+
+/**
+ * @def cfwritesharded
+ * @brief Macro to write an array of entries as a sharded configuration.
+ * @param manifest The name of the manifest to write.
+ * @param entries The entries.
+ * @param entrycount The number of entries.
+ * @param shards The number of shards.
+ * @param mode How keys are assigned to shards.
+ * @return true on success, false on failure.
+ */
+#define cfwritesharded(manifest, entries, entrycount, shards, mode) confin_write_sharded(manifest, entries, entrycount, shards, mode)
+
+/**
+ * @brief Writes an array of entries as a sharded configuration.
+ * @param manifest The name of the manifest to write.
+ * @param entries The entries.
+ * @param entrycount The number of entries.
+ * @param shards The number of shards, at least 1.
+ * @param mode How keys are assigned to shards.
+ * @return true on success, false on failure.
+ */
+bool confin_write_sharded(const char *manifest, const cfentry_t *entries, uint64_t entrycount, uint32_t shards, cfshardmode_t mode);
+
+/**
+ * @def cfshardedopen
+ * @brief Macro to open a sharded configuration.
+ * @param manifest The name of the manifest.
+ * @return Pointer to the sharded configuration, or NULL on failure.
+ */
+#define cfshardedopen(manifest) confin_sharded_open(manifest)
+
+/**
+ * @brief Opens a sharded configuration.
+ *
+ * Only the manifest is read; no shard is loaded.
+ *
+ * @param manifest The name of the manifest.
+ * @return Pointer to the sharded configuration, or NULL on failure.
+ */
+cfsharded_t *confin_sharded_open(const char *manifest);
+
+/**
+ * @def cfshardedopenctx
+ * @brief Macro to open a sharded configuration with a context.
+ * @param manifest The name of the manifest.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the sharded configuration, or NULL on failure.
+ */
+#define cfshardedopenctx(manifest, ctx) confin_sharded_open_ctx(manifest, ctx)
+
+/**
+ * @brief Opens a sharded configuration with a context.
+ *
+ * The context is also used to load the shards.
+ *
+ * @param manifest The name of the manifest.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the sharded configuration, or NULL on failure.
+ */
+cfsharded_t *confin_sharded_open_ctx(const char *manifest, cfcontext_t *ctx);
+
+/**
+ * @def cfshardedcount
+ * @brief Macro to get the number of shards.
+ * @param sharded Pointer to the sharded configuration.
+ * @return The number of shards.
+ */
+#define cfshardedcount(sharded) confin_sharded_count(sharded)
+
+/**
+ * @brief Returns the number of shards of a sharded configuration.
+ * @param sharded Pointer to the sharded configuration.
+ * @return The number of shards.
+ */
+uint32_t confin_sharded_count(const cfsharded_t *sharded);
+
+/**
+ * @def cfshardedroute
+ * @brief Macro to find the shard of a key.
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key.
+ * @return The index of the shard.
+ */
+#define cfshardedroute(sharded, key) confin_sharded_route(sharded, key)
+
+/**
+ * @brief Finds the shard of a key.
+ *
+ * With @ref CONFIN_SHARD_PREFIX a prefix given without the separator, such as
+ * `tenant42`, is routed to the shard of the keys `tenant42.*`.
+ *
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key.
+ * @return The index of the shard.
+ */
+uint32_t confin_sharded_route(const cfsharded_t *sharded, const char *key);
+
+/**
+ * @def cfshardedload
+ * @brief Macro to load a shard.
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ * @return true on success, false on failure.
+ */
+#define cfshardedload(sharded, shard) confin_sharded_load(sharded, shard)
+
+/**
+ * @brief Loads a shard; a shard already loaded is kept.
+ *
+ * The number of entries of the file must match the manifest.
+ *
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ * @return true on success, false on failure.
+ */
+bool confin_sharded_load(cfsharded_t *sharded, uint32_t shard);
+
+/**
+ * @def cfshardedloadkey
+ * @brief Macro to load the shard of a key.
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key, or a prefix with @ref CONFIN_SHARD_PREFIX.
+ * @return true on success, false on failure.
+ */
+#define cfshardedloadkey(sharded, key) confin_sharded_load_key(sharded, key)
+
+/**
+ * @brief Loads the shard of a key.
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key, or a prefix with @ref CONFIN_SHARD_PREFIX.
+ * @return true on success, false on failure.
+ */
+bool confin_sharded_load_key(cfsharded_t *sharded, const char *key);
+
+/**
+ * @def cfshardedunload
+ * @brief Macro to unload a shard.
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ */
+#define cfshardedunload(sharded, shard) confin_sharded_unload(sharded, shard)
+
+/**
+ * @brief Unloads a shard, freeing its entries; a shard not loaded is ignored.
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ */
+void confin_sharded_unload(cfsharded_t *sharded, uint32_t shard);
+
+/**
+ * @def cfshardedshard
+ * @brief Macro to get the configuration of a loaded shard.
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ * @return Pointer to the configuration of the shard, or NULL if it is not loaded.
+ */
+#define cfshardedshard(sharded, shard) confin_sharded_shard(sharded, shard)
+
+/**
+ * @brief Returns the configuration of a loaded shard.
+ *
+ * The configuration belongs to the sharded configuration and must not be freed.
+ *
+ * @param sharded Pointer to the sharded configuration.
+ * @param shard The index of the shard.
+ * @return Pointer to the configuration of the shard, or NULL if it is not loaded.
+ */
+cffile_t *confin_sharded_shard(const cfsharded_t *sharded, uint32_t shard);
+
+/**
+ * @def cfshardedget
+ * @brief Macro to find an entry in the shard of its key.
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if it is not present or its shard is not loaded.
+ */
+#define cfshardedget(sharded, key) confin_sharded_get(sharded, key)
+
+/**
+ * @brief Finds an entry in the shard of its key.
+ *
+ * Shards are not loaded on demand; see @ref confin_sharded_load_key.
+ *
+ * @param sharded Pointer to the sharded configuration.
+ * @param key The key to find.
+ * @return Pointer to the entry, or NULL if it is not present or its shard is not loaded.
+ */
+const cfentry_t *confin_sharded_get(cfsharded_t *sharded, const char *key);
+
+/**
+ * @def cfshardedclose
+ * @brief Macro to close a sharded configuration.
+ * @param sharded Pointer to the sharded configuration.
+ */
+#define cfshardedclose(sharded) confin_sharded_close(sharded)
+
+/**
+ * @brief Closes a sharded configuration, freeing every loaded shard.
+ * @param sharded Pointer to the sharded configuration; NULL is ignored.
+ */
+void confin_sharded_close(cfsharded_t *sharded);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_SHARD_H
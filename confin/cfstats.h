@@ -0,0 +1,99 @@
+/**
+ * @file cfstats.h
+ * @brief Functions and macros for the instrumentation of the Confin library.
+ * 
+ * This header file provides the functions to collect counters and per-phase timings
+ * for reading, writing, validating and scanning files. Collection is off by default:
+ * it is enabled globally with `confin_enable_stats`, or for the calls using a context
+ * whose `stats` or `trace` member is set. Defining `__CONFIN_ENABLE_STATS` to 0 when
+ * building the library removes it entirely.
+ */
+
+#ifndef _CONFIN_STATS_H
+#define _CONFIN_STATS_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfenablestats
+ * @brief Macro to enable or disable the global counters.
+ * @param enable true to collect the global counters.
+ */
+#define cfenablestats(enable) confin_enable_stats(enable)
+
+/**
+ * @brief Enables or disables the global counters.
+ * @param enable true to collect the global counters.
+ */
+void confin_enable_stats(bool enable);
+
+/**
+ * @def cfgetstats
+ * @brief Macro to get a snapshot of the global counters.
+ * @param stats The structure to fill.
+ */
+#define cfgetstats(stats) confin_get_stats(stats)
+
+/**
+ * @brief Gets a snapshot of the global counters.
+ * @param stats The structure to fill.
+ */
+void confin_get_stats(cfstats_t *stats);
+
+/**
+ * @def cfresetstats
+ * @brief Macro to reset the global counters.
+ */
+#define cfresetstats() confin_reset_stats()
+
+/**
+ * @brief Resets the global counters.
+ */
+void confin_reset_stats(void);
+
+/**
+ * @def cfsettrace
+ * @brief Macro to set the global trace callback.
+ * @param trace The callback, or NULL to remove it.
+ * @param userdata User context passed to the callback.
+ */
+#define cfsettrace(trace, userdata) confin_set_trace(trace, userdata)
+
+/**
+ * @brief Sets the global trace callback.
+ * 
+ * The callback is called for each phase at the end of every operation that does
+ * not use a context with its own callback.
+ * 
+ * @param trace The callback, or NULL to remove it.
+ * @param userdata User context passed to the callback.
+ */
+void confin_set_trace(cftracefn_t trace, void *userdata);
+
+/**
+ * @brief Gets the name of an operation.
+ * @param op The operation.
+ * @return The name of the operation.
+ */
+const char *confin_op_name(cfop_t op);
+
+/**
+ * @brief Gets the name of a phase.
+ * @param phase The phase.
+ * @return The name of the phase.
+ */
+const char *confin_phase_name(cfphase_t phase);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_STATS_H
@@ -12,8 +12,10 @@
 
 #ifdef __cplusplus
 #include <cstdint>
+#include <cstddef>
 #else
 #include <stdint.h>
+#include <stddef.h>
 #endif
 
 #include "cfdef.h" // confin/cfdef.h
@@ -43,6 +45,105 @@ enum __e_confin_annotype {
     CONFIN_ANNOTYPE_STRUCT  /**< Structure type */
 };
 
+/**
+ * @enum __e_confin_delta_op
+ * @brief Enum for the operations recorded in a delta file.
+ * 
+ * The operation of a delta record is stored in the `reserved` field of its
+ * entry header.
+ */
+enum __e_confin_delta_op {
+    CONFIN_DELTA_ADD,    /**< The entry is added */
+    CONFIN_DELTA_CHANGE, /**< The type or value of the entry changed */
+    CONFIN_DELTA_REMOVE  /**< The entry is removed, no value follows */
+};
+
+/**
+ * @enum __e_confin_source
+ * @brief Enum for the text formats accepted by the compiler.
+ */
+enum __e_confin_source {
+    CONFIN_SOURCE_AUTO, /**< Detected from the file extension, then from the content */
+    CONFIN_SOURCE_INI,  /**< INI: `[section]` headers and `key = value` lines */
+    CONFIN_SOURCE_JSON  /**< JSON document with an object or array at the top level */
+};
+
+/**
+ * @enum __e_confin_export
+ * @brief Enum for the output formats of the JSON exporter.
+ */
+enum __e_confin_export {
+    CONFIN_EXPORT_JSON, /**< One JSON object mapping keys to values */
+    CONFIN_EXPORT_JSONL /**< JSON Lines: one `{"key", "type", "value"}` object per entry */
+};
+
+/**
+ * @enum __e_confin_bind_status
+ * @brief Enum for the outcome of binding one descriptor.
+ */
+enum __e_confin_bind_status {
+    CONFIN_BIND_OK,       /**< The key was found and copied into the target */
+    CONFIN_BIND_DEFAULT,  /**< The key is absent, the default value was copied */
+    CONFIN_BIND_MISSING,  /**< The key is absent and there is no default, the field is untouched */
+    CONFIN_BIND_MISTYPED  /**< The type or size of the entry does not fit the field, the default (if any) was copied */
+};
+
+/**
+ * @enum __e_confin_shard_mode
+ * @brief Enum for the ways a sharded configuration assigns keys to shards.
+ */
+enum __e_confin_shard_mode {
+    CONFIN_SHARD_HASH,  /**< By the hash of the whole key */
+    CONFIN_SHARD_PREFIX /**< By the hash of the key up to the first @ref __CONFIN_SHARD_SEPARATOR, so keys sharing that prefix share a shard */
+};
+
+/**
+ * @enum __e_confin_request_op
+ * @brief Enum for the operations of a request to the configuration server.
+ */
+enum __e_confin_request_op {
+    CONFIN_REQUEST_GET,   /**< Look up each key of the request */
+    CONFIN_REQUEST_PREFIX /**< List the entries whose key starts with the one string of the request */
+};
+
+/**
+ * @enum __e_confin_reply_status
+ * @brief Enum for the status of a reply from the configuration server.
+ */
+enum __e_confin_reply_status {
+    CONFIN_REPLY_OK,             /**< The request was served, the items follow */
+    CONFIN_REPLY_MALFORMED,      /**< The body of the request could not be parsed */
+    CONFIN_REPLY_UNKNOWN_CONFIG, /**< No configuration of the requested name is served */
+    CONFIN_REPLY_TOO_LARGE       /**< The reply would not fit in a frame */
+};
+
+/**
+ * @enum __e_confin_op
+ * @brief Enum for the instrumented operations of the library.
+ */
+enum __e_confin_op {
+    CONFIN_OP_READ,     /**< confin_read_config */
+    CONFIN_OP_WRITE,    /**< confin_write_config */
+    CONFIN_OP_VALIDATE, /**< confin_validate_file */
+    CONFIN_OP_SCAN,     /**< confin_scan_file */
+    CONFIN_OP_COUNT     /**< Number of operations */
+};
+
+/**
+ * @enum __e_confin_phase
+ * @brief Enum for the timed phases of an operation.
+ */
+enum __e_confin_phase {
+    CONFIN_PHASE_OPEN,    /**< Opening the file */
+    CONFIN_PHASE_HEADER,  /**< Header and layout block */
+    CONFIN_PHASE_ENTRIES, /**< Entry headers */
+    CONFIN_PHASE_VALUES,  /**< Entry values and value pool */
+    CONFIN_PHASE_ALLOC,   /**< Memory allocations */
+    CONFIN_PHASE_PROCESS, /**< Processing: value hashing when writing, formatting when scanning */
+    CONFIN_PHASE_CLOSE,   /**< Closing the file */
+    CONFIN_PHASE_COUNT    /**< Number of phases */
+};
+
 /**
  * @struct __s_confin_header
  * @brief Structure for the configuration file header.
@@ -56,18 +157,263 @@ struct __s_confin_header {
     uint64_t entrycount;    /**< Number of entries in the configuration file */
 };
 
+/**
+ * @struct __s_confin_layout
+ * @brief Structure for the layout block following the header.
+ * 
+ * Present in files of version @ref __CONFIN_LAYOUT_VERSION and newer. It describes
+ * how the entry values are laid out in the rest of the file.
+ */
+struct __s_confin_layout {
+    uint64_t flags;         /**< Layout flags (CONFIN_LAYOUT_*) */
+    uint64_t poolsize;      /**< Size of the value pool in bytes, 0 if the file is not pooled */
+};
+
+/**
+ * @struct __s_confin_offset_table
+ * @brief Structure for the trailer of an offset table.
+ * 
+ * Files with @ref CONFIN_LAYOUT_OFFSETS end with `count` 64-bit file positions,
+ * the position of every `stride`-th entry header starting with the first, followed
+ * by this trailer. Loaders that do not use the table ignore it.
+ */
+struct __s_confin_offset_table {
+    uint64_t stride;        /**< Number of entries between two recorded positions */
+    uint64_t count;         /**< Number of recorded positions */
+};
+
+/**
+ * @struct __s_confin_delta_base
+ * @brief Structure for the configuration a delta file was computed from.
+ * 
+ * Follows the header of a delta file. The checksum is the wrapping sum of a hash
+ * of the key, type and value of every entry, so it does not depend on their order.
+ */
+struct __s_confin_delta_base {
+    uint64_t entrycount;    /**< Number of entries of the base configuration */
+    uint64_t checksum;      /**< Checksum of the entries of the base configuration */
+};
+
+/**
+ * @struct __s_confin_manifest_header
+ * @brief Header of the manifest of a sharded configuration.
+ * 
+ * The header is followed by `shardcount` @ref __s_confin_shard_record structures,
+ * one per shard in shard order.
+ */
+struct __s_confin_manifest_header {
+    uint32_t magic;         /**< Magic number (@ref __CONFIN_MANIFEST_MAGIC_NUMBER) */
+    uint32_t version;       /**< Version of the format */
+    uint32_t mode;          /**< How keys are assigned to shards (see @ref __e_confin_shard_mode) */
+    uint32_t shardcount;    /**< Number of shards */
+    uint64_t entrycount;    /**< Number of entries of all shards */
+};
+
+/**
+ * @struct __s_confin_shard_record
+ * @brief Record of one shard in a manifest.
+ */
+struct __s_confin_shard_record {
+    char file[__CONFIN_STRUCT_MAX_KEYLEN]; /**< Name of the shard file, relative to the directory of the manifest */
+    uint64_t entrycount;    /**< Number of entries in the shard */
+};
+
+/**
+ * @struct __s_confin_compact_header
+ * @brief Header of a compact configuration file.
+ * 
+ * The header is followed by `blockcount` pairs of 64-bit offsets, the first key
+ * and the first value of each block, then `keybytes` bytes of front-coded keys
+ * and `valuebytes` bytes of values.
+ */
+struct __s_confin_compact_header {
+    uint32_t magic;         /**< Magic number (@ref __CONFIN_COMPACT_MAGIC_NUMBER) */
+    uint32_t version;       /**< Version of the format */
+    uint64_t entrycount;    /**< Number of entries */
+    uint64_t blockcount;    /**< Number of blocks of @ref __CONFIN_COMPACT_BLOCK keys */
+    uint64_t keybytes;      /**< Size of the front-coded keys */
+    uint64_t valuebytes;    /**< Size of the values */
+};
+
+/**
+ * @struct __s_confin_request_header
+ * @brief Header of a request frame sent to the configuration server.
+ * 
+ * The body that follows holds the name of the configuration and then `count`
+ * keys, each as a 16-bit length followed by that many bytes without a terminator.
+ * An empty name selects the first configuration of the server. All fields are in
+ * the byte order of the host.
+ */
+struct __s_confin_request_header {
+    uint32_t size;          /**< Size of the body in bytes */
+    uint32_t id;            /**< Number echoed in the reply */
+    uint16_t op;            /**< Operation (see @ref __e_confin_request_op) */
+    uint16_t count;         /**< Number of keys in the body */
+};
+
+/**
+ * @struct __s_confin_reply_header
+ * @brief Header of a reply frame sent by the configuration server.
+ * 
+ * The body that follows holds `count` items, each a @ref __s_confin_reply_item,
+ * the key and the value, with the key and the value padded to a multiple of
+ * @ref __CONFIN_POOL_ALIGN bytes. Replies are sent in the order of the requests.
+ */
+struct __s_confin_reply_header {
+    uint32_t size;          /**< Size of the body in bytes */
+    uint32_t id;            /**< Number of the request */
+    uint16_t status;        /**< Status (see @ref __e_confin_reply_status) */
+    uint16_t reserved;      /**< Reserved, 0 */
+    uint32_t count;         /**< Number of items in the body */
+};
+
+/**
+ * @struct __s_confin_reply_item
+ * @brief Header of one item in the body of a reply.
+ */
+struct __s_confin_reply_item {
+    uint32_t type;          /**< Type of the value (see @ref __e_confin_annotype) */
+    uint16_t keylength;     /**< Length of the key that follows, without a terminator */
+    uint16_t flags;         /**< Item flags (CONFIN_REPLY_*) */
+    uint64_t size;          /**< Size of the value */
+};
+
+/**
+ * @struct __s_confin_entry_header
+ * @brief On-disk header of each configuration entry.
+ * 
+ * This structure is what precedes every value in the file. In a pooled file the
+ * value is replaced by a 64-bit offset into the value pool.
+ */
+struct __s_confin_entry_header {
+    char key[__CONFIN_STRUCT_MAX_KEYLEN]; /**< Key of the configuration entry */
+    uint32_t type;                        /**< Type of the value (see @ref __e_confin_annotype) */
+    uint32_t reserved;                    /**< Reserved, written as zero */
+    uint64_t size;                        /**< Size of the value */
+};
+
 /**
  * @struct __s_confin_entry
  * @brief Structure for each configuration entry.
  * 
  * This structure represents a single entry in a configuration file. It includes the
- * key, type of the value, size of the value, and a pointer to the value itself.
+ * key, type of the value, size of the value, and the value itself. In a loaded
+ * configuration, values of up to @ref __CONFIN_INLINE_VALUE_MAX bytes are stored in
+ * `inlinevalue` and `value` points at it.
+ * 
+ * The inline buffer makes the structure 112 bytes on 64-bit targets instead of 88.
+ * A copy of an inline entry, made by assignment, `memcpy` or `realloc` of an entry
+ * array, keeps `value` pointing at the original entry, which may be gone; read
+ * copies with @ref CF_ENTRYVAL, which does not use `value` for inline entries.
  */
 struct __s_confin_entry {
     char key[__CONFIN_STRUCT_MAX_KEYLEN]; /**< Key of the configuration entry */
     enum __e_confin_annotype type;        /**< Type of the value (see @ref __e_confin_annotype) */
     uint64_t size;                        /**< Size of the value */
     void *value;                          /**< Pointer to the value */
+    unsigned char inlinevalue[__CONFIN_INLINE_VALUE_MAX]; /**< Value stored inline (@ref CONFIN_ENTRY_INLINE) */
+    uint32_t flags;                       /**< Storage flags (CONFIN_ENTRY_*), 0 for a value in its own block */
+};
+
+/**
+ * @struct __s_confin_allocator
+ * @brief Structure for the allocator used by the library.
+ * 
+ * Every allocation made by the library goes through these callbacks. All three
+ * callbacks must be set; an allocator whose `alloc` is NULL in a context means
+ * the globally installed allocator is used.
+ */
+struct __s_confin_allocator {
+    void *(*alloc)(void *userdata, size_t size);              /**< Allocates a block of `size` bytes */
+    void *(*realloc)(void *userdata, void *ptr, size_t size); /**< Resizes a block allocated by `alloc` */
+    void (*free)(void *userdata, void *ptr);                  /**< Frees a block allocated by `alloc` */
+    void *userdata;                                           /**< User context passed to every callback */
+};
+
+/**
+ * @struct __s_confin_op_stats
+ * @brief Structure for the counters of one instrumented operation.
+ */
+struct __s_confin_op_stats {
+    uint64_t calls;                             /**< Number of calls */
+    uint64_t bytesread;                         /**< Bytes read from files */
+    uint64_t byteswritten;                      /**< Bytes written to files */
+    uint64_t iocalls;                           /**< File I/O calls (open, read, write, close) */
+    uint64_t allocations;                       /**< Number of allocations */
+    uint64_t allocatedbytes;                    /**< Bytes allocated */
+    uint64_t entries;                           /**< Entries processed */
+    uint64_t nanoseconds[CONFIN_PHASE_COUNT];   /**< Time spent per phase (see @ref __e_confin_phase) */
+};
+
+/**
+ * @struct __s_confin_stats
+ * @brief Structure for the instrumentation counters of the library.
+ */
+struct __s_confin_stats {
+    struct __s_confin_op_stats ops[CONFIN_OP_COUNT]; /**< Counters per operation (see @ref __e_confin_op) */
+};
+
+/**
+ * @struct __s_confin_diff_summary
+ * @brief Structure for the number of records of each kind in a delta.
+ */
+struct __s_confin_diff_summary {
+    uint64_t added;   /**< Entries added */
+    uint64_t changed; /**< Entries whose type or value changed */
+    uint64_t removed; /**< Entries removed */
+};
+
+/**
+ * @struct __s_confin_binding
+ * @brief Structure for the descriptor of one field bound to a configuration key.
+ * 
+ * Descriptor tables are usually static and built with @ref CONFIN_BINDING.
+ */
+struct __s_confin_binding {
+    const char *key;                /**< Key of the entry */
+    enum __e_confin_annotype type;  /**< Expected type of the entry */
+    size_t offset;                  /**< Offset of the field in the target structure */
+    size_t size;                    /**< Size of the field */
+    const void *defvalue;           /**< Default value of `size` bytes, or NULL */
+    uint64_t hash;                  /**< Hash of the key, 0 until computed by confin_bind_prepare */
+};
+
+/**
+ * @struct __s_confin_key_handle
+ * @brief Structure for a key resolved once and looked up by position afterwards.
+ * 
+ * A handle is valid for the configuration it was resolved in; a zero generation
+ * marks a key that was not found.
+ */
+struct __s_confin_key_handle {
+    uint64_t generation; /**< Generation of the configuration the key was resolved in */
+    uint64_t index;      /**< Index of the entry */
+};
+
+/**
+ * @struct __s_confin_compile_options
+ * @brief Structure for the options of the text compiler.
+ * 
+ * A zero-initialized structure detects the format and compiles on one thread.
+ */
+struct __s_confin_compile_options {
+    enum __e_confin_source format; /**< Source format (see @ref __e_confin_source) */
+    uint32_t flags;                /**< Compiler options (CONFIN_COMPILE_*) */
+    unsigned threads;              /**< Worker threads for INI sources, 0 or 1 for the calling thread only; ignored without POSIX threads */
+};
+
+/**
+ * @struct __s_confin_context
+ * @brief Structure for the per-call context of the library.
+ * 
+ * A context passed to the `*_ctx` functions overrides the global settings for
+ * that call. A zero-initialized context behaves like the global settings.
+ */
+struct __s_confin_context {
+    struct __s_confin_allocator allocator; /**< Allocator for this call (see @ref __s_confin_allocator) */
+    struct __s_confin_stats *stats;        /**< Counters accumulated by the calls using this context, or NULL */
+    void (*trace)(void *userdata, enum __e_confin_op op, enum __e_confin_phase phase, uint64_t nanoseconds); /**< Called for each phase at the end of an operation, or NULL */
+    void *tracedata;                       /**< User context passed to `trace` */
 };
 
 #ifdef _MSC_VER
@@ -84,6 +430,11 @@ struct __s_confin_entry {
  */
 struct __s_confin_file {
     struct __s_confin_header header; /**< Header of the configuration file */
+    struct __s_confin_layout layout; /**< Layout of the configuration file */
+    void *pool;                      /**< Value pool shared by the entries, or NULL */
+    struct __s_confin_allocator allocator; /**< Allocator that owns the structure, its pool and values */
+    uint64_t generation;             /**< Unique number of this configuration, checked by key handles */
+    void *index;                     /**< Key index built on the first lookup, or NULL */
     struct __s_confin_entry entries[]; /**< Array of configuration entries */
 };
 
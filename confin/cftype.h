@@ -34,6 +34,32 @@ typedef
  */
 typedef struct __s_confin_header cfheader_t;
 
+/**
+ * @typedef cflayout_t
+ * @brief Type alias for the layout block structure.
+ * 
+ * This type alias represents the block describing how values are stored in a
+ * configuration file. It is equivalent to `struct __s_confin_layout`.
+ */
+typedef struct __s_confin_layout cflayout_t;
+
+/**
+ * @typedef cfoffsettable_t
+ * @brief Type alias for the trailer of an offset table.
+ * 
+ * It is equivalent to `struct __s_confin_offset_table`.
+ */
+typedef struct __s_confin_offset_table cfoffsettable_t;
+
+/**
+ * @typedef cfentryhdr_t
+ * @brief Type alias for the on-disk entry header structure.
+ * 
+ * This type alias represents the header written before every entry value.
+ * It is equivalent to `struct __s_confin_entry_header`.
+ */
+typedef struct __s_confin_entry_header cfentryhdr_t;
+
 /**
  * @typedef cfentry_t
  * @brief Type alias for the configuration entry structure.
@@ -52,4 +78,329 @@ typedef struct __s_confin_entry cfentry_t;
  */
 typedef struct __s_confin_file cffile_t;
 
+/**
+ * @typedef cfallocator_t
+ * @brief Type alias for the allocator structure.
+ * 
+ * This type alias represents the set of callbacks used for every allocation made by
+ * the library. It is equivalent to `struct __s_confin_allocator`.
+ */
+typedef struct __s_confin_allocator cfallocator_t;
+
+/**
+ * @typedef cfcontext_t
+ * @brief Type alias for the per-call context structure.
+ * 
+ * This type alias represents the settings passed to the `*_ctx` functions.
+ * It is equivalent to `struct __s_confin_context`.
+ */
+typedef struct __s_confin_context cfcontext_t;
+
+/**
+ * @typedef cfop_t
+ * @brief Type alias for the instrumented operations.
+ * 
+ * It is equivalent to `enum __e_confin_op`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_op cfop_t;
+
+/**
+ * @typedef cfphase_t
+ * @brief Type alias for the timed phases of an operation.
+ * 
+ * It is equivalent to `enum __e_confin_phase`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_phase cfphase_t;
+
+/**
+ * @typedef cfopstats_t
+ * @brief Type alias for the counters of one operation.
+ * 
+ * It is equivalent to `struct __s_confin_op_stats`.
+ */
+typedef struct __s_confin_op_stats cfopstats_t;
+
+/**
+ * @typedef cfstats_t
+ * @brief Type alias for the instrumentation counters.
+ * 
+ * It is equivalent to `struct __s_confin_stats`.
+ */
+typedef struct __s_confin_stats cfstats_t;
+
+/**
+ * @typedef cftracefn_t
+ * @brief Type of the trace callback, called for each phase at the end of an operation.
+ */
+typedef void (*cftracefn_t)(void *userdata, cfop_t op, cfphase_t phase, uint64_t nanoseconds);
+
+/**
+ * @typedef cfdeltaop_t
+ * @brief Type alias for the operations recorded in a delta file.
+ * 
+ * It is equivalent to `enum __e_confin_delta_op`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_delta_op cfdeltaop_t;
+
+/**
+ * @typedef cfdiffsummary_t
+ * @brief Type alias for the summary of a delta.
+ * 
+ * It is equivalent to `struct __s_confin_diff_summary`.
+ */
+typedef struct __s_confin_diff_summary cfdiffsummary_t;
+
+/**
+ * @typedef cfdeltabase_t
+ * @brief Type alias for the description of the base configuration of a delta.
+ * 
+ * It is equivalent to `struct __s_confin_delta_base`.
+ */
+typedef struct __s_confin_delta_base cfdeltabase_t;
+
+/**
+ * @typedef cfsource_t
+ * @brief Type alias for the text formats accepted by the compiler.
+ * 
+ * It is equivalent to `enum __e_confin_source`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_source cfsource_t;
+
+/**
+ * @typedef cfcompileopts_t
+ * @brief Type alias for the options of the text compiler.
+ * 
+ * It is equivalent to `struct __s_confin_compile_options`.
+ */
+typedef struct __s_confin_compile_options cfcompileopts_t;
+
+/**
+ * @typedef cfexportfmt_t
+ * @brief Type alias for the output formats of the JSON exporter.
+ * 
+ * It is equivalent to `enum __e_confin_export`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_export cfexportfmt_t;
+
+/**
+ * @typedef cfbinding_t
+ * @brief Type alias for a field descriptor of the binder.
+ * 
+ * It is equivalent to `struct __s_confin_binding`.
+ */
+typedef struct __s_confin_binding cfbinding_t;
+
+/**
+ * @typedef cfbindstatus_t
+ * @brief Type alias for the outcome of binding one descriptor.
+ * 
+ * It is equivalent to `enum __e_confin_bind_status`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_bind_status cfbindstatus_t;
+
+/**
+ * @typedef cfkeyhandle_t
+ * @brief Type alias for a pre-resolved key.
+ * 
+ * It is equivalent to `struct __s_confin_key_handle`.
+ */
+typedef struct __s_confin_key_handle cfkeyhandle_t;
+
+/**
+ * @typedef cfwriter_t
+ * @brief Type alias for a streaming writer handle.
+ * 
+ * It is equivalent to `struct __s_confin_writer`, which is opaque.
+ */
+typedef struct __s_confin_writer cfwriter_t;
+
+/**
+ * @typedef cfreadfn_t
+ * @brief Type of the callback that supplies a value to the streaming writer.
+ * 
+ * It copies up to `size` bytes into `buffer` and returns the number copied,
+ * or 0 on an error.
+ */
+typedef size_t (*cfreadfn_t)(void *userdata, void *buffer, size_t size);
+
+/**
+ * @typedef cfmutable_t
+ * @brief Type alias for a mutable configuration.
+ * 
+ * It is equivalent to `struct __s_confin_mutable`, which is opaque.
+ */
+typedef struct __s_confin_mutable cfmutable_t;
+
+/**
+ * @typedef cfsnapshot_t
+ * @brief Type alias for a committed version of a mutable configuration.
+ * 
+ * It is equivalent to `struct __s_confin_snapshot`, which is opaque.
+ */
+typedef struct __s_confin_snapshot cfsnapshot_t;
+
+/**
+ * @typedef cftxn_t
+ * @brief Type alias for a transaction on a mutable configuration.
+ * 
+ * It is equivalent to `struct __s_confin_txn`, which is opaque.
+ */
+typedef struct __s_confin_txn cftxn_t;
+
+/**
+ * @typedef cfrequestop_t
+ * @brief Type alias for the operations of a request to the configuration server.
+ * 
+ * It is equivalent to `enum __e_confin_request_op`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_request_op cfrequestop_t;
+
+/**
+ * @typedef cfreplystatus_t
+ * @brief Type alias for the status of a reply from the configuration server.
+ * 
+ * It is equivalent to `enum __e_confin_reply_status`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_reply_status cfreplystatus_t;
+
+/**
+ * @typedef cfrequesthdr_t
+ * @brief Type alias for the header of a request frame.
+ * 
+ * It is equivalent to `struct __s_confin_request_header`.
+ */
+typedef struct __s_confin_request_header cfrequesthdr_t;
+
+/**
+ * @typedef cfreplyhdr_t
+ * @brief Type alias for the header of a reply frame.
+ * 
+ * It is equivalent to `struct __s_confin_reply_header`.
+ */
+typedef struct __s_confin_reply_header cfreplyhdr_t;
+
+/**
+ * @typedef cfreplyitem_t
+ * @brief Type alias for the header of an item in a reply.
+ * 
+ * It is equivalent to `struct __s_confin_reply_item`.
+ */
+typedef struct __s_confin_reply_item cfreplyitem_t;
+
+/**
+ * @typedef cfserver_t
+ * @brief Type alias for a configuration server.
+ * 
+ * It is equivalent to `struct __s_confin_server`, which is opaque.
+ */
+typedef struct __s_confin_server cfserver_t;
+
+/**
+ * @typedef cfclient_t
+ * @brief Type alias for a connection to a configuration server.
+ * 
+ * It is equivalent to `struct __s_confin_client`, which is opaque.
+ */
+typedef struct __s_confin_client cfclient_t;
+
+/**
+ * @typedef cfshardmode_t
+ * @brief Type alias for the ways a sharded configuration assigns keys to shards.
+ * 
+ * It is equivalent to `enum __e_confin_shard_mode`.
+ */
+typedef 
+#ifndef __cplusplus
+    enum
+#endif
+    __e_confin_shard_mode cfshardmode_t;
+
+/**
+ * @typedef cfmanifest_t
+ * @brief Type alias for the header of a manifest.
+ * 
+ * It is equivalent to `struct __s_confin_manifest_header`.
+ */
+typedef struct __s_confin_manifest_header cfmanifest_t;
+
+/**
+ * @typedef cfshardrecord_t
+ * @brief Type alias for the record of a shard in a manifest.
+ * 
+ * It is equivalent to `struct __s_confin_shard_record`.
+ */
+typedef struct __s_confin_shard_record cfshardrecord_t;
+
+/**
+ * @typedef cfshardwriter_t
+ * @brief Type alias for a writer of a sharded configuration.
+ * 
+ * It is equivalent to `struct __s_confin_shard_writer`, which is opaque.
+ */
+typedef struct __s_confin_shard_writer cfshardwriter_t;
+
+/**
+ * @typedef cfsharded_t
+ * @brief Type alias for a sharded configuration opened for reading.
+ * 
+ * It is equivalent to `struct __s_confin_sharded`, which is opaque.
+ */
+typedef struct __s_confin_sharded cfsharded_t;
+
+/**
+ * @typedef cffrozen_t
+ * @brief Type alias for a frozen, read-only configuration.
+ * 
+ * It is equivalent to `struct __s_confin_frozen`, which is opaque.
+ */
+typedef struct __s_confin_frozen cffrozen_t;
+
+/**
+ * @typedef cfcompacthdr_t
+ * @brief Type alias for the header of a compact configuration file.
+ * 
+ * It is equivalent to `struct __s_confin_compact_header`.
+ */
+typedef struct __s_confin_compact_header cfcompacthdr_t;
+
+/**
+ * @typedef cfcompact_t
+ * @brief Type alias for a compact configuration with front-coded keys.
+ * 
+ * It is equivalent to `struct __s_confin_compact`, which is opaque.
+ */
+typedef struct __s_confin_compact cfcompact_t;
+
 #endif // _CONFIN_TYPE_H
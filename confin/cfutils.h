@@ -45,6 +45,37 @@ extern "C" {
  */
 cfentry_t confin_create_config_entry(const char *key, cfannotype_t type, const void *value, uint64_t size);
 
+/**
+ * @brief Macro to create a configuration entry with a context.
+ * 
+ * This macro calls the `confin_create_config_entry_ctx` function.
+ * 
+ * @param key The key for the configuration entry.
+ * @param annotype The type of the value (see @ref cfannotype_t).
+ * @param value The value to be stored in the configuration entry.
+ * @param size The size of the value.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The created configuration entry.
+ */
+#define cfcreatecfgentryctx(key, annotype, value, size, ctx) \
+    confin_create_config_entry_ctx(key, annotype, value, size, ctx)
+
+/**
+ * @brief Creates a configuration entry with a context.
+ * 
+ * Same as `confin_create_config_entry`; a value that is not stored inline is
+ * allocated with the allocator of the context. Free the entry with
+ * `confin_free_config_entry_ctx` and the same context.
+ * 
+ * @param key The key for the configuration entry.
+ * @param type The type of the value (see @ref cfannotype_t).
+ * @param value The value to be stored in the configuration entry.
+ * @param size The size of the value.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The created configuration entry.
+ */
+cfentry_t confin_create_config_entry_ctx(const char *key, cfannotype_t type, const void *value, uint64_t size, cfcontext_t *ctx);
+
 /**
  * @brief Macro to free a configuration entry.
  * 
@@ -65,6 +96,28 @@ cfentry_t confin_create_config_entry(const char *key, cfannotype_t type, const v
  */
 void confin_free_config_entry(cfentry_t *entry);
 
+/**
+ * @brief Macro to free a configuration entry with a context.
+ * 
+ * This macro calls the `confin_free_config_entry_ctx` function.
+ * 
+ * @param entry Pointer to the configuration entry to be freed.
+ * @param ctx The context of the call, or NULL for the global settings.
+ */
+#define cffreecfgentryctx(entry, ctx) \
+    confin_free_config_entry_ctx(entry, ctx)
+
+/**
+ * @brief Frees a configuration entry with a context.
+ * 
+ * Same as `confin_free_config_entry`; the value is freed with the allocator of
+ * the context.
+ * 
+ * @param entry Pointer to the configuration entry to be freed.
+ * @param ctx The context of the call, or NULL for the global settings.
+ */
+void confin_free_config_entry_ctx(cfentry_t *entry, cfcontext_t *ctx);
+
 /**
  * @brief Macro to display a configuration entry.
  * 
@@ -101,7 +154,7 @@ void confin_display_config_entry(const cfentry_t *entry);
  * @brief Frees a configuration file.
  * 
  * This function frees the memory allocated for a configuration file, including
- * its header and entries.
+ * its header, entries and value pool, with the allocator it was created with.
  * 
  * @param config Pointer to the configuration file to be freed.
  */
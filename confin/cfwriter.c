@@ -0,0 +1,352 @@
+#ifdef __cplusplus
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+#include "cfwriter.h" // confin/cfwriter.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/**
+ * @brief Size of the output buffer, flushed with a single write when full.
+ */
+#define CONFIN_WRITER_BUFSIZE (1 << 20)
+
+/**
+ * @brief Size of the chunks requested from a read callback.
+ */
+#define CONFIN_WRITER_CHUNK (64 * 1024)
+
+/**
+ * @struct __s_confin_writer
+ * @brief Structure for the state of a streaming writer.
+ */
+struct __s_confin_writer {
+    FILE *file;              /**< Output file, NULL for a detached writer */
+    char *filename;          /**< Name of the output file, to remove it on failure */
+    unsigned char *buffer;   /**< Pending output */
+    size_t size;             /**< Bytes used in `buffer` */
+    size_t capacity;         /**< Size of `buffer` */
+    uint64_t count;          /**< Number of entries appended */
+    uint64_t position;       /**< File position of the next entry */
+    uint64_t *offsets;       /**< Positions of every __CONFIN_OFFSET_STRIDE-th entry */
+    uint64_t offsetcapacity; /**< Positions allocated in `offsets` */
+    bool failed;             /**< Set by the first failed append */
+    cfallocator_t allocator; /**< Allocator of the writer and its buffer */
+};
+
+static bool confin_writer_output(cfwriter_t *writer, const void *bytes, size_t size) {
+    // A detached writer only holds its file open while it writes
+    FILE *file = writer->file ? writer->file : fopen(writer->filename, "ab");
+    if (!file) {
+        perror("fopen");
+        writer->failed = true;
+        return false;
+    }
+    if (fwrite(bytes, size, 1, file) != 1) {
+        perror("fwrite");
+        writer->failed = true;
+    }
+    if (!writer->file && fclose(file) != 0) {
+        perror("fclose");
+        writer->failed = true;
+    }
+    return !writer->failed;
+}
+
+static bool confin_writer_flush(cfwriter_t *writer) {
+    if (writer->size) {
+        confin_writer_output(writer, writer->buffer, writer->size);
+    }
+    writer->size = 0;
+    return !writer->failed;
+}
+
+static bool confin_writer_write(cfwriter_t *writer, const void *bytes, size_t size) {
+    if (writer->size + size > writer->capacity) {
+        if (!confin_writer_flush(writer)) {
+            return false;
+        }
+        if (size > writer->capacity) {
+            return confin_writer_output(writer, bytes, size);
+        }
+    }
+    memcpy(writer->buffer + writer->size, bytes, size);
+    writer->size += size;
+    return true;
+}
+
+/**
+ * @brief Records the position of the next entry if it starts a stride of the offset table.
+ */
+static bool confin_writer_mark(cfwriter_t *writer, uint64_t size) {
+    if (writer->count % __CONFIN_OFFSET_STRIDE == 0) {
+        uint64_t slot = writer->count / __CONFIN_OFFSET_STRIDE;
+        if (slot == writer->offsetcapacity) {
+            uint64_t capacity = writer->offsetcapacity ? writer->offsetcapacity * 2 : 64;
+            uint64_t *offsets = (uint64_t*)confin_realloc(&writer->allocator, writer->offsets, sizeof(uint64_t) * capacity);
+            if (!offsets) {
+                perror("malloc");
+                writer->failed = true;
+                return false;
+            }
+            writer->offsets = offsets;
+            writer->offsetcapacity = capacity;
+        }
+        writer->offsets[slot] = writer->position;
+    }
+    writer->position += sizeof(cfentryhdr_t) + size;
+    return true;
+}
+
+static bool confin_writer_header(cfwriter_t *writer, const char *key, cfannotype_t type, uint64_t size) {
+    if (writer->failed) {
+        return false;
+    }
+    size_t length = 0;
+    while (length < __CONFIN_STRUCT_MAX_KEYLEN && key[length]) {
+        ++length;
+    }
+    if (length == __CONFIN_STRUCT_MAX_KEYLEN) {
+        fprintf(stderr, "Key '%.*s' is too long\n", __CONFIN_STRUCT_MAX_KEYLEN, key);
+        writer->failed = true;
+        return false;
+    }
+    if (!confin_writer_mark(writer, size)) {
+        return false;
+    }
+    cfentryhdr_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.key, key, length);
+    hdr.type = (uint32_t)type;
+    hdr.size = size;
+    return confin_writer_write(writer, &hdr, sizeof(hdr));
+}
+
+static cfwriter_t *confin_writer_create(const char *filename, size_t capacity, bool detached, cfcontext_t *ctx) {
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    size_t namelength = strlen(filename) + 1;
+    cfwriter_t *writer = (cfwriter_t*)confin_alloc(&allocator, sizeof(cfwriter_t) + namelength);
+    if (!writer) {
+        perror("malloc");
+        return NULL;
+    }
+    writer->filename = (char*)(writer + 1);
+    memcpy(writer->filename, filename, namelength);
+    writer->size = 0;
+    writer->capacity = capacity;
+    writer->count = 0;
+    writer->position = sizeof(cfheader_t) + sizeof(cflayout_t);
+    writer->offsets = NULL;
+    writer->offsetcapacity = 0;
+    writer->failed = false;
+    writer->allocator = allocator;
+
+    writer->buffer = (unsigned char*)confin_alloc(&allocator, capacity);
+    if (!writer->buffer) {
+        perror("malloc");
+        confin_free(&allocator, writer);
+        return NULL;
+    }
+    writer->file = fopen(filename, "wb");
+    if (!writer->file) {
+        perror("fopen");
+        confin_free(&allocator, writer->buffer);
+        confin_free(&allocator, writer);
+        return NULL;
+    }
+    if (detached) {
+        fclose(writer->file);
+        writer->file = NULL;
+    }
+
+    // The entry count is backpatched by confin_writer_close
+    cfheader_t header = {__CONFIN_STRUCT_MAGIC_NUMBER, _CF_VER, 0};
+    cflayout_t layout = {0, 0};
+    confin_writer_write(writer, &header, sizeof(header));
+    confin_writer_write(writer, &layout, sizeof(layout));
+    return writer;
+}
+
+/**
+ * @brief Opens a streaming writer.
+ * @param filename The name of the file to write.
+ * @return The writer, or NULL on failure.
+ */
+cfwriter_t *confin_writer_open(const char *filename) {
+    return confin_writer_open_ctx(filename, NULL);
+}
+
+/**
+ * @brief Opens a streaming writer with a context.
+ * @param filename The name of the file to write.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The writer, or NULL on failure.
+ */
+cfwriter_t *confin_writer_open_ctx(const char *filename, cfcontext_t *ctx) {
+    return confin_writer_create(filename, CONFIN_WRITER_BUFSIZE, false, ctx);
+}
+
+/**
+ * @brief Opens a streaming writer that only holds its file open while it flushes.
+ * @param filename The name of the file to write.
+ * @param capacity Size of the output buffer.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The writer, or NULL on failure.
+ */
+cfwriter_t *confin_writer_open_detached(const char *filename, size_t capacity, cfcontext_t *ctx) {
+    return confin_writer_create(filename, capacity, true, ctx);
+}
+
+/**
+ * @brief Appends an entry to a streaming writer.
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param value Pointer to the value.
+ * @param size The size of the value.
+ * @return true on success, false on a write error.
+ */
+bool confin_writer_append(cfwriter_t *writer, const char *key, cfannotype_t type, const void *value, uint64_t size) {
+    if (!confin_writer_header(writer, key, type, size) || !confin_writer_write(writer, value, (size_t)size)) {
+        return false;
+    }
+    writer->count++;
+    return true;
+}
+
+/**
+ * @brief Appends an existing entry to a streaming writer.
+ * @param writer The writer.
+ * @param entry The entry.
+ * @return true on success, false on a write error.
+ */
+bool confin_writer_append_entry(cfwriter_t *writer, const cfentry_t *entry) {
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    memcpy(key, entry->key, sizeof(key) - 1);
+    key[sizeof(key) - 1] = '\0';
+    return confin_writer_append(writer, key, entry->type, CF_ENTRYVAL(entry), entry->size);
+}
+
+/**
+ * @brief Appends an entry whose value is supplied by a callback.
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param size The size of the value.
+ * @param read The callback supplying the value.
+ * @param userdata The first argument of the callback.
+ * @return true on success, false on a write or callback error.
+ */
+bool confin_writer_append_stream(cfwriter_t *writer, const char *key, cfannotype_t type, uint64_t size, cfreadfn_t read, void *userdata) {
+    if (!confin_writer_header(writer, key, type, size)) {
+        return false;
+    }
+
+    // Chunks go straight into the output buffer
+    uint64_t remaining = size;
+    while (remaining) {
+        if (writer->size + CONFIN_WRITER_CHUNK > writer->capacity && writer->size && !confin_writer_flush(writer)) {
+            return false;
+        }
+        size_t room = writer->capacity - writer->size;
+        size_t request = remaining < CONFIN_WRITER_CHUNK ? (size_t)remaining : CONFIN_WRITER_CHUNK;
+        request = request < room ? request : room;
+        size_t supplied = read(userdata, writer->buffer + writer->size, request);
+        if (supplied == 0 || supplied > request) {
+            fprintf(stderr, "Value of '%s' ended %llu bytes early\n", key, (unsigned long long)remaining);
+            writer->failed = true;
+            return false;
+        }
+        writer->size += supplied;
+        remaining -= supplied;
+    }
+    writer->count++;
+    return true;
+}
+
+/**
+ * @brief Appends entries already encoded as in the file.
+ * @param writer The writer.
+ * @param records The entry headers and values.
+ * @param size The size of `records`.
+ * @param count The number of entries in `records`.
+ * @return true on success, false on a write error.
+ */
+bool confin_writer_append_encoded(cfwriter_t *writer, const void *records, size_t size, uint64_t count) {
+    const unsigned char *record = (const unsigned char*)records;
+    for (uint64_t i = 0; i < count && !writer->failed; ++i) {
+        cfentryhdr_t hdr;
+        memcpy(&hdr, record, sizeof(hdr));
+        if (!confin_writer_mark(writer, hdr.size)) {
+            return false;
+        }
+        writer->count++;
+        record += sizeof(hdr) + hdr.size;
+    }
+    return !writer->failed && confin_writer_write(writer, records, size);
+}
+
+/**
+ * @brief Gets the number of entries appended so far.
+ * @param writer The writer.
+ * @return The number of entries.
+ */
+uint64_t confin_writer_count(const cfwriter_t *writer) {
+    return writer->count;
+}
+
+/**
+ * @brief Finishes the file and frees a streaming writer.
+ * @param writer The writer.
+ * @return true if the whole file was written, false otherwise.
+ */
+bool confin_writer_close(cfwriter_t *writer) {
+    cfoffsettable_t table = {__CONFIN_OFFSET_STRIDE, (writer->count + __CONFIN_OFFSET_STRIDE - 1) / __CONFIN_OFFSET_STRIDE};
+    if (!writer->failed && table.count) {
+        confin_writer_write(writer, writer->offsets, sizeof(uint64_t) * table.count);
+        confin_writer_write(writer, &table, sizeof(table));
+    }
+    bool ok = confin_writer_flush(writer);
+
+    // Backpatch the entry count and announce the offset table
+    struct {
+        cfheader_t header;
+        cflayout_t layout;
+    } head = {{__CONFIN_STRUCT_MAGIC_NUMBER, _CF_VER, writer->count}, {table.count ? CONFIN_LAYOUT_OFFSETS : 0, 0}};
+    FILE *file = writer->file ? writer->file : ok ? fopen(writer->filename, "r+b") : NULL;
+    if (ok && !file) {
+        perror("fopen");
+    }
+    ok = ok && file && fseek(file, 0, SEEK_SET) == 0 && fwrite(&head, sizeof(head), 1, file) == 1;
+    if (file) {
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) {
+        remove(writer->filename);
+    }
+
+    cfallocator_t allocator = writer->allocator;
+    confin_free(&allocator, writer->offsets);
+    confin_free(&allocator, writer->buffer);
+    confin_free(&allocator, writer);
+    return ok;
+}
+
+/**
+ * @brief Discards the file and frees a streaming writer.
+ * @param writer The writer.
+ */
+void confin_writer_abort(cfwriter_t *writer) {
+    writer->failed = true;
+    writer->size = 0;
+    confin_writer_close(writer);
+}
@@ -0,0 +1,191 @@
+/**
+ * @file cfwriter.h
+ * @brief Functions and macros for writing Confin files one entry at a time.
+ * 
+ * This header file provides the streaming writer. The header is written with a
+ * zero entry count when the writer is opened, entries are appended as they are
+ * produced and the count is backpatched when the writer is closed, so memory use
+ * does not depend on the number or size of the entries. Values can be passed as a
+ * pointer or pulled in chunks from a callback. The file ends with an offset table
+ * recording every @ref __CONFIN_OFFSET_STRIDE-th entry, which keeps memory use to
+ * 8 bytes per stride and lets the file be loaded in parallel.
+ */
+
+#ifndef _CONFIN_WRITER_H
+#define _CONFIN_WRITER_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#include "cftype.h" // confin/cftype.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @def cfwriteropen
+ * @brief Macro to open a streaming writer.
+ * @param filename The name of the file to write.
+ * @return The writer, or NULL on failure.
+ */
+#define cfwriteropen(filename) confin_writer_open(filename)
+
+/**
+ * @brief Opens a streaming writer.
+ * @param filename The name of the file to write.
+ * @return The writer, or NULL on failure.
+ */
+cfwriter_t *confin_writer_open(const char *filename);
+
+/**
+ * @def cfwriteropenctx
+ * @brief Macro to open a streaming writer with a context.
+ * @param filename The name of the file to write.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The writer, or NULL on failure.
+ */
+#define cfwriteropenctx(filename, ctx) confin_writer_open_ctx(filename, ctx)
+
+/**
+ * @brief Opens a streaming writer with a context.
+ * 
+ * The allocator of the context is used for the writer and its output buffer.
+ * 
+ * @param filename The name of the file to write.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The writer, or NULL on failure.
+ */
+cfwriter_t *confin_writer_open_ctx(const char *filename, cfcontext_t *ctx);
+
+/**
+ * @def cfwriterappend
+ * @brief Macro to append an entry to a streaming writer.
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param value Pointer to the value.
+ * @param size The size of the value.
+ * @return true on success, false on a write error.
+ */
+#define cfwriterappend(writer, key, type, value, size) \
+    confin_writer_append(writer, key, type, value, size)
+
+/**
+ * @brief Appends an entry to a streaming writer.
+ * 
+ * Keys must be shorter than @ref __CONFIN_STRUCT_MAX_KEYLEN characters; a longer
+ * key fails the writer, as truncating it could produce duplicate keys.
+ * 
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param value Pointer to the value.
+ * @param size The size of the value.
+ * @return true on success, false on a write error.
+ */
+bool confin_writer_append(cfwriter_t *writer, const char *key, cfannotype_t type, const void *value, uint64_t size);
+
+/**
+ * @def cfwriterappendentry
+ * @brief Macro to append an existing entry to a streaming writer.
+ * @param writer The writer.
+ * @param entry The entry.
+ * @return true on success, false on a write error.
+ */
+#define cfwriterappendentry(writer, entry) confin_writer_append_entry(writer, entry)
+
+/**
+ * @brief Appends an existing entry to a streaming writer.
+ * @param writer The writer.
+ * @param entry The entry.
+ * @return true on success, false on a write error.
+ */
+bool confin_writer_append_entry(cfwriter_t *writer, const cfentry_t *entry);
+
+/**
+ * @def cfwriterappendstream
+ * @brief Macro to append an entry whose value is supplied by a callback.
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param size The size of the value.
+ * @param read The callback supplying the value.
+ * @param userdata The first argument of the callback.
+ * @return true on success, false on a write or callback error.
+ */
+#define cfwriterappendstream(writer, key, type, size, read, userdata) \
+    confin_writer_append_stream(writer, key, type, size, read, userdata)
+
+/**
+ * @brief Appends an entry whose value is supplied by a callback.
+ * 
+ * The callback is called until `size` bytes have been supplied, so values larger
+ * than memory can be copied from another file or generated on the fly.
+ * 
+ * @param writer The writer.
+ * @param key The key of the entry.
+ * @param type The type of the value.
+ * @param size The size of the value.
+ * @param read The callback supplying the value.
+ * @param userdata The first argument of the callback.
+ * @return true on success, false on a write or callback error.
+ */
+bool confin_writer_append_stream(cfwriter_t *writer, const char *key, cfannotype_t type, uint64_t size, cfreadfn_t read, void *userdata);
+
+/**
+ * @def cfwritercount
+ * @brief Macro to get the number of entries appended so far.
+ * @param writer The writer.
+ * @return The number of entries.
+ */
+#define cfwritercount(writer) confin_writer_count(writer)
+
+/**
+ * @brief Gets the number of entries appended so far.
+ * @param writer The writer.
+ * @return The number of entries.
+ */
+uint64_t confin_writer_count(const cfwriter_t *writer);
+
+/**
+ * @def cfwriterclose
+ * @brief Macro to finish the file and free a streaming writer.
+ * @param writer The writer.
+ * @return true if the whole file was written, false otherwise.
+ */
+#define cfwriterclose(writer) confin_writer_close(writer)
+
+/**
+ * @brief Finishes the file and frees a streaming writer.
+ * 
+ * Backpatches the entry count in the header. If any append failed, or finishing
+ * the file fails, the incomplete file is removed.
+ * 
+ * @param writer The writer.
+ * @return true if the whole file was written, false otherwise.
+ */
+bool confin_writer_close(cfwriter_t *writer);
+
+/**
+ * @def cfwriterabort
+ * @brief Macro to discard the file and free a streaming writer.
+ * @param writer The writer.
+ */
+#define cfwriterabort(writer) confin_writer_abort(writer)
+
+/**
+ * @brief Discards the file and frees a streaming writer.
+ * 
+ * Use it when the producer of the entries fails and the file must not be kept.
+ * 
+ * @param writer The writer.
+ */
+void confin_writer_abort(cfwriter_t *writer);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // _CONFIN_WRITER_H
@@ -11,10 +11,823 @@
 #include <stdbool.h>
 #endif
 
+#include <time.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "cftype.h" // confin/cftype.h
 #include "cfio.h" // confin/cfio.h
 #include "cfutils.h" // confin/cfutils.h
 #include "cffmt.h" // confin/cffmt.h
+#include "cfctx.h" // confin/cfctx.h
+#include "cfstats.h" // confin/cfstats.h
+#include "cfinternal.h" // confin/cfinternal.h
+
+/* internal helpers */
+
+static void *confin_default_alloc(void *userdata, size_t size) {
+    (void)userdata;
+    return malloc(size);
+}
+
+static void *confin_default_realloc(void *userdata, void *ptr, size_t size) {
+    (void)userdata;
+    return realloc(ptr, size);
+}
+
+static void confin_default_free(void *userdata, void *ptr) {
+    (void)userdata;
+    free(ptr);
+}
+
+/**
+ * @brief The global allocator, `malloc`/`realloc`/`free` unless replaced with @ref confin_set_allocator.
+ */
+static cfallocator_t confin_global_allocator = {
+    confin_default_alloc,
+    confin_default_realloc,
+    confin_default_free,
+    NULL
+};
+
+static volatile int64_t confin_generation_counter = 0;
+
+/**
+ * @brief Returns a new configuration generation, unique for the process and never 0.
+ */
+uint64_t confin_next_generation(void) {
+#ifdef _MSC_VER
+    return (uint64_t)_InterlockedIncrement64((volatile __int64*)&confin_generation_counter);
+#else
+    return (uint64_t)__atomic_add_fetch(&confin_generation_counter, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * @brief Resolves the allocator used by a call.
+ * @param ctx The context of the call, or NULL.
+ * @return The allocator of the context if it has one, the global allocator otherwise.
+ */
+cfallocator_t confin_resolve_allocator(const cfcontext_t *ctx) {
+    if (ctx && ctx->allocator.alloc) {
+        return ctx->allocator;
+    }
+    return confin_global_allocator;
+}
+
+void *confin_alloc(const cfallocator_t *allocator, size_t size) {
+    return allocator->alloc(allocator->userdata, size);
+}
+
+void *confin_realloc(const cfallocator_t *allocator, void *ptr, size_t size) {
+    return allocator->realloc(allocator->userdata, ptr, size);
+}
+
+void confin_free(const cfallocator_t *allocator, void *ptr) {
+    if (ptr) {
+        allocator->free(allocator->userdata, ptr);
+    }
+}
+
+/**
+ * @brief Per-call instrumentation state.
+ * 
+ * Counters are accumulated locally during the call and merged into the context
+ * and global counters by @ref confin_probe_end.
+ */
+typedef struct {
+    cfcontext_t *ctx; /**< Context of the call, or NULL */
+    cfop_t op;        /**< Instrumented operation */
+    bool enabled;     /**< Whether the call is instrumented */
+    cfopstats_t stats; /**< Counters of the call */
+} confin_probe_t;
+
+#if __CONFIN_ENABLE_STATS
+
+static bool confin_stats_enabled = false;
+static cfstats_t confin_global_stats;
+static cftracefn_t confin_global_trace = NULL;
+static void *confin_global_tracedata = NULL;
+
+#define confin_probe_on(probe) ((probe)->enabled)
+
+static uint64_t confin_now_ns(void) {
+    struct timespec ts;
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void confin_atomic_add(uint64_t *target, uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_fetch_add(target, value, __ATOMIC_RELAXED);
+#else
+    *target += value;
+#endif
+}
+
+#else
+
+#define confin_probe_on(probe) ((void)(probe), false)
+
+static uint64_t confin_now_ns(void) {
+    return 0;
+}
+
+#endif
+
+/**
+ * @brief Starts the instrumentation of a call.
+ * @param probe The probe to initialize.
+ * @param op The instrumented operation.
+ * @param ctx The context of the call, or NULL.
+ */
+static void confin_probe_begin(confin_probe_t *probe, cfop_t op, cfcontext_t *ctx) {
+    probe->ctx = ctx;
+    probe->op = op;
+    probe->enabled = false;
+#if __CONFIN_ENABLE_STATS
+    probe->enabled = confin_stats_enabled || confin_global_trace || (ctx && (ctx->stats || ctx->trace));
+    if (probe->enabled) {
+        memset(&probe->stats, 0, sizeof(probe->stats));
+        probe->stats.calls = 1;
+    }
+#endif
+}
+
+/**
+ * @brief Reads the clock if the call is instrumented.
+ * @param probe The probe of the call.
+ * @return The current time in nanoseconds, or 0.
+ */
+static uint64_t confin_probe_clock(const confin_probe_t *probe) {
+    return confin_probe_on(probe) ? confin_now_ns() : 0;
+}
+
+/**
+ * @brief Accounts the time elapsed since `start` to a phase.
+ * @param probe The probe of the call.
+ * @param phase The phase the time was spent in.
+ * @param start Time returned by @ref confin_probe_clock.
+ */
+static void confin_probe_phase(confin_probe_t *probe, cfphase_t phase, uint64_t start) {
+    if (confin_probe_on(probe)) {
+        probe->stats.nanoseconds[phase] += confin_now_ns() - start;
+    }
+}
+
+/**
+ * @brief Finishes the instrumentation of a call.
+ * 
+ * Merges the counters of the call into the context and global counters and
+ * reports every phase to the trace callback.
+ * 
+ * @param probe The probe of the call.
+ */
+static void confin_probe_end(confin_probe_t *probe) {
+    if (!confin_probe_on(probe)) {
+        return;
+    }
+#if __CONFIN_ENABLE_STATS
+    const uint64_t *counters = (const uint64_t*)&probe->stats;
+    size_t count = sizeof(cfopstats_t) / sizeof(uint64_t);
+
+    if (probe->ctx && probe->ctx->stats) {
+        uint64_t *target = (uint64_t*)&probe->ctx->stats->ops[probe->op];
+        for (size_t i = 0; i < count; ++i) {
+            target[i] += counters[i];
+        }
+    }
+    if (confin_stats_enabled) {
+        uint64_t *target = (uint64_t*)&confin_global_stats.ops[probe->op];
+        for (size_t i = 0; i < count; ++i) {
+            confin_atomic_add(&target[i], counters[i]);
+        }
+    }
+
+    cftracefn_t trace = confin_global_trace;
+    void *tracedata = confin_global_tracedata;
+    if (probe->ctx && probe->ctx->trace) {
+        trace = probe->ctx->trace;
+        tracedata = probe->ctx->tracedata;
+    }
+    if (trace) {
+        for (int phase = 0; phase < CONFIN_PHASE_COUNT; ++phase) {
+            trace(tracedata, probe->op, (cfphase_t)phase, probe->stats.nanoseconds[phase]);
+        }
+    }
+#endif
+}
+
+static FILE *confin_probe_fopen(confin_probe_t *probe, const char *filename, const char *mode) {
+    uint64_t start = confin_probe_clock(probe);
+    FILE *file = fopen(filename, mode);
+    if (confin_probe_on(probe)) {
+        probe->stats.iocalls++;
+        confin_probe_phase(probe, CONFIN_PHASE_OPEN, start);
+    }
+    return file;
+}
+
+static void confin_probe_fclose(confin_probe_t *probe, FILE *file) {
+    uint64_t start = confin_probe_clock(probe);
+    fclose(file);
+    if (confin_probe_on(probe)) {
+        probe->stats.iocalls++;
+        confin_probe_phase(probe, CONFIN_PHASE_CLOSE, start);
+    }
+}
+
+/**
+ * @brief Reads exactly `size` bytes, accounting them to a phase.
+ * @return true on success, false if the file is truncated.
+ */
+static bool confin_probe_read(confin_probe_t *probe, cfphase_t phase, void *ptr, uint64_t size, FILE *file) {
+    if (!size) {
+        return true;
+    }
+    uint64_t start = confin_probe_clock(probe);
+    bool ok = fread(ptr, (size_t)size, 1, file) == 1;
+    if (confin_probe_on(probe)) {
+        probe->stats.iocalls++;
+        probe->stats.bytesread += ok ? size : 0;
+        confin_probe_phase(probe, phase, start);
+    }
+    return ok;
+}
+
+/**
+ * @brief Writes `size` bytes, accounting them to a phase.
+ * @return true on success, false on a write error.
+ */
+static bool confin_probe_write(confin_probe_t *probe, cfphase_t phase, const void *ptr, uint64_t size, FILE *file) {
+    if (!size) {
+        return true;
+    }
+    uint64_t start = confin_probe_clock(probe);
+    bool ok = fwrite(ptr, (size_t)size, 1, file) == 1;
+    if (confin_probe_on(probe)) {
+        probe->stats.iocalls++;
+        probe->stats.byteswritten += ok ? size : 0;
+        confin_probe_phase(probe, phase, start);
+    }
+    return ok;
+}
+
+static void *confin_probe_alloc(confin_probe_t *probe, const cfallocator_t *allocator, size_t size) {
+    uint64_t start = confin_probe_clock(probe);
+    void *ptr = confin_alloc(allocator, size);
+    if (confin_probe_on(probe)) {
+        probe->stats.allocations++;
+        probe->stats.allocatedbytes += size;
+        confin_probe_phase(probe, CONFIN_PHASE_ALLOC, start);
+    }
+    return ptr;
+}
+
+static void *confin_probe_alloc_zeroed(confin_probe_t *probe, const cfallocator_t *allocator, size_t size) {
+    void *ptr = confin_probe_alloc(probe, allocator, size);
+    if (ptr) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of a byte range.
+ * @param data Bytes to hash.
+ * @param size Number of bytes.
+ * @return The hash value.
+ */
+uint64_t confin_hash_bytes(const void *data, uint64_t size) {
+    const unsigned char *bytes = (const unsigned char*)data;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (uint64_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the hash of a key.
+ * @param key The key, hashed up to its terminator or @ref __CONFIN_STRUCT_MAX_KEYLEN bytes.
+ * @return The hash value.
+ */
+uint64_t confin_hash_key(const char *key) {
+    uint64_t length = 0;
+    while (length < __CONFIN_STRUCT_MAX_KEYLEN && key[length]) {
+        ++length;
+    }
+    return confin_hash_bytes(key, length);
+}
+
+/**
+ * @brief Computes the checksum of an entry.
+ * 
+ * The hashes of the key and of the type and value are mixed, so that entries
+ * swapping values do not cancel out in a sum.
+ * 
+ * @param entry The configuration entry.
+ * @return The checksum of the key, type and value.
+ */
+uint64_t confin_entry_checksum(const cfentry_t *entry) {
+    uint64_t hash = confin_hash_key(entry->key) * 0x9E3779B97F4A7C15ULL;
+    hash ^= confin_hash_bytes(CF_ENTRYVAL(entry), entry->size) + (uint64_t)entry->type;
+    hash ^= hash >> 31;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * @brief Fills the on-disk header of an entry.
+ * @param entry The in-memory configuration entry.
+ * @param hdr The on-disk header to fill.
+ */
+void confin_entry_to_header(const cfentry_t *entry, cfentryhdr_t *hdr) {
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->key, entry->key, sizeof(hdr->key));
+    hdr->key[__CONFIN_STRUCT_MAX_KEYLEN - 1] = '\0';
+    hdr->type = (uint32_t)entry->type;
+    hdr->size = entry->size;
+}
+
+/**
+ * @brief Initializes an in-memory entry from its on-disk header.
+ * @param hdr The on-disk header.
+ * @param entry The configuration entry to fill; its value is cleared.
+ */
+void confin_entry_from_header(const cfentryhdr_t *hdr, cfentry_t *entry) {
+    memcpy(entry->key, hdr->key, sizeof(entry->key));
+    entry->key[__CONFIN_STRUCT_MAX_KEYLEN - 1] = '\0';
+    entry->type = (cfannotype_t)hdr->type;
+    entry->flags = 0;
+    entry->size = hdr->size;
+    entry->value = NULL;
+}
+
+/**
+ * @brief Allocates an empty configuration file structure.
+ * 
+ * The entry count is left at 0 and incremented by the caller as entries are
+ * filled in, so that a partially built structure can always be freed.
+ * 
+ * @param allocator The allocator for the structure.
+ * @param entrycount Number of entries to make room for.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+cffile_t *confin_alloc_config(const cfallocator_t *allocator, uint64_t entrycount) {
+    cffile_t *config = (cffile_t*)confin_alloc(allocator, sizeof(cffile_t) + sizeof(cfentry_t) * entrycount);
+    if (!config) {
+        perror("malloc");
+        return NULL;
+    }
+    config->header.magic = __CONFIN_STRUCT_MAGIC_NUMBER;
+    config->header.version = _CF_VER;
+    config->header.entrycount = 0;
+    config->layout.flags = 0;
+    config->layout.poolsize = 0;
+    config->pool = NULL;
+    config->allocator = *allocator;
+    config->generation = confin_next_generation();
+    config->index = NULL;
+    return config;
+}
+
+/**
+ * @brief Copies an entry, giving the copy its own value.
+ * @param dst The entry to fill.
+ * @param src The entry to copy.
+ * @param allocator The allocator for a value that is not stored inline.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_copy_entry(cfentry_t *dst, const cfentry_t *src, const cfallocator_t *allocator) {
+    memcpy(dst->key, src->key, sizeof(dst->key));
+    dst->type = src->type;
+    dst->size = src->size;
+    if (src->size <= __CONFIN_INLINE_VALUE_MAX) {
+        dst->flags = CONFIN_ENTRY_INLINE;
+        dst->value = dst->inlinevalue;
+        memcpy(dst->inlinevalue, CF_ENTRYVAL(src), src->size);
+        return true;
+    }
+    dst->flags = 0;
+    dst->value = confin_alloc(allocator, src->size);
+    if (!dst->value) {
+        perror("malloc");
+        return false;
+    }
+    memcpy(dst->value, CF_ENTRYVAL(src), src->size);
+    return true;
+}
+
+/**
+ * @brief Moves an entry, pointing the value of an inline entry at its new place.
+ * @param dst The entry to fill.
+ * @param src The entry to move; its value now belongs to `dst`.
+ */
+void confin_move_entry(cfentry_t *dst, const cfentry_t *src) {
+    *dst = *src;
+    if (dst->flags & CONFIN_ENTRY_INLINE) {
+        dst->value = dst->inlinevalue;
+    }
+}
+
+/* internal key index */
+
+/**
+ * @brief Builds a key index over an array of entries.
+ * 
+ * The index has at least twice as many slots as entries; with duplicate keys the
+ * first entry wins.
+ * 
+ * @param index The key index to build.
+ * @param entries The entries to index.
+ * @param entrycount Number of entries.
+ * @param allocator The allocator for the slots.
+ * @return true on success, false if memory could not be allocated.
+ */
+bool confin_keyindex_build(confin_keyindex_t *index, const cfentry_t *entries, uint64_t entrycount, const cfallocator_t *allocator) {
+    uint64_t capacity = 16;
+    while (capacity < entrycount * 2) {
+        capacity <<= 1;
+    }
+
+    index->mask = capacity - 1;
+    index->slots = (confin_keyslot_t*)confin_alloc(allocator, sizeof(confin_keyslot_t) * capacity);
+    if (!index->slots) {
+        perror("malloc");
+        return false;
+    }
+    memset(index->slots, 0, sizeof(confin_keyslot_t) * capacity);
+
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        uint64_t hash = confin_hash_key(entries[i].key);
+        if (confin_keyindex_find(index, entries, entries[i].key, hash) != UINT64_MAX) {
+            continue;
+        }
+        uint64_t slot = hash & index->mask;
+        while (index->slots[slot].index) {
+            slot = (slot + 1) & index->mask;
+        }
+        index->slots[slot].hash = hash;
+        index->slots[slot].index = i + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Finds a key in a key index.
+ * @param index The key index.
+ * @param entries The entries the index was built over.
+ * @param key The key to find.
+ * @param hash The hash of the key (see @ref confin_hash_key).
+ * @return The index of the entry, or UINT64_MAX if the key is not present.
+ */
+uint64_t confin_keyindex_find(const confin_keyindex_t *index, const cfentry_t *entries, const char *key, uint64_t hash) {
+    uint64_t slot = hash & index->mask;
+    while (index->slots[slot].index) {
+        const confin_keyslot_t *candidate = &index->slots[slot];
+        if (candidate->hash == hash &&
+            strncmp(entries[candidate->index - 1].key, key, __CONFIN_STRUCT_MAX_KEYLEN) == 0) {
+            return candidate->index - 1;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+    return UINT64_MAX;
+}
+
+/**
+ * @brief Frees the slots of a key index.
+ * @param index The key index.
+ * @param allocator The allocator the index was built with.
+ */
+void confin_keyindex_free(confin_keyindex_t *index, const cfallocator_t *allocator) {
+    confin_free(allocator, index->slots);
+    index->slots = NULL;
+    index->mask = 0;
+}
+
+/**
+ * @brief Reads the layout block that follows the header.
+ * 
+ * Files older than @ref __CONFIN_LAYOUT_VERSION have no layout block; the layout is
+ * zeroed for them.
+ * 
+ * @param probe The probe of the call.
+ * @param file The file positioned right after the header.
+ * @param header The header already read from the file.
+ * @param layout The layout to fill.
+ * @return true on success, false if the file is truncated.
+ */
+static bool confin_read_layout(confin_probe_t *probe, FILE *file, const cfheader_t *header, cflayout_t *layout) {
+    memset(layout, 0, sizeof(*layout));
+    if (header->version < __CONFIN_LAYOUT_VERSION) {
+        return true;
+    }
+    return confin_probe_read(probe, CONFIN_PHASE_HEADER, layout, sizeof(cflayout_t), file);
+}
+
+/**
+ * @brief Loads the body of a configuration file.
+ * 
+ * Reads the layout block, the value pool and all entries that follow the header.
+ * 
+ * @param probe The probe of the call.
+ * @param file The file positioned right after the header.
+ * @param header The header already read from the file.
+ * @param allocator The allocator for the structure, its pool and values.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+static cffile_t *confin_load(confin_probe_t *probe, FILE *file, const cfheader_t *header, const cfallocator_t *allocator) {
+    cflayout_t layout;
+    if (!confin_read_layout(probe, file, header, &layout)) {
+        fprintf(stderr, "Unexpected end of file\n");
+        return NULL;
+    }
+
+    cffile_t *config = (cffile_t*)confin_probe_alloc(probe, allocator, sizeof(cffile_t) + sizeof(cfentry_t) * header->entrycount);
+    if (!config) {
+        perror("malloc");
+        return NULL;
+    }
+
+    config->header = *header;
+    config->header.entrycount = 0;
+    config->layout = layout;
+    config->pool = NULL;
+    config->allocator = *allocator;
+    config->generation = confin_next_generation();
+    config->index = NULL;
+
+    bool pooled = (layout.flags & CONFIN_LAYOUT_POOLED) != 0;
+    if (pooled) {
+        config->pool = confin_probe_alloc(probe, allocator, layout.poolsize ? layout.poolsize : 1);
+        if (!config->pool) {
+            perror("malloc");
+            confin_free_config_file(config);
+            return NULL;
+        }
+        if (!confin_probe_read(probe, CONFIN_PHASE_VALUES, config->pool, layout.poolsize, file)) {
+            fprintf(stderr, "Unexpected end of file\n");
+            confin_free_config_file(config);
+            return NULL;
+        }
+    }
+
+    for (uint64_t i = 0; i < header->entrycount; ++i) {
+        cfentryhdr_t hdr;
+        if (!confin_probe_read(probe, CONFIN_PHASE_ENTRIES, &hdr, sizeof(cfentryhdr_t), file)) {
+            fprintf(stderr, "Unexpected end of file\n");
+            confin_free_config_file(config);
+            return NULL;
+        }
+
+        cfentry_t *entry = &config->entries[i];
+        confin_entry_from_header(&hdr, entry);
+        if (confin_probe_on(probe)) {
+            probe->stats.entries++;
+        }
+
+        if (pooled) {
+            uint64_t offset;
+            if (!confin_probe_read(probe, CONFIN_PHASE_ENTRIES, &offset, sizeof(offset), file)) {
+                fprintf(stderr, "Unexpected end of file\n");
+                confin_free_config_file(config);
+                return NULL;
+            }
+            if (offset > layout.poolsize || entry->size > layout.poolsize - offset) {
+                fprintf(stderr, "Invalid pool offset\n");
+                confin_free_config_file(config);
+                return NULL;
+            }
+            entry->value = (unsigned char*)config->pool + offset;
+            entry->flags |= CONFIN_ENTRY_SHARED;
+            config->header.entrycount = i + 1;
+            continue;
+        }
+
+        if (entry->size <= __CONFIN_INLINE_VALUE_MAX) {
+            entry->flags |= CONFIN_ENTRY_INLINE;
+            entry->value = entry->inlinevalue;
+            config->header.entrycount = i + 1;
+            if (!confin_probe_read(probe, CONFIN_PHASE_VALUES, entry->inlinevalue, entry->size, file)) {
+                fprintf(stderr, "Unexpected end of file\n");
+                confin_free_config_file(config);
+                return NULL;
+            }
+            continue;
+        }
+
+        entry->value = confin_probe_alloc(probe, allocator, entry->size);
+        if (!entry->value) {
+            perror("malloc");
+            confin_free_config_file(config);
+            return NULL;
+        }
+        config->header.entrycount = i + 1;
+
+        if (!confin_probe_read(probe, CONFIN_PHASE_VALUES, entry->value, entry->size, file)) {
+            fprintf(stderr, "Unexpected end of file\n");
+            confin_free_config_file(config);
+            return NULL;
+        }
+    }
+
+    return config;
+}
+
+/**
+ * @brief Writes the entries of a pooled configuration file.
+ * 
+ * Identical values are detected by hashing and stored once in the value pool,
+ * every entry then references its payload by pool offset.
+ * 
+ * @param probe The probe of the call.
+ * @param file The file positioned right after the header.
+ * @param entries Array of configuration entries to write.
+ * @param entrycount Number of configuration entries.
+ * @param allocator The allocator for the temporary tables.
+ * @return true on success, false if memory could not be allocated.
+ */
+static bool confin_write_pooled(confin_probe_t *probe, FILE *file, cfentry_t *entries, uint64_t entrycount, const cfallocator_t *allocator) {
+    uint64_t capacity = 16;
+    while (capacity < entrycount * 2) {
+        capacity <<= 1;
+    }
+
+    // Each slot holds the index of the first entry carrying a distinct value, plus one
+    uint64_t *slots = (uint64_t*)confin_probe_alloc_zeroed(probe, allocator, sizeof(uint64_t) * capacity);
+    uint64_t *offsets = (uint64_t*)confin_probe_alloc(probe, allocator, sizeof(uint64_t) * (entrycount ? entrycount : 1));
+    unsigned char *owners = (unsigned char*)confin_probe_alloc_zeroed(probe, allocator, entrycount ? entrycount : 1);
+    if (!slots || !offsets || !owners) {
+        perror("malloc");
+        confin_free(allocator, slots);
+        confin_free(allocator, offsets);
+        confin_free(allocator, owners);
+        return false;
+    }
+
+    cflayout_t layout = {CONFIN_LAYOUT_POOLED, 0};
+    uint64_t start = confin_probe_clock(probe);
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        uint64_t hash = confin_hash_bytes(CF_ENTRYVAL(&entries[i]), entries[i].size) ^ entries[i].size;
+        uint64_t slot = hash & (capacity - 1);
+        while (slots[slot]) {
+            const cfentry_t *other = &entries[slots[slot] - 1];
+            if (other->size == entries[i].size && memcmp(CF_ENTRYVAL(other), CF_ENTRYVAL(&entries[i]), entries[i].size) == 0) {
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+
+        if (slots[slot]) {
+            offsets[i] = offsets[slots[slot] - 1];
+            continue;
+        }
+
+        slots[slot] = i + 1;
+        owners[i] = 1;
+        layout.poolsize = (layout.poolsize + __CONFIN_POOL_ALIGN - 1) & ~(uint64_t)(__CONFIN_POOL_ALIGN - 1);
+        offsets[i] = layout.poolsize;
+        layout.poolsize += entries[i].size;
+    }
+    confin_probe_phase(probe, CONFIN_PHASE_PROCESS, start);
+
+    confin_probe_write(probe, CONFIN_PHASE_HEADER, &layout, sizeof(cflayout_t), file);
+
+    // Distinct payloads were given increasing offsets in entry order
+    static const unsigned char padding[__CONFIN_POOL_ALIGN] = {0};
+    uint64_t position = 0;
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        if (!owners[i]) {
+            continue;
+        }
+        confin_probe_write(probe, CONFIN_PHASE_VALUES, padding, offsets[i] - position, file);
+        confin_probe_write(probe, CONFIN_PHASE_VALUES, CF_ENTRYVAL(&entries[i]), entries[i].size, file);
+        position = offsets[i] + entries[i].size;
+    }
+
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        cfentryhdr_t hdr;
+        confin_entry_to_header(&entries[i], &hdr);
+        confin_probe_write(probe, CONFIN_PHASE_ENTRIES, &hdr, sizeof(cfentryhdr_t), file);
+        confin_probe_write(probe, CONFIN_PHASE_ENTRIES, &offsets[i], sizeof(uint64_t), file);
+    }
+    if (confin_probe_on(probe)) {
+        probe->stats.entries += entrycount;
+    }
+
+    confin_free(allocator, slots);
+    confin_free(allocator, offsets);
+    confin_free(allocator, owners);
+    return true;
+}
+
+/* cfctx implementation */
+
+/**
+ * @brief Sets the global allocator.
+ * 
+ * The allocator is copied. It is used by every allocation that is not made with
+ * a context overriding it.
+ * 
+ * @param allocator The allocator to install, or NULL to restore `malloc`/`realloc`/`free`.
+ */
+void confin_set_allocator(const cfallocator_t *allocator) {
+    if (!allocator) {
+        confin_global_allocator.alloc = confin_default_alloc;
+        confin_global_allocator.realloc = confin_default_realloc;
+        confin_global_allocator.free = confin_default_free;
+        confin_global_allocator.userdata = NULL;
+        return;
+    }
+    confin_global_allocator = *allocator;
+}
+
+/**
+ * @brief Gets the global allocator.
+ * 
+ * @return The global allocator.
+ */
+const cfallocator_t *confin_get_allocator(void) {
+    return &confin_global_allocator;
+}
+
+/* cfstats implementation */
+
+/**
+ * @brief Enables or disables the global counters.
+ * @param enable true to collect the global counters.
+ */
+void confin_enable_stats(bool enable) {
+#if __CONFIN_ENABLE_STATS
+    confin_stats_enabled = enable;
+#else
+    (void)enable;
+#endif
+}
+
+/**
+ * @brief Gets a snapshot of the global counters.
+ * @param stats The structure to fill.
+ */
+void confin_get_stats(cfstats_t *stats) {
+#if __CONFIN_ENABLE_STATS
+    *stats = confin_global_stats;
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+}
+
+/**
+ * @brief Resets the global counters.
+ */
+void confin_reset_stats(void) {
+#if __CONFIN_ENABLE_STATS
+    memset(&confin_global_stats, 0, sizeof(confin_global_stats));
+#endif
+}
+
+/**
+ * @brief Sets the global trace callback.
+ * @param trace The callback, or NULL to remove it.
+ * @param userdata User context passed to the callback.
+ */
+void confin_set_trace(cftracefn_t trace, void *userdata) {
+#if __CONFIN_ENABLE_STATS
+    confin_global_trace = trace;
+    confin_global_tracedata = userdata;
+#else
+    (void)trace;
+    (void)userdata;
+#endif
+}
+
+/**
+ * @brief Gets the name of an operation.
+ * @param op The operation.
+ * @return The name of the operation.
+ */
+const char *confin_op_name(cfop_t op) {
+    static const char *names[CONFIN_OP_COUNT] = {"read", "write", "validate", "scan"};
+    return (unsigned)op < CONFIN_OP_COUNT ? names[op] : "unknown";
+}
+
+/**
+ * @brief Gets the name of a phase.
+ * @param phase The phase.
+ * @return The name of the phase.
+ */
+const char *confin_phase_name(cfphase_t phase) {
+    static const char *names[CONFIN_PHASE_COUNT] = {"open", "header", "entries", "values", "alloc", "process", "close"};
+    return (unsigned)phase < CONFIN_PHASE_COUNT ? names[phase] : "unknown";
+}
 
 /* cfio implementation */
 
@@ -28,21 +841,98 @@
  * @param entrycount Number of configuration entries.
  */
 void confin_write_config(const char *filename, cfentry_t *entries, uint64_t entrycount) {
-    FILE *file = fopen(filename, "wb");
+    confin_write_config_ex(filename, entries, entrycount, 0);
+}
+
+/**
+ * @brief Writes the configuration to a file with writer options.
+ * 
+ * This function writes an array of configuration entries to a specified file.
+ * With @ref CONFIN_WRITE_DEDUP every distinct value is stored once in a value
+ * pool and entries reference it by offset. With @ref CONFIN_WRITE_OFFSETS an
+ * offset table is appended for parallel loading; pooled files do not need one
+ * since their entry records have a fixed size.
+ * 
+ * @param filename The name of the file to write the configuration to.
+ * @param entries Array of configuration entries to write.
+ * @param entrycount Number of configuration entries.
+ * @param flags Writer options (CONFIN_WRITE_*).
+ */
+void confin_write_config_ex(const char *filename, cfentry_t *entries, uint64_t entrycount, uint32_t flags) {
+    confin_write_config_ctx(filename, entries, entrycount, flags, NULL);
+}
+
+/**
+ * @brief Writes the configuration to a file with writer options and a context.
+ * 
+ * Same as @ref confin_write_config_ex; temporary memory is allocated with the
+ * allocator of the context.
+ * 
+ * @param filename The name of the file to write the configuration to.
+ * @param entries Array of configuration entries to write.
+ * @param entrycount Number of configuration entries.
+ * @param flags Writer options (CONFIN_WRITE_*).
+ * @param ctx The context of the call, or NULL for the global settings.
+ */
+void confin_write_config_ctx(const char *filename, cfentry_t *entries, uint64_t entrycount, uint32_t flags, cfcontext_t *ctx) {
+    confin_probe_t probe;
+    confin_probe_begin(&probe, CONFIN_OP_WRITE, ctx);
+
+    FILE *file = confin_probe_fopen(&probe, filename, "wb");
     if (!file) {
         perror("fopen");
+        confin_probe_end(&probe);
         return;
     }
 
     cfheader_t header = {__CONFIN_STRUCT_MAGIC_NUMBER, _CF_VER, entrycount};
-    fwrite(&header, sizeof(cfheader_t), 1, file);
+    confin_probe_write(&probe, CONFIN_PHASE_HEADER, &header, sizeof(cfheader_t), file);
 
-    for (uint32_t i = 0; i < entrycount; ++i) {
-        fwrite(&entries[i], sizeof(cfentry_t) - sizeof(void*), 1, file);
-        fwrite(entries[i].value, entries[i].size, 1, file);
+    if (flags & CONFIN_WRITE_DEDUP) {
+        cfallocator_t allocator = confin_resolve_allocator(ctx);
+        confin_write_pooled(&probe, file, entries, entrycount, &allocator);
+        confin_probe_fclose(&probe, file);
+        confin_probe_end(&probe);
+        return;
     }
 
-    fclose(file);
+    // Positions of every __CONFIN_OFFSET_STRIDE-th entry, written after the entries
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    cfoffsettable_t table = {__CONFIN_OFFSET_STRIDE, (entrycount + __CONFIN_OFFSET_STRIDE - 1) / __CONFIN_OFFSET_STRIDE};
+    uint64_t *offsets = NULL;
+    if (flags & CONFIN_WRITE_OFFSETS) {
+        offsets = (uint64_t*)confin_probe_alloc(&probe, &allocator, sizeof(uint64_t) * (table.count ? table.count : 1));
+        if (!offsets) {
+            perror("malloc");
+        }
+    }
+
+    cflayout_t layout = {offsets ? CONFIN_LAYOUT_OFFSETS : 0, 0};
+    confin_probe_write(&probe, CONFIN_PHASE_HEADER, &layout, sizeof(cflayout_t), file);
+
+    uint64_t position = sizeof(cfheader_t) + sizeof(cflayout_t);
+    for (uint64_t i = 0; i < entrycount; ++i) {
+        if (offsets && i % __CONFIN_OFFSET_STRIDE == 0) {
+            offsets[i / __CONFIN_OFFSET_STRIDE] = position;
+        }
+        cfentryhdr_t hdr;
+        confin_entry_to_header(&entries[i], &hdr);
+        confin_probe_write(&probe, CONFIN_PHASE_ENTRIES, &hdr, sizeof(cfentryhdr_t), file);
+        confin_probe_write(&probe, CONFIN_PHASE_VALUES, CF_ENTRYVAL(&entries[i]), entries[i].size, file);
+        position += sizeof(cfentryhdr_t) + entries[i].size;
+    }
+    if (confin_probe_on(&probe)) {
+        probe.stats.entries += entrycount;
+    }
+
+    if (offsets) {
+        confin_probe_write(&probe, CONFIN_PHASE_ENTRIES, offsets, sizeof(uint64_t) * table.count, file);
+        confin_probe_write(&probe, CONFIN_PHASE_ENTRIES, &table, sizeof(cfoffsettable_t), file);
+        confin_free(&allocator, offsets);
+    }
+
+    confin_probe_fclose(&probe, file);
+    confin_probe_end(&probe);
 }
 
 /**
@@ -61,46 +951,50 @@ void confin_write_config_file(const char *filename, cffile_t *file) {
  * @brief Reads the configuration from a file.
  * 
  * This function reads the configuration from the specified file and returns
- * a pointer to the configuration file structure.
+ * a pointer to the configuration file structure. Values of a pooled file
+ * point into a single shared pool owned by the returned structure.
  * 
  * @param filename The name of the file to read the configuration from.
  * @return Pointer to the configuration file structure, or NULL on failure.
  */
 cffile_t *confin_read_config(const char *filename) {
-    FILE *file = fopen(filename, "rb");
+    return confin_read_config_ctx(filename, NULL);
+}
+
+/**
+ * @brief Reads the configuration from a file with a context.
+ * 
+ * Same as @ref confin_read_config; the returned structure, its pool and values are
+ * allocated with the allocator of the context, which is remembered for
+ * @ref confin_free_config_file.
+ * 
+ * @param filename The name of the file to read the configuration from.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return Pointer to the configuration file structure, or NULL on failure.
+ */
+cffile_t *confin_read_config_ctx(const char *filename, cfcontext_t *ctx) {
+    confin_probe_t probe;
+    confin_probe_begin(&probe, CONFIN_OP_READ, ctx);
+
+    FILE *file = confin_probe_fopen(&probe, filename, "rb");
     if (!file) {
         perror("fopen");
+        confin_probe_end(&probe);
         return NULL;
     }
 
     cfheader_t header;
-    size_t items_read;
-
-    items_read = fread(&header, sizeof(cfheader_t), 1, file);
-
-    cffile_t *config = (cffile_t*)malloc(sizeof(cfheader_t) + sizeof(cfentry_t) * header.entrycount);
-    if (!config) {
-        perror("malloc");
-        fclose(file);
+    if (!confin_probe_read(&probe, CONFIN_PHASE_HEADER, &header, sizeof(cfheader_t), file)) {
+        fprintf(stderr, "Unexpected end of file\n");
+        confin_probe_fclose(&probe, file);
+        confin_probe_end(&probe);
         return NULL;
     }
 
-    config->header = header;
-    for (uint32_t i = 0; i < header.entrycount; ++i) {
-        items_read = fread(&config->entries[i], sizeof(cfentry_t) - sizeof(void*), 1, file);
-
-        config->entries[i].value = malloc(config->entries[i].size);
-        if (!config->entries[i].value) {
-            perror("malloc");
-            fclose(file);
-            free(config);
-            return NULL;
-        }
-
-        items_read = fread(config->entries[i].value, config->entries[i].size, 1, file);
-    }
-    (void)items_read;
-    fclose(file);
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    cffile_t *config = confin_load(&probe, file, &header, &allocator);
+    confin_probe_fclose(&probe, file);
+    confin_probe_end(&probe);
     return config;
 }
 
@@ -119,6 +1013,24 @@ cffile_t *confin_read_config(const char *filename) {
  * @return The created configuration entry.
  */
 cfentry_t confin_create_config_entry(const char *key, cfannotype_t type, const void *value, uint64_t size) {
+    return confin_create_config_entry_ctx(key, type, value, size, NULL);
+}
+
+/**
+ * @brief Creates a configuration entry with a context.
+ * 
+ * Same as @ref confin_create_config_entry; a value that is not stored inline is
+ * allocated with the allocator of the context. Free the entry with
+ * @ref confin_free_config_entry_ctx and the same context.
+ * 
+ * @param key The key for the configuration entry.
+ * @param type The type of the value (see @ref cfannotype_t).
+ * @param value The value to be stored in the configuration entry.
+ * @param size The size of the value.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return The created configuration entry.
+ */
+cfentry_t confin_create_config_entry_ctx(const char *key, cfannotype_t type, const void *value, uint64_t size, cfcontext_t *ctx) {
     cfentry_t entry;
     #ifdef _MSC_VER
     strncpy_s(entry.key, sizeof(entry.key), key, _TRUNCATE);
@@ -127,8 +1039,10 @@ cfentry_t confin_create_config_entry(const char *key, cfannotype_t type, const v
     entry.key[__CONFIN_STRUCT_MAX_KEYLEN - 1] = '\0'; // Ensure null-termination
     #endif
     entry.type = type;
+    entry.flags = 0;
     entry.size = size;
-    entry.value = malloc(size);
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    entry.value = confin_alloc(&allocator, size);
     if (entry.value) {
         memcpy(entry.value, value, size);
     } else {
@@ -146,8 +1060,29 @@ cfentry_t confin_create_config_entry(const char *key, cfannotype_t type, const v
  * @param entry Pointer to the configuration entry to be freed.
  */
 void confin_free_config_entry(cfentry_t *entry) {
+    confin_free_config_entry_ctx(entry, NULL);
+}
+
+/**
+ * @brief Frees a configuration entry with a context.
+ * 
+ * Same as @ref confin_free_config_entry; the value is freed with the allocator of
+ * the context.
+ * 
+ * @param entry Pointer to the configuration entry to be freed.
+ * @param ctx The context of the call, or NULL for the global settings.
+ */
+void confin_free_config_entry_ctx(cfentry_t *entry, cfcontext_t *ctx) {
+    if (entry->flags & CONFIN_ENTRY_INLINE) {
+        entry->flags &= ~CONFIN_ENTRY_INLINE;
+        entry->value = NULL;
+        return;
+    }
     if (entry->value) {
-        free(entry->value);
+        if (!(entry->flags & CONFIN_ENTRY_SHARED)) {
+            cfallocator_t allocator = confin_resolve_allocator(ctx);
+            confin_free(&allocator, entry->value);
+        }
         entry->value = NULL;
     }
 }
@@ -165,13 +1100,13 @@ void confin_display_config_entry(const cfentry_t *entry) {
 
     switch (entry->type) {
         case CONFIN_ANNOTYPE_INT:
-            printf("Value: %d\n", CF_UNREF_ENTRYVAL(entry->value, int));
+            printf("Value: %d\n", CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), int));
             break;
         case CONFIN_ANNOTYPE_FLOAT:
-            printf("Value: %f\n", CF_UNREF_ENTRYVAL(entry->value, float));
+            printf("Value: %f\n", CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), float));
             break;
         case CONFIN_ANNOTYPE_STRING:
-            printf("Value: %s\n", CF_REF_ENTRYVAL(entry->value, char));
+            printf("Value: %s\n", CF_REF_ENTRYVAL(CF_ENTRYVAL(entry), char));
             break;
         default:
             printf("Unknown type\n");
@@ -183,15 +1118,23 @@ void confin_display_config_entry(const cfentry_t *entry) {
  * @brief Frees a configuration file.
  * 
  * This function frees the memory allocated for a configuration file, including
- * its header and entries.
+ * its header, entries and value pool, with the allocator it was created with.
  * 
  * @param config Pointer to the configuration file to be freed.
  */
 void confin_free_config_file(cffile_t *config) {
-    for (uint32_t i = 0; i < config->header.entrycount; ++i) {
-        confin_free_config_entry(&config->entries[i]);
+    cfcontext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.allocator = config->allocator;
+    for (uint64_t i = 0; i < config->header.entrycount; ++i) {
+        confin_free_config_entry_ctx(&config->entries[i], &ctx);
     }
-    free(config);
+    if (config->index) {
+        confin_keyindex_free((confin_keyindex_t*)config->index, &ctx.allocator);
+        confin_free(&ctx.allocator, config->index);
+    }
+    confin_free(&ctx.allocator, config->pool);
+    confin_free(&ctx.allocator, config);
 }
 
 /* cffmt implementation */
@@ -202,60 +1145,53 @@ void confin_free_config_file(cffile_t *config) {
  * @return true if the file format is valid, false otherwise.
  */
 bool confin_validate_file(const char *filename) {
-    FILE *file = fopen(filename, "rb");
+    return confin_validate_file_ctx(filename, NULL);
+}
+
+/**
+ * @brief Function to validate if a file conforms to the Confin format with a context.
+ * @param filename The name of the file to validate.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return true if the file format is valid, false otherwise.
+ */
+bool confin_validate_file_ctx(const char *filename, cfcontext_t *ctx) {
+    confin_probe_t probe;
+    confin_probe_begin(&probe, CONFIN_OP_VALIDATE, ctx);
+
+    FILE *file = confin_probe_fopen(&probe, filename, "rb");
     if (!file) {
         perror("fopen");
+        confin_probe_end(&probe);
         return 0;
     }
 
     cfheader_t header;
-    size_t items_read;
-    items_read = fread(&header, sizeof(cfheader_t), 1, file);
-
-    if (header.magic != __CONFIN_STRUCT_MAGIC_NUMBER) {
+    bool valid = confin_probe_read(&probe, CONFIN_PHASE_HEADER, &header, sizeof(cfheader_t), file);
+    if (!valid) {
+        fprintf(stderr, "Unexpected end of file\n");
+    } else if (header.magic != __CONFIN_STRUCT_MAGIC_NUMBER) {
         fprintf(stderr, "Invalid magic number\n");
-        fclose(file);
-        return 0;
-    }
-
-    if (header.version > _CF_VER) {
+        valid = 0;
+    } else if (header.version > _CF_VER) {
         // Unable to read confin format when the version of the confin library used in the file is higher than the current one, update the library
         fprintf(stderr, "Invalid version\n");
-        fclose(file);
-        return 0;
-    }
-
-    cffile_t *config = (cffile_t*)malloc(sizeof(cfheader_t) + sizeof(cfentry_t) * header.entrycount);
-    if (!config) {
-        perror("malloc");
-        fclose(file);
-        return 0;
+        valid = 0;
     }
 
-    config->header = header;
-    for (uint32_t i = 0; i < header.entrycount; ++i) {
-        items_read = fread(&config->entries[i], sizeof(cfentry_t) - sizeof(void*), 1, file);
+    if (valid) {
+        cfallocator_t allocator = confin_resolve_allocator(ctx);
+        cffile_t *config = confin_load(&probe, file, &header, &allocator);
+        valid = config != NULL;
 
-        config->entries[i].value = malloc(config->entries[i].size);
-        if (!config->entries[i].value) {
-            perror("malloc");
-            fclose(file);
-            free(config);
-            return 0;
+        // Free allocated memory
+        if (config) {
+            confin_free_config_file(config);
         }
-
-        items_read = fread(config->entries[i].value, config->entries[i].size, 1, file);
     }
 
-    fclose(file);
-
-    // Free allocated memory
-    for (uint32_t i = 0; i < header.entrycount; ++i) {
-        free(config->entries[i].value);
-    }
-    free(config);
-    (void)items_read;
-    return 1;
+    confin_probe_fclose(&probe, file);
+    confin_probe_end(&probe);
+    return valid;
 }
 
 /**
@@ -266,47 +1202,47 @@ bool confin_validate_file(const char *filename) {
  * @return true if the file format is valid and information is displayed, false otherwise.
  */
 bool confin_scan_file(const char *filename, char *output, size_t output_size) {
-    FILE *file = fopen(filename, "rb");
+    return confin_scan_file_ctx(filename, output, output_size, NULL);
+}
+
+/**
+ * @brief Function to scan and write all information from a Confin format file to a string with a context.
+ * @param filename The name of the file to scan.
+ * @param output The output string in which information about the file will be written.
+ * @param output_size Buffer size for output string.
+ * @param ctx The context of the call, or NULL for the global settings.
+ * @return true if the file format is valid and information is displayed, false otherwise.
+ */
+bool confin_scan_file_ctx(const char *filename, char *output, size_t output_size, cfcontext_t *ctx) {
+    confin_probe_t probe;
+    confin_probe_begin(&probe, CONFIN_OP_SCAN, ctx);
+
+    FILE *file = confin_probe_fopen(&probe, filename, "rb");
     if (!file) {
         perror("fopen");
+        confin_probe_end(&probe);
         return false;
     }
 
     cfheader_t header;
-    size_t items_read;
-    items_read = fread(&header, sizeof(cfheader_t), 1, file);
-
-    if (header.magic != __CONFIN_STRUCT_MAGIC_NUMBER) {
+    if (!confin_probe_read(&probe, CONFIN_PHASE_HEADER, &header, sizeof(cfheader_t), file) ||
+        header.magic != __CONFIN_STRUCT_MAGIC_NUMBER) {
         snprintf(output, output_size, "Invalid magic number\n");
-        fclose(file);
+        confin_probe_fclose(&probe, file);
+        confin_probe_end(&probe);
         return false;
     }
 
-    cffile_t *config = (cffile_t*)malloc(sizeof(cfheader_t) + sizeof(cfentry_t) * header.entrycount);
+    cfallocator_t allocator = confin_resolve_allocator(ctx);
+    cffile_t *config = confin_load(&probe, file, &header, &allocator);
+    confin_probe_fclose(&probe, file);
     if (!config) {
-        perror("malloc");
-        fclose(file);
+        confin_probe_end(&probe);
         return false;
     }
 
-    config->header = header;
-    for (uint32_t i = 0; i < header.entrycount; ++i) {
-        items_read = fread(&config->entries[i], sizeof(cfentry_t) - sizeof(void*), 1, file);
-
-        config->entries[i].value = malloc(config->entries[i].size);
-        if (!config->entries[i].value) {
-            perror("malloc");
-            fclose(file);
-            free(config);
-            return false;
-        }
-
-        items_read = fread(config->entries[i].value, config->entries[i].size, 1, file);
-    }
-
-    fclose(file);
-
     // Prepare the output string
+    uint64_t start = confin_probe_clock(&probe);
     char *ptr = output;
     size_t remaining_size = output_size;
     int written;
@@ -351,7 +1287,7 @@ bool confin_scan_file(const char *filename, char *output, size_t output_size) {
         remaining_size -= written;
 
         for (uint32_t j = 0; j < config->entries[i].size; ++j) {
-            written = snprintf(ptr, remaining_size, "%02X ", ((unsigned char*)config->entries[i].value)[j]);
+            written = snprintf(ptr, remaining_size, "%02X ", ((unsigned char*)CF_ENTRYVAL(&config->entries[i]))[j]);
             ptr += written;
             remaining_size -= written;
         }
@@ -361,11 +1297,10 @@ bool confin_scan_file(const char *filename, char *output, size_t output_size) {
         remaining_size -= written;
     }
 
+    confin_probe_phase(&probe, CONFIN_PHASE_PROCESS, start);
+    confin_probe_end(&probe);
+
     // Free allocated memory
-    for (uint32_t i = 0; i < header.entrycount; ++i) {
-        free(config->entries[i].value);
-    }
-    free(config);
-    (void)items_read;
+    confin_free_config_file(config);
     return true;
 }
\ No newline at end of file
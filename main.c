@@ -5,6 +5,26 @@ void test_write_read_config();
 void test_validate_config();
 void test_scan_config();
 void test_create_free_entries();
+void test_dedup_config();
+void test_initialized_entries();
+void test_inline_values();
+void test_allocator_hooks();
+void test_stats();
+void test_diff_delta();
+void test_diff_duplicate_keys();
+void test_compile_sources();
+void test_export_json();
+void test_bind_struct();
+void test_key_handles();
+void test_get_many();
+void test_streaming_writer();
+void test_parallel_load();
+void test_mutable_config();
+void test_version_history();
+void test_config_server();
+void test_sharded_config();
+void test_frozen_config();
+void test_compact_config();
 void cleanup_test_files();
 
 int main() {
@@ -12,6 +32,26 @@ int main() {
     test_validate_config();
     test_scan_config();
     test_create_free_entries();
+    test_dedup_config();
+    test_initialized_entries();
+    test_inline_values();
+    test_allocator_hooks();
+    test_stats();
+    test_diff_delta();
+    test_diff_duplicate_keys();
+    test_compile_sources();
+    test_export_json();
+    test_bind_struct();
+    test_key_handles();
+    test_get_many();
+    test_streaming_writer();
+    test_parallel_load();
+    test_mutable_config();
+    test_version_history();
+    test_config_server();
+    test_sharded_config();
+    test_frozen_config();
+    test_compact_config();
 
     printf("$ All tests passed.\n");
     cleanup_test_files();
@@ -16,6 +16,43 @@
 #include "../confin/cfio.h"
 #include "../confin/cfutils.h"
 #include "../confin/cffmt.h"
+#include "../confin/cfctx.h"
+#include "../confin/cfstats.h"
+#include "../confin/cfdiff.h"
+#include "../confin/cfcompile.h"
+#include "../confin/cfexport.h"
+#include "../confin/cfbind.h"
+#include "../confin/cflookup.h"
+#include "../confin/cfwriter.h"
+#include "../confin/cfparallel.h"
+#include "../confin/cfmutable.h"
+#include "../confin/cfserver.h"
+#include "../confin/cfclient.h"
+#include "../confin/cfshard.h"
+#include "../confin/cffrozen.h"
+#include "../confin/cfcompact.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_test_directory(name) _mkdir(name)
+#else
+#include <sys/stat.h>
+#define make_test_directory(name) mkdir(name, 0755)
+#endif
+
+// Like assert, but evaluated and enforced in every build, so the tests also run under NDEBUG
+#define CHECK(expr) \
+    do { \
+        if (!(expr)) { \
+            fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, #expr); \
+            abort(); \
+        } \
+    } while (0)
 
 struct Structure {
     int x, y;
@@ -163,12 +200,1432 @@ void test_create_free_entries() {
     assert(int_entry.value == NULL);
 }
 
+// Test for writing a configuration with a deduplicated value pool
+void test_dedup_config() {
+    const char *string_value = "default";
+    int int_value = 7;
+    cfentry_t entries[6];
+    entries[0] = cfcreatecfgentry("shard.0", CONFIN_ANNOTYPE_STRING, string_value, strlen(string_value) + 1);
+    entries[1] = cfcreatecfgentry("shard.1", CONFIN_ANNOTYPE_STRING, string_value, strlen(string_value) + 1);
+    entries[2] = cfcreatecfgentry("limit.0", CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value));
+    entries[3] = cfcreatecfgentry("shard.2", CONFIN_ANNOTYPE_STRING, string_value, strlen(string_value) + 1);
+    entries[4] = cfcreatecfgentry("limit.1", CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value));
+    entries[5] = cfcreatecfgentry("name", CONFIN_ANNOTYPE_STRING, "other", 6);
+
+    cfwritecfg("config_test_plain.bin", entries, 6);
+    cfwritecfgex("config_test_dedup.bin", entries, 6, CONFIN_WRITE_DEDUP);
+    for (int i = 0; i < 6; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+
+    assert(cfvalidatefile("config_test_dedup.bin") == true);
+
+    cffile_t *plain = cfreadcfg("config_test_plain.bin");
+    cffile_t *dedup = cfreadcfg("config_test_dedup.bin");
+    assert(plain != NULL && dedup != NULL);
+    assert(plain->pool == NULL);
+    assert(dedup->layout.flags & CONFIN_LAYOUT_POOLED);
+    assert(dedup->layout.poolsize < 32);
+    assert(dedup->header.entrycount == 6);
+
+    for (int i = 0; i < 6; ++i) {
+        assert(strcmp(plain->entries[i].key, dedup->entries[i].key) == 0);
+        assert(plain->entries[i].size == dedup->entries[i].size);
+        assert(memcmp(plain->entries[i].value, dedup->entries[i].value, plain->entries[i].size) == 0);
+    }
+
+    // Identical values share one payload in the pool
+    assert(dedup->entries[0].value == dedup->entries[1].value);
+    assert(dedup->entries[0].value == dedup->entries[3].value);
+    assert(dedup->entries[2].value == dedup->entries[4].value);
+    assert(dedup->entries[0].value != dedup->entries[5].value);
+    assert(CF_UNREF_ENTRYVAL(dedup->entries[4].value, int) == 7);
+
+    cffreecfgfile(plain);
+    cffreecfgfile(dedup);
+}
+
+// Test for entries built by hand, without setting the storage flags
+void test_initialized_entries() {
+    int int_value = 11;
+    cfentry_t entries[1];
+    memset(entries, 0, sizeof(entries));
+    strcpy(entries[0].key, "init_key");
+    entries[0].type = CONFIN_ANNOTYPE_INT;
+    entries[0].size = sizeof(int_value);
+    entries[0].value = &int_value;
+    assert(CF_ENTRYVAL(&entries[0]) == (void*)&int_value);
+
+    cfwritecfg("config_test_initialized.bin", entries, 1);
+    cffile_t *config = cfreadcfg("config_test_initialized.bin");
+    assert(config != NULL && config->header.entrycount == 1);
+    assert(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(&config->entries[0]), int) == 11);
+    cffreecfgfile(config);
+}
+
+// Test for small values stored inline in the entries
+void test_inline_values() {
+    int int_value = 1234;
+    char big_value[__CONFIN_INLINE_VALUE_MAX + 1];
+    memset(big_value, 'x', sizeof(big_value));
+
+    cfentry_t entries[2];
+    entries[0] = cfcreatecfgentry("small", CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value));
+    entries[1] = cfcreatecfgentry("big", CONFIN_ANNOTYPE_STRUCT, big_value, sizeof(big_value));
+    cfwritecfg("config_test_inline.bin", entries, 2);
+    cffreecfgentry(&entries[0]);
+    cffreecfgentry(&entries[1]);
+
+    cffile_t *config = cfreadcfg("config_test_inline.bin");
+    assert(config != NULL);
+    assert(config->entries[0].flags & CONFIN_ENTRY_INLINE);
+    assert(CF_ENTRYVAL(&config->entries[0]) == (void*)config->entries[0].inlinevalue);
+    assert(config->entries[0].value == (void*)config->entries[0].inlinevalue);
+    assert(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(&config->entries[0]), int) == 1234);
+    assert(!(config->entries[1].flags & CONFIN_ENTRY_INLINE));
+    assert(memcmp(CF_ENTRYVAL(&config->entries[1]), big_value, sizeof(big_value)) == 0);
+    cffreecfgfile(config);
+}
+
+// Allocator counting the live blocks it hands out
+struct CountingAllocator {
+    int allocs, frees;
+};
+
+static void *counting_alloc(void *userdata, size_t size) {
+    ((struct CountingAllocator*)userdata)->allocs++;
+    return malloc(size);
+}
+
+static void *counting_realloc(void *userdata, void *ptr, size_t size) {
+    if (!ptr) {
+        ((struct CountingAllocator*)userdata)->allocs++;
+    }
+    return realloc(ptr, size);
+}
+
+static void counting_free(void *userdata, void *ptr) {
+    ((struct CountingAllocator*)userdata)->frees++;
+    free(ptr);
+}
+
+// Test for routing allocations through global and per-call allocators
+void test_allocator_hooks() {
+    struct CountingAllocator global_counts = {0, 0};
+    struct CountingAllocator call_counts = {0, 0};
+    cfallocator_t global_allocator = {counting_alloc, counting_realloc, counting_free, &global_counts};
+    cfcontext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.allocator = global_allocator;
+    ctx.allocator.userdata = &call_counts;
+
+    cfsetallocator(&global_allocator);
+
+    char big_value[64];
+    memset(big_value, 'v', sizeof(big_value));
+    cfentry_t entries[3];
+    entries[0] = cfcreatecfgentry("a", CONFIN_ANNOTYPE_STRUCT, big_value, sizeof(big_value));
+    entries[1] = cfcreatecfgentry("b", CONFIN_ANNOTYPE_STRUCT, big_value, sizeof(big_value));
+    entries[2] = cfcreatecfgentryctx("c", CONFIN_ANNOTYPE_STRUCT, big_value, sizeof(big_value), &ctx);
+    CHECK(global_counts.allocs == 2 && call_counts.allocs == 1);
+
+    cfwritecfgex("config_test_alloc.bin", entries, 3, CONFIN_WRITE_DEDUP);
+    cfwritecfg("config_test_alloc_plain.bin", entries, 3);
+    cffreecfgentry(&entries[0]);
+    cffreecfgentry(&entries[1]);
+    cffreecfgentryctx(&entries[2], &ctx);
+
+    // Global allocator
+    cffile_t *config = cfreadcfg("config_test_alloc_plain.bin");
+    CHECK(config != NULL);
+    CHECK(cfvalidatefile("config_test_alloc.bin") == true);
+    char output[0x400];
+    CHECK(cfscanfile("config_test_alloc.bin", output, sizeof(output)) == true);
+    cffreecfgfile(config);
+    int global_allocs = global_counts.allocs;
+    CHECK(global_allocs > 2);
+    CHECK(global_counts.allocs == global_counts.frees);
+
+    // Per-call allocator, remembered by the configuration for freeing
+    config = cfreadcfgctx("config_test_alloc.bin", &ctx);
+    CHECK(config != NULL);
+    cfsetallocator(NULL);
+    cffreecfgfile(config);
+    CHECK(global_counts.allocs == global_allocs);
+    CHECK(call_counts.allocs > 1);
+    CHECK(call_counts.allocs == call_counts.frees);
+    CHECK(cfgetallocator()->userdata == NULL);
+}
+
+#if __CONFIN_ENABLE_STATS
+// Trace callback counting the reported phases
+static void counting_trace(void *userdata, cfop_t op, cfphase_t phase, uint64_t nanoseconds) {
+    (void)op;
+    (void)phase;
+    (void)nanoseconds;
+    (*(int*)userdata)++;
+}
+#endif
+
+// Test for the instrumentation counters and trace callback
+void test_stats() {
+#if __CONFIN_ENABLE_STATS
+    cfstats_t stats;
+    int traced = 0;
+    cfcontext_t ctx;
+    memset(&stats, 0, sizeof(stats));
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.stats = &stats;
+    ctx.trace = counting_trace;
+    ctx.tracedata = &traced;
+
+    char big_value[32];
+    memset(big_value, 's', sizeof(big_value));
+    int int_value = 5;
+    cfentry_t entries[2];
+    entries[0] = cfcreatecfgentry("big", CONFIN_ANNOTYPE_STRUCT, big_value, sizeof(big_value));
+    entries[1] = cfcreatecfgentry("int", CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value));
+    cfwritecfgctx("config_test_stats.bin", entries, 2, 0, &ctx);
+    cffreecfgentry(&entries[0]);
+    cffreecfgentry(&entries[1]);
+
+    const cfopstats_t *write = &stats.ops[CONFIN_OP_WRITE];
+    uint64_t file_size = sizeof(cfheader_t) + sizeof(cflayout_t) + 2 * sizeof(cfentryhdr_t) + sizeof(big_value) + sizeof(int_value);
+    CHECK(write->calls == 1);
+    CHECK(write->entries == 2);
+    CHECK(write->byteswritten == file_size);
+    CHECK(traced == CONFIN_PHASE_COUNT);
+
+    cffile_t *config = cfreadcfgctx("config_test_stats.bin", &ctx);
+    CHECK(config != NULL);
+    cffreecfgfile(config);
+
+    const cfopstats_t *read = &stats.ops[CONFIN_OP_READ];
+    CHECK(read->calls == 1);
+    CHECK(read->entries == 2);
+    CHECK(read->bytesread == file_size);
+    CHECK(read->allocations == 2); // structure and the non-inline value
+    CHECK(read->iocalls >= 2 + 5);
+    CHECK(traced == 2 * CONFIN_PHASE_COUNT);
+
+    // Global counters
+    cfstats_t global;
+    cfresetstats();
+    cfenablestats(true);
+    CHECK(cfvalidatefile("config_test_stats.bin") == true);
+    cfenablestats(false);
+    CHECK(cfvalidatefile("config_test_stats.bin") == true);
+    cfgetstats(&global);
+    CHECK(global.ops[CONFIN_OP_VALIDATE].calls == 1);
+    CHECK(global.ops[CONFIN_OP_VALIDATE].bytesread == file_size);
+    CHECK(global.ops[CONFIN_OP_READ].calls == 0);
+    CHECK(strcmp(confin_phase_name(CONFIN_PHASE_VALUES), "values") == 0);
+    CHECK(strcmp(confin_op_name(CONFIN_OP_SCAN), "scan") == 0);
+#endif
+}
+
+// Finds an entry by key in a configuration
+static const cfentry_t *find_entry(const cffile_t *config, const char *key) {
+    for (uint64_t i = 0; i < config->header.entrycount; ++i) {
+        if (strcmp(config->entries[i].key, key) == 0) {
+            return &config->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Test for computing and applying a delta between two configurations
+void test_diff_delta() {
+    int values[4] = {1, 2, 3, 4};
+    const char *long_value = "a value stored out of line in the entry";
+    int changed = 20;
+
+    cfentry_t old_entries[4];
+    old_entries[0] = cfcreatecfgentry("keep", CONFIN_ANNOTYPE_INT, &values[0], sizeof(int));
+    old_entries[1] = cfcreatecfgentry("change", CONFIN_ANNOTYPE_INT, &values[1], sizeof(int));
+    old_entries[2] = cfcreatecfgentry("remove", CONFIN_ANNOTYPE_INT, &values[2], sizeof(int));
+    old_entries[3] = cfcreatecfgentry("long", CONFIN_ANNOTYPE_STRING, long_value, strlen(long_value) + 1);
+
+    cfentry_t new_entries[4];
+    new_entries[0] = cfcreatecfgentry("long", CONFIN_ANNOTYPE_STRING, long_value, strlen(long_value) + 1);
+    new_entries[1] = cfcreatecfgentry("keep", CONFIN_ANNOTYPE_INT, &values[0], sizeof(int));
+    new_entries[2] = cfcreatecfgentry("change", CONFIN_ANNOTYPE_INT, &changed, sizeof(int));
+    new_entries[3] = cfcreatecfgentry("add", CONFIN_ANNOTYPE_STRING, long_value, strlen(long_value) + 1);
+
+    cfwritecfg("config_test_old.bin", old_entries, 4);
+    cfwritecfg("config_test_new.bin", new_entries, 4);
+    for (int i = 0; i < 4; ++i) {
+        cffreecfgentry(&old_entries[i]);
+        cffreecfgentry(&new_entries[i]);
+    }
+
+    cffile_t *oldcfg = cfreadcfg("config_test_old.bin");
+    cffile_t *newcfg = cfreadcfg("config_test_new.bin");
+    CHECK(oldcfg != NULL && newcfg != NULL);
+
+    cfdiffsummary_t summary;
+    CHECK(cfdiff(oldcfg, newcfg, "config_test_delta.bin", &summary) == true);
+    CHECK(summary.added == 1 && summary.changed == 1 && summary.removed == 1);
+
+    // The delta only carries the records
+    FILE *delta = fopen("config_test_delta.bin", "rb");
+    CHECK(delta != NULL);
+    fseek(delta, 0, SEEK_END);
+    long delta_size = ftell(delta);
+    fclose(delta);
+    CHECK(delta_size == (long)(sizeof(cfheader_t) + sizeof(cfdeltabase_t) + 3 * sizeof(cfentryhdr_t) + sizeof(int) + strlen(long_value) + 1));
+
+    cffile_t *applied = cfapplydelta(oldcfg, "config_test_delta.bin");
+    CHECK(applied != NULL);
+    CHECK(applied->header.entrycount == newcfg->header.entrycount);
+    for (uint64_t i = 0; i < newcfg->header.entrycount; ++i) {
+        const cfentry_t *expected = &newcfg->entries[i];
+        const cfentry_t *actual = find_entry(applied, expected->key);
+        CHECK(actual != NULL);
+        CHECK(actual->type == expected->type && actual->size == expected->size);
+        CHECK(memcmp(CF_ENTRYVAL(actual), CF_ENTRYVAL(expected), expected->size) == 0);
+    }
+    CHECK(find_entry(applied, "remove") == NULL);
+
+    // A delta does not apply to a configuration it was not computed from
+    CHECK(cfapplydelta(newcfg, "config_test_delta.bin") == NULL);
+
+    // Nor to one with the same keys and another value
+    CF_UNREF_ENTRYVAL(CF_ENTRYVAL(find_entry(oldcfg, "keep")), int) = 99;
+    CHECK(cfapplydelta(oldcfg, "config_test_delta.bin") == NULL);
+
+    cffreecfgfile(applied);
+    cffreecfgfile(oldcfg);
+    cffreecfgfile(newcfg);
+}
+
+// Writes a delta file with the given records, all for the given base
+static void write_test_delta(const char *filename, const cfdeltabase_t *base, const void *records, size_t size, uint64_t count) {
+    cfheader_t header = {__CONFIN_DELTA_MAGIC_NUMBER, _CF_VER, count};
+    FILE *file = fopen(filename, "wb");
+    CHECK(file != NULL);
+    CHECK(fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(base, sizeof(*base), 1, file) == 1);
+    CHECK(size == 0 || fwrite(records, size, 1, file) == 1);
+    fclose(file);
+}
+
+// Reads the base and the first record of a delta file
+static cfdeltabase_t read_test_delta(const char *filename, void *record, size_t size) {
+    cfdeltabase_t base;
+    FILE *file = fopen(filename, "rb");
+    CHECK(file != NULL);
+    CHECK(fseek(file, sizeof(cfheader_t), SEEK_SET) == 0 && fread(&base, sizeof(base), 1, file) == 1);
+    CHECK(size == 0 || fread(record, size, 1, file) == 1);
+    fclose(file);
+    return base;
+}
+
+// Test for refusing duplicate keys in diffs and deltas
+void test_diff_duplicate_keys() {
+    int values[2] = {1, 2};
+    cfentry_t entries[3];
+    entries[0] = cfcreatecfgentry("key", CONFIN_ANNOTYPE_INT, &values[0], sizeof(int));
+    entries[1] = cfcreatecfgentry("added", CONFIN_ANNOTYPE_INT, &values[1], sizeof(int));
+    entries[2] = cfcreatecfgentry("key", CONFIN_ANNOTYPE_INT, &values[1], sizeof(int));
+    cfwritecfg("config_test_dup_old.bin", entries, 1);
+    cfwritecfg("config_test_dup_new.bin", entries, 2);
+    cfwritecfg("config_test_dup.bin", entries, 3);
+    cfwritecfg("config_test_dup_last.bin", &entries[2], 1);
+    for (int i = 0; i < 3; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+
+    cffile_t *oldcfg = cfreadcfg("config_test_dup_old.bin");
+    cffile_t *newcfg = cfreadcfg("config_test_dup_new.bin");
+    cffile_t *dupcfg = cfreadcfg("config_test_dup.bin");
+    cffile_t *lastcfg = cfreadcfg("config_test_dup_last.bin");
+    CHECK(oldcfg != NULL && newcfg != NULL && dupcfg != NULL && lastcfg != NULL);
+
+    // Neither side of a diff may repeat a key
+    CHECK(cfdiff(dupcfg, newcfg, "config_test_dup_delta.bin", NULL) == false);
+    CHECK(cfdiff(oldcfg, dupcfg, "config_test_dup_delta.bin", NULL) == false);
+
+    // A delta adding the same key twice is refused
+    unsigned char records[2][sizeof(cfentryhdr_t) + sizeof(int)];
+    CHECK(cfdiff(oldcfg, newcfg, "config_test_dup_delta.bin", NULL) == true);
+    cfdeltabase_t base = read_test_delta("config_test_dup_delta.bin", records[0], sizeof(records[0]));
+    memcpy(records[1], records[0], sizeof(records[0]));
+    write_test_delta("config_test_dup_delta.bin", &base, records, sizeof(records[0]), 1);
+    cffile_t *applied = cfapplydelta(oldcfg, "config_test_dup_delta.bin");
+    CHECK(applied != NULL && applied->header.entrycount == 2);
+    cffreecfgfile(applied);
+    write_test_delta("config_test_dup_delta.bin", &base, records, sizeof(records), 2);
+    CHECK(cfapplydelta(oldcfg, "config_test_dup_delta.bin") == NULL);
+
+    // So is a configuration with a repeated key, even when the base matches; the
+    // checksum of a configuration is the sum of those of its entries
+    CHECK(cfdiff(newcfg, newcfg, "config_test_dup_delta.bin", NULL) == true);
+    base = read_test_delta("config_test_dup_delta.bin", NULL, 0);
+    CHECK(cfdiff(lastcfg, lastcfg, "config_test_dup_delta.bin", NULL) == true);
+    base.checksum += read_test_delta("config_test_dup_delta.bin", NULL, 0).checksum;
+    base.entrycount = 3;
+    write_test_delta("config_test_dup_delta.bin", &base, NULL, 0, 0);
+    CHECK(cfapplydelta(dupcfg, "config_test_dup_delta.bin") == NULL);
+
+    cffreecfgfile(oldcfg);
+    cffreecfgfile(newcfg);
+    cffreecfgfile(dupcfg);
+    cffreecfgfile(lastcfg);
+}
+
+// Test for compiling INI and JSON sources
+void test_compile_sources() {
+    const char *ini =
+        "; comment\n"
+        "name = confin\n"
+        "[server]\n"
+        "port = 8080\n"
+        "ratio: 0.5 ; inline comment\n"
+        "enabled = true\n"
+        "motd = \"hello, world\"\n"
+        "big = 5000000000\n";
+    cfcompileopts_t options = {CONFIN_SOURCE_AUTO, 0, 2};
+    uint64_t entrycount = 0;
+    CHECK(cfcompilebuffer(ini, strlen(ini), "config_test_ini.bin", &options, &entrycount) == true);
+    CHECK(entrycount == 6);
+
+    cffile_t *config = cfreadcfg("config_test_ini.bin");
+    CHECK(config != NULL && config->header.entrycount == 6);
+    const cfentry_t *entry = find_entry(config, "name");
+    CHECK(entry && entry->type == CONFIN_ANNOTYPE_STRING && strcmp((const char*)CF_ENTRYVAL(entry), "confin") == 0);
+    entry = find_entry(config, "server.port");
+    CHECK(entry && entry->type == CONFIN_ANNOTYPE_INT && entry->size == sizeof(int32_t));
+    CHECK(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), int32_t) == 8080);
+    entry = find_entry(config, "server.ratio");
+    CHECK(entry && entry->type == CONFIN_ANNOTYPE_FLOAT && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), float) == 0.5f);
+    entry = find_entry(config, "server.enabled");
+    CHECK(entry && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), int32_t) == 1);
+    entry = find_entry(config, "server.motd");
+    CHECK(entry && strcmp((const char*)CF_ENTRYVAL(entry), "hello, world") == 0);
+    entry = find_entry(config, "server.big");
+    CHECK(entry && entry->size == sizeof(int64_t) && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), int64_t) == 5000000000LL);
+    cffreecfgfile(config);
+
+    const char *json =
+        "{\"db\": {\"host\": \"local\\u00e9\", \"ports\": [5432, 5433], \"timeout\": 1.5e1},"
+        " \"debug\": false, \"unused\": null}";
+    options.flags = CONFIN_COMPILE_DOUBLE;
+    CHECK(cfcompilebuffer(json, strlen(json), "config_test_json.bin", &options, &entrycount) == true);
+    CHECK(entrycount == 5);
+
+    config = cfreadcfg("config_test_json.bin");
+    CHECK(config != NULL && config->header.entrycount == 5);
+    entry = find_entry(config, "db.host");
+    CHECK(entry && strcmp((const char*)CF_ENTRYVAL(entry), "local\xc3\xa9") == 0);
+    entry = find_entry(config, "db.ports.1");
+    CHECK(entry && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), int32_t) == 5433);
+    entry = find_entry(config, "db.timeout");
+    CHECK(entry && entry->size == sizeof(double) && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), double) == 15.0);
+    entry = find_entry(config, "debug");
+    CHECK(entry && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(entry), int32_t) == 0);
+    CHECK(find_entry(config, "unused") == NULL);
+    cffreecfgfile(config);
+
+    // Malformed sources are rejected without leaving an output file
+    const char *broken = "{\"a\": [1, 2}";
+    CHECK(cfcompilebuffer(broken, strlen(broken), "config_test_broken.bin", NULL, NULL) == false);
+    CHECK(fopen("config_test_broken.bin", "rb") == NULL);
+}
+
+// Function to read a whole text file into a static buffer
+static const char *read_text(const char *filename) {
+    static char text[4096];
+    FILE *file = fopen(filename, "rb");
+    assert(file != NULL);
+    size_t size = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    text[size] = '\0';
+    return text;
+}
+
+// Test for exporting a configuration as JSON and JSON Lines
+void test_export_json() {
+    int32_t int_value = -42;
+    int64_t big_value = 5000000000LL;
+    float float_value = 0.1f;
+    double double_value = 2.0;
+    const char *string_value = "say \"hi\"\n";
+    struct Structure struct_value = {1, 2};
+
+    cfentry_t entries[6];
+    entries[0] = cfcreatecfgentry("int", CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value));
+    entries[1] = cfcreatecfgentry("big", CONFIN_ANNOTYPE_INT, &big_value, sizeof(big_value));
+    entries[2] = cfcreatecfgentry("float", CONFIN_ANNOTYPE_FLOAT, &float_value, sizeof(float_value));
+    entries[3] = cfcreatecfgentry("double", CONFIN_ANNOTYPE_FLOAT, &double_value, sizeof(double_value));
+    entries[4] = cfcreatecfgentry("string", CONFIN_ANNOTYPE_STRING, string_value, strlen(string_value) + 1);
+    entries[5] = cfcreatecfgentry("struct", CONFIN_ANNOTYPE_STRUCT, &struct_value, sizeof(struct_value));
+    cfwritecfg("config_test_export.bin", entries, 6);
+    cfwritecfgex("config_test_export_pooled.bin", entries, 6, CONFIN_WRITE_DEDUP);
+    for (int i = 0; i < 6; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+
+    const char *expected_json =
+        "{\n"
+        "  \"int\": -42,\n"
+        "  \"big\": 5000000000,\n"
+        "  \"float\": 0.1,\n"
+        "  \"double\": 2.0,\n"
+        "  \"string\": \"say \\\"hi\\\"\\n\",\n"
+        "  \"struct\": \"AQAAAAIAAAA=\"\n"
+        "}\n";
+    CHECK(cfexportfile("config_test_export.bin", "config_test_export.json", CONFIN_EXPORT_JSON) == true);
+    CHECK(strcmp(read_text("config_test_export.json"), expected_json) == 0);
+
+    // Pooled files and configurations in memory render the same
+    CHECK(cfexportfile("config_test_export_pooled.bin", "config_test_export.json", CONFIN_EXPORT_JSON) == true);
+    CHECK(strcmp(read_text("config_test_export.json"), expected_json) == 0);
+    cffile_t *config = cfreadcfg("config_test_export.bin");
+    CHECK(config != NULL);
+    CHECK(cfexportcfg(config, "config_test_export.json", CONFIN_EXPORT_JSON) == true);
+    CHECK(strcmp(read_text("config_test_export.json"), expected_json) == 0);
+    cffreecfgfile(config);
+
+    CHECK(cfexportfile("config_test_export.bin", "config_test_export.jsonl", CONFIN_EXPORT_JSONL) == true);
+    const char *lines = read_text("config_test_export.jsonl");
+    const char *first_line = "{\"key\":\"int\",\"type\":\"INT\",\"value\":-42}\n";
+    CHECK(strncmp(lines, first_line, strlen(first_line)) == 0);
+    CHECK(strstr(lines, "{\"key\":\"struct\",\"type\":\"STRUCT\",\"value\":\"AQAAAAIAAAA=\"}\n") != NULL);
+
+    CHECK(cfexportfile("config_test_missing.bin", "config_test_export.json", CONFIN_EXPORT_JSON) == false);
+}
+
+struct Settings {
+    int64_t port;
+    double ratio;
+    char name[16];
+    struct Structure origin;
+    int32_t retries;
+    int32_t workers;
+    int32_t mode;
+};
+
+// Test for binding entries into a structure with a descriptor table
+void test_bind_struct() {
+    int32_t port = 8080;
+    float ratio = 0.5f;
+    const char *name = "confin";
+    struct Structure origin = {3, 4};
+    const char *mode = "fast";
+
+    cfentry_t entries[5];
+    entries[0] = cfcreatecfgentry("origin", CONFIN_ANNOTYPE_STRUCT, &origin, sizeof(origin));
+    entries[1] = cfcreatecfgentry("server.port", CONFIN_ANNOTYPE_INT, &port, sizeof(port));
+    entries[2] = cfcreatecfgentry("mode", CONFIN_ANNOTYPE_STRING, mode, strlen(mode) + 1);
+    entries[3] = cfcreatecfgentry("server.ratio", CONFIN_ANNOTYPE_FLOAT, &ratio, sizeof(ratio));
+    entries[4] = cfcreatecfgentry("name", CONFIN_ANNOTYPE_STRING, name, strlen(name) + 1);
+    cfwritecfg("config_test_bind.bin", entries, 5);
+    for (int i = 0; i < 5; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+
+    static const int32_t default_retries = 3;
+    static const int32_t default_mode = 1;
+    static cfbinding_t bindings[] = {
+        CONFIN_BINDING(struct Settings, port, "server.port", CONFIN_ANNOTYPE_INT, NULL),
+        CONFIN_BINDING(struct Settings, ratio, "server.ratio", CONFIN_ANNOTYPE_FLOAT, NULL),
+        CONFIN_BINDING(struct Settings, name, "name", CONFIN_ANNOTYPE_STRING, NULL),
+        CONFIN_BINDING(struct Settings, origin, "origin", CONFIN_ANNOTYPE_STRUCT, NULL),
+        CONFIN_BINDING(struct Settings, retries, "retries", CONFIN_ANNOTYPE_INT, &default_retries),
+        CONFIN_BINDING(struct Settings, workers, "workers", CONFIN_ANNOTYPE_INT, NULL),
+        CONFIN_BINDING(struct Settings, mode, "mode", CONFIN_ANNOTYPE_INT, &default_mode)
+    };
+    const size_t count = sizeof(bindings) / sizeof(bindings[0]);
+    cfbindprepare(bindings, count);
+
+    cffile_t *config = cfreadcfg("config_test_bind.bin");
+    CHECK(config != NULL);
+
+    struct Settings settings;
+    memset(&settings, 0, sizeof(settings));
+    settings.workers = -1;
+    cfbindstatus_t status[7];
+    CHECK(cfbind(config, bindings, count, &settings, status) == false);
+
+    CHECK(status[0] == CONFIN_BIND_OK && settings.port == 8080);
+    CHECK(status[1] == CONFIN_BIND_OK && settings.ratio == 0.5);
+    CHECK(status[2] == CONFIN_BIND_OK && strcmp(settings.name, "confin") == 0);
+    CHECK(status[3] == CONFIN_BIND_OK && settings.origin.x == 3 && settings.origin.y == 4);
+    CHECK(status[4] == CONFIN_BIND_DEFAULT && settings.retries == 3);
+    CHECK(status[5] == CONFIN_BIND_MISSING && settings.workers == -1);
+    CHECK(status[6] == CONFIN_BIND_MISTYPED && settings.mode == 1);
+    CHECK(strcmp(cfbindstatusname(status[6]), "mistyped") == 0);
+
+    // Binding only the keys that are present succeeds
+    CHECK(cfbind(config, bindings, 5, &settings, NULL) == true);
+
+    // A descriptor is bound by its key, not by its hash alone
+    cfbinding_t collision = CONFIN_BINDING(struct Settings, workers, "workers", CONFIN_ANNOTYPE_INT, NULL);
+    collision.hash = bindings[0].hash;
+    settings.workers = -1;
+    CHECK(cfbind(config, &collision, 1, &settings, status) == false);
+    CHECK(status[0] == CONFIN_BIND_MISSING && settings.workers == -1);
+
+    cffreecfgfile(config);
+}
+
+// Test for resolving keys into handles and revalidating them after a reload
+void test_key_handles() {
+    int values[3] = {1, 2, 3};
+    cfentry_t entries[3];
+    entries[0] = cfcreatecfgentry("a", CONFIN_ANNOTYPE_INT, &values[0], sizeof(int));
+    entries[1] = cfcreatecfgentry("b", CONFIN_ANNOTYPE_INT, &values[1], sizeof(int));
+    entries[2] = cfcreatecfgentry("c", CONFIN_ANNOTYPE_INT, &values[2], sizeof(int));
+    cfwritecfg("config_test_handles.bin", entries, 3);
+
+    cffile_t *config = cfreadcfg("config_test_handles.bin");
+    CHECK(config != NULL);
+    CHECK(cfget(config, "b") == &config->entries[1]);
+    CHECK(cfget(config, "missing") == NULL);
+
+    cfkeyhandle_t handle_b = cfresolve(config, "b");
+    cfkeyhandle_t handle_c = cfresolve(config, "c");
+    cfkeyhandle_t handle_missing = cfresolve(config, "missing");
+    CHECK(handle_missing.generation == 0 && cfgetbyhandle(config, handle_missing) == NULL);
+    CHECK(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(cfgetbyhandle(config, handle_b)), int) == 2);
+
+    // A reload gives a new generation: old handles are rejected until revalidated
+    cffile_t *reloaded = cfreadcfg("config_test_handles.bin");
+    CHECK(reloaded != NULL && reloaded->generation != config->generation);
+    CHECK(cfgetbyhandle(reloaded, handle_b) == NULL);
+    CHECK(cfrevalidate(reloaded, &handle_b, "b") == true);
+    CHECK(cfgetbyhandle(reloaded, handle_b) == &reloaded->entries[1]);
+    cffreecfgfile(reloaded);
+
+    // Keys that moved are resolved again, keys that disappeared are reported
+    cfentry_t reordered[2] = {entries[2], entries[0]};
+    cfwritecfg("config_test_handles.bin", reordered, 2);
+    reloaded = cfreadcfg("config_test_handles.bin");
+    CHECK(reloaded != NULL);
+    CHECK(cfrevalidate(reloaded, &handle_c, "c") == true && handle_c.index == 0);
+    CHECK(cfrevalidate(reloaded, &handle_b, "b") == false && cfgetbyhandle(reloaded, handle_b) == NULL);
+    cffreecfgfile(reloaded);
+
+    for (int i = 0; i < 3; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+    cffreecfgfile(config);
+}
+
+// Test for looking up several keys in one batched call
+void test_get_many() {
+    cfentry_t entries[100];
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    for (int i = 0; i < 100; ++i) {
+        snprintf(key, sizeof(key), "key.%d", i);
+        entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_INT, &i, sizeof(int));
+    }
+    cfwritecfg("config_test_many.bin", entries, 100);
+    for (int i = 0; i < 100; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+
+    cffile_t *config = cfreadcfg("config_test_many.bin");
+    CHECK(config != NULL);
+
+    // More keys than one group, with absent keys mixed in
+    char names[70][__CONFIN_STRUCT_MAX_KEYLEN];
+    const char *keys[70];
+    const cfentry_t *out[70];
+    for (int i = 0; i < 70; ++i) {
+        snprintf(names[i], sizeof(names[i]), i % 7 == 0 ? "absent.%d" : "key.%d", (i * 37) % 100);
+        keys[i] = names[i];
+    }
+    CHECK(cfgetmany(config, keys, 70, out) == 60);
+    for (int i = 0; i < 70; ++i) {
+        CHECK(out[i] == cfget(config, keys[i]));
+        CHECK(i % 7 == 0 || CF_UNREF_ENTRYVAL(CF_ENTRYVAL(out[i]), int) == (i * 37) % 100);
+    }
+
+    cffreecfgfile(config);
+}
+
+// Read callback producing a repeating byte pattern
+static size_t pattern_read(void *userdata, void *buffer, size_t size) {
+    uint64_t *offset = (uint64_t*)userdata;
+    unsigned char *bytes = (unsigned char*)buffer;
+    size = size > 1000 ? 1000 : size;
+    for (size_t i = 0; i < size; ++i) {
+        bytes[i] = (unsigned char)((*offset + i) % 251);
+    }
+    *offset += size;
+    return size;
+}
+
+// Read callback that fails
+static size_t failing_read(void *userdata, void *buffer, size_t size) {
+    (void)userdata;
+    (void)buffer;
+    (void)size;
+    return 0;
+}
+
+// Test for writing entries with the constant-memory streaming writer
+void test_streaming_writer() {
+    int int_value = 7;
+    const char *long_value = "a value stored out of line in the entry";
+    const uint64_t large_size = 3 * 1024 * 1024 + 17;
+
+    cfwriter_t *writer = cfwriteropen("config_test_writer.bin");
+    CHECK(writer != NULL);
+    CHECK(cfwriterappend(writer, "int", CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value)) == true);
+    cfentry_t entry = cfcreatecfgentry("string", CONFIN_ANNOTYPE_STRING, long_value, strlen(long_value) + 1);
+    CHECK(cfwriterappendentry(writer, &entry) == true);
+    cffreecfgentry(&entry);
+    uint64_t offset = 0;
+    CHECK(cfwriterappendstream(writer, "large", CONFIN_ANNOTYPE_STRUCT, large_size, pattern_read, &offset) == true);
+    CHECK(offset == large_size && cfwritercount(writer) == 3);
+    CHECK(cfwriterclose(writer) == true);
+
+    cffile_t *config = cfreadcfg("config_test_writer.bin");
+    CHECK(config != NULL && config->header.entrycount == 3);
+    CHECK(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(&config->entries[0]), int) == 7);
+    CHECK(strcmp((const char*)CF_ENTRYVAL(&config->entries[1]), long_value) == 0);
+    const unsigned char *large = (const unsigned char*)CF_ENTRYVAL(&config->entries[2]);
+    CHECK(config->entries[2].size == large_size);
+    for (uint64_t i = 0; i < large_size; i += 4099) {
+        CHECK(large[i] == (unsigned char)(i % 251));
+    }
+    cffreecfgfile(config);
+
+    // A value that ends early fails the writer and the file is not kept
+    writer = cfwriteropen("config_test_writer_failed.bin");
+    CHECK(writer != NULL);
+    CHECK(cfwriterappendstream(writer, "broken", CONFIN_ANNOTYPE_STRUCT, 10, failing_read, NULL) == false);
+    CHECK(cfwriterappend(writer, "int", CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value)) == false);
+    CHECK(cfwriterclose(writer) == false);
+    CHECK(fopen("config_test_writer_failed.bin", "rb") == NULL);
+
+    // So does a key that does not fit in an entry header
+    writer = cfwriteropen("config_test_writer_failed.bin");
+    CHECK(writer != NULL);
+    char long_key[__CONFIN_STRUCT_MAX_KEYLEN + 1];
+    memset(long_key, 'k', sizeof(long_key) - 1);
+    long_key[sizeof(long_key) - 1] = '\0';
+    CHECK(cfwriterappend(writer, long_key, CONFIN_ANNOTYPE_INT, &int_value, sizeof(int_value)) == false);
+    CHECK(cfwriterclose(writer) == false);
+    CHECK(fopen("config_test_writer_failed.bin", "rb") == NULL);
+}
+
+// Checks that two loaded configurations hold the same entries
+static void check_same_config(const cffile_t *a, const cffile_t *b) {
+    CHECK(a->header.entrycount == b->header.entrycount);
+    for (uint64_t i = 0; i < a->header.entrycount; ++i) {
+        CHECK(strcmp(a->entries[i].key, b->entries[i].key) == 0);
+        CHECK(a->entries[i].type == b->entries[i].type && a->entries[i].size == b->entries[i].size);
+        CHECK(memcmp(CF_ENTRYVAL(&a->entries[i]), CF_ENTRYVAL(&b->entries[i]), a->entries[i].size) == 0);
+    }
+}
+
+// Test for loading a configuration on several threads
+void test_parallel_load() {
+    // More entries than one offset stride, with inline and out-of-line values
+    enum { count = 2500 };
+    cfentry_t *entries = (cfentry_t*)malloc(sizeof(cfentry_t) * count);
+    CHECK(entries != NULL);
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    char text[64];
+    for (int i = 0; i < count; ++i) {
+        snprintf(key, sizeof(key), "key.%d", i);
+        if (i % 3 == 0) {
+            entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_INT, &i, sizeof(int));
+        } else {
+            int length = snprintf(text, sizeof(text), "value number %d of the parallel test", i % (7 + i % 40));
+            entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_STRING, text, (uint64_t)(i % 2 ? length + 1 : 9));
+        }
+    }
+    cfwritecfgex("config_test_parallel.bin", entries, count, CONFIN_WRITE_OFFSETS);
+    cfwritecfg("config_test_parallel_plain.bin", entries, count);
+    cfwritecfgex("config_test_parallel_pooled.bin", entries, count, CONFIN_WRITE_DEDUP);
+    cfwriter_t *writer = cfwriteropen("config_test_parallel_writer.bin");
+    CHECK(writer != NULL);
+    for (int i = 0; i < count; ++i) {
+        CHECK(cfwriterappendentry(writer, &entries[i]) == true);
+    }
+    CHECK(cfwriterclose(writer) == true);
+    for (int i = 0; i < count; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+    free(entries);
+
+    // Offset table, prescan, fixed-size pooled records and writer output
+    const char *files[] = {
+        "config_test_parallel.bin",
+        "config_test_parallel_plain.bin",
+        "config_test_parallel_pooled.bin",
+        "config_test_parallel_writer.bin"
+    };
+    cffile_t *expected = cfreadcfg("config_test_parallel_plain.bin");
+    CHECK(expected != NULL && expected->header.entrycount == count);
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        unsigned threads[] = {1, 4};
+        for (size_t t = 0; t < 2; ++t) {
+            cffile_t *config = cfreadcfgparallel(files[f], threads[t]);
+            CHECK(config != NULL);
+            check_same_config(config, expected);
+            cffreecfgfile(config);
+        }
+        // The serial reader ignores the offset table
+        cffile_t *config = cfreadcfg(files[f]);
+        CHECK(config != NULL);
+        check_same_config(config, expected);
+        cffreecfgfile(config);
+    }
+    cffreecfgfile(expected);
+
+    // A position that does not match the entries is rejected
+    FILE *file = fopen("config_test_parallel.bin", "r+b");
+    CHECK(file != NULL);
+    uint64_t position = 12345;
+    CHECK(fseek(file, -(long)(sizeof(cfoffsettable_t) + sizeof(uint64_t)), SEEK_END) == 0);
+    CHECK(fwrite(&position, sizeof(position), 1, file) == 1);
+    fclose(file);
+    CHECK(cfreadcfgparallel("config_test_parallel.bin", 4) == NULL);
+
+    // So is a table that does not start at the first entry
+    file = fopen("config_test_parallel_writer.bin", "r+b");
+    CHECK(file != NULL);
+    long strides = (count + __CONFIN_OFFSET_STRIDE - 1) / __CONFIN_OFFSET_STRIDE;
+    CHECK(fseek(file, -(long)(sizeof(cfoffsettable_t) + sizeof(uint64_t) * strides), SEEK_END) == 0);
+    CHECK(fread(&position, sizeof(position), 1, file) == 1);
+    position += sizeof(cfentryhdr_t) + sizeof(int);
+    CHECK(fseek(file, -(long)(sizeof(cfoffsettable_t) + sizeof(uint64_t) * strides), SEEK_END) == 0);
+    CHECK(fwrite(&position, sizeof(position), 1, file) == 1);
+    fclose(file);
+    CHECK(cfreadcfgparallel("config_test_parallel_writer.bin", 4) == NULL);
+}
+
+// Test for lock-free reads and transactional commits of a mutable configuration
+void test_mutable_config() {
+    enum { count = 3000 };
+    cfentry_t *entries = (cfentry_t*)malloc(sizeof(cfentry_t) * count);
+    CHECK(entries != NULL);
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    for (int i = 0; i < count; ++i) {
+        snprintf(key, sizeof(key), "key.%d", i);
+        entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_INT, &i, sizeof(int));
+    }
+    cfwritecfg("config_test_mutable.bin", entries, count);
+    for (int i = 0; i < count; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+    free(entries);
+
+    cffile_t *config = cfreadcfg("config_test_mutable.bin");
+    CHECK(config != NULL);
+    cfmutable_t *mutableconfig = cfmutcreate(config);
+    cffreecfgfile(config);
+    CHECK(mutableconfig != NULL);
+    cfsnapshot_t *first = cfmutsnapshot(mutableconfig);
+    CHECK(cfsnapversion(first) == 1 && cfsnapcount(first) == count);
+
+    // Changes are visible in the transaction only until it commits
+    const char *long_value = "a value stored out of line in the item";
+    int value = -1;
+    cftxn_t *txn = cftxnbegin(mutableconfig);
+    CHECK(txn != NULL);
+    CHECK(cftxnset(txn, "key.5", CONFIN_ANNOTYPE_STRING, long_value, strlen(long_value) + 1) == true);
+    CHECK(cftxnset(txn, "added", CONFIN_ANNOTYPE_INT, &value, sizeof(value)) == true);
+    CHECK(cftxndelete(txn, "key.7") == true);
+    CHECK(cftxndelete(txn, "absent") == false);
+    CHECK(cftxnget(txn, "key.7") == NULL && cftxnget(txn, "added") != NULL);
+    CHECK(cfsnapget(first, "added") == NULL);
+    CHECK(cftxnset(txn, "a.key.that.does.not.fit.in.the.sixty.four.bytes.of.the.key.of.an.entry", CONFIN_ANNOTYPE_INT, &value, sizeof(value)) == false);
+    CHECK(cftxncommit(txn) == true);
+
+    cfsnapshot_t *second = cfmutsnapshot(mutableconfig);
+    CHECK(cfsnapversion(second) == 2 && cfsnapcount(second) == count);
+    CHECK(strcmp((const char*)CF_ENTRYVAL(cfsnapget(second, "key.5")), long_value) == 0);
+    CHECK(cfsnapget(second, "key.7") == NULL);
+    CHECK(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(cfsnapget(first, "key.5")), int) == 5);
+    CHECK(cfsnapget(first, "key.7") != NULL);
+    // Untouched entries are shared between versions
+    CHECK(cfsnapget(first, "key.100") == cfsnapget(second, "key.100"));
+
+    // The first commit wins
+    cftxn_t *winner = cftxnbegin(mutableconfig);
+    cftxn_t *loser = cftxnbegin(mutableconfig);
+    CHECK(cftxnset(winner, "key.1", CONFIN_ANNOTYPE_INT, &value, sizeof(value)) == true);
+    CHECK(cftxnset(loser, "key.2", CONFIN_ANNOTYPE_INT, &value, sizeof(value)) == true);
+    CHECK(cftxncommit(winner) == true);
+    CHECK(cftxncommit(loser) == false);
+    txn = cftxnbegin(mutableconfig);
+    CHECK(cftxnset(txn, "key.3", CONFIN_ANNOTYPE_INT, &value, sizeof(value)) == true);
+    cftxnabort(txn);
+
+    // Deleting most keys folds the trie back
+    txn = cftxnbegin(mutableconfig);
+    for (int i = 10; i < count; ++i) {
+        snprintf(key, sizeof(key), "key.%d", i);
+        CHECK(cftxndelete(txn, key) == true);
+    }
+    CHECK(cftxncommit(txn) == true);
+    cfsnapshot_t *third = cfmutsnapshot(mutableconfig);
+    CHECK(cfsnapversion(third) == 4 && cfsnapcount(third) == 10);
+    CHECK(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(cfsnapget(third, "key.1")), int) == -1);
+    CHECK(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(cfsnapget(third, "key.2")), int) == 2);
+    CHECK(cfsnapget(third, "key.3") != NULL && cfsnapget(third, "key.10") == NULL);
+
+    // Insertion order is kept, with added keys last
+    cffile_t *copy = cfsnaptocfg(third);
+    CHECK(copy != NULL && copy->header.entrycount == 10);
+    const char *order[] = {"key.0", "key.1", "key.2", "key.3", "key.4", "key.5", "key.6", "key.8", "key.9", "added"};
+    for (int i = 0; i < 10; ++i) {
+        CHECK(strcmp(copy->entries[i].key, order[i]) == 0);
+    }
+    CHECK(cfsnapwrite(third, "config_test_mutable_out.bin") == true);
+    cffile_t *written = cfreadcfg("config_test_mutable_out.bin");
+    CHECK(written != NULL && written->header.entrycount == 10);
+    for (int i = 0; i < 10; ++i) {
+        CHECK(strcmp(written->entries[i].key, copy->entries[i].key) == 0);
+        CHECK(written->entries[i].size == copy->entries[i].size);
+        CHECK(memcmp(CF_ENTRYVAL(&written->entries[i]), CF_ENTRYVAL(&copy->entries[i]), copy->entries[i].size) == 0);
+    }
+    cffreecfgfile(written);
+    cffreecfgfile(copy);
+
+    // Versions outlive the configuration
+    cfsnaprelease(second);
+    cfsnaprelease(third);
+    cfmutfree(mutableconfig);
+    CHECK(cfsnapcount(first) == count && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(cfsnapget(first, "key.2999")), int) == 2999);
+    cfsnaprelease(first);
+}
+
+// Checks that a loaded configuration holds the entries of a version
+static void check_same_version(const cffile_t *config, const cfsnapshot_t *snapshot) {
+    CHECK(config->header.entrycount == cfsnapcount(snapshot));
+    for (uint64_t i = 0; i < config->header.entrycount; ++i) {
+        const cfentry_t *entry = cfsnapget(snapshot, config->entries[i].key);
+        CHECK(entry != NULL && entry->type == config->entries[i].type && entry->size == config->entries[i].size);
+        CHECK(memcmp(CF_ENTRYVAL(entry), CF_ENTRYVAL(&config->entries[i]), entry->size) == 0);
+    }
+}
+
+// Test for retaining, rolling back and saving the versions of a mutable configuration
+void test_version_history() {
+    cfmutable_t *mutableconfig = cfmutcreate(NULL);
+    CHECK(mutableconfig != NULL);
+    CHECK(cfmutsethistory(mutableconfig, 4) == true);
+    make_test_directory("config_test_history");
+    CHECK(cfmutpersist(mutableconfig, "config_test_history") == true);
+
+    // Version 2 adds the keys, versions 3 to 6 change key.0, version 4 also deletes key.1
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    cftxn_t *txn = cftxnbegin(mutableconfig);
+    for (int i = 0; i < 200; ++i) {
+        snprintf(key, sizeof(key), "key.%d", i);
+        CHECK(cftxnset(txn, key, CONFIN_ANNOTYPE_INT, &i, sizeof(int)) == true);
+    }
+    CHECK(cftxncommit(txn) == true);
+    for (int version = 3; version <= 6; ++version) {
+        txn = cftxnbegin(mutableconfig);
+        CHECK(cftxnset(txn, "key.0", CONFIN_ANNOTYPE_INT, &version, sizeof(int)) == true);
+        CHECK(version != 4 || cftxndelete(txn, "key.1") == true);
+        CHECK(cftxncommit(txn) == true);
+    }
+
+    uint64_t versions[8];
+    CHECK(cfmutversions(mutableconfig, versions, 8) == 4);
+    CHECK(versions[0] == 6 && versions[1] == 5 && versions[2] == 4 && versions[3] == 3);
+    CHECK(cfmutversion(mutableconfig, 2) == NULL);
+    CHECK(cfmutrollback(mutableconfig, 2) == false);
+
+    // Rolling back commits the retained entries as version 7, and can itself be undone
+    cfsnapshot_t *third = cfmutversion(mutableconfig, 3);
+    CHECK(third != NULL);
+    CHECK(cfmutrollback(mutableconfig, 4) == true);
+    cfsnapshot_t *current = cfmutsnapshot(mutableconfig);
+    CHECK(cfsnapversion(current) == 7 && cfsnapcount(current) == 199);
+    CHECK(CF_UNREF_ENTRYVAL(CF_ENTRYVAL(cfsnapget(current, "key.0")), int) == 4);
+    CHECK(cfsnapget(current, "key.1") == NULL);
+    CHECK(cfsnapget(current, "key.50") == cfsnapget(third, "key.50"));
+    cfsnaprelease(current);
+    CHECK(cfmutrollback(mutableconfig, 6) == true);
+    current = cfmutsnapshot(mutableconfig);
+    CHECK(cfsnapversion(current) == 8 && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(cfsnapget(current, "key.0")), int) == 6);
+
+    // Saved versions are rebuilt from the full version and the deltas
+    cffile_t *loaded = cfhistoryload("config_test_history", 8);
+    CHECK(loaded != NULL);
+    check_same_version(loaded, current);
+    cffreecfgfile(loaded);
+    loaded = cfhistoryload("config_test_history", 3);
+    CHECK(loaded != NULL);
+    check_same_version(loaded, third);
+    CHECK(strcmp(loaded->entries[0].key, "key.0") == 0 && strcmp(loaded->entries[199].key, "key.199") == 0);
+    cffreecfgfile(loaded);
+    cfsnaprelease(current);
+
+    CHECK(cfmutsethistory(mutableconfig, 2) == true);
+    CHECK(cfmutversions(mutableconfig, versions, 8) == 2 && versions[0] == 8 && versions[1] == 7);
+    CHECK(cfmutversion(mutableconfig, 6) == NULL);
+    cfmutfree(mutableconfig);
+    // A released version stays valid while it is held
+    CHECK(cfsnapcount(third) == 200);
+    cfsnaprelease(third);
+}
+
+#ifdef __linux__
+static void *run_server(void *server) {
+    return cfserverrun((cfserver_t*)server) ? server : NULL;
+}
+
+static void write_server_config(int port) {
+    const char *host = "localhost";
+    const char *password = "correct-horse-battery-staple";
+    cfentry_t entries[3];
+    entries[0] = cfcreatecfgentry("db.port", CONFIN_ANNOTYPE_INT, &port, sizeof(port));
+    entries[1] = cfcreatecfgentry("db.host", CONFIN_ANNOTYPE_STRING, host, strlen(host) + 1);
+    entries[2] = cfcreatecfgentry("db.password", CONFIN_ANNOTYPE_STRING, password, strlen(password) + 1);
+    // Replaced by a rename, as deployments do
+    cfwritecfg("config_test_server.tmp", entries, 3);
+    CHECK(rename("config_test_server.tmp", "config_test_server.bin") == 0);
+    for (int i = 0; i < 3; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+}
+#endif
+
+// Test for serving configurations over a Unix domain socket
+void test_config_server() {
+#ifdef __linux__
+    int flag = 1;
+    cfentry_t extra = cfcreatecfgentry("feature.flag", CONFIN_ANNOTYPE_INT, &flag, sizeof(flag));
+    cfwritecfg("config_test_server_extra.bin", &extra, 1);
+    cffreecfgentry(&extra);
+    write_server_config(5432);
+
+    const char *files[] = {"config_test_server.bin", "config_test_server_extra.bin"};
+    cfserver_t *server = cfservercreate("config_test_server.sock", files, 2);
+    CHECK(server != NULL);
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, run_server, server) == 0);
+    cfclient_t *client = cfclientconnect("config_test_server.sock");
+    CHECK(client != NULL);
+
+    // Missing keys, including one too long to exist, are left out
+    const char *keys[] = {"db.password", "db.missing", "db.port",
+                          "db.a.key.that.is.far.too.long.to.be.stored.in.a.configuration.entry"};
+    cffile_t *reply = cfclientget(client, NULL, keys, 4);
+    CHECK(reply != NULL);
+    CHECK(reply->header.entrycount == 2);
+    CHECK(strcmp(reply->entries[0].key, "db.password") == 0);
+    CHECK(strcmp((const char*)CF_ENTRYVAL(&reply->entries[0]), "correct-horse-battery-staple") == 0);
+    CHECK(strcmp(reply->entries[1].key, "db.port") == 0);
+    CHECK(*(int*)CF_ENTRYVAL(&reply->entries[1]) == 5432);
+    CHECK(cfget(reply, "db.port") == &reply->entries[1]);
+    cffreecfgfile(reply);
+
+    // Prefix lookups are ordered by key
+    reply = cfclientprefix(client, "config_test_server", "db.");
+    CHECK(reply != NULL);
+    CHECK(reply->header.entrycount == 3);
+    CHECK(strcmp(reply->entries[0].key, "db.host") == 0);
+    CHECK(strcmp(reply->entries[1].key, "db.password") == 0);
+    CHECK(strcmp(reply->entries[2].key, "db.port") == 0);
+    cffreecfgfile(reply);
+    reply = cfclientprefix(client, NULL, "dc");
+    CHECK(reply != NULL && reply->header.entrycount == 0);
+    cffreecfgfile(reply);
+
+    // Other configurations are selected by name
+    const char *flagkey = "feature.flag";
+    CHECK(cfclientget(client, "config_test_missing", &flagkey, 1) == NULL);
+    for (int i = 0; i < 3; ++i) {
+        CHECK(cfclientsend(client, CONFIN_REQUEST_GET, "config_test_server_extra", &flagkey, 1) == true);
+    }
+    for (int i = 0; i < 3; ++i) {
+        reply = cfclientreceive(client);
+        CHECK(reply != NULL && reply->header.entrycount == 1);
+        CHECK(*(int*)CF_ENTRYVAL(&reply->entries[0]) == 1);
+        cffreecfgfile(reply);
+    }
+
+    // Replaced files are served once the loader thread has read them
+    write_server_config(6543);
+    cfserverreload(server);
+    int port = 5432;
+    for (int attempt = 0; port != 6543 && attempt < 500; ++attempt) {
+        reply = cfclientget(client, NULL, keys + 2, 1);
+        CHECK(reply != NULL && reply->header.entrycount == 1);
+        port = *(int*)CF_ENTRYVAL(&reply->entries[0]);
+        CHECK(port == 5432 || port == 6543);
+        cffreecfgfile(reply);
+        if (port != 6543) {
+            usleep(10000);
+        }
+    }
+    CHECK(port == 6543);
+
+    cfclientclose(client);
+    cfserverstop(server);
+    void *result;
+    CHECK(pthread_join(thread, &result) == 0);
+    CHECK(result == server);
+    cfserverfree(server);
+    CHECK(access("config_test_server.sock", F_OK) != 0);
+#endif
+}
+
+// Test for splitting a configuration into shards loaded on demand
+void test_sharded_config() {
+    // 100 tenants with 3 keys each, sharded by tenant
+    cfshardwriter_t *writer = cfshardwriteropen("config_test_shards.cfm", 4, CONFIN_SHARD_PREFIX);
+    CHECK(writer != NULL);
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    for (int tenant = 0; tenant < 100; ++tenant) {
+        for (int limit = 0; limit < 3; ++limit) {
+            int value = tenant * 10 + limit;
+            snprintf(key, sizeof(key), "tenant%d.limit%d", tenant, limit);
+            CHECK(cfshardwriterappend(writer, key, CONFIN_ANNOTYPE_INT, &value, sizeof(value)) == true);
+        }
+    }
+    CHECK(cfshardwriterclose(writer) == true);
+
+    cfsharded_t *sharded = cfshardedopen("config_test_shards.cfm");
+    CHECK(sharded != NULL);
+    CHECK(cfshardedcount(sharded) == 4);
+    CHECK(cfshardedroute(sharded, "tenant42") == cfshardedroute(sharded, "tenant42.limit1"));
+    CHECK(cfshardedget(sharded, "tenant42.limit1") == NULL);
+
+    // Only the shard of tenant42 is loaded
+    CHECK(cfshardedloadkey(sharded, "tenant42") == true);
+    uint32_t shard = cfshardedroute(sharded, "tenant42");
+    const cfentry_t *entry = cfshardedget(sharded, "tenant42.limit1");
+    CHECK(entry != NULL && *(int*)CF_ENTRYVAL(entry) == 421);
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < cfshardedcount(sharded); ++i) {
+        cffile_t *config = cfshardedshard(sharded, i);
+        CHECK((config != NULL) == (i == shard));
+    }
+    for (int tenant = 0; tenant < 100; ++tenant) {
+        snprintf(key, sizeof(key), "tenant%d.limit0", tenant);
+        CHECK((cfshardedget(sharded, key) != NULL) == (cfshardedroute(sharded, key) == shard));
+    }
+
+    // Every key is in its shard and in no other
+    for (uint32_t i = 0; i < cfshardedcount(sharded); ++i) {
+        CHECK(cfshardedload(sharded, i) == true);
+        cffile_t *config = cfshardedshard(sharded, i);
+        for (uint64_t j = 0; j < config->header.entrycount; ++j) {
+            CHECK(cfshardedroute(sharded, config->entries[j].key) == i);
+        }
+        total += config->header.entrycount;
+    }
+    CHECK(total == 300);
+    cfshardedunload(sharded, shard);
+    CHECK(cfshardedshard(sharded, shard) == NULL);
+    CHECK(cfshardedload(sharded, 4) == false);
+    cfshardedclose(sharded);
+
+    // Hash sharding of an entry array
+    cfentry_t entries[4];
+    uint64_t entry_count;
+    create_sample_entries(entries, &entry_count);
+    CHECK(cfwritesharded("config_test_hashed.cfm", entries, entry_count, 3, CONFIN_SHARD_HASH) == true);
+    sharded = cfshardedopen("config_test_hashed.cfm");
+    CHECK(sharded != NULL);
+    for (uint64_t i = 0; i < entry_count; ++i) {
+        CHECK(cfshardedloadkey(sharded, entries[i].key) == true);
+        entry = cfshardedget(sharded, entries[i].key);
+        CHECK(entry != NULL && entry->size == entries[i].size);
+        CHECK(memcmp(CF_ENTRYVAL(entry), CF_ENTRYVAL(&entries[i]), entries[i].size) == 0);
+        cffreecfgentry(&entries[i]);
+    }
+    cfshardedclose(sharded);
+
+    // A manifest that does not match its shards is refused
+    FILE *file = fopen("config_test_hashed.cfm", "r+b");
+    CHECK(file != NULL);
+    uint64_t wrong = 5;
+    CHECK(fseek(file, offsetof(cfmanifest_t, entrycount), SEEK_SET) == 0);
+    CHECK(fwrite(&wrong, sizeof(wrong), 1, file) == 1);
+    fclose(file);
+    CHECK(cfshardedopen("config_test_hashed.cfm") == NULL);
+
+    // Values larger than the buffer of a shard
+    static unsigned char large[100000];
+    for (size_t i = 0; i < sizeof(large); ++i) {
+        large[i] = (unsigned char)(i * 7);
+    }
+    writer = cfshardwriteropen("config_test_large.cfm", 2, CONFIN_SHARD_HASH);
+    CHECK(writer != NULL);
+    CHECK(cfshardwriterappend(writer, "large.a", CONFIN_ANNOTYPE_STRUCT, large, sizeof(large)) == true);
+    CHECK(cfshardwriterappend(writer, "large.b", CONFIN_ANNOTYPE_STRUCT, large, sizeof(large)) == true);
+    CHECK(cfshardwriterappend(writer, "large.c", CONFIN_ANNOTYPE_STRUCT, large, 1000) == true);
+    CHECK(cfshardwriterclose(writer) == true);
+    sharded = cfshardedopen("config_test_large.cfm");
+    CHECK(sharded != NULL);
+    const char *large_keys[] = {"large.a", "large.b", "large.c"};
+    for (int i = 0; i < 3; ++i) {
+        CHECK(cfshardedloadkey(sharded, large_keys[i]) == true);
+        entry = cfshardedget(sharded, large_keys[i]);
+        CHECK(entry != NULL && entry->size == (i < 2 ? sizeof(large) : 1000));
+        CHECK(memcmp(CF_ENTRYVAL(entry), large, entry->size) == 0);
+    }
+    cfshardedclose(sharded);
+}
+
+// Test for freezing a configuration into a read-only block
+void test_frozen_config() {
+    // Values inline and out of line, and a repeated key at the end
+    cfentry_t entries[501];
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    char value[40];
+    for (int i = 0; i < 500; ++i) {
+        snprintf(key, sizeof(key), "key.%d", i);
+        memset(value, 'a' + i % 26, sizeof(value));
+        entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_STRING, value, (uint64_t)(i % 40));
+    }
+    entries[500] = cfcreatecfgentry("key.7", CONFIN_ANNOTYPE_STRING, "again", 6);
+    cfwritecfg("config_test_frozen.bin", entries, 501);
+    for (int i = 0; i < 501; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+
+    cffile_t *config = cfreadcfg("config_test_frozen.bin");
+    CHECK(config != NULL);
+    cffrozen_t *frozen = cffreeze(config, 0);
+    CHECK(frozen != NULL);
+    CHECK(cffrozencount(frozen) == 500);
+    CHECK(cffrozensize(frozen) > 500 * sizeof(cfentry_t));
+    for (int i = 0; i < 500; ++i) {
+        snprintf(key, sizeof(key), "key.%d", i);
+        const cfentry_t *expected = cfget(config, key);
+        const cfentry_t *entry = cffrozenget(frozen, key);
+        CHECK(entry != NULL && entry != expected);
+        CHECK(strcmp(entry->key, key) == 0 && entry->type == expected->type && entry->size == expected->size);
+        CHECK(memcmp(CF_ENTRYVAL(entry), CF_ENTRYVAL(expected), entry->size) == 0);
+    }
+    CHECK(cffrozenget(frozen, "key.500") == NULL);
+    CHECK(cffrozenget(frozen, "") == NULL);
+    cffreecfgfile(config);
+
+    // Entries stay valid without the configuration, in key order
+    CHECK(cffrozenget(frozen, "key.7")->size == 7);
+    for (uint64_t i = 1; i < cffrozencount(frozen); ++i) {
+        CHECK(strcmp(cffrozenentry(frozen, i - 1)->key, cffrozenentry(frozen, i)->key) < 0);
+    }
+    CHECK(cffrozenentry(frozen, 500) == NULL);
+
+    // More keys than one group, with absent keys mixed in
+    char names[70][__CONFIN_STRUCT_MAX_KEYLEN];
+    const char *keys[70];
+    const cfentry_t *out[70];
+    for (int i = 0; i < 70; ++i) {
+        snprintf(names[i], sizeof(names[i]), i % 7 == 0 ? "absent.%d" : "key.%d", (i * 37) % 500);
+        keys[i] = names[i];
+    }
+    CHECK(cffrozengetmany(frozen, keys, 70, out) == 60);
+    for (int i = 0; i < 70; ++i) {
+        CHECK(out[i] == cffrozenget(frozen, keys[i]));
+    }
+    CHECK((cffrozenflags(frozen) & CONFIN_FREEZE_MLOCK) == 0);
+    cffrozenfree(frozen);
+
+    // An empty configuration freezes too, with the allocator of a context
+    struct CountingAllocator counts = {0, 0};
+    cfcontext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.allocator.alloc = counting_alloc;
+    ctx.allocator.realloc = counting_realloc;
+    ctx.allocator.free = counting_free;
+    ctx.allocator.userdata = &counts;
+    cffile_t empty;
+    memset(&empty, 0, sizeof(empty));
+    frozen = cffreezectx(&empty, 0, &ctx);
+    CHECK(frozen != NULL && cffrozencount(frozen) == 0);
+    CHECK(cffrozenget(frozen, "key.0") == NULL);
+    CHECK(counts.allocs > 0);
+    cffrozenfree(frozen);
+    CHECK(counts.allocs == counts.frees);
+}
+
+// Test for the front-coded compact form of a configuration
+void test_compact_config() {
+    // Hierarchical keys, values of every size class and a repeated key at the end
+    cfentry_t entries[301];
+    char key[__CONFIN_STRUCT_MAX_KEYLEN];
+    char value[200];
+    for (int i = 0; i < 300; ++i) {
+        snprintf(key, sizeof(key), "tenant%d.limits.%s", i / 3, i % 3 == 0 ? "rate" : i % 3 == 1 ? "burst" : "name");
+        memset(value, 'a' + i % 26, sizeof(value));
+        entries[i] = cfcreatecfgentry(key, CONFIN_ANNOTYPE_STRING, value, (uint64_t)(i % 7 == 0 ? 200 : i % 20));
+    }
+    entries[300] = cfcreatecfgentry("tenant5.limits.rate", CONFIN_ANNOTYPE_INT, "again", 6);
+    cfwritecfg("config_test_compact.bin", entries, 301);
+    for (int i = 0; i < 301; ++i) {
+        cffreecfgentry(&entries[i]);
+    }
+
+    cffile_t *config = cfreadcfg("config_test_compact.bin");
+    CHECK(config != NULL);
+    cfcompact_t *compact = cfcompact(config);
+    CHECK(compact != NULL);
+    CHECK(cfcompactcount(compact) == 300);
+    CHECK(cfcompactsize(compact) < 300 * sizeof(cfentry_t));
+    cfentry_t entry;
+    for (uint64_t i = 0; i < 300; ++i) {
+        const cfentry_t *expected = &config->entries[i];
+        CHECK(cfcompactget(compact, expected->key, &entry) == true);
+        CHECK(strcmp(entry.key, expected->key) == 0 && entry.type == expected->type && entry.size == expected->size);
+        CHECK(memcmp(CF_ENTRYVAL(&entry), CF_ENTRYVAL(expected), entry.size) == 0);
+    }
+    CHECK(cfcompactget(compact, "tenant5.limits.rate", &entry) == true && entry.type == CONFIN_ANNOTYPE_STRING);
+    const char *absent[] = {"", "a", "tenant0", "tenant0.limits.", "tenant42.limits.rates", "tenant99.limits.rate2", "zzz",
+                            "a.key.that.does.not.fit.in.the.sixty.four.bytes.of.the.key.of.an.entry"};
+    for (size_t i = 0; i < sizeof(absent) / sizeof(absent[0]); ++i) {
+        CHECK(cfcompactfind(compact, absent[i]) == UINT64_MAX);
+        CHECK(cfcompactget(compact, absent[i], &entry) == false);
+    }
+    cffreecfgfile(config);
+
+    // Entries stay valid without the configuration, in key order
+    char previous[__CONFIN_STRUCT_MAX_KEYLEN] = "";
+    for (uint64_t i = 0; i < cfcompactcount(compact); ++i) {
+        CHECK(cfcompactentry(compact, i, &entry) == true);
+        CHECK(strcmp(previous, entry.key) < 0);
+        CHECK(cfcompactfind(compact, entry.key) == i);
+        strcpy(previous, entry.key);
+    }
+    CHECK(cfcompactentry(compact, 300, &entry) == false);
+
+    // Round trip through a file
+    CHECK(cfcompactwrite(compact, "config_test_compact.cfc") == true);
+    cfcompact_t *loaded = cfcompactread("config_test_compact.cfc");
+    CHECK(loaded != NULL && cfcompactcount(loaded) == 300);
+    cfentry_t other;
+    for (uint64_t i = 0; i < 300; ++i) {
+        CHECK(cfcompactentry(compact, i, &entry) == true && cfcompactentry(loaded, i, &other) == true);
+        CHECK(strcmp(entry.key, other.key) == 0 && entry.size == other.size);
+        CHECK(memcmp(CF_ENTRYVAL(&entry), CF_ENTRYVAL(&other), entry.size) == 0);
+    }
+    cfcompactfree(loaded);
+    cfcompactfree(compact);
+
+    // A first key that claims a shared prefix is refused
+    FILE *file = fopen("config_test_compact.cfc", "r+b");
+    CHECK(file != NULL);
+    cfcompacthdr_t header;
+    CHECK(fread(&header, sizeof(header), 1, file) == 1);
+    unsigned char shared = 1;
+    CHECK(fseek(file, (long)(sizeof(header) + header.blockcount * 2 * sizeof(uint64_t)), SEEK_SET) == 0);
+    CHECK(fwrite(&shared, 1, 1, file) == 1);
+    fclose(file);
+    CHECK(cfcompactread("config_test_compact.cfc") == NULL);
+
+    // Enough blocks for several fences; keys share no prefix and miss between blocks.
+    // They are compacted and read back with the allocator of a context
+    struct CountingAllocator counts = {0, 0};
+    cfcontext_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.allocator.alloc = counting_alloc;
+    ctx.allocator.realloc = counting_realloc;
+    ctx.allocator.free = counting_free;
+    ctx.allocator.userdata = &counts;
+    cfwriter_t *writer = cfwriteropen("config_test_compact.bin");
+    CHECK(writer != NULL);
+    for (int i = 0; i < 5000; ++i) {
+        snprintf(key, sizeof(key), "%c%d.x", 'a' + i % 3, i * 2);
+        CHECK(cfwriterappend(writer, key, CONFIN_ANNOTYPE_INT, &i, sizeof(i)) == true);
+    }
+    CHECK(cfwriterclose(writer) == true);
+    config = cfreadcfg("config_test_compact.bin");
+    CHECK(config != NULL);
+    compact = cfcompactctx(config, &ctx);
+    CHECK(compact != NULL && cfcompactwrite(compact, "config_test_compact.cfc") == true);
+    cfcompactfree(compact);
+    compact = cfcompactreadctx("config_test_compact.cfc", &ctx);
+    CHECK(compact != NULL && cfcompactcount(compact) == 5000);
+    for (int i = 0; i < 5000; ++i) {
+        snprintf(key, sizeof(key), "%c%d.x", 'a' + i % 3, i * 2);
+        CHECK(cfcompactget(compact, key, &entry) == true && CF_UNREF_ENTRYVAL(CF_ENTRYVAL(&entry), int) == i);
+        snprintf(key, sizeof(key), "%c%d.x", 'a' + i % 3, i * 2 + 1);
+        CHECK(cfcompactfind(compact, key) == UINT64_MAX);
+    }
+    cfcompactfree(compact);
+    CHECK(counts.allocs > 0 && counts.allocs == counts.frees);
+    cffreecfgfile(config);
+
+    // An empty configuration
+    cffile_t empty;
+    memset(&empty, 0, sizeof(empty));
+    compact = cfcompact(&empty);
+    CHECK(compact != NULL && cfcompactcount(compact) == 0);
+    CHECK(cfcompactget(compact, "tenant0.limits.rate", &entry) == false);
+    cfcompactfree(compact);
+}
+
 // Function to cleanup test files
 void cleanup_test_files() {
     const char *files[] = {
         "config_test.bin",
         "config_test_empty.bin",
-        "empty_file.bin"
+        "empty_file.bin",
+        "config_test_plain.bin",
+        "config_test_dedup.bin",
+        "config_test_initialized.bin",
+        "config_test_inline.bin",
+        "config_test_alloc.bin",
+        "config_test_alloc_plain.bin",
+        "config_test_stats.bin",
+        "config_test_old.bin",
+        "config_test_new.bin",
+        "config_test_delta.bin",
+        "config_test_dup_old.bin",
+        "config_test_dup_new.bin",
+        "config_test_dup.bin",
+        "config_test_dup_last.bin",
+        "config_test_dup_delta.bin",
+        "config_test_ini.bin",
+        "config_test_json.bin",
+        "config_test_export.bin",
+        "config_test_export_pooled.bin",
+        "config_test_export.json",
+        "config_test_export.jsonl",
+        "config_test_bind.bin",
+        "config_test_handles.bin",
+        "config_test_many.bin",
+        "config_test_writer.bin",
+        "config_test_parallel.bin",
+        "config_test_parallel_plain.bin",
+        "config_test_parallel_pooled.bin",
+        "config_test_parallel_writer.bin",
+        "config_test_mutable.bin",
+        "config_test_mutable_out.bin",
+        "config_test_history/1.bin",
+        "config_test_history/2.delta",
+        "config_test_history/3.delta",
+        "config_test_history/4.delta",
+        "config_test_history/5.delta",
+        "config_test_history/6.delta",
+        "config_test_history/7.delta",
+        "config_test_history/8.delta",
+        "config_test_history/history.index",
+        "config_test_history",
+        "config_test_server.bin",
+        "config_test_server_extra.bin",
+        "config_test_shards.cfm",
+        "config_test_shards.0.bin",
+        "config_test_shards.1.bin",
+        "config_test_shards.2.bin",
+        "config_test_shards.3.bin",
+        "config_test_hashed.cfm",
+        "config_test_hashed.0.bin",
+        "config_test_hashed.1.bin",
+        "config_test_hashed.2.bin",
+        "config_test_large.cfm",
+        "config_test_large.0.bin",
+        "config_test_large.1.bin",
+        "config_test_frozen.bin",
+        "config_test_compact.bin",
+        "config_test_compact.cfc"
     };
 
     for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
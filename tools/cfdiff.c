@@ -0,0 +1,76 @@
+/**
+ * @file cfdiff.c
+ * @brief Command line tool to compute and apply configuration deltas.
+ * 
+ * Usage:
+ *   cfdiff diff <old> <new> <delta>    Writes the delta from <old> to <new>
+ *   cfdiff apply <old> <delta> <out>   Applies <delta> to <old> and writes <out>
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../confin/cfself.h"
+
+static int usage(void) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  cfdiff diff <old> <new> <delta>\n"
+            "  cfdiff apply <old> <delta> <out>\n");
+    return 2;
+}
+
+static int run_diff(const char *oldname, const char *newname, const char *deltaname) {
+    cffile_t *oldcfg = cfreadcfg(oldname);
+    cffile_t *newcfg = oldcfg ? cfreadcfg(newname) : NULL;
+    if (!oldcfg || !newcfg) {
+        if (oldcfg) {
+            cffreecfgfile(oldcfg);
+        }
+        return 1;
+    }
+
+    cfdiffsummary_t summary;
+    bool ok = cfdiff(oldcfg, newcfg, deltaname, &summary);
+    if (ok) {
+        printf("added: %llu, changed: %llu, removed: %llu\n",
+               (unsigned long long)summary.added,
+               (unsigned long long)summary.changed,
+               (unsigned long long)summary.removed);
+    }
+
+    cffreecfgfile(oldcfg);
+    cffreecfgfile(newcfg);
+    return ok ? 0 : 1;
+}
+
+static int run_apply(const char *oldname, const char *deltaname, const char *outname) {
+    cffile_t *oldcfg = cfreadcfg(oldname);
+    if (!oldcfg) {
+        return 1;
+    }
+
+    cffile_t *newcfg = cfapplydelta(oldcfg, deltaname);
+    cffreecfgfile(oldcfg);
+    if (!newcfg) {
+        return 1;
+    }
+
+    cfwritecfgfile(outname, newcfg);
+    printf("entries: %llu\n", (unsigned long long)newcfg->header.entrycount);
+    cffreecfgfile(newcfg);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 5) {
+        return usage();
+    }
+    if (strcmp(argv[1], "diff") == 0) {
+        return run_diff(argv[2], argv[3], argv[4]);
+    }
+    if (strcmp(argv[1], "apply") == 0) {
+        return run_apply(argv[2], argv[3], argv[4]);
+    }
+    return usage();
+}
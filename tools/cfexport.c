@@ -0,0 +1,57 @@
+/**
+ * @file cfexport.c
+ * @brief Command line tool to export Confin files as JSON.
+ * 
+ * Usage:
+ *   cfexport [--lines] [-o <dir>] <input>...
+ * 
+ * Every input is written to `stdout`, as one JSON object per file or, with
+ * `--lines`, as JSON Lines. With `-o <dir>` each input is written to
+ * `<dir>/<name>.json` (or `.jsonl`) instead.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../confin/cfself.h"
+
+static int usage(void) {
+    fprintf(stderr, "Usage: cfexport [--lines] [-o <dir>] <input>...\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    cfexportfmt_t format = CONFIN_EXPORT_JSON;
+    const char *directory = NULL;
+    int first = 1;
+
+    for (; first < argc && argv[first][0] == '-'; ++first) {
+        if (strcmp(argv[first], "--lines") == 0) {
+            format = CONFIN_EXPORT_JSONL;
+        } else if (strcmp(argv[first], "-o") == 0 && first + 1 < argc) {
+            directory = argv[++first];
+        } else {
+            return usage();
+        }
+    }
+    if (first == argc) {
+        return usage();
+    }
+
+    int status = 0;
+    for (int i = first; i < argc; ++i) {
+        char output[4096];
+        if (directory) {
+            const char *name = strrchr(argv[i], '/');
+            name = name ? name + 1 : argv[i];
+            size_t length = strcspn(name, ".");
+            snprintf(output, sizeof(output), "%s/%.*s.%s", directory, (int)length, name,
+                     format == CONFIN_EXPORT_JSONL ? "jsonl" : "json");
+        }
+        if (!cfexportfile(argv[i], directory ? output : NULL, format)) {
+            fprintf(stderr, "%s: export failed\n", argv[i]);
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file cfserve.c
+ * @brief Command line tool to serve Confin files over a Unix domain socket.
+ * 
+ * Usage:
+ *   cfserve <socket> <input>...
+ * 
+ * Every input is served under its file name without the extension; requests
+ * with an empty name go to the first input. Inputs are reloaded when they change
+ * on disk and on `SIGHUP`; `SIGINT` and `SIGTERM` stop the server.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../confin/cfself.h"
+
+static cfserver_t *server;
+
+static void on_signal(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        cfserverstop(server);
+#ifndef _WIN32
+    } else if (signal == SIGHUP) {
+        cfserverreload(server);
+#endif
+    }
+}
+
+static int usage(void) {
+    fprintf(stderr, "Usage: cfserve <socket> <input>...\n");
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        return usage();
+    }
+
+#ifndef _WIN32
+    // Every client holds a descriptor: allow as many as the hard limit
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+
+    server = cfservercreate(argv[1], (const char**)(argv + 2), (size_t)(argc - 2));
+    if (!server) {
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+#ifndef _WIN32
+    signal(SIGHUP, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    fprintf(stderr, "Serving %d file(s) on %s\n", argc - 2, argv[1]);
+    int status = cfserverrun(server) ? 0 : 1;
+    cfserverfree(server);
+    return status;
+}